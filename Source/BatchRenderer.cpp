@@ -0,0 +1,222 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.cpp
+// ============
+// render many fixed views of the scene offscreen and write them as images
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BatchRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  BatchRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BatchRenderer::BatchRenderer(
+	SceneManager* pSceneManager,
+	SoftwareRasterizer* pSceneRasterizer,
+	JobSystem* pJobSystem)
+{
+	m_pSceneManager = pSceneManager;
+	m_pSceneRasterizer = pSceneRasterizer;
+	m_pJobSystem = pJobSystem;
+
+	// every worker rasterizes a whole view on one thread, so
+	// the views run in parallel instead of their tiles
+	int threadCount = (NULL != m_pJobSystem) ? m_pJobSystem->GetThreadCount() : 1;
+	m_workers.resize(threadCount);
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_workers[i] = new SoftwareRasterizer(NULL);
+	}
+}
+
+/***********************************************************
+ *  ~BatchRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BatchRenderer::~BatchRenderer()
+{
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		delete m_workers[i];
+	}
+	m_workers.clear();
+	m_pSceneManager = NULL;
+	m_pSceneRasterizer = NULL;
+	m_pJobSystem = NULL;
+}
+
+/***********************************************************
+ *  LoadViews()
+ *
+ *  This method is used for loading the camera poses of a
+ *  view file.  Every line holds one view:
+ *
+ *    view <position x y z> <front x y z> <zoom>
+ *         <perspective or ortho> [image file]
+ *
+ *  The views without an image file are written to the
+ *  prefix followed by their number.  Lines starting with #
+ *  are comments.
+ ***********************************************************/
+bool BatchRenderer::LoadViews(const char* filename, const char* outputPrefix)
+{
+	std::ifstream input(filename);
+	if (!input)
+	{
+		std::cout << "Could not open view file:" << filename << std::endl;
+		return(false);
+	}
+
+	bool bValid = true;
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(input, text))
+	{
+		lineNumber++;
+		std::istringstream line(text);
+		std::string kind;
+		if (!(line >> kind) || (kind[0] == '#'))
+		{
+			continue;
+		}
+
+		VIEW_REQUEST view;
+		std::string projection;
+		view.pose.up = glm::vec3(0.0f, 1.0f, 0.0f);
+		bool bLineValid = (kind == "view") &&
+			(line >> view.pose.position.x >> view.pose.position.y >> view.pose.position.z) &&
+			(line >> view.pose.front.x >> view.pose.front.y >> view.pose.front.z) &&
+			(line >> view.pose.zoom >> projection) &&
+			((projection == "perspective") || (projection == "ortho"));
+		if (bLineValid == false)
+		{
+			std::cout << filename << ":" << lineNumber << ": invalid view line" << std::endl;
+			bValid = false;
+			continue;
+		}
+		view.pose.bOrthographic = (projection == "ortho");
+
+		if (!(line >> view.filename))
+		{
+			char number[16];
+			snprintf(number, sizeof(number), "%04d", (int)m_views.size());
+			view.filename = std::string(outputPrefix) + number + ".ppm";
+		}
+		m_views.push_back(view);
+	}
+
+	return(bValid);
+}
+
+/***********************************************************
+ *  AddView()
+ *
+ *  This method is used for adding one view to render.
+ ***********************************************************/
+void BatchRenderer::AddView(const VIEW_REQUEST& view)
+{
+	m_views.push_back(view);
+}
+
+/***********************************************************
+ *  GetViewCount()
+ *
+ *  This method is used for getting the number of views to
+ *  render.
+ ***********************************************************/
+int BatchRenderer::GetViewCount() const
+{
+	return((int)m_views.size());
+}
+
+/***********************************************************
+ *  Render()
+ *
+ *  This method is used for rendering all the views and
+ *  writing their images.  The throughput is printed at the
+ *  end in views per second.
+ ***********************************************************/
+bool BatchRenderer::Render(int width, int height)
+{
+	int viewCount = (int)m_views.size();
+	int workerCount = (int)m_workers.size();
+	// set by the threads, so not a vector of bool
+	std::vector<unsigned char> written(viewCount, 0);
+
+	// pick up the lights and textures the scene was prepared with
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers[i]->ShareScene(*m_pSceneRasterizer);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int first = 0; first < viewCount; first += workerCount)
+	{
+		int groupSize = std::min(workerCount, viewCount - first);
+
+		// the scene manager is not thread safe, so every view of
+		// the group is culled, sorted and recorded here
+		for (int i = 0; i < groupSize; i++)
+		{
+			ViewManager::VIEW_STATE view = ViewManager::BuildView(m_views[first + i].pose, width, height);
+			m_workers[i]->BeginFrame(width, height,
+				view.viewProjection, view.position, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+			m_pSceneManager->SetViewPosition(view.position);
+			m_pSceneManager->SetViewProjection(view.viewProjection);
+			m_pSceneManager->SetSoftwareTarget(m_workers[i]);
+			m_pSceneManager->RenderScene();
+		}
+		m_pSceneManager->SetSoftwareTarget(NULL);
+
+		// rasterize the recorded views and write their images
+		JobSystem::RANGE_FUNCTION body = [this, first, &written](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				m_workers[i]->EndFrame();
+				written[first + i] = m_workers[i]->WriteImage(m_views[first + i].filename.c_str()) ? 1 : 0;
+			}
+		};
+		if (NULL != m_pJobSystem)
+		{
+			m_pJobSystem->ParallelFor(groupSize, 1, body);
+		}
+		else
+		{
+			body(0, groupSize);
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	int failed = 0;
+	for (int i = 0; i < viewCount; i++)
+	{
+		if (written[i] == 0)
+		{
+			failed++;
+		}
+	}
+
+	std::cout << "Batch renderer: " << viewCount << " views of " << width << "x" << height
+		<< " on " << workerCount << " threads in " << seconds << " s, "
+		<< ((seconds > 0.0) ? (viewCount / seconds) : 0.0) << " views per second";
+	if (failed > 0)
+	{
+		std::cout << ", " << failed << " images not written";
+	}
+	std::cout << std::endl;
+
+	return(failed == 0);
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.h
+// ============
+// render many fixed views of the scene offscreen and write them as images
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "SoftwareRasterizer.h"
+#include "ViewManager.h"
+#include "JobSystem.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  BatchRenderer
+ *
+ *  This class renders a list of camera poses without a
+ *  window, for thumbnails and previews of the scene.  The
+ *  scene is prepared once with the software rasterizer, and
+ *  every job thread gets a rasterizer of its own that samples
+ *  the same decoded textures.
+ *
+ *  The views are rendered in groups of one per thread.  The
+ *  scene manager culls and sorts the draws of every view of
+ *  a group on the calling thread, which takes microseconds,
+ *  then the threads rasterize their views and write the
+ *  images in parallel.
+ ***********************************************************/
+class BatchRenderer
+{
+public:
+	// one view to render and the image it is written to
+	struct VIEW_REQUEST
+	{
+		ViewManager::CAMERA_POSE pose;
+		std::string filename;
+	};
+
+	// constructor, the scene must be prepared with the passed
+	// in software rasterizer
+	BatchRenderer(
+		SceneManager* pSceneManager,
+		SoftwareRasterizer* pSceneRasterizer,
+		JobSystem* pJobSystem);
+	// destructor
+	~BatchRenderer();
+
+private:
+	// prepared scene and the rasterizer holding its textures
+	SceneManager* m_pSceneManager;
+	SoftwareRasterizer* m_pSceneRasterizer;
+	// runs the views of a group in parallel, or NULL
+	JobSystem* m_pJobSystem;
+	// rasterizer of every job thread
+	std::vector<SoftwareRasterizer*> m_workers;
+	// views in the order they were loaded
+	std::vector<VIEW_REQUEST> m_views;
+
+public:
+	// load the camera poses of a view file, the images without
+	// a file name of their own are numbered after the prefix
+	bool LoadViews(const char* filename, const char* outputPrefix);
+	// add one view to render
+	void AddView(const VIEW_REQUEST& view);
+	// get the number of views to render
+	int GetViewCount() const;
+	// render all the views at the passed in size and write
+	// their images, returning false when any image failed
+	bool Render(int width, int height);
+};
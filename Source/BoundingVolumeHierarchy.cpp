@@ -0,0 +1,739 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// spatial index over object bounding boxes for ray, box and frustum queries
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	typedef BoundingVolumeHierarchy::AABB AABB;
+
+	// cost of visiting a node, relative to testing an object
+	const float TRAVERSAL_COST = 1.0f;
+
+	/***********************************************************
+	 *  EmptyBox()
+	 *
+	 *  Get a box that any grown box replaces.
+	 ***********************************************************/
+	AABB EmptyBox()
+	{
+		AABB box;
+		box.min = glm::vec3(FLT_MAX);
+		box.max = glm::vec3(-FLT_MAX);
+		return(box);
+	}
+
+	/***********************************************************
+	 *  GrowBox()
+	 *
+	 *  Grow a box to hold another box.
+	 ***********************************************************/
+	void GrowBox(AABB& box, const AABB& other)
+	{
+		box.min = glm::min(box.min, other.min);
+		box.max = glm::max(box.max, other.max);
+	}
+
+	/***********************************************************
+	 *  SurfaceArea()
+	 *
+	 *  Get the surface area of a box, 0 for an empty box.
+	 ***********************************************************/
+	float SurfaceArea(const AABB& box)
+	{
+		glm::vec3 size = glm::max(box.max - box.min, glm::vec3(0.0f));
+		return(2.0f * ((size.x * size.y) + (size.y * size.z) + (size.z * size.x)));
+	}
+
+	/***********************************************************
+	 *  IntersectBox()
+	 *
+	 *  Get the distance along a ray where it enters a box,
+	 *  if it does before the passed in distance.
+	 ***********************************************************/
+	bool IntersectBox(
+		const AABB& box,
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		float maxDistance,
+		float& entry)
+	{
+		glm::vec3 t1 = (box.min - origin) * inverseDirection;
+		glm::vec3 t2 = (box.max - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t1, t2);
+		glm::vec3 tFar = glm::max(t1, t2);
+		float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		entry = tEnter;
+		return(tEnter <= tExit);
+	}
+
+	/***********************************************************
+	 *  BoxesOverlap()
+	 *
+	 *  Check whether two boxes overlap or touch.
+	 ***********************************************************/
+	bool BoxesOverlap(const AABB& a, const AABB& b)
+	{
+		return((a.min.x <= b.max.x) && (a.max.x >= b.min.x) &&
+			(a.min.y <= b.max.y) && (a.max.y >= b.min.y) &&
+			(a.min.z <= b.max.z) && (a.max.z >= b.min.z));
+	}
+
+	/***********************************************************
+	 *  BoxContains()
+	 *
+	 *  Check whether a box holds all of another box.
+	 ***********************************************************/
+	bool BoxContains(const AABB& outer, const AABB& inner)
+	{
+		return((outer.min.x <= inner.min.x) && (outer.max.x >= inner.max.x) &&
+			(outer.min.y <= inner.min.y) && (outer.max.y >= inner.max.y) &&
+			(outer.min.z <= inner.min.z) && (outer.max.z >= inner.max.z));
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  ~BoundingVolumeHierarchy()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the
+ *  passed in object bounds.  The nodes are split from the
+ *  root down, and the objects of every node are partitioned
+ *  in place so each subtree keeps a contiguous range.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const AABB* pBounds, int objectCount)
+{
+	Clear();
+	if (objectCount <= 0)
+	{
+		return;
+	}
+
+	m_objectBounds.assign(pBounds, pBounds + objectCount);
+	m_objects.resize(objectCount);
+	m_objectLeaves.resize(objectCount);
+	std::vector<glm::vec3> centroids(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		m_objects[i] = i;
+		centroids[i] = (m_objectBounds[i].min + m_objectBounds[i].max) * 0.5f;
+	}
+
+	// a binary tree has fewer than two nodes per object
+	m_nodes.reserve(2 * objectCount);
+	m_parents.reserve(2 * objectCount);
+	NODE root;
+	root.bounds = EmptyBox();
+	root.firstObject = 0;
+	root.objectCount = objectCount;
+	root.firstChild = -1;
+	m_nodes.push_back(root);
+	m_parents.push_back(-1);
+
+	// split the nodes depth-first, tracking their depth
+	std::vector<std::pair<int, int> > pending;
+	pending.push_back(std::make_pair(0, 0));
+	while (pending.empty() == false)
+	{
+		int node = pending.back().first;
+		int depth = pending.back().second;
+		pending.pop_back();
+		if (SplitNode(node, depth, centroids) == true)
+		{
+			int child = m_nodes[node].firstChild;
+			pending.push_back(std::make_pair(child + 1, depth + 1));
+			pending.push_back(std::make_pair(child, depth + 1));
+		}
+	}
+
+	// the leaves are known once the splitting is done
+	for (int node = 0; node < (int)m_nodes.size(); node++)
+	{
+		const NODE& leaf = m_nodes[node];
+		if (leaf.firstChild < 0)
+		{
+			for (int i = leaf.firstObject; i < leaf.firstObject + leaf.objectCount; i++)
+			{
+				m_objectLeaves[m_objects[i]] = node;
+			}
+		}
+	}
+	m_dirtyFlags.assign(m_nodes.size(), 0);
+
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_SCENE_DATA, "bounding volume hierarchy",
+		(m_nodes.size() * (sizeof(NODE) + sizeof(int) + sizeof(uint8_t))) +
+		(objectCount * (sizeof(AABB) + (2 * sizeof(int)))));
+}
+
+/***********************************************************
+ *  SplitNode()
+ *
+ *  This method is used for setting the box of a node and
+ *  splitting it.  The object centers are sorted into bins
+ *  along every axis, and the split between two bins with
+ *  the lowest surface area cost is taken.  The node stays a
+ *  leaf when no split is cheaper than testing its objects.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::SplitNode(int node, int depth, std::vector<glm::vec3>& centroids)
+{
+	int first = m_nodes[node].firstObject;
+	int count = m_nodes[node].objectCount;
+
+	// the box of the objects and the box of their centers
+	AABB bounds = EmptyBox();
+	AABB centerBounds = EmptyBox();
+	for (int i = first; i < first + count; i++)
+	{
+		int object = m_objects[i];
+		GrowBox(bounds, m_objectBounds[object]);
+		centerBounds.min = glm::min(centerBounds.min, centroids[object]);
+		centerBounds.max = glm::max(centerBounds.max, centroids[object]);
+	}
+	m_nodes[node].bounds = bounds;
+
+	if ((count <= 1) || (depth >= MAX_DEPTH - 1))
+	{
+		return(false);
+	}
+
+	int bestAxis = -1;
+	int bestSplit = 0;
+	float bestCost = FLT_MAX;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = centerBounds.max[axis] - centerBounds.min[axis];
+		if (extent <= 0.0f)
+		{
+			continue;
+		}
+		float binScale = BIN_COUNT / extent;
+
+		int binCounts[BIN_COUNT];
+		AABB binBounds[BIN_COUNT];
+		for (int bin = 0; bin < BIN_COUNT; bin++)
+		{
+			binCounts[bin] = 0;
+			binBounds[bin] = EmptyBox();
+		}
+		for (int i = first; i < first + count; i++)
+		{
+			int object = m_objects[i];
+			int bin = std::min(BIN_COUNT - 1, (int)((centroids[object][axis] - centerBounds.min[axis]) * binScale));
+			binCounts[bin]++;
+			GrowBox(binBounds[bin], m_objectBounds[object]);
+		}
+
+		// sweep from the right, then from the left, so every
+		// split between bins is costed in one pass
+		float rightAreas[BIN_COUNT];
+		int rightCounts[BIN_COUNT];
+		AABB rightBox = EmptyBox();
+		int rightCount = 0;
+		for (int bin = BIN_COUNT - 1; bin > 0; bin--)
+		{
+			GrowBox(rightBox, binBounds[bin]);
+			rightCount += binCounts[bin];
+			rightAreas[bin] = SurfaceArea(rightBox);
+			rightCounts[bin] = rightCount;
+		}
+		AABB leftBox = EmptyBox();
+		int leftCount = 0;
+		for (int split = 0; split < BIN_COUNT - 1; split++)
+		{
+			GrowBox(leftBox, binBounds[split]);
+			leftCount += binCounts[split];
+			if ((leftCount == 0) || (rightCounts[split + 1] == 0))
+			{
+				continue;
+			}
+			float cost = (SurfaceArea(leftBox) * leftCount) +
+				(rightAreas[split + 1] * rightCounts[split + 1]);
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	// all the centers are the same point, or a few objects
+	// are cheaper to test than to split
+	if (bestAxis < 0)
+	{
+		return(false);
+	}
+	float area = SurfaceArea(bounds);
+	if ((count <= MAX_LEAF_OBJECTS) && (bestCost + (TRAVERSAL_COST * area) >= area * count))
+	{
+		return(false);
+	}
+
+	float axisMin = centerBounds.min[bestAxis];
+	float binScale = BIN_COUNT / (centerBounds.max[bestAxis] - axisMin);
+	std::vector<int>::iterator middle = std::partition(
+		m_objects.begin() + first, m_objects.begin() + first + count,
+		[&](int object)
+		{
+			int bin = std::min(BIN_COUNT - 1, (int)((centroids[object][bestAxis] - axisMin) * binScale));
+			return(bin <= bestSplit);
+		});
+	int leftCount = (int)(middle - (m_objects.begin() + first));
+
+	int child = (int)m_nodes.size();
+	NODE left;
+	left.bounds = EmptyBox();
+	left.firstObject = first;
+	left.objectCount = leftCount;
+	left.firstChild = -1;
+	NODE right = left;
+	right.firstObject = first + leftCount;
+	right.objectCount = count - leftCount;
+	m_nodes.push_back(left);
+	m_nodes.push_back(right);
+	m_parents.push_back(node);
+	m_parents.push_back(node);
+	m_nodes[node].firstChild = child;
+	return(true);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the objects.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_parents.clear();
+	m_objects.clear();
+	m_objectBounds.clear();
+	m_objectLeaves.clear();
+	m_dirtyLeaves.clear();
+	m_dirtyFlags.clear();
+	MemoryTracker::Release(this, 0);
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of objects.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetObjectCount() const
+{
+	return((int)m_objectBounds.size());
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of nodes.
+ ***********************************************************/
+int BoundingVolumeHierarchy::GetNodeCount() const
+{
+	return((int)m_nodes.size());
+}
+
+/***********************************************************
+ *  GetObjectBounds()
+ *
+ *  This method is used for getting the world bounds of an
+ *  object.
+ ***********************************************************/
+const BoundingVolumeHierarchy::AABB& BoundingVolumeHierarchy::GetObjectBounds(int object) const
+{
+	return(m_objectBounds[object]);
+}
+
+/***********************************************************
+ *  SetObjectBounds()
+ *
+ *  This method is used for setting the world bounds of an
+ *  object that moved.  The boxes above it are only updated
+ *  by the next Refit(), so many objects can move first.
+ ***********************************************************/
+void BoundingVolumeHierarchy::SetObjectBounds(int object, const AABB& bounds)
+{
+	m_objectBounds[object] = bounds;
+	int leaf = m_objectLeaves[object];
+	if (m_dirtyFlags[leaf] == 0)
+	{
+		m_dirtyFlags[leaf] = 1;
+		m_dirtyLeaves.push_back(leaf);
+	}
+}
+
+/***********************************************************
+ *  RefitNode()
+ *
+ *  This method is used for recomputing the box of a node
+ *  from its children, or from its objects for a leaf, and
+ *  returns whether the box changed.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::RefitNode(int node)
+{
+	NODE& current = m_nodes[node];
+	AABB bounds;
+	if (current.firstChild < 0)
+	{
+		bounds = EmptyBox();
+		for (int i = current.firstObject; i < current.firstObject + current.objectCount; i++)
+		{
+			GrowBox(bounds, m_objectBounds[m_objects[i]]);
+		}
+	}
+	else
+	{
+		bounds = m_nodes[current.firstChild].bounds;
+		GrowBox(bounds, m_nodes[current.firstChild + 1].bounds);
+	}
+
+	if ((bounds.min == current.bounds.min) && (bounds.max == current.bounds.max))
+	{
+		return(false);
+	}
+	current.bounds = bounds;
+	return(true);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the boxes above the
+ *  objects that moved.  Every box is recomputed exactly
+ *  from its children, so the walk up from a leaf stops at
+ *  the first box that did not change.
+ ***********************************************************/
+int BoundingVolumeHierarchy::Refit()
+{
+	int refitCount = 0;
+	for (size_t i = 0; i < m_dirtyLeaves.size(); i++)
+	{
+		int node = m_dirtyLeaves[i];
+		m_dirtyFlags[node] = 0;
+		while (node >= 0)
+		{
+			refitCount++;
+			if (RefitNode(node) == false)
+			{
+				break;
+			}
+			node = m_parents[node];
+		}
+	}
+	m_dirtyLeaves.clear();
+	return(refitCount);
+}
+
+/***********************************************************
+ *  Raycast()
+ *
+ *  This method is used for finding the closest object along
+ *  a ray.  The nearer child is visited first and a node is
+ *  skipped once a closer hit than its entry is known, so
+ *  only the nodes around the ray are visited.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::Raycast(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	const RAY_TEST& test,
+	RAY_HIT& hit) const
+{
+	hit.object = -1;
+	hit.distance = maxDistance;
+	if (m_nodes.empty() == true)
+	{
+		return(false);
+	}
+
+	glm::vec3 inverseDirection = 1.0f / direction;
+	int stack[MAX_DEPTH];
+	float stackEntries[MAX_DEPTH];
+	int stackSize = 0;
+
+	float entry = 0.0f;
+	if (IntersectBox(m_nodes[0].bounds, origin, inverseDirection, hit.distance, entry) == true)
+	{
+		stack[stackSize] = 0;
+		stackEntries[stackSize++] = entry;
+	}
+
+	while (stackSize > 0)
+	{
+		stackSize--;
+		if (stackEntries[stackSize] > hit.distance)
+		{
+			continue;
+		}
+		const NODE& node = m_nodes[stack[stackSize]];
+
+		if (node.firstChild < 0)
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				int object = m_objects[i];
+				if (IntersectBox(m_objectBounds[object], origin, inverseDirection, hit.distance, entry) == false)
+				{
+					continue;
+				}
+				float distance = entry;
+				if (test && (test(object, distance) == false))
+				{
+					continue;
+				}
+				if (distance <= hit.distance)
+				{
+					hit.object = object;
+					hit.distance = distance;
+				}
+			}
+			continue;
+		}
+
+		// push the farther child first, so the nearer one is
+		// taken off the stack next
+		float entries[2];
+		bool bHits[2];
+		for (int c = 0; c < 2; c++)
+		{
+			bHits[c] = IntersectBox(m_nodes[node.firstChild + c].bounds,
+				origin, inverseDirection, hit.distance, entries[c]);
+		}
+		int nearChild = (entries[1] < entries[0]) ? 1 : 0;
+		int farChild = 1 - nearChild;
+		if (bHits[farChild] == true)
+		{
+			stack[stackSize] = node.firstChild + farChild;
+			stackEntries[stackSize++] = entries[farChild];
+		}
+		if (bHits[nearChild] == true)
+		{
+			stack[stackSize] = node.firstChild + nearChild;
+			stackEntries[stackSize++] = entries[nearChild];
+		}
+	}
+
+	return(hit.object >= 0);
+}
+
+/***********************************************************
+ *  IntersectRay()
+ *
+ *  This method is used for getting the distance along a ray
+ *  where it enters a box, for the exact tests of objects
+ *  that are boxes in their own space.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::IntersectRay(
+	const AABB& box,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	float& distance)
+{
+	return(IntersectBox(box, origin, 1.0f / direction, maxDistance, distance));
+}
+
+/***********************************************************
+ *  IntersectTriangle()
+ *
+ *  This method is used for getting the distance along a ray
+ *  where it crosses a triangle from either side, with the
+ *  Moller-Trumbore test, for the exact tests of meshes.
+ ***********************************************************/
+bool BoundingVolumeHierarchy::IntersectTriangle(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	const glm::vec3& p0,
+	const glm::vec3& p1,
+	const glm::vec3& p2,
+	float& distance)
+{
+	glm::vec3 edge1 = p1 - p0;
+	glm::vec3 edge2 = p2 - p0;
+	glm::vec3 p = glm::cross(direction, edge2);
+	float determinant = glm::dot(edge1, p);
+	if (std::fabs(determinant) < 1e-12f)
+	{
+		return(false);
+	}
+
+	float inverseDeterminant = 1.0f / determinant;
+	glm::vec3 t = origin - p0;
+	float u = glm::dot(t, p) * inverseDeterminant;
+	if ((u < 0.0f) || (u > 1.0f))
+	{
+		return(false);
+	}
+	glm::vec3 q = glm::cross(t, edge1);
+	float v = glm::dot(direction, q) * inverseDeterminant;
+	if ((v < 0.0f) || (u + v > 1.0f))
+	{
+		return(false);
+	}
+	distance = glm::dot(edge2, q) * inverseDeterminant;
+	return(distance > 0.0f);
+}
+
+/***********************************************************
+ *  QueryBox()
+ *
+ *  This method is used for finding the objects whose boxes
+ *  overlap the passed in box.  The results are appended.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryBox(const AABB& box, std::vector<int>& results) const
+{
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	int stack[MAX_DEPTH];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const NODE& node = m_nodes[stack[--stackSize]];
+		if (BoxesOverlap(box, node.bounds) == false)
+		{
+			continue;
+		}
+
+		// every object of a subtree inside the box overlaps it
+		if ((node.firstChild < 0) || (BoxContains(box, node.bounds) == true))
+		{
+			bool bInside = (node.firstChild >= 0);
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				if ((bInside == true) || (BoxesOverlap(box, m_objectBounds[m_objects[i]]) == true))
+				{
+					results.push_back(m_objects[i]);
+				}
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.firstChild + 1;
+		stack[stackSize++] = node.firstChild;
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for finding the objects whose boxes
+ *  are not fully outside of any of the frustum planes, in
+ *  the same form as the culling planes of the scene.  The
+ *  planes a box is fully inside of are not tested again
+ *  below it.  The results are appended.
+ ***********************************************************/
+void BoundingVolumeHierarchy::QueryFrustum(const glm::vec4 planes[6], std::vector<int>& results) const
+{
+	const int ALL_PLANES = 0x3F;
+
+	if (m_nodes.empty() == true)
+	{
+		return;
+	}
+
+	int stack[MAX_DEPTH];
+	int stackMasks[MAX_DEPTH];
+	int stackSize = 0;
+	stack[stackSize] = 0;
+	stackMasks[stackSize++] = ALL_PLANES;
+	while (stackSize > 0)
+	{
+		stackSize--;
+		const NODE& node = m_nodes[stack[stackSize]];
+		int mask = stackMasks[stackSize];
+
+		// the bit of a plane is cleared once the box is inside it
+		glm::vec3 center = (node.bounds.min + node.bounds.max) * 0.5f;
+		glm::vec3 extent = (node.bounds.max - node.bounds.min) * 0.5f;
+		bool bOutside = false;
+		for (int plane = 0; (plane < 6) && (bOutside == false); plane++)
+		{
+			if ((mask & (1 << plane)) == 0)
+			{
+				continue;
+			}
+			glm::vec3 normal = glm::vec3(planes[plane]);
+			float distance = glm::dot(normal, center) + planes[plane].w;
+			float radius = glm::dot(glm::abs(normal), extent);
+			if (distance < -radius)
+			{
+				bOutside = true;
+			}
+			else if (distance >= radius)
+			{
+				mask &= ~(1 << plane);
+			}
+		}
+		if (bOutside == true)
+		{
+			continue;
+		}
+
+		if ((mask == 0) || (node.firstChild < 0))
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				int object = m_objects[i];
+				if (mask != 0)
+				{
+					// a leaf straddling a plane tests its objects
+					const AABB& bounds = m_objectBounds[object];
+					glm::vec3 objectCenter = (bounds.min + bounds.max) * 0.5f;
+					glm::vec3 objectExtent = (bounds.max - bounds.min) * 0.5f;
+					bool bObjectOutside = false;
+					for (int plane = 0; (plane < 6) && (bObjectOutside == false); plane++)
+					{
+						glm::vec3 normal = glm::vec3(planes[plane]);
+						bObjectOutside = ((mask & (1 << plane)) != 0) &&
+							(glm::dot(normal, objectCenter) + planes[plane].w < -glm::dot(glm::abs(normal), objectExtent));
+					}
+					if (bObjectOutside == true)
+					{
+						continue;
+					}
+				}
+				results.push_back(object);
+			}
+			continue;
+		}
+
+		stack[stackSize] = node.firstChild + 1;
+		stackMasks[stackSize++] = mask;
+		stack[stackSize] = node.firstChild;
+		stackMasks[stackSize++] = mask;
+	}
+}
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// spatial index over object bounding boxes for ray, box and frustum queries
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class keeps a binary tree of axis-aligned boxes over
+ *  the world-space bounds of the scene objects, so a query
+ *  only visits the objects near it instead of all of them.
+ *  The tree is split with the surface area heuristic over a
+ *  few bins per axis, and the objects of every subtree are
+ *  one contiguous range, so a subtree inside a query is
+ *  taken whole without visiting its nodes.
+ *
+ *  Moving objects only refit the boxes on the path from
+ *  their leaf to the root.  The tree keeps its shape, so it
+ *  should be built again when most objects moved far.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// axis-aligned box in world space
+	struct AABB
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	// closest object a ray hit
+	struct RAY_HIT
+	{
+		int object;
+		float distance;
+	};
+
+	// exact test of the ray against an object whose box it
+	// hit, setting the distance along the ray of a hit
+	typedef std::function<bool(int object, float& distance)> RAY_TEST;
+
+	// constructor
+	BoundingVolumeHierarchy();
+	// destructor
+	~BoundingVolumeHierarchy();
+
+private:
+	// bins per axis the splits are chosen from
+	static const int BIN_COUNT = 12;
+	// objects below this count may stay in one leaf
+	static const int MAX_LEAF_OBJECTS = 4;
+	// deepest tree, so the queries need no heap stack
+	static const int MAX_DEPTH = 64;
+
+	// one node, the children of an inner node are stored
+	// next to each other
+	struct NODE
+	{
+		AABB bounds;
+		// range of the subtree in the object order
+		int firstObject;
+		int objectCount;
+		// first of the two children, -1 for a leaf
+		int firstChild;
+	};
+
+	// nodes with the root first, parents before children
+	std::vector<NODE> m_nodes;
+	// parent of every node, -1 for the root
+	std::vector<int> m_parents;
+	// object indices in the order of the leaves
+	std::vector<int> m_objects;
+	// world bounds of every object
+	std::vector<AABB> m_objectBounds;
+	// leaf holding every object
+	std::vector<int> m_objectLeaves;
+	// leaves whose objects moved since the last refit
+	std::vector<int> m_dirtyLeaves;
+	std::vector<uint8_t> m_dirtyFlags;
+
+	// split a node into two children or keep it as a leaf
+	bool SplitNode(int node, int depth, std::vector<glm::vec3>& centroids);
+	// recompute the box of a node from its children or objects
+	bool RefitNode(int node);
+
+public:
+	// build the tree over the passed in object bounds
+	void Build(const AABB* pBounds, int objectCount);
+	// remove all of the objects
+	void Clear();
+
+	// get the number of objects
+	int GetObjectCount() const;
+	// get the number of nodes
+	int GetNodeCount() const;
+	// get the world bounds of an object
+	const AABB& GetObjectBounds(int object) const;
+
+	// set the world bounds of an object that moved
+	void SetObjectBounds(int object, const AABB& bounds);
+	// grow the boxes above the moved objects, returning the
+	// number of nodes that were refit
+	int Refit();
+
+	// find the closest object along a ray up to the passed in
+	// distance, testing the objects with the exact test or
+	// only their boxes when it is empty
+	bool Raycast(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		const RAY_TEST& test,
+		RAY_HIT& hit) const;
+	// get the distance along a ray where it enters a box, if
+	// it does before the passed in distance
+	static bool IntersectRay(
+		const AABB& box,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		float& distance);
+	// get the distance along a ray where it crosses a
+	// triangle, if it does
+	static bool IntersectTriangle(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const glm::vec3& p0,
+		const glm::vec3& p1,
+		const glm::vec3& p2,
+		float& distance);
+	// find the objects whose boxes overlap a box
+	void QueryBox(const AABB& box, std::vector<int>& results) const;
+	// find the objects whose boxes are not fully outside of
+	// any of the frustum planes
+	void QueryFrustum(const glm::vec4 planes[6], std::vector<int>& results) const;
+};
@@ -0,0 +1,532 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// render the scene offscreen at a resolution scaled to the GPU frame time
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+#include "MemoryTracker.h"
+
+#include <iostream>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// texture unit of the offscreen color target during the
+	// blit, above the 16 slots used by the scene textures
+	const int BLIT_TEXTURE_UNIT = 16;
+
+	// the scale is only changed when the GPU time leaves this
+	// band around the target, so it does not flicker
+	const float SCALE_DOWN_THRESHOLD = 1.05f;
+	const float SCALE_UP_THRESHOLD = 0.85f;
+	// largest change of the scale per frame
+	const float MAX_SCALE_STEP = 0.05f;
+	// weight of a new timer result in the smoothed GPU time
+	const float GPU_TIME_SMOOTHING = 0.2f;
+
+	// full screen triangle generated from the vertex index
+	const char* g_BlitVertexShader =
+		"#version 330 core\n"
+		"out vec2 fragUV;\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+		"	fragUV = corner;\n"
+		"	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);\n"
+		"}\n";
+
+	// bilinear upscale of the rendered part with a small
+	// unsharp mask to restore the edges lost to the scaling
+	const char* g_BlitFragmentShader =
+		"#version 330 core\n"
+		"in vec2 fragUV;\n"
+		"out vec4 fragmentColor;\n"
+		"uniform sampler2D sourceTexture;\n"
+		"uniform vec2 uvScale;\n"
+		"uniform vec2 uvClamp;\n"
+		"uniform vec2 texelSize;\n"
+		"uniform float sharpness;\n"
+		"vec3 Fetch(vec2 uv)\n"
+		"{\n"
+		"	return texture(sourceTexture, clamp(uv, texelSize * 0.5, uvClamp)).rgb;\n"
+		"}\n"
+		"void main()\n"
+		"{\n"
+		"	vec2 uv = fragUV * uvScale;\n"
+		"	vec3 center = Fetch(uv);\n"
+		"	if (sharpness > 0.0)\n"
+		"	{\n"
+		"		vec3 neighbors = Fetch(uv + vec2(texelSize.x, 0.0)) + Fetch(uv - vec2(texelSize.x, 0.0)) +\n"
+		"			Fetch(uv + vec2(0.0, texelSize.y)) + Fetch(uv - vec2(0.0, texelSize.y));\n"
+		"		center = clamp(center + sharpness * (4.0 * center - neighbors), 0.0, 1.0);\n"
+		"	}\n"
+		"	fragmentColor = vec4(center, 1.0);\n"
+		"}\n";
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DynamicResolution::DynamicResolution(GLStateCache* pStateCache, const RESOLUTION_SETTINGS& settings)
+{
+	m_pStateCache = pStateCache;
+	m_settings = settings;
+	if (m_settings.minScale < 0.25f)
+		m_settings.minScale = 0.25f;
+	if (m_settings.minScale > 1.0f)
+		m_settings.minScale = 1.0f;
+
+	m_framebuffer = 0;
+	m_colorTexture = 0;
+	m_depthBuffer = 0;
+	m_targetWidth = 0;
+	m_targetHeight = 0;
+	m_windowWidth = 0;
+	m_windowHeight = 0;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+	m_scale = 1.0f;
+	m_bOffscreen = false;
+
+	m_blitProgram = 0;
+	m_blitVertexArray = 0;
+	m_uvScaleLocation = -1;
+	m_uvClampLocation = -1;
+	m_texelSizeLocation = -1;
+	m_sharpnessLocation = -1;
+	m_sceneProgram = 0;
+
+	m_bTimerQueries = false;
+	m_bQueryActive = false;
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		m_queries[i] = 0;
+		m_bQueryPending[i] = false;
+	}
+	m_queryIndex = 0;
+	m_gpuFrameMs = 0.0f;
+}
+
+/***********************************************************
+ *  ~DynamicResolution()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DynamicResolution::~DynamicResolution()
+{
+	Destroy();
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for compiling one stage of the blit
+ *  program.  It returns 0 and prints the log on failure.
+ ***********************************************************/
+GLuint DynamicResolution::CompileShader(GLenum type, const char* source)
+{
+	GLuint shader = glCreateShader(type);
+	GLint bCompiled = GL_FALSE;
+
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &bCompiled);
+	if (bCompiled == GL_FALSE)
+	{
+		char infoLog[512];
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Failed to compile the resolution blit shader: " << infoLog << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	return(shader);
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the blit program and
+ *  the timer queries.  The program that is current when it
+ *  is called is restored after every blit.
+ ***********************************************************/
+bool DynamicResolution::Create()
+{
+	if (m_settings.bEnabled == false)
+	{
+		return(true);
+	}
+
+	GLint currentProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+	m_sceneProgram = (GLuint)currentProgram;
+
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, g_BlitVertexShader);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, g_BlitFragmentShader);
+	if ((vertexShader == 0) || (fragmentShader == 0))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		m_settings.bEnabled = false;
+		return(false);
+	}
+
+	m_blitProgram = glCreateProgram();
+	glAttachShader(m_blitProgram, vertexShader);
+	glAttachShader(m_blitProgram, fragmentShader);
+	glLinkProgram(m_blitProgram);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint bLinked = GL_FALSE;
+	glGetProgramiv(m_blitProgram, GL_LINK_STATUS, &bLinked);
+	if (bLinked == GL_FALSE)
+	{
+		char infoLog[512];
+		glGetProgramInfoLog(m_blitProgram, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Failed to link the resolution blit program: " << infoLog << std::endl;
+		glDeleteProgram(m_blitProgram);
+		m_blitProgram = 0;
+		m_settings.bEnabled = false;
+		return(false);
+	}
+
+	m_uvScaleLocation = glGetUniformLocation(m_blitProgram, "uvScale");
+	m_uvClampLocation = glGetUniformLocation(m_blitProgram, "uvClamp");
+	m_texelSizeLocation = glGetUniformLocation(m_blitProgram, "texelSize");
+	m_sharpnessLocation = glGetUniformLocation(m_blitProgram, "sharpness");
+
+	// the source texture unit never changes
+	m_pStateCache->UseProgram(m_blitProgram);
+	glUniform1i(glGetUniformLocation(m_blitProgram, "sourceTexture"), BLIT_TEXTURE_UNIT);
+	m_pStateCache->UseProgram(m_sceneProgram);
+
+	// the triangle has no vertex attributes, but a vertex
+	// array object must still be bound to draw it
+	glGenVertexArrays(1, &m_blitVertexArray);
+
+	// without timer queries the scene still renders offscreen,
+	// but the scale stays at full resolution
+	m_bTimerQueries = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query);
+	if (m_bTimerQueries == true)
+	{
+		glGenQueries(QUERY_COUNT, m_queries);
+	}
+	else
+	{
+		std::cout << "GPU timer queries are not supported, dynamic resolution stays at full scale" << std::endl;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing all of the OpenGL objects
+ *  owned by the class.
+ ***********************************************************/
+void DynamicResolution::Destroy()
+{
+	DestroyTarget();
+
+	if (m_blitProgram != 0)
+	{
+		glDeleteProgram(m_blitProgram);
+		m_blitProgram = 0;
+	}
+	if (m_blitVertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_blitVertexArray);
+		m_blitVertexArray = 0;
+	}
+	if (m_queries[0] != 0)
+	{
+		glDeleteQueries(QUERY_COUNT, m_queries);
+		for (int i = 0; i < QUERY_COUNT; i++)
+		{
+			m_queries[i] = 0;
+			m_bQueryPending[i] = false;
+		}
+	}
+}
+
+/***********************************************************
+ *  CreateTarget()
+ *
+ *  This method is used for creating the offscreen color and
+ *  depth target at the passed in window size.  The scaled
+ *  frames are rendered into its lower left corner, so it
+ *  only has to be recreated when the window is resized.
+ ***********************************************************/
+bool DynamicResolution::CreateTarget(int width, int height)
+{
+	DestroyTarget();
+
+	glGenTextures(1, &m_colorTexture);
+	m_pStateCache->BindTexture(BLIT_TEXTURE_UNIT, m_colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenRenderbuffers(1, &m_depthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Failed to create the " << width << "x" << height
+			<< " offscreen target, status " << status << std::endl;
+		DestroyTarget();
+		m_settings.bEnabled = false;
+		return(false);
+	}
+
+	m_targetWidth = width;
+	m_targetHeight = height;
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_RENDER_TARGET,
+		"offscreen color", (size_t)width * height * 4);
+	MemoryTracker::Track(this, 1, MemoryTracker::MEMORY_RENDER_TARGET,
+		"offscreen depth and stencil", (size_t)width * height * 4);
+	return(true);
+}
+
+/***********************************************************
+ *  DestroyTarget()
+ *
+ *  This method is used for freeing the offscreen target.
+ ***********************************************************/
+void DynamicResolution::DestroyTarget()
+{
+	if (m_framebuffer != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (m_colorTexture != 0)
+	{
+		glDeleteTextures(1, &m_colorTexture);
+		m_colorTexture = 0;
+		m_pStateCache->InvalidateTextures();
+	}
+	if (m_depthBuffer != 0)
+	{
+		glDeleteRenderbuffers(1, &m_depthBuffer);
+		m_depthBuffer = 0;
+	}
+	m_targetWidth = 0;
+	m_targetHeight = 0;
+	MemoryTracker::Release(this, 0);
+	MemoryTracker::Release(this, 1);
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used for reading the timer queries that
+ *  have finished, without waiting for the others, and moving
+ *  the scale towards the one that fits the target frame
+ *  time.  The GPU time grows with the pixel count, which is
+ *  the square of the scale.
+ ***********************************************************/
+void DynamicResolution::UpdateScale()
+{
+	if (m_bTimerQueries == false)
+	{
+		return;
+	}
+
+	bool bNewResult = false;
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		if (m_bQueryPending[i] == false)
+		{
+			continue;
+		}
+
+		GLint bAvailable = GL_FALSE;
+		glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable == GL_FALSE)
+		{
+			continue;
+		}
+
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &elapsed);
+		m_bQueryPending[i] = false;
+
+		float frameMs = (float)((double)elapsed / 1000000.0);
+		if (m_gpuFrameMs <= 0.0f)
+			m_gpuFrameMs = frameMs;
+		else
+			m_gpuFrameMs += (frameMs - m_gpuFrameMs) * GPU_TIME_SMOOTHING;
+		bNewResult = true;
+	}
+
+	if ((bNewResult == false) || (m_gpuFrameMs <= 0.0f))
+	{
+		return;
+	}
+
+	if ((m_gpuFrameMs > m_settings.targetFrameMs * SCALE_DOWN_THRESHOLD) ||
+		(m_gpuFrameMs < m_settings.targetFrameMs * SCALE_UP_THRESHOLD))
+	{
+		float scale = m_scale * sqrtf(m_settings.targetFrameMs / m_gpuFrameMs);
+		if (scale > m_scale + MAX_SCALE_STEP)
+			scale = m_scale + MAX_SCALE_STEP;
+		if (scale < m_scale - MAX_SCALE_STEP)
+			scale = m_scale - MAX_SCALE_STEP;
+		if (scale > 1.0f)
+			scale = 1.0f;
+		if (scale < m_settings.minScale)
+			scale = m_settings.minScale;
+		m_scale = scale;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for binding the offscreen target at
+ *  the current scale and starting the GPU timer, before the
+ *  scene is rendered.  When dynamic resolution is off, the
+ *  scene renders straight into the window.
+ ***********************************************************/
+void DynamicResolution::BeginFrame(int windowWidth, int windowHeight)
+{
+	m_windowWidth = windowWidth;
+	m_windowHeight = windowHeight;
+	m_bOffscreen = false;
+
+	if ((m_settings.bEnabled == false) || (windowWidth <= 0) || (windowHeight <= 0))
+	{
+		m_pStateCache->Viewport(0, 0, windowWidth, windowHeight);
+		return;
+	}
+
+	if ((windowWidth != m_targetWidth) || (windowHeight != m_targetHeight))
+	{
+		if (CreateTarget(windowWidth, windowHeight) == false)
+		{
+			m_pStateCache->Viewport(0, 0, windowWidth, windowHeight);
+			return;
+		}
+	}
+
+	UpdateScale();
+	m_renderWidth = (int)(windowWidth * m_scale + 0.5f);
+	m_renderHeight = (int)(windowHeight * m_scale + 0.5f);
+	if (m_renderWidth < 1)
+		m_renderWidth = 1;
+	if (m_renderHeight < 1)
+		m_renderHeight = 1;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	m_pStateCache->Viewport(0, 0, m_renderWidth, m_renderHeight);
+
+	// skip the timing of this frame if the query in this slot
+	// has not come back yet
+	m_bQueryActive = false;
+	if ((m_bTimerQueries == true) && (m_bQueryPending[m_queryIndex] == false))
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_queries[m_queryIndex]);
+		m_bQueryActive = true;
+	}
+
+	m_bOffscreen = true;
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for stopping the GPU timer and
+ *  drawing the rendered part of the offscreen target over
+ *  the whole window, sharpened by how far it was scaled.
+ ***********************************************************/
+void DynamicResolution::EndFrame()
+{
+	if (m_bOffscreen == false)
+	{
+		return;
+	}
+
+	if (m_bQueryActive == true)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_bQueryPending[m_queryIndex] = true;
+		m_queryIndex = (m_queryIndex + 1) % QUERY_COUNT;
+		m_bQueryActive = false;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	m_pStateCache->Viewport(0, 0, m_windowWidth, m_windowHeight);
+	m_pStateCache->Disable(GL_DEPTH_TEST);
+	m_pStateCache->Disable(GL_BLEND);
+
+	// sharpen more the further the frame was scaled down
+	float sharpness = 0.0f;
+	if ((m_scale < 1.0f) && (m_settings.minScale < 1.0f))
+	{
+		sharpness = m_settings.sharpness * (1.0f - m_scale) / (1.0f - m_settings.minScale);
+	}
+
+	m_pStateCache->UseProgram(m_blitProgram);
+	m_pStateCache->BindTexture(BLIT_TEXTURE_UNIT, m_colorTexture);
+	glUniform2f(m_uvScaleLocation,
+		(float)m_renderWidth / (float)m_targetWidth,
+		(float)m_renderHeight / (float)m_targetHeight);
+	glUniform2f(m_uvClampLocation,
+		((float)m_renderWidth - 0.5f) / (float)m_targetWidth,
+		((float)m_renderHeight - 0.5f) / (float)m_targetHeight);
+	glUniform2f(m_texelSizeLocation, 1.0f / (float)m_targetWidth, 1.0f / (float)m_targetHeight);
+	glUniform1f(m_sharpnessLocation, sharpness);
+
+	m_pStateCache->BindVertexArray(m_blitVertexArray);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	m_pStateCache->UseProgram(m_sceneProgram);
+}
+
+/***********************************************************
+ *  GetScale()
+ *
+ *  This method is used for getting the current scale of the
+ *  window size per axis.
+ ***********************************************************/
+float DynamicResolution::GetScale() const
+{
+	return(m_scale);
+}
+
+/***********************************************************
+ *  PrintFrameStats()
+ *
+ *  This method is used for printing the current scale and
+ *  the smoothed GPU frame time.
+ ***********************************************************/
+void DynamicResolution::PrintFrameStats() const
+{
+	if (m_settings.bEnabled == false)
+	{
+		return;
+	}
+
+	std::cout << "Dynamic resolution: scale " << m_scale << " ("
+		<< m_renderWidth << "x" << m_renderHeight << "), GPU "
+		<< m_gpuFrameMs << " ms / target " << m_settings.targetFrameMs << " ms" << std::endl;
+}
@@ -0,0 +1,117 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// render the scene offscreen at a resolution scaled to the GPU frame time
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "GLStateCache.h"
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class owns an offscreen color and depth target that
+ *  the scene is rendered into.  Only part of the target is
+ *  used, scaled down from the window size whenever the GPU
+ *  time measured with timer queries goes over the target
+ *  frame time, and scaled back up when there is headroom.
+ *  The used part is then upscaled and sharpened into the
+ *  default framebuffer.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// controller settings, changed from the command line
+	struct RESOLUTION_SETTINGS
+	{
+		// render offscreen and scale the resolution
+		bool bEnabled;
+		// GPU time per frame that the controller holds, in ms
+		float targetFrameMs;
+		// smallest allowed scale of the window size per axis
+		float minScale;
+		// strength of the sharpen filter at the smallest scale
+		float sharpness;
+	};
+
+	// constructor
+	DynamicResolution(GLStateCache* pStateCache, const RESOLUTION_SETTINGS& settings);
+	// destructor
+	~DynamicResolution();
+
+private:
+	// number of timer queries in flight, so results are read
+	// a few frames late instead of stalling the pipeline
+	static const int QUERY_COUNT = 4;
+
+	// pointer to the state cache object
+	GLStateCache* m_pStateCache;
+	RESOLUTION_SETTINGS m_settings;
+
+	// offscreen target, sized to the window at full scale
+	GLuint m_framebuffer;
+	GLuint m_colorTexture;
+	GLuint m_depthBuffer;
+	int m_targetWidth;
+	int m_targetHeight;
+
+	// size of the window and of the rendered part this frame
+	int m_windowWidth;
+	int m_windowHeight;
+	int m_renderWidth;
+	int m_renderHeight;
+	// current scale of the window size per axis
+	float m_scale;
+	// this frame is rendered into the offscreen target
+	bool m_bOffscreen;
+
+	// upscale and sharpen program drawn as one triangle
+	GLuint m_blitProgram;
+	GLuint m_blitVertexArray;
+	GLint m_uvScaleLocation;
+	GLint m_uvClampLocation;
+	GLint m_texelSizeLocation;
+	GLint m_sharpnessLocation;
+	// program that was current before the blit
+	GLuint m_sceneProgram;
+
+	// ring of GPU timer queries
+	bool m_bTimerQueries;
+	GLuint m_queries[QUERY_COUNT];
+	bool m_bQueryPending[QUERY_COUNT];
+	int m_queryIndex;
+	// a query was started for this frame
+	bool m_bQueryActive;
+	// smoothed GPU time of the rendered frames, in ms
+	float m_gpuFrameMs;
+
+	// compile one stage of the blit program
+	GLuint CompileShader(GLenum type, const char* source);
+	// create or resize the offscreen target for the window
+	bool CreateTarget(int width, int height);
+	// free the offscreen target
+	void DestroyTarget();
+	// read the finished timer queries and adjust the scale
+	void UpdateScale();
+
+public:
+	// create the blit program and timer queries
+	bool Create();
+	// free all of the OpenGL objects
+	void Destroy();
+
+	// bind the offscreen target at the current scale, before
+	// the scene is rendered
+	void BeginFrame(int windowWidth, int windowHeight);
+	// upscale the rendered part into the default framebuffer
+	void EndFrame();
+
+	// get the current scale of the window size per axis
+	float GetScale() const;
+	// print the scale and the measured GPU frame time
+	void PrintFrameStats() const;
+};
@@ -0,0 +1,225 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// notice when a file on disk has been written
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <iostream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_writeTime = 0;
+	m_notifyDescriptor = -1;
+	m_watchDescriptor = -1;
+	m_changeHandle = NULL;
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  GetWriteTime()
+ *
+ *  This method is used for getting the modification time of
+ *  a file, or 0 when the file does not exist.  The time
+ *  keeps the sub-second part, so two saves within the same
+ *  second still get different times.
+ ***********************************************************/
+long long FileWatcher::GetWriteTime(const char* path)
+{
+#ifdef _WIN32
+	// the file time counts 100 nanosecond steps, so saves in
+	// quick succession still get different times
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (GetFileAttributesExA(path, GetFileExInfoStandard, &attributes) == FALSE)
+	{
+		return(0);
+	}
+	return(((long long)attributes.ftLastWriteTime.dwHighDateTime << 32) |
+		attributes.ftLastWriteTime.dwLowDateTime);
+#else
+	// nanoseconds since the epoch
+	struct stat status;
+	if (stat(path, &status) != 0)
+	{
+		return(0);
+	}
+#ifdef __APPLE__
+	return(((long long)status.st_mtimespec.tv_sec * 1000000000LL) + status.st_mtimespec.tv_nsec);
+#else
+	return(((long long)status.st_mtim.tv_sec * 1000000000LL) + status.st_mtim.tv_nsec);
+#endif
+#endif
+}
+
+/***********************************************************
+ *  Watch()
+ *
+ *  This method is used for starting to watch a file.  The
+ *  directory is watched rather than the file itself, since
+ *  most editors save by writing a new file and renaming it
+ *  over the old one.
+ ***********************************************************/
+bool FileWatcher::Watch(const char* path)
+{
+	Stop();
+
+	m_path = path;
+	size_t separator = m_path.find_last_of("/\\");
+	std::string directory = (separator == std::string::npos) ? "." : m_path.substr(0, separator);
+	m_name = (separator == std::string::npos) ? m_path : m_path.substr(separator + 1);
+	m_writeTime = GetWriteTime(path);
+
+#ifdef _WIN32
+	HANDLE change = FindFirstChangeNotificationA(directory.c_str(), FALSE,
+		FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE);
+	if (change == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Could not watch directory:" << directory << std::endl;
+		return(false);
+	}
+	m_changeHandle = change;
+#elif defined(__linux__)
+	m_notifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_notifyDescriptor >= 0)
+	{
+		m_watchDescriptor = inotify_add_watch(m_notifyDescriptor, directory.c_str(),
+			IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	}
+	if (m_watchDescriptor < 0)
+	{
+		std::cout << "Could not watch directory:" << directory << std::endl;
+		Stop();
+		return(false);
+	}
+#endif
+
+	return(true);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for releasing the notification
+ *  handles of the watched directory.
+ ***********************************************************/
+void FileWatcher::Stop()
+{
+#ifdef _WIN32
+	if (NULL != m_changeHandle)
+	{
+		FindCloseChangeNotification((HANDLE)m_changeHandle);
+	}
+#elif defined(__linux__)
+	if (m_notifyDescriptor >= 0)
+	{
+		// closing the instance also removes the watch
+		close(m_notifyDescriptor);
+	}
+#endif
+
+	m_changeHandle = NULL;
+	m_notifyDescriptor = -1;
+	m_watchDescriptor = -1;
+}
+
+/***********************************************************
+ *  PollChanged()
+ *
+ *  This method is used for checking without blocking whether
+ *  the watched file was written since the last check.  The
+ *  notifications only say that something in the directory
+ *  changed, so the modification time decides whether it was
+ *  the watched file.
+ ***********************************************************/
+bool FileWatcher::PollChanged()
+{
+	if (m_path.empty())
+	{
+		return(false);
+	}
+
+	bool bNotified = false;
+#ifdef _WIN32
+	if (NULL == m_changeHandle)
+	{
+		return(false);
+	}
+	if (WaitForSingleObject((HANDLE)m_changeHandle, 0) == WAIT_OBJECT_0)
+	{
+		bNotified = true;
+		FindNextChangeNotification((HANDLE)m_changeHandle);
+	}
+#elif defined(__linux__)
+	if (m_notifyDescriptor < 0)
+	{
+		return(false);
+	}
+
+	// drain every pending event, the buffer is aligned for
+	// the event structure as the inotify manual requires
+	alignas(struct inotify_event) char buffer[4096];
+	ssize_t length;
+	while ((length = read(m_notifyDescriptor, buffer, sizeof(buffer))) > 0)
+	{
+		for (char* pEvent = buffer; pEvent < buffer + length;)
+		{
+			const struct inotify_event* event = (const struct inotify_event*)pEvent;
+			if ((event->len > 0) && (m_name == event->name))
+			{
+				bNotified = true;
+			}
+			pEvent += sizeof(struct inotify_event) + event->len;
+		}
+	}
+#else
+	bNotified = true;
+#endif
+
+	if (bNotified == false)
+	{
+		return(false);
+	}
+
+	// a file that is still missing mid-save is not reported,
+	// and neither is one that kept its time unless inotify
+	// named it, since some file systems keep coarse times
+	long long writeTime = GetWriteTime(m_path.c_str());
+#ifdef __linux__
+	if (writeTime == 0)
+#else
+	if ((writeTime == 0) || (writeTime == m_writeTime))
+#endif
+	{
+		return(false);
+	}
+
+	m_writeTime = writeTime;
+	return(true);
+}
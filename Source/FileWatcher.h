@@ -0,0 +1,51 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// notice when a file on disk has been written
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class watches the directory of one file and reports
+ *  when that file was written or replaced.  It uses inotify
+ *  on Linux and change notifications on Windows, and falls
+ *  back to comparing the modification time elsewhere.  The
+ *  check never blocks, so it can run once per frame.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+private:
+	// full path and file name part of the watched file
+	std::string m_path;
+	std::string m_name;
+	// modification time when the file was last reported
+	long long m_writeTime;
+	// inotify instance and watch on Linux
+	int m_notifyDescriptor;
+	int m_watchDescriptor;
+	// change notification handle on Windows
+	void* m_changeHandle;
+
+public:
+	// start watching a file, replacing the previous one
+	bool Watch(const char* path);
+	// stop watching
+	void Stop();
+	// check whether the file was written since the last call
+	bool PollChanged();
+
+	// get the modification time of a file, 0 when it is missing
+	static long long GetWriteTime(const char* path);
+};
@@ -0,0 +1,556 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.cpp
+// ============
+// read rendered frames back asynchronously and write them as images
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameCapture.h"
+#include "MemoryTracker.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// longest run of a TGA packet
+	const int TGA_MAX_RUN = 128;
+}
+
+/***********************************************************
+ *  FrameCapture()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameCapture::FrameCapture(int writerCount)
+{
+	for (int i = 0; i < BUFFER_COUNT; i++)
+	{
+		m_readbacks[i].buffer = 0;
+		m_readbacks[i].bufferSize = 0;
+		m_readbacks[i].fence = 0;
+		m_readbacks[i].width = 0;
+		m_readbacks[i].height = 0;
+	}
+	m_nextReadback = 0;
+	m_bSupported = false;
+	m_bBusy = false;
+
+	m_sequenceFrames = 0;
+	m_sequenceIndex = 0;
+	m_screenshotRequests = 0;
+	m_screenshotIndex = 0;
+
+	m_writerCount = (writerCount > 0) ? writerCount : 1;
+	m_imageCount = 0;
+	m_bStopping = false;
+
+	m_stats.captured = 0;
+	m_stats.stalls = 0;
+	m_stats.dropped = 0;
+	m_stats.readbackMs = 0.0;
+	m_imagesWritten = 0;
+	m_writeFailures = 0;
+}
+
+/***********************************************************
+ *  ~FrameCapture()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameCapture::~FrameCapture()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for checking that fence syncs are
+ *  supported and starting the writer threads.  Without
+ *  fences every capture would stall, so nothing is captured.
+ ***********************************************************/
+bool FrameCapture::Create()
+{
+	m_bSupported = (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+	if (m_bSupported == false)
+	{
+		std::cout << "Fence syncs are not supported, frames are not captured" << std::endl;
+		return(false);
+	}
+
+	GLuint buffers[BUFFER_COUNT];
+	glGenBuffers(BUFFER_COUNT, buffers);
+	for (int i = 0; i < BUFFER_COUNT; i++)
+	{
+		m_readbacks[i].buffer = buffers[i];
+	}
+
+	m_bStopping = false;
+	for (int i = 0; i < m_writerCount; i++)
+	{
+		m_writers.push_back(std::thread(&FrameCapture::WriterMain, this));
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for finishing the captures that are
+ *  still in flight, waiting until the writers have written
+ *  every image, and freeing the buffers.  It must run on the
+ *  thread that owns the OpenGL context.
+ ***********************************************************/
+void FrameCapture::Destroy()
+{
+	if (m_bSupported == true)
+	{
+		// oldest first, so the images are queued in order
+		for (int i = 0; i < BUFFER_COUNT; i++)
+		{
+			CollectReadback((m_nextReadback + i) % BUFFER_COUNT, true);
+		}
+		for (int i = 0; i < BUFFER_COUNT; i++)
+		{
+			if (m_readbacks[i].buffer != 0)
+			{
+				glDeleteBuffers(1, &m_readbacks[i].buffer);
+				m_readbacks[i].buffer = 0;
+			}
+			m_readbacks[i].bufferSize = 0;
+			MemoryTracker::Release(this, i);
+		}
+		m_bBusy = false;
+		m_bSupported = false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_bStopping = true;
+	}
+	m_condition.notify_all();
+	for (size_t i = 0; i < m_writers.size(); i++)
+	{
+		m_writers[i].join();
+	}
+	m_writers.clear();
+
+	for (size_t i = 0; i < m_freeImages.size(); i++)
+	{
+		delete m_freeImages[i];
+	}
+	m_freeImages.clear();
+	for (int i = 0; i < m_imageCount; i++)
+	{
+		MemoryTracker::Release(this, BUFFER_COUNT + i);
+	}
+	m_imageCount = 0;
+}
+
+/***********************************************************
+ *  StartSequence()
+ *
+ *  This method is used for capturing every following frame
+ *  into numbered files after the prefix, for the passed in
+ *  number of frames or -1 until StopSequence() is called.
+ ***********************************************************/
+void FrameCapture::StartSequence(const char* prefix, int frameCount)
+{
+	m_sequencePrefix = prefix;
+	m_sequenceFrames = (frameCount > 0) ? frameCount : -1;
+	m_sequenceIndex = 0;
+	UpdateBusy();
+}
+
+/***********************************************************
+ *  StopSequence()
+ *
+ *  This method is used for stopping the image sequence.
+ ***********************************************************/
+void FrameCapture::StopSequence()
+{
+	m_sequenceFrames = 0;
+}
+
+/***********************************************************
+ *  RequestScreenshot()
+ *
+ *  This method is used for capturing the next rendered frame
+ *  as a screenshot.  It may be called from the main thread
+ *  while the render thread captures.
+ ***********************************************************/
+void FrameCapture::RequestScreenshot()
+{
+	m_screenshotRequests++;
+}
+
+/***********************************************************
+ *  CaptureFrame()
+ *
+ *  This method is used for collecting the readbacks that
+ *  finished and starting the readback of the current frame
+ *  when it is captured.  The copy into the pixel pack buffer
+ *  is queued on the GPU, so this returns right away unless
+ *  the whole ring is still in flight.
+ ***********************************************************/
+void FrameCapture::CaptureFrame(int width, int height)
+{
+	if ((m_bSupported == false) || (width <= 0) || (height <= 0))
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// hand the finished readbacks to the writers, oldest first
+	for (int i = 0; i < BUFFER_COUNT; i++)
+	{
+		CollectReadback((m_nextReadback + i) % BUFFER_COUNT, false);
+	}
+
+	// name the frame if it is captured at all
+	char filename[512];
+	filename[0] = '\0';
+	if (m_screenshotRequests > 0)
+	{
+		m_screenshotRequests--;
+		snprintf(filename, sizeof(filename), "screenshot_%04d.tga", m_screenshotIndex++);
+	}
+	else if (m_sequenceFrames != 0)
+	{
+		snprintf(filename, sizeof(filename), "%s%06d.tga", m_sequencePrefix.c_str(), m_sequenceIndex++);
+		if (m_sequenceFrames > 0)
+		{
+			m_sequenceFrames--;
+		}
+	}
+	if (filename[0] == '\0')
+	{
+		UpdateBusy();
+		m_stats.readbackMs += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+		return;
+	}
+
+	// only wait when the GPU is a whole ring behind
+	READBACK& readback = m_readbacks[m_nextReadback];
+	if (readback.fence != 0)
+	{
+		CollectReadback(m_nextReadback, true);
+		m_stats.stalls++;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	size_t size = (size_t)width * height * 4;
+	if (readback.bufferSize != size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		readback.bufferSize = size;
+		MemoryTracker::Track(this, m_nextReadback, MemoryTracker::MEMORY_READBACK_BUFFER,
+			"frame capture buffer", size);
+	}
+
+	// BGRA is the layout of the window on most drivers, so the
+	// copy needs no conversion, and it is also the TGA layout
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.width = width;
+	readback.height = height;
+	readback.filename = filename;
+	m_nextReadback = (m_nextReadback + 1) % BUFFER_COUNT;
+	m_stats.captured++;
+	UpdateBusy();
+
+	m_stats.readbackMs += std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+/***********************************************************
+ *  IsBusy()
+ *
+ *  This method is used for checking whether the requested
+ *  captures still need frames.  A readback is only collected
+ *  by a later CaptureFrame() call, so in on-demand mode the
+ *  main loop keeps rendering while this is true, or else a
+ *  screenshot would wait for the next input event.
+ ***********************************************************/
+bool FrameCapture::IsBusy() const
+{
+	return((m_bBusy == true) || (m_screenshotRequests > 0));
+}
+
+/***********************************************************
+ *  UpdateBusy()
+ *
+ *  This method is used for noting whether a sequence is
+ *  running or any buffer of the ring is still in flight.
+ ***********************************************************/
+void FrameCapture::UpdateBusy()
+{
+	bool bBusy = (m_bSupported == true) && (m_sequenceFrames != 0);
+	for (int i = 0; (i < BUFFER_COUNT) && (bBusy == false); i++)
+	{
+		bBusy = (m_readbacks[i].fence != 0);
+	}
+	m_bBusy = bBusy;
+}
+
+/***********************************************************
+ *  CollectReadback()
+ *
+ *  This method is used for copying the pixels out of a pixel
+ *  pack buffer whose fence has signaled and queueing them
+ *  for the writers.  A buffer that is still in flight is
+ *  skipped, unless the caller asked to wait for it.
+ ***********************************************************/
+bool FrameCapture::CollectReadback(int index, bool bWait)
+{
+	READBACK& readback = m_readbacks[index];
+	if (readback.fence == 0)
+	{
+		return(false);
+	}
+
+	GLbitfield flags = (bWait == true) ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+	GLuint64 timeout = (bWait == true) ? GL_TIMEOUT_IGNORED : 0;
+	GLenum result = glClientWaitSync(readback.fence, flags, timeout);
+	if ((result != GL_ALREADY_SIGNALED) && (result != GL_CONDITION_SATISFIED))
+	{
+		// a failed wait would never succeed, so drop the frame
+		if ((bWait == false) && (result == GL_TIMEOUT_EXPIRED))
+		{
+			return(false);
+		}
+		glDeleteSync(readback.fence);
+		readback.fence = 0;
+		std::cout << "Could not read back " << readback.filename << std::endl;
+		return(false);
+	}
+	glDeleteSync(readback.fence);
+	readback.fence = 0;
+
+	// the writers are behind, so the frame is dropped rather
+	// than stalling the render thread or growing the memory
+	IMAGE* pImage = AcquireImage();
+	if (NULL == pImage)
+	{
+		m_stats.dropped++;
+		return(false);
+	}
+	size_t size = (size_t)readback.width * readback.height * 4;
+	if (pImage->pixels.size() != size)
+	{
+		pImage->pixels.resize(size);
+		MemoryTracker::Track(this, BUFFER_COUNT + pImage->trackerId, MemoryTracker::MEMORY_IMAGE_DATA,
+			"frame capture image", size);
+	}
+	pImage->width = readback.width;
+	pImage->height = readback.height;
+	pImage->filename = readback.filename;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	const void* pPixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+	bool bMapped = (NULL != pPixels);
+	if (bMapped == true)
+	{
+		memcpy(&pImage->pixels[0], pPixels, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (bMapped == true)
+		{
+			m_queue.push_back(pImage);
+		}
+		else
+		{
+			m_freeImages.push_back(pImage);
+		}
+	}
+	if (bMapped == false)
+	{
+		std::cout << "Could not map the readback of " << readback.filename << std::endl;
+		return(false);
+	}
+	m_condition.notify_one();
+	return(true);
+}
+
+/***********************************************************
+ *  AcquireImage()
+ *
+ *  This method is used for taking an image that a writer has
+ *  finished with, or allocating a new one.  The number of
+ *  images only grows while the writers fall behind, up to
+ *  one per writer and MAX_QUEUED_IMAGES waiting, and is NULL
+ *  once they are all in use.
+ ***********************************************************/
+FrameCapture::IMAGE* FrameCapture::AcquireImage()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (m_freeImages.empty() == false)
+		{
+			IMAGE* pImage = m_freeImages.back();
+			m_freeImages.pop_back();
+			return(pImage);
+		}
+	}
+	if (m_imageCount >= m_writerCount + MAX_QUEUED_IMAGES)
+	{
+		return(NULL);
+	}
+
+	IMAGE* pImage = new IMAGE();
+	pImage->width = 0;
+	pImage->height = 0;
+	pImage->trackerId = m_imageCount++;
+	return(pImage);
+}
+
+/***********************************************************
+ *  WriterMain()
+ *
+ *  This method is the main loop of the writer threads.  It
+ *  encodes and writes the queued images, and returns them to
+ *  the free list.
+ ***********************************************************/
+void FrameCapture::WriterMain()
+{
+	for (;;)
+	{
+		IMAGE* pImage = NULL;
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_condition.wait(lock, [this]() { return (m_bStopping || !m_queue.empty()); });
+			if (m_queue.empty() == true)
+			{
+				// stopping, and every image is written
+				return;
+			}
+			pImage = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		if (WriteImage(*pImage) == true)
+		{
+			m_imagesWritten++;
+		}
+		else
+		{
+			m_writeFailures++;
+		}
+
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_freeImages.push_back(pImage);
+	}
+}
+
+/***********************************************************
+ *  WriteImage()
+ *
+ *  This method is used for writing an image as a 24-bit TGA
+ *  file with run-length encoding.  TGA stores the bottom row
+ *  first in BGR order, so the pixels are written the way
+ *  OpenGL read them.
+ ***********************************************************/
+bool FrameCapture::WriteImage(const IMAGE& image)
+{
+	FILE* pFile = fopen(image.filename.c_str(), "wb");
+	if (NULL == pFile)
+	{
+		std::cout << "Could not write image:" << image.filename << std::endl;
+		return(false);
+	}
+
+	unsigned char header[18];
+	memset(header, 0, sizeof(header));
+	// run-length encoded true color, bottom-left origin
+	header[2] = 10;
+	header[12] = (unsigned char)(image.width & 0xff);
+	header[13] = (unsigned char)((image.width >> 8) & 0xff);
+	header[14] = (unsigned char)(image.height & 0xff);
+	header[15] = (unsigned char)((image.height >> 8) & 0xff);
+	header[16] = 24;
+	bool bWritten = (fwrite(header, 1, sizeof(header), pFile) == sizeof(header));
+
+	// packets do not cross rows, as the format recommends
+	std::vector<unsigned char> row;
+	row.reserve((size_t)image.width * 4 + (image.width / TGA_MAX_RUN) + 1);
+	for (int y = 0; (y < image.height) && (bWritten == true); y++)
+	{
+		const unsigned char* pRow = &image.pixels[(size_t)y * image.width * 4];
+		row.clear();
+		int x = 0;
+		while (x < image.width)
+		{
+			// count the pixels equal to this one
+			int run = 1;
+			while ((x + run < image.width) && (run < TGA_MAX_RUN) &&
+				(memcmp(pRow + (x * 4), pRow + ((x + run) * 4), 3) == 0))
+			{
+				run++;
+			}
+
+			if (run > 1)
+			{
+				row.push_back((unsigned char)(0x80 | (run - 1)));
+				row.insert(row.end(), pRow + (x * 4), pRow + (x * 4) + 3);
+				x += run;
+				continue;
+			}
+
+			// gather the pixels up to the next run of two
+			int count = 1;
+			while ((x + count < image.width) && (count < TGA_MAX_RUN) &&
+				((x + count + 1 >= image.width) ||
+					(memcmp(pRow + ((x + count) * 4), pRow + ((x + count + 1) * 4), 3) != 0)))
+			{
+				count++;
+			}
+			row.push_back((unsigned char)(count - 1));
+			for (int i = 0; i < count; i++)
+			{
+				row.insert(row.end(), pRow + ((x + i) * 4), pRow + ((x + i) * 4) + 3);
+			}
+			x += count;
+		}
+		bWritten = (fwrite(&row[0], 1, row.size(), pFile) == row.size());
+	}
+
+	fclose(pFile);
+	return(bWritten);
+}
+
+/***********************************************************
+ *  PrintFrameStats()
+ *
+ *  This method is used for printing the captured, stalled,
+ *  dropped and written frames, and the average time a
+ *  capture takes on the render thread.
+ ***********************************************************/
+void FrameCapture::PrintFrameStats() const
+{
+	if (m_stats.captured == 0)
+	{
+		return;
+	}
+
+	std::cout << "Frame capture: " << m_stats.captured << " captured, "
+		<< m_stats.stalls << " stalls, "
+		<< m_stats.dropped << " dropped, "
+		<< m_imagesWritten << " written, "
+		<< m_writeFailures << " failed, "
+		<< (m_stats.readbackMs / m_stats.captured) << " ms per capture on the render thread"
+		<< std::endl;
+}
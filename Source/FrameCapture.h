@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////
+// framecapture.h
+// ============
+// read rendered frames back asynchronously and write them as images
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FrameCapture
+ *
+ *  This class captures screenshots and image sequences of
+ *  the window without stalling the render loop.  A captured
+ *  frame is copied into one of a ring of pixel pack buffers
+ *  and a fence is placed behind the copy.  The buffer is
+ *  only mapped a few frames later, once its fence has
+ *  signaled, so the GPU never has to catch up with the CPU.
+ *  The pixels are then handed to writer threads that encode
+ *  and write the TGA files.
+ *
+ *  Only when every buffer of the ring is still in flight
+ *  does a capture wait for the oldest one.  The images
+ *  waiting for the writers are limited, so when the disk
+ *  falls behind, frames are dropped instead of the memory
+ *  growing.
+ ***********************************************************/
+class FrameCapture
+{
+public:
+	// constructor, the writers are started in Create()
+	FrameCapture(int writerCount);
+	// destructor
+	~FrameCapture();
+
+private:
+	// pixel pack buffers in flight, so the readback completes
+	// a few frames late instead of stalling the pipeline
+	static const int BUFFER_COUNT = 3;
+	// images waiting for a writer on top of the ones being
+	// written, later frames are dropped until one is free
+	static const int MAX_QUEUED_IMAGES = 4;
+
+	// one pixel pack buffer of the ring
+	struct READBACK
+	{
+		GLuint buffer;
+		size_t bufferSize;
+		// placed behind the copy, 0 when the buffer is free
+		GLsync fence;
+		int width;
+		int height;
+		std::string filename;
+	};
+
+	// pixels of a finished readback waiting for a writer,
+	// BGRA with the bottom row first as OpenGL reads them
+	struct IMAGE
+	{
+		std::vector<unsigned char> pixels;
+		int width;
+		int height;
+		std::string filename;
+		// memory tracker id, after the ids of the buffers
+		int trackerId;
+	};
+
+	// counts since the capture was created
+	struct CAPTURE_STATS
+	{
+		int captured;
+		int stalls;
+		// read back while every image was in use, not written
+		int dropped;
+		// time spent on the render thread issuing and
+		// collecting the readbacks
+		double readbackMs;
+	};
+
+	// ring of pixel pack buffers
+	READBACK m_readbacks[BUFFER_COUNT];
+	// ring index of the next capture
+	int m_nextReadback;
+	// a sequence is running or a readback is in flight, so
+	// more frames have to be rendered to finish the captures
+	std::atomic<bool> m_bBusy;
+	// fence syncs and pixel pack buffers are available
+	bool m_bSupported;
+
+	// file name prefix of the image sequence
+	std::string m_sequencePrefix;
+	// frames left to capture, -1 for no end, 0 when stopped
+	int m_sequenceFrames;
+	int m_sequenceIndex;
+	// screenshots requested by the main thread
+	std::atomic<int> m_screenshotRequests;
+	int m_screenshotIndex;
+
+	// writer threads and the images waiting for them
+	int m_writerCount;
+	std::vector<std::thread> m_writers;
+	std::deque<IMAGE*> m_queue;
+	// written images kept to reuse their memory
+	std::vector<IMAGE*> m_freeImages;
+	int m_imageCount;
+	// the writers are asked to finish
+	bool m_bStopping;
+	std::mutex m_lock;
+	std::condition_variable m_condition;
+
+	// counts of the render thread and of the writers
+	CAPTURE_STATS m_stats;
+	std::atomic<int> m_imagesWritten;
+	std::atomic<int> m_writeFailures;
+
+	// map a buffer whose fence has signaled and queue its
+	// pixels, waiting for the fence when asked to
+	bool CollectReadback(int index, bool bWait);
+	// update whether the captures need more frames
+	void UpdateBusy();
+	// take an image from the free list or allocate one, NULL
+	// when all the images are in use
+	IMAGE* AcquireImage();
+	// main loop of the writer threads
+	void WriterMain();
+	// encode an image as a run-length compressed TGA file
+	static bool WriteImage(const IMAGE& image);
+
+public:
+	// check the OpenGL support and start the writer threads
+	bool Create();
+	// finish the captures in flight, wait for the writers and
+	// free the buffers
+	void Destroy();
+
+	// capture every following frame as prefix000000.tga and
+	// up, frameCount frames or -1 until stopped
+	void StartSequence(const char* prefix, int frameCount);
+	// stop capturing the image sequence
+	void StopSequence();
+	// capture the next frame as a screenshot, from any thread
+	void RequestScreenshot();
+
+	// read the frame in the default framebuffer back, after
+	// the frame is drawn and before the buffers are swapped
+	void CaptureFrame(int width, int height);
+	// check whether frames still have to be rendered for the
+	// requested captures to be written, from any thread
+	bool IsBusy() const;
+
+	// print the capture counts and the average time a capture
+	// takes on the render thread
+	void PrintFrameStats() const;
+};
@@ -0,0 +1,283 @@
+///////////////////////////////////////////////////////////////////////////////
+// framescheduler.cpp
+// ============
+// pace the main loop and skip frames when nothing on screen has changed
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameScheduler.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+// declaration of global variables
+namespace
+{
+	// the scheduler that receives the window callbacks
+	FrameScheduler* g_pScheduler = nullptr;
+
+	// current state of the display window
+	bool gWindowFocused = true;
+	bool gWindowIconified = false;
+
+	// the last part of a wait is spun instead of slept, since
+	// the operating system may wake a sleeping thread late
+	constexpr double SPIN_SECONDS = 0.002;
+	// longest block while minimized, so close requests are seen
+	constexpr double ICONIFIED_WAIT_SECONDS = 0.25;
+	// longest block in on-demand mode while the caller polls
+	// for changes that do not arrive as window events
+	constexpr double POLLING_WAIT_SECONDS = 0.1;
+}
+
+/***********************************************************
+ *  FrameScheduler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameScheduler::FrameScheduler(const FRAME_SETTINGS& settings)
+{
+	m_settings = settings;
+	m_pWindow = NULL;
+	m_bRedrawRequested = true;
+	m_lastFrameStart = Clock::now();
+	g_pScheduler = this;
+
+#ifdef _WIN32
+	// raise the timer resolution so short sleeps are accurate
+	timeBeginPeriod(1);
+#endif
+}
+
+/***********************************************************
+ *  ~FrameScheduler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameScheduler::~FrameScheduler()
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+	m_pWindow = NULL;
+	g_pScheduler = nullptr;
+}
+
+/***********************************************************
+ *  AttachWindow()
+ *
+ *  This method is used for attaching the scheduler to the
+ *  display window.  The window's OpenGL context must be
+ *  current so the swap interval can be applied.
+ ***********************************************************/
+void FrameScheduler::AttachWindow(GLFWwindow* window)
+{
+	m_pWindow = window;
+
+	glfwSwapInterval(m_settings.bVSync ? 1 : 0);
+
+	// these callbacks are used to throttle or skip rendering
+	glfwSetWindowFocusCallback(window, &FrameScheduler::Window_Focus_Callback);
+	glfwSetWindowIconifyCallback(window, &FrameScheduler::Window_Iconify_Callback);
+	glfwSetWindowRefreshCallback(window, &FrameScheduler::Window_Refresh_Callback);
+}
+
+/***********************************************************
+ *  GetSettings()
+ *
+ *  This method is used for getting the active settings.
+ ***********************************************************/
+const FrameScheduler::FRAME_SETTINGS& FrameScheduler::GetSettings() const
+{
+	return(m_settings);
+}
+
+/***********************************************************
+ *  Window_Focus_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the display window gains or loses the input focus.
+ ***********************************************************/
+void FrameScheduler::Window_Focus_Callback(GLFWwindow* window, int focused)
+{
+	gWindowFocused = (focused != 0);
+	if (NULL != g_pScheduler)
+	{
+		g_pScheduler->RequestRedraw();
+	}
+}
+
+/***********************************************************
+ *  Window_Iconify_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the display window is minimized or restored.
+ ***********************************************************/
+void FrameScheduler::Window_Iconify_Callback(GLFWwindow* window, int iconified)
+{
+	gWindowIconified = (iconified != 0);
+	if (NULL != g_pScheduler)
+	{
+		g_pScheduler->RequestRedraw();
+	}
+}
+
+/***********************************************************
+ *  Window_Refresh_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the contents of the display window need to be redrawn,
+ *  for example after it was uncovered or resized.
+ ***********************************************************/
+void FrameScheduler::Window_Refresh_Callback(GLFWwindow* window)
+{
+	if (NULL != g_pScheduler)
+	{
+		g_pScheduler->RequestRedraw();
+	}
+}
+
+/***********************************************************
+ *  RequestRedraw()
+ *
+ *  This method is used for asking for a new frame, for
+ *  example after the camera or the scene has changed.
+ ***********************************************************/
+void FrameScheduler::RequestRedraw()
+{
+	m_bRedrawRequested = true;
+}
+
+/***********************************************************
+ *  GetFramePeriod()
+ *
+ *  This method is used for getting the minimum time between
+ *  two frames in seconds, or 0 when frames are not capped.
+ ***********************************************************/
+double FrameScheduler::GetFramePeriod() const
+{
+	float fps = m_settings.maxFPS;
+
+	// an unfocused window does not need the full frame rate
+	if ((gWindowFocused == false) && (m_settings.unfocusedFPS > 0.0f))
+	{
+		if ((fps <= 0.0f) || (m_settings.unfocusedFPS < fps))
+			fps = m_settings.unfocusedFPS;
+	}
+
+	if (fps <= 0.0f)
+	{
+		return(0.0);
+	}
+	return(1.0 / fps);
+}
+
+/***********************************************************
+ *  WaitUntil()
+ *
+ *  This method is used for waiting until the deadline.  It
+ *  sleeps for most of the time and spins for the last part
+ *  to hit the deadline precisely.
+ ***********************************************************/
+void FrameScheduler::WaitUntil(Clock::time_point deadline) const
+{
+	const Clock::duration spin = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(SPIN_SECONDS));
+
+	Clock::time_point now = Clock::now();
+	if (deadline - now > spin)
+	{
+		std::this_thread::sleep_for(deadline - now - spin);
+	}
+	while (Clock::now() < deadline)
+	{
+		std::this_thread::yield();
+	}
+}
+
+/***********************************************************
+ *  WaitForEvents()
+ *
+ *  This method is used for processing the pending window
+ *  events.  In on-demand mode, and while minimized, it blocks
+ *  until an event arrives unless a redraw is pending or the
+ *  caller needs to keep rendering (e.g. a key is held down).
+ *  While the caller is polling for changes that are not
+ *  window events (e.g. a watched file), the on-demand block
+ *  ends after a short timeout so they are still picked up.
+ ***********************************************************/
+void FrameScheduler::WaitForEvents(bool bKeepRendering, bool bPolling)
+{
+	if (gWindowIconified == true)
+	{
+		// nothing is visible, so only wake up for events
+		glfwWaitEventsTimeout(ICONIFIED_WAIT_SECONDS);
+	}
+	else if ((m_settings.bOnDemand == true) &&
+		(m_bRedrawRequested == false) &&
+		(bKeepRendering == false))
+	{
+		if (bPolling == true)
+		{
+			glfwWaitEventsTimeout(POLLING_WAIT_SECONDS);
+		}
+		else
+		{
+			glfwWaitEvents();
+		}
+	}
+	else
+	{
+		glfwPollEvents();
+	}
+
+	if (bKeepRendering == true)
+	{
+		m_bRedrawRequested = true;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for deciding whether a frame should
+ *  be rendered now.  It returns false when the window is
+ *  minimized, or in on-demand mode when nothing changed.
+ ***********************************************************/
+bool FrameScheduler::BeginFrame()
+{
+	if (gWindowIconified == true)
+	{
+		return(false);
+	}
+	if ((m_settings.bOnDemand == true) && (m_bRedrawRequested == false))
+	{
+		return(false);
+	}
+
+	m_bRedrawRequested = false;
+	m_lastFrameStart = Clock::now();
+	return(true);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for waiting out the remainder of the
+ *  frame period after the buffers were swapped.
+ ***********************************************************/
+void FrameScheduler::EndFrame()
+{
+	double period = GetFramePeriod();
+	if (period > 0.0)
+	{
+		WaitUntil(m_lastFrameStart + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>(period)));
+	}
+}
@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+// framescheduler.h
+// ============
+// pace the main loop and skip frames when nothing on screen has changed
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <chrono>
+
+/***********************************************************
+ *  FrameScheduler
+ *
+ *  This class decides when the main loop renders a frame.
+ *  It supports vsync, a frame rate cap that sleeps and then
+ *  spins to the exact deadline, and an on-demand mode that
+ *  blocks in glfwWaitEvents until something has changed.
+ *  Unfocused windows are throttled and minimized windows
+ *  are not rendered at all.
+ ***********************************************************/
+class FrameScheduler
+{
+public:
+	// settings for pacing the main loop
+	struct FRAME_SETTINGS
+	{
+		// synchronize the buffer swaps with the display refresh
+		bool bVSync;
+		// maximum frames per second, 0 for no cap
+		float maxFPS;
+		// only render when the scene, camera or window changed
+		bool bOnDemand;
+		// maximum frames per second while the window is unfocused
+		float unfocusedFPS;
+	};
+
+	// constructor
+	FrameScheduler(const FRAME_SETTINGS& settings);
+	// destructor
+	~FrameScheduler();
+
+	// window event callbacks that drive the throttling
+	static void Window_Focus_Callback(GLFWwindow* window, int focused);
+	static void Window_Iconify_Callback(GLFWwindow* window, int iconified);
+	static void Window_Refresh_Callback(GLFWwindow* window);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	// active pacing settings
+	FRAME_SETTINGS m_settings;
+	// window whose events are processed
+	GLFWwindow* m_pWindow;
+	// a new frame has to be rendered
+	bool m_bRedrawRequested;
+	// time the last rendered frame was started
+	Clock::time_point m_lastFrameStart;
+
+	// get the frame period for the current window state
+	double GetFramePeriod() const;
+	// sleep and then spin until the passed in deadline
+	void WaitUntil(Clock::time_point deadline) const;
+
+public:
+	// attach to the display window and apply the swap interval
+	void AttachWindow(GLFWwindow* window);
+	// get the active pacing settings
+	const FRAME_SETTINGS& GetSettings() const;
+
+	// ask for a new frame to be rendered
+	void RequestRedraw();
+	// process the pending window events, blocking in on-demand
+	// mode until there is something to render, or briefly
+	// while the caller polls for other changes
+	void WaitForEvents(bool bKeepRendering, bool bPolling);
+	// returns true when a frame should be rendered now
+	bool BeginFrame();
+	// wait out the rest of the frame period after the swap
+	void EndFrame();
+};
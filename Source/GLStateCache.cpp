@@ -0,0 +1,421 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.cpp
+// ============
+// shadow the OpenGL pipeline state and filter redundant state calls
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GLStateCache.h"
+
+#include <iostream>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// printable names of the tracked state calls
+	const char* g_CallNames[GLStateCache::CALL_COUNT] =
+	{
+		"glEnable/glDisable",
+		"glBlendFunc",
+		"glDepthFunc",
+		"glDepthMask",
+		"glClearColor",
+		"glViewport",
+		"glUseProgram",
+		"glBindVertexArray",
+		"glActiveTexture",
+		"glBindTexture"
+	};
+}
+
+/***********************************************************
+ *  GLStateCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+GLStateCache::GLStateCache()
+{
+	m_capabilityCount = 0;
+	for (int i = 0; i < MAX_CAPABILITIES; i++)
+	{
+		m_capabilities[i] = 0;
+		m_capabilityStates[i] = -1;
+	}
+
+	Invalidate();
+
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+	memset(&m_lastFrameStats, 0, sizeof(m_lastFrameStats));
+}
+
+/***********************************************************
+ *  ~GLStateCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+GLStateCache::~GLStateCache()
+{
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all of the shadowed
+ *  state, so that the next call of every kind is issued.
+ ***********************************************************/
+void GLStateCache::Invalidate()
+{
+	for (int i = 0; i < m_capabilityCount; i++)
+	{
+		m_capabilityStates[i] = -1;
+	}
+	m_bBlendFuncKnown = false;
+	m_bDepthFuncKnown = false;
+	m_bDepthMaskKnown = false;
+	m_bClearColorKnown = false;
+	m_bViewportKnown = false;
+	m_bProgramKnown = false;
+	m_bActiveTextureKnown = false;
+	InvalidateVertexArray();
+	InvalidateTextures();
+}
+
+/***********************************************************
+ *  InvalidateTextures()
+ *
+ *  This method is used for forgetting the shadowed texture
+ *  bindings of all the texture units.
+ ***********************************************************/
+void GLStateCache::InvalidateTextures()
+{
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		m_bTextureKnown[i] = false;
+		m_textures[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  InvalidateVertexArray()
+ *
+ *  This method is used for forgetting the shadowed vertex
+ *  array binding, after code outside of the cache bound one.
+ ***********************************************************/
+void GLStateCache::InvalidateVertexArray()
+{
+	m_bVertexArrayKnown = false;
+	m_vertexArray = 0;
+}
+
+/***********************************************************
+ *  FindCapability()
+ *
+ *  This method is used for finding the shadow slot for the
+ *  passed in capability.  Returns -1 when all slots are used.
+ ***********************************************************/
+int GLStateCache::FindCapability(GLenum capability)
+{
+	for (int i = 0; i < m_capabilityCount; i++)
+	{
+		if (m_capabilities[i] == capability)
+		{
+			return(i);
+		}
+	}
+
+	if (m_capabilityCount < MAX_CAPABILITIES)
+	{
+		m_capabilities[m_capabilityCount] = capability;
+		m_capabilityStates[m_capabilityCount] = -1;
+		m_capabilityCount++;
+		return(m_capabilityCount - 1);
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  CountCall()
+ *
+ *  This method is used for counting a state call as either
+ *  issued to the driver or filtered out.
+ ***********************************************************/
+void GLStateCache::CountCall(STATE_CALL call, bool bIssued)
+{
+	if (bIssued == true)
+		m_frameStats.issued[call]++;
+	else
+		m_frameStats.filtered[call]++;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for closing the counters of the last
+ *  frame and starting to count a new one.
+ ***********************************************************/
+void GLStateCache::BeginFrame()
+{
+	m_lastFrameStats = m_frameStats;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+}
+
+/***********************************************************
+ *  GetLastFrameStats()
+ *
+ *  This method is used for getting the counters of the last
+ *  completed frame.
+ ***********************************************************/
+const GLStateCache::FRAME_STATS& GLStateCache::GetLastFrameStats() const
+{
+	return(m_lastFrameStats);
+}
+
+/***********************************************************
+ *  PrintFrameStats()
+ *
+ *  This method is used for printing the issued and filtered
+ *  call counters of the last completed frame.
+ ***********************************************************/
+void GLStateCache::PrintFrameStats() const
+{
+	int totalIssued = 0;
+	int totalFiltered = 0;
+
+	std::cout << "GL state calls (issued/filtered):";
+	for (int i = 0; i < CALL_COUNT; i++)
+	{
+		totalIssued += m_lastFrameStats.issued[i];
+		totalFiltered += m_lastFrameStats.filtered[i];
+		if ((m_lastFrameStats.issued[i] > 0) || (m_lastFrameStats.filtered[i] > 0))
+		{
+			std::cout << " " << g_CallNames[i] << " " << m_lastFrameStats.issued[i]
+				<< "/" << m_lastFrameStats.filtered[i];
+		}
+	}
+	std::cout << " | total " << totalIssued << "/" << totalFiltered << std::endl;
+}
+
+/***********************************************************
+ *  Enable()
+ *
+ *  This method is used for enabling a capability when it is
+ *  not already enabled.
+ ***********************************************************/
+void GLStateCache::Enable(GLenum capability)
+{
+	int slot = FindCapability(capability);
+	bool bIssue = (slot < 0) || (m_capabilityStates[slot] != 1);
+
+	if (bIssue == true)
+	{
+		glEnable(capability);
+		if (slot >= 0)
+			m_capabilityStates[slot] = 1;
+	}
+	CountCall(CALL_ENABLE, bIssue);
+}
+
+/***********************************************************
+ *  Disable()
+ *
+ *  This method is used for disabling a capability when it is
+ *  not already disabled.
+ ***********************************************************/
+void GLStateCache::Disable(GLenum capability)
+{
+	int slot = FindCapability(capability);
+	bool bIssue = (slot < 0) || (m_capabilityStates[slot] != 0);
+
+	if (bIssue == true)
+	{
+		glDisable(capability);
+		if (slot >= 0)
+			m_capabilityStates[slot] = 0;
+	}
+	CountCall(CALL_ENABLE, bIssue);
+}
+
+/***********************************************************
+ *  BlendFunc()
+ *
+ *  This method is used for setting the blend factors.
+ ***********************************************************/
+void GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+	bool bIssue = (m_bBlendFuncKnown == false) ||
+		(m_blendSource != source) || (m_blendDestination != destination);
+
+	if (bIssue == true)
+	{
+		glBlendFunc(source, destination);
+		m_blendSource = source;
+		m_blendDestination = destination;
+		m_bBlendFuncKnown = true;
+	}
+	CountCall(CALL_BLEND_FUNC, bIssue);
+}
+
+/***********************************************************
+ *  DepthFunc()
+ *
+ *  This method is used for setting the depth comparison.
+ ***********************************************************/
+void GLStateCache::DepthFunc(GLenum func)
+{
+	bool bIssue = (m_bDepthFuncKnown == false) || (m_depthFunc != func);
+
+	if (bIssue == true)
+	{
+		glDepthFunc(func);
+		m_depthFunc = func;
+		m_bDepthFuncKnown = true;
+	}
+	CountCall(CALL_DEPTH_FUNC, bIssue);
+}
+
+/***********************************************************
+ *  DepthMask()
+ *
+ *  This method is used for enabling or disabling depth
+ *  buffer writes.
+ ***********************************************************/
+void GLStateCache::DepthMask(GLboolean bWrite)
+{
+	bool bIssue = (m_bDepthMaskKnown == false) || (m_depthMask != bWrite);
+
+	if (bIssue == true)
+	{
+		glDepthMask(bWrite);
+		m_depthMask = bWrite;
+		m_bDepthMaskKnown = true;
+	}
+	CountCall(CALL_DEPTH_MASK, bIssue);
+}
+
+/***********************************************************
+ *  ClearColor()
+ *
+ *  This method is used for setting the color buffer clear
+ *  value.
+ ***********************************************************/
+void GLStateCache::ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+{
+	bool bIssue = (m_bClearColorKnown == false) ||
+		(m_clearColor[0] != red) || (m_clearColor[1] != green) ||
+		(m_clearColor[2] != blue) || (m_clearColor[3] != alpha);
+
+	if (bIssue == true)
+	{
+		glClearColor(red, green, blue, alpha);
+		m_clearColor[0] = red;
+		m_clearColor[1] = green;
+		m_clearColor[2] = blue;
+		m_clearColor[3] = alpha;
+		m_bClearColorKnown = true;
+	}
+	CountCall(CALL_CLEAR_COLOR, bIssue);
+}
+
+/***********************************************************
+ *  Viewport()
+ *
+ *  This method is used for setting the viewport rectangle.
+ ***********************************************************/
+void GLStateCache::Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	bool bIssue = (m_bViewportKnown == false) ||
+		(m_viewport[0] != x) || (m_viewport[1] != y) ||
+		(m_viewport[2] != width) || (m_viewport[3] != height);
+
+	if (bIssue == true)
+	{
+		glViewport(x, y, width, height);
+		m_viewport[0] = x;
+		m_viewport[1] = y;
+		m_viewport[2] = width;
+		m_viewport[3] = height;
+		m_bViewportKnown = true;
+	}
+	CountCall(CALL_VIEWPORT, bIssue);
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making a shader program current.
+ ***********************************************************/
+void GLStateCache::UseProgram(GLuint program)
+{
+	bool bIssue = (m_bProgramKnown == false) || (m_program != program);
+
+	if (bIssue == true)
+	{
+		glUseProgram(program);
+		m_program = program;
+		m_bProgramKnown = true;
+	}
+	CountCall(CALL_USE_PROGRAM, bIssue);
+}
+
+/***********************************************************
+ *  BindVertexArray()
+ *
+ *  This method is used for binding a vertex array object.
+ ***********************************************************/
+void GLStateCache::BindVertexArray(GLuint vertexArray)
+{
+	bool bIssue = (m_bVertexArrayKnown == false) || (m_vertexArray != vertexArray);
+
+	if (bIssue == true)
+	{
+		glBindVertexArray(vertexArray);
+		m_vertexArray = vertexArray;
+		m_bVertexArrayKnown = true;
+	}
+	CountCall(CALL_BIND_VERTEX_ARRAY, bIssue);
+}
+
+/***********************************************************
+ *  ActiveTexture()
+ *
+ *  This method is used for selecting the active texture unit.
+ ***********************************************************/
+void GLStateCache::ActiveTexture(int unit)
+{
+	bool bIssue = (m_bActiveTextureKnown == false) || (m_activeTextureUnit != unit);
+
+	if (bIssue == true)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_activeTextureUnit = unit;
+		m_bActiveTextureKnown = true;
+	}
+	CountCall(CALL_ACTIVE_TEXTURE, bIssue);
+}
+
+/***********************************************************
+ *  BindTexture()
+ *
+ *  This method is used for binding a 2D texture to a texture
+ *  unit.  The active unit is only switched when the binding
+ *  actually changes.
+ ***********************************************************/
+void GLStateCache::BindTexture(int unit, GLuint texture)
+{
+	bool bIssue = (unit < 0) || (unit >= MAX_TEXTURE_UNITS) ||
+		(m_bTextureKnown[unit] == false) || (m_textures[unit] != texture);
+
+	if (bIssue == true)
+	{
+		ActiveTexture(unit);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		if ((unit >= 0) && (unit < MAX_TEXTURE_UNITS))
+		{
+			m_textures[unit] = texture;
+			m_bTextureKnown[unit] = true;
+		}
+	}
+	CountCall(CALL_BIND_TEXTURE, bIssue);
+}
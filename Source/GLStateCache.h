@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// glstatecache.h
+// ============
+// shadow the OpenGL pipeline state and filter redundant state calls
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  GLStateCache
+ *
+ *  This class keeps a CPU-side copy of the OpenGL state it
+ *  has set and skips calls that would not change anything.
+ *  Code outside of the cache that changes the same state
+ *  must call Invalidate() so the next call is issued again.
+ ***********************************************************/
+class GLStateCache
+{
+public:
+	// constructor
+	GLStateCache();
+	// destructor
+	~GLStateCache();
+
+	// categories of the tracked state calls
+	enum STATE_CALL
+	{
+		CALL_ENABLE,
+		CALL_BLEND_FUNC,
+		CALL_DEPTH_FUNC,
+		CALL_DEPTH_MASK,
+		CALL_CLEAR_COLOR,
+		CALL_VIEWPORT,
+		CALL_USE_PROGRAM,
+		CALL_BIND_VERTEX_ARRAY,
+		CALL_ACTIVE_TEXTURE,
+		CALL_BIND_TEXTURE,
+		CALL_COUNT
+	};
+
+	// issued versus filtered call counters for one frame
+	struct FRAME_STATS
+	{
+		int issued[CALL_COUNT];
+		int filtered[CALL_COUNT];
+	};
+
+	// the number of texture units that are shadowed
+	static const int MAX_TEXTURE_UNITS = 32;
+
+private:
+	// capabilities that are shadowed by the cache
+	static const int MAX_CAPABILITIES = 8;
+	GLenum m_capabilities[MAX_CAPABILITIES];
+	// -1 unknown, 0 disabled, 1 enabled
+	int m_capabilityStates[MAX_CAPABILITIES];
+	int m_capabilityCount;
+
+	// shadowed state values, only valid when the matching
+	// known flag is true
+	bool m_bBlendFuncKnown;
+	GLenum m_blendSource;
+	GLenum m_blendDestination;
+	bool m_bDepthFuncKnown;
+	GLenum m_depthFunc;
+	bool m_bDepthMaskKnown;
+	GLboolean m_depthMask;
+	bool m_bClearColorKnown;
+	GLfloat m_clearColor[4];
+	bool m_bViewportKnown;
+	GLint m_viewport[4];
+	bool m_bProgramKnown;
+	GLuint m_program;
+	bool m_bVertexArrayKnown;
+	GLuint m_vertexArray;
+	bool m_bActiveTextureKnown;
+	int m_activeTextureUnit;
+	bool m_bTextureKnown[MAX_TEXTURE_UNITS];
+	GLuint m_textures[MAX_TEXTURE_UNITS];
+
+	// counters for the current and the last completed frame
+	FRAME_STATS m_frameStats;
+	FRAME_STATS m_lastFrameStats;
+
+	// find the slot for a capability, adding it when needed
+	int FindCapability(GLenum capability);
+	// count a call as issued or filtered
+	void CountCall(STATE_CALL call, bool bIssued);
+
+public:
+	// forget all shadowed state so the next calls are issued
+	void Invalidate();
+	// forget the shadowed texture bindings
+	void InvalidateTextures();
+	// forget the shadowed vertex array binding
+	void InvalidateVertexArray();
+
+	// start counting a new frame
+	void BeginFrame();
+	// get the counters of the last completed frame
+	const FRAME_STATS& GetLastFrameStats() const;
+	// print the counters of the last completed frame
+	void PrintFrameStats() const;
+
+	// filtered versions of the OpenGL state calls
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void BlendFunc(GLenum source, GLenum destination);
+	void DepthFunc(GLenum func);
+	void DepthMask(GLboolean bWrite);
+	void ClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+	void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	void UseProgram(GLuint program);
+	void BindVertexArray(GLuint vertexArray);
+	void ActiveTexture(int unit);
+	void BindTexture(int unit, GLuint texture);
+};
@@ -0,0 +1,269 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// run small jobs on a pool of worker threads with work stealing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+// declaration of global variables
+namespace
+{
+	// index of the job deque owned by the current thread
+	thread_local int t_threadIndex = 0;
+}
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(int workerCount)
+{
+	if (workerCount < 0)
+	{
+		workerCount = (int)std::thread::hardware_concurrency() - 1;
+		if (workerCount < 0)
+			workerCount = 0;
+	}
+
+	m_bRunning = true;
+	m_pendingJobs = 0;
+
+	for (int i = 0; i <= workerCount; i++)
+	{
+		m_queues.push_back(new WORK_QUEUE());
+	}
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, i + 1));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_sleepLock);
+		m_bRunning = false;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	for (size_t i = 0; i < m_queues.size(); i++)
+	{
+		delete m_queues[i];
+	}
+	m_queues.clear();
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads
+ *  that run jobs, including the outside thread.
+ ***********************************************************/
+int JobSystem::GetThreadCount() const
+{
+	return((int)m_queues.size());
+}
+
+/***********************************************************
+ *  GetThreadIndex()
+ *
+ *  This method is used for getting the index of the calling
+ *  thread, which can be used to select per-thread buffers.
+ ***********************************************************/
+int JobSystem::GetThreadIndex()
+{
+	return(t_threadIndex);
+}
+
+/***********************************************************
+ *  PopJob()
+ *
+ *  This method is used for taking the most recently pushed
+ *  job from the deque owned by the passed in thread.
+ ***********************************************************/
+bool JobSystem::PopJob(int threadIndex, JOB& job)
+{
+	WORK_QUEUE* pQueue = m_queues[threadIndex];
+	std::lock_guard<std::mutex> guard(pQueue->lock);
+
+	if (pQueue->jobs.empty())
+	{
+		return(false);
+	}
+
+	job = pQueue->jobs.back();
+	pQueue->jobs.pop_back();
+	m_pendingJobs--;
+	return(true);
+}
+
+/***********************************************************
+ *  StealJob()
+ *
+ *  This method is used for taking the oldest job from one of
+ *  the other threads' deques, starting with the next thread.
+ ***********************************************************/
+bool JobSystem::StealJob(int threadIndex, JOB& job)
+{
+	int queueCount = (int)m_queues.size();
+
+	for (int i = 1; i < queueCount; i++)
+	{
+		WORK_QUEUE* pQueue = m_queues[(threadIndex + i) % queueCount];
+		std::lock_guard<std::mutex> guard(pQueue->lock);
+
+		if (pQueue->jobs.empty() == false)
+		{
+			job = pQueue->jobs.front();
+			pQueue->jobs.pop_front();
+			m_pendingJobs--;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  RunOneJob()
+ *
+ *  This method is used for running one job from the thread's
+ *  own deque, or a stolen one when its deque is empty.
+ ***********************************************************/
+bool JobSystem::RunOneJob(int threadIndex)
+{
+	JOB job;
+
+	if ((PopJob(threadIndex, job) == false) &&
+		(StealJob(threadIndex, job) == false))
+	{
+		return(false);
+	}
+
+	job.function();
+	if (NULL != job.pCounter)
+	{
+		(*job.pCounter)--;
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is the main loop of a worker thread.  It runs
+ *  jobs while there are any and sleeps when all deques are
+ *  empty.
+ ***********************************************************/
+void JobSystem::WorkerMain(int threadIndex)
+{
+	t_threadIndex = threadIndex;
+
+	while (m_bRunning)
+	{
+		if (RunOneJob(threadIndex) == false)
+		{
+			std::unique_lock<std::mutex> lock(m_sleepLock);
+			m_wakeCondition.wait(lock, [this]()
+				{ return (m_pendingJobs > 0) || (m_bRunning == false); });
+		}
+	}
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for pushing a job onto the calling
+ *  thread's deque.  The counter is decremented once the job
+ *  has finished running.
+ ***********************************************************/
+void JobSystem::Submit(const JOB_FUNCTION& job, std::atomic<int>* pCounter)
+{
+	WORK_QUEUE* pQueue = m_queues[t_threadIndex];
+	JOB queued;
+
+	queued.function = job;
+	queued.pCounter = pCounter;
+	{
+		std::lock_guard<std::mutex> guard(pQueue->lock);
+		pQueue->jobs.push_back(queued);
+		m_pendingJobs++;
+	}
+
+	// the sleep lock orders the wake up after the worker's check
+	{
+		std::lock_guard<std::mutex> guard(m_sleepLock);
+	}
+	m_wakeCondition.notify_one();
+}
+
+/***********************************************************
+ *  Wait()
+ *
+ *  This method is used for waiting until the counter drops
+ *  to zero.  The calling thread runs jobs while it waits.
+ ***********************************************************/
+void JobSystem::Wait(std::atomic<int>* pCounter)
+{
+	while (*pCounter > 0)
+	{
+		if (RunOneJob(t_threadIndex) == false)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running the body over the range
+ *  [0, count) split into chunks of up to grainSize items.
+ *  Ranges that fit in one chunk run on the calling thread.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int grainSize, const RANGE_FUNCTION& body)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if (grainSize < 1)
+	{
+		grainSize = 1;
+	}
+	if ((count <= grainSize) || (m_workers.size() == 0))
+	{
+		body(0, count);
+		return;
+	}
+
+	std::atomic<int> counter(0);
+	int chunkCount = (count + grainSize - 1) / grainSize;
+	counter = chunkCount;
+
+	for (int chunk = 0; chunk < chunkCount; chunk++)
+	{
+		int begin = chunk * grainSize;
+		int end = begin + grainSize;
+		if (end > count)
+			end = count;
+
+		Submit([&body, begin, end]() { body(begin, end); }, &counter);
+	}
+
+	Wait(&counter);
+}
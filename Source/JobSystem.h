@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// run small jobs on a pool of worker threads with work stealing
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class owns a pool of worker threads.  Every thread,
+ *  including the one that submits work, has its own deque of
+ *  jobs: it pushes and pops at the back, and idle threads
+ *  steal from the front of the other deques.  Waiting on a
+ *  job counter runs jobs instead of blocking, so the
+ *  submitting thread always helps with its own work.
+ *
+ *  Jobs may be submitted from one outside thread at a time,
+ *  which shares thread index 0, or from inside other jobs.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	typedef std::function<void()> JOB_FUNCTION;
+	typedef std::function<void(int begin, int end)> RANGE_FUNCTION;
+
+	// constructor, a negative worker count uses one worker per
+	// hardware thread besides the calling one
+	JobSystem(int workerCount);
+	// destructor
+	~JobSystem();
+
+private:
+	// one queued job and the counter it decrements when done
+	struct JOB
+	{
+		JOB_FUNCTION function;
+		std::atomic<int>* pCounter;
+	};
+
+	// the job deque owned by one thread
+	struct WORK_QUEUE
+	{
+		std::mutex lock;
+		std::deque<JOB> jobs;
+	};
+
+	// job deques, index 0 belongs to the outside thread
+	std::vector<WORK_QUEUE*> m_queues;
+	// worker threads, worker i owns deque i + 1
+	std::vector<std::thread> m_workers;
+	// cleared to stop the worker threads
+	std::atomic<bool> m_bRunning;
+	// number of jobs waiting in any deque
+	std::atomic<int> m_pendingJobs;
+	// idle workers sleep here until new jobs are pushed
+	std::mutex m_sleepLock;
+	std::condition_variable m_wakeCondition;
+
+	// take the newest job from a thread's own deque
+	bool PopJob(int threadIndex, JOB& job);
+	// take the oldest job from another thread's deque
+	bool StealJob(int threadIndex, JOB& job);
+	// run one job if any is available
+	bool RunOneJob(int threadIndex);
+	// main loop of the worker threads
+	void WorkerMain(int threadIndex);
+
+public:
+	// get the number of threads that run jobs, including the
+	// outside thread
+	int GetThreadCount() const;
+	// get the index of the calling thread, from 0 up to
+	// GetThreadCount() - 1
+	static int GetThreadIndex();
+
+	// queue a job, the counter is decremented when it finishes
+	void Submit(const JOB_FUNCTION& job, std::atomic<int>* pCounter);
+	// run jobs until the counter reaches zero
+	void Wait(std::atomic<int>* pCounter);
+	// split [0, count) into ranges of up to grainSize items
+	// and run them in parallel, returning when all are done
+	void ParallelFor(int count, int grainSize, const RANGE_FUNCTION& body);
+};
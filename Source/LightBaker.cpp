@@ -0,0 +1,606 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightbaker.cpp
+// ============
+// bake the static lighting of the scene into per-vertex colors
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightBaker.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	typedef BoundingVolumeHierarchy::AABB AABB;
+
+	const char BAKE_MAGIC[4] = { 'L', 'B', 'A', 'K' };
+	// raise whenever the baked terms change, so older bake
+	// files are refused
+	const uint32_t BAKE_VERSION = 2;
+
+	// 64-bit FNV-1a offset basis and prime
+	const uint64_t HASH_OFFSET = 14695981039346656037ULL;
+	const uint64_t HASH_PRIME = 1099511628211ULL;
+
+	// occlusion rays start this far above the surface, so they
+	// do not hit the triangles they start from
+	const float RAY_OFFSET = 0.001f;
+	// vertices per job while baking a draw
+	const int VERTEX_GRAIN_SIZE = 64;
+
+	/***********************************************************
+	 *  HashBytes()
+	 *
+	 *  Add bytes to a 64-bit FNV-1a hash.
+	 ***********************************************************/
+	uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+	{
+		const unsigned char* pBytes = (const unsigned char*)pData;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ pBytes[i]) * HASH_PRIME;
+		}
+		return(hash);
+	}
+
+	/***********************************************************
+	 *  GetVertexPosition()
+	 *
+	 *  Get the mesh-space position of a vertex.
+	 ***********************************************************/
+	glm::vec3 GetVertexPosition(const MeshGenerator::MESH_DATA& mesh, uint32_t index)
+	{
+		const float* pPosition = mesh.vertices[index].position;
+		return(glm::vec3(pPosition[0], pPosition[1], pPosition[2]));
+	}
+
+	/***********************************************************
+	 *  GetHemisphereSamples()
+	 *
+	 *  Get directions spread evenly over the hemisphere around
+	 *  +Z, denser toward the pole by the cosine so every ray
+	 *  counts the same.  The pattern is fixed, so a scene bakes
+	 *  the same every time.
+	 ***********************************************************/
+	void GetHemisphereSamples(int count, std::vector<glm::vec3>& samples)
+	{
+		// the golden angle keeps neighboring samples apart
+		const float GOLDEN_ANGLE = 2.39996323f;
+
+		samples.resize(count);
+		for (int i = 0; i < count; i++)
+		{
+			float height = ((float)i + 0.5f) / (float)count;
+			float radius = std::sqrt(height);
+			float angle = GOLDEN_ANGLE * (float)i;
+			samples[i] = glm::vec3(radius * std::cos(angle), radius * std::sin(angle), std::sqrt(1.0f - height));
+		}
+	}
+
+	/***********************************************************
+	 *  GetTangentFrame()
+	 *
+	 *  Get two directions that form an orthonormal frame with
+	 *  a unit normal, without a branch on its direction.
+	 ***********************************************************/
+	void GetTangentFrame(const glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent)
+	{
+		float sign = (normal.z >= 0.0f) ? 1.0f : -1.0f;
+		float a = -1.0f / (sign + normal.z);
+		float b = normal.x * normal.y * a;
+		tangent = glm::vec3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+		bitangent = glm::vec3(b, sign + normal.y * normal.y * a, -normal.y);
+	}
+}
+
+/***********************************************************
+ *  LightBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightBaker::LightBaker()
+{
+	m_sceneHash = 0;
+}
+
+/***********************************************************
+ *  ~LightBaker()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightBaker::~LightBaker()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  SetLights()
+ *
+ *  This method is used for setting the lights the scene is
+ *  baked with, the same records the shader is given.
+ ***********************************************************/
+void LightBaker::SetLights(const SceneFile::LIGHT_RECORD* pLights, int count)
+{
+	m_lights.assign(pLights, pLights + count);
+}
+
+/***********************************************************
+ *  IsOccluded()
+ *
+ *  This method is used for checking whether a ray hits any
+ *  triangle of the scene before the passed in distance.  The
+ *  index of the scene finds the objects whose boxes the ray
+ *  crosses, and the ray is moved into the space of every
+ *  such mesh to walk the index of its triangles.  The mesh
+ *  space direction keeps the length the model matrix gives
+ *  it, so the distances along the ray stay the same.
+ ***********************************************************/
+bool LightBaker::IsOccluded(
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float distance,
+	const std::vector<glm::mat4>& inverseModels,
+	const std::vector<int>& drawMeshes,
+	const std::vector<MESH_INDEX>& meshes,
+	const BoundingVolumeHierarchy& index) const
+{
+	BoundingVolumeHierarchy::RAY_HIT hit;
+	BoundingVolumeHierarchy::RAY_TEST objectTest = [&](int object, float& objectDistance)
+	{
+		const MESH_INDEX& mesh = meshes[drawMeshes[object]];
+		const MeshGenerator::MESH_DATA& data = *mesh.pMesh;
+		glm::vec3 meshOrigin = glm::vec3(inverseModels[object] * glm::vec4(origin, 1.0f));
+		glm::vec3 meshDirection = glm::mat3(inverseModels[object]) * direction;
+
+		BoundingVolumeHierarchy::RAY_TEST triangleTest = [&](int triangle, float& triangleDistance)
+		{
+			size_t first = (size_t)triangle * 3;
+			return(BoundingVolumeHierarchy::IntersectTriangle(meshOrigin, meshDirection,
+				GetVertexPosition(data, data.indices[first]),
+				GetVertexPosition(data, data.indices[first + 1]),
+				GetVertexPosition(data, data.indices[first + 2]),
+				triangleDistance));
+		};
+
+		BoundingVolumeHierarchy::RAY_HIT triangleHit;
+		if (mesh.pTriangles->Raycast(meshOrigin, meshDirection, distance, triangleTest, triangleHit) == false)
+		{
+			return(false);
+		}
+		objectDistance = triangleHit.distance;
+		return(true);
+	};
+
+	return(index.Raycast(origin, direction, distance, objectTest, hit));
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for baking the lighting of every
+ *  vertex of the draws with the terms of the shader that do
+ *  not depend on the camera:
+ *
+ *    directional - light ambient * material ambient color,
+ *                  plus N.L * light and material diffuse
+ *    point light - light ambient, plus N.L * light and
+ *                  material diffuse
+ *
+ *  where the ambient terms are scaled by the part of the
+ *  occlusion rays that reach the occlusion distance without
+ *  hitting anything.  The draws must be the objects of the
+ *  passed in index, in the same order.
+ ***********************************************************/
+void LightBaker::Bake(
+	const std::vector<BAKE_DRAW>& draws,
+	const BoundingVolumeHierarchy& index,
+	const OCCLUSION_SETTINGS& occlusion,
+	JobSystem* pJobSystem)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// the last directional light wins and only the point
+	// lights the shader has uniforms for count, like the
+	// lights the scene is rendered with
+	SoftwareRasterizer::DIRECTIONAL_LIGHT directional;
+	directional.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	directional.ambient = glm::vec3(0.0f);
+	directional.diffuse = glm::vec3(0.0f);
+	directional.specular = glm::vec3(0.0f);
+	std::vector<SoftwareRasterizer::POINT_LIGHT> pointLights;
+	for (size_t i = 0; i < m_lights.size(); i++)
+	{
+		const SceneFile::LIGHT_RECORD& record = m_lights[i];
+		if (record.type == SceneFile::LIGHT_DIRECTIONAL)
+		{
+			directional.direction = glm::vec3(record.vector[0], record.vector[1], record.vector[2]);
+			directional.ambient = glm::vec3(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]);
+			directional.diffuse = glm::vec3(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]);
+		}
+		else if ((int)pointLights.size() < SceneFile::MAX_POINT_LIGHTS)
+		{
+			SoftwareRasterizer::POINT_LIGHT light;
+			light.position = glm::vec3(record.vector[0], record.vector[1], record.vector[2]);
+			light.ambientColor = glm::vec3(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]);
+			light.diffuseColor = glm::vec3(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]);
+			light.specularColor = glm::vec3(0.0f);
+			light.focalStrength = record.focalStrength;
+			light.specularIntensity = record.specularIntensity;
+			pointLights.push_back(light);
+		}
+	}
+	glm::vec3 directionalDirection = glm::normalize(-directional.direction);
+
+	// index the triangles of every mesh once, the draws of
+	// the same shape share it
+	std::vector<MESH_INDEX> meshes;
+	std::vector<int> drawMeshes(draws.size());
+	std::vector<glm::mat4> inverseModels(draws.size());
+	bool bOcclusion = (occlusion.sampleCount > 0) && (occlusion.distance > 0.0f);
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		inverseModels[i] = glm::inverse(draws[i].model);
+		drawMeshes[i] = -1;
+		for (size_t j = 0; (j < meshes.size()) && (drawMeshes[i] < 0); j++)
+		{
+			if (meshes[j].pMesh == draws[i].pMesh)
+			{
+				drawMeshes[i] = (int)j;
+			}
+		}
+		if ((drawMeshes[i] >= 0) || (bOcclusion == false))
+		{
+			continue;
+		}
+
+		MESH_INDEX mesh;
+		mesh.pMesh = draws[i].pMesh;
+		mesh.pTriangles = new BoundingVolumeHierarchy();
+		const MeshGenerator::MESH_DATA& data = *mesh.pMesh;
+		std::vector<AABB> bounds(data.indices.size() / 3);
+		for (size_t k = 0; k < bounds.size(); k++)
+		{
+			glm::vec3 p0 = GetVertexPosition(data, data.indices[k * 3]);
+			glm::vec3 p1 = GetVertexPosition(data, data.indices[k * 3 + 1]);
+			glm::vec3 p2 = GetVertexPosition(data, data.indices[k * 3 + 2]);
+			bounds[k].min = glm::min(p0, glm::min(p1, p2));
+			bounds[k].max = glm::max(p0, glm::max(p1, p2));
+		}
+		if (bounds.empty() == false)
+		{
+			mesh.pTriangles->Build(&bounds[0], (int)bounds.size());
+		}
+		drawMeshes[i] = (int)meshes.size();
+		meshes.push_back(mesh);
+	}
+
+	std::vector<glm::vec3> samples;
+	if (bOcclusion == true)
+	{
+		GetHemisphereSamples(occlusion.sampleCount, samples);
+	}
+
+	Clear();
+	m_sceneHash = HashScene(draws, m_lights.empty() ? NULL : &m_lights[0], (int)m_lights.size());
+	m_draws.resize(draws.size());
+	size_t totalVertices = 0;
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		const BAKE_DRAW& draw = draws[i];
+		const MeshGenerator::MESH_DATA& mesh = *draw.pMesh;
+		const SoftwareRasterizer::MATERIAL& material = draw.material;
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(draw.model)));
+		DRAW_LIGHTING& lighting = m_draws[i];
+		lighting.mesh = draw.mesh;
+		lighting.vertices.resize(mesh.vertices.size());
+		totalVertices += mesh.vertices.size();
+
+		JobSystem::RANGE_FUNCTION bakeVertices = [&](int begin, int end)
+		{
+			for (int v = begin; v < end; v++)
+			{
+				const MeshGenerator::MESH_VERTEX& source = mesh.vertices[v];
+				glm::vec3 position = glm::vec3(draw.model *
+					glm::vec4(source.position[0], source.position[1], source.position[2], 1.0f));
+				glm::vec3 normal = normalMatrix * glm::vec3(source.normal[0], source.normal[1], source.normal[2]);
+				if (glm::dot(normal, normal) > 0.0f)
+				{
+					normal = glm::normalize(normal);
+				}
+
+				float visibility = 1.0f;
+				if ((bOcclusion == true) && (glm::dot(normal, normal) > 0.0f))
+				{
+					glm::vec3 tangent;
+					glm::vec3 bitangent;
+					GetTangentFrame(normal, tangent, bitangent);
+					glm::vec3 origin = position + (normal * RAY_OFFSET);
+					int openCount = 0;
+					for (size_t s = 0; s < samples.size(); s++)
+					{
+						glm::vec3 direction = (tangent * samples[s].x) + (bitangent * samples[s].y) + (normal * samples[s].z);
+						if (IsOccluded(origin, direction, occlusion.distance,
+							inverseModels, drawMeshes, meshes, index) == false)
+						{
+							openCount++;
+						}
+					}
+					visibility = (float)openCount / (float)samples.size();
+				}
+
+				glm::vec3 ambient = directional.ambient * material.ambientColor;
+				glm::vec3 diffuse = directional.diffuse * std::max(glm::dot(normal, directionalDirection), 0.0f) *
+					material.diffuseColor;
+				for (size_t l = 0; l < pointLights.size(); l++)
+				{
+					const SoftwareRasterizer::POINT_LIGHT& light = pointLights[l];
+					glm::vec3 toLight = light.position - position;
+					float impact = 0.0f;
+					if (glm::dot(toLight, toLight) > 0.0f)
+					{
+						impact = std::max(glm::dot(normal, glm::normalize(toLight)), 0.0f);
+					}
+					ambient += light.ambientColor;
+					diffuse += impact * light.diffuseColor * material.diffuseColor;
+				}
+				lighting.vertices[v] = (ambient * visibility) + diffuse;
+			}
+		};
+
+		if (NULL != pJobSystem)
+		{
+			pJobSystem->ParallelFor((int)mesh.vertices.size(), VERTEX_GRAIN_SIZE, bakeVertices);
+		}
+		else
+		{
+			bakeVertices(0, (int)mesh.vertices.size());
+		}
+	}
+
+	for (size_t i = 0; i < meshes.size(); i++)
+	{
+		delete meshes[i].pTriangles;
+	}
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_SCENE_DATA, "baked lighting",
+		totalVertices * sizeof(glm::vec3));
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "Baked lighting: " << draws.size() << " draws, " << totalVertices << " vertices, "
+		<< samples.size() << " occlusion rays per vertex in " << elapsed.count() << " s" << std::endl;
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for forgetting the baked colors, so
+ *  every pixel is lit again.
+ ***********************************************************/
+void LightBaker::Clear()
+{
+	m_draws.clear();
+	m_sceneHash = 0;
+	MemoryTracker::Release(this, 0);
+}
+
+/***********************************************************
+ *  WriteFile()
+ *
+ *  This method is used for writing the baked colors to a
+ *  bake file.  The hash of the baked scene is written first
+ *  and every draw is written with its mesh and its vertex
+ *  count, so a bake of another scene or another mesh detail
+ *  is not applied to the wrong vertices.
+ ***********************************************************/
+bool LightBaker::WriteFile(const char* filename) const
+{
+	FILE* output = fopen(filename, "wb");
+	if (NULL == output)
+	{
+		std::cout << "Could not create bake file:" << filename << std::endl;
+		return(false);
+	}
+
+	// the padding of the header is written as zeros
+	FILE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, BAKE_MAGIC, sizeof(BAKE_MAGIC));
+	header.version = BAKE_VERSION;
+	header.sceneHash = m_sceneHash;
+	header.drawCount = (uint32_t)m_draws.size();
+	fwrite(&header, sizeof(header), 1, output);
+	for (size_t i = 0; i < m_draws.size(); i++)
+	{
+		DRAW_HEADER drawHeader;
+		drawHeader.mesh = m_draws[i].mesh;
+		drawHeader.vertexCount = (uint32_t)m_draws[i].vertices.size();
+		fwrite(&drawHeader, sizeof(drawHeader), 1, output);
+		if (drawHeader.vertexCount > 0)
+		{
+			fwrite(&m_draws[i].vertices[0], sizeof(glm::vec3), drawHeader.vertexCount, output);
+		}
+	}
+	bool bWritten = (ferror(output) == 0);
+	fclose(output);
+	if (bWritten == false)
+	{
+		std::cout << "Could not write bake file:" << filename << std::endl;
+		remove(filename);
+	}
+	return(bWritten);
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This method is used for reading the colors of a bake
+ *  file.  Files from another bake version, that are cut
+ *  short, or whose draw and vertex counts are not the ones
+ *  of the passed in draws, are refused and leave no colors.
+ *  Every count is checked before anything is allocated for
+ *  it, so a damaged file cannot ask for more memory than
+ *  the file and the scene hold.
+ ***********************************************************/
+bool LightBaker::ReadFile(const char* filename, const std::vector<BAKE_DRAW>& draws)
+{
+	Clear();
+
+	FILE* input = fopen(filename, "rb");
+	if (NULL == input)
+	{
+		std::cout << "Could not open bake file:" << filename << std::endl;
+		return(false);
+	}
+
+	// the bytes left after each part bound the counts in it
+	uint64_t remaining = 0;
+	if (fseek(input, 0, SEEK_END) == 0)
+	{
+		long fileSize = ftell(input);
+		remaining = (fileSize > 0) ? (uint64_t)fileSize : 0;
+	}
+	rewind(input);
+
+	FILE_HEADER header;
+	bool bRead = (remaining >= sizeof(header)) &&
+		(fread(&header, sizeof(header), 1, input) == 1) &&
+		(memcmp(header.magic, BAKE_MAGIC, sizeof(BAKE_MAGIC)) == 0) &&
+		(header.version == BAKE_VERSION);
+	bool bMatches = true;
+	size_t totalVertices = 0;
+	if (bRead == true)
+	{
+		remaining -= sizeof(header);
+		bRead = ((uint64_t)header.drawCount * sizeof(DRAW_HEADER) <= remaining);
+	}
+	if (bRead == true)
+	{
+		bMatches = (header.drawCount == draws.size());
+	}
+	if ((bRead == true) && (bMatches == true))
+	{
+		m_sceneHash = header.sceneHash;
+		m_draws.resize(header.drawCount);
+	}
+	for (size_t i = 0; (bRead == true) && (bMatches == true) && (i < m_draws.size()); i++)
+	{
+		DRAW_HEADER drawHeader;
+		bRead = (fread(&drawHeader, sizeof(drawHeader), 1, input) == 1);
+		if (bRead == true)
+		{
+			remaining -= sizeof(drawHeader);
+			bRead = ((uint64_t)drawHeader.vertexCount * sizeof(glm::vec3) <= remaining);
+		}
+		if (bRead == true)
+		{
+			bMatches = (drawHeader.mesh == draws[i].mesh) &&
+				(drawHeader.vertexCount == draws[i].pMesh->vertices.size());
+		}
+		if ((bRead == true) && (bMatches == true))
+		{
+			m_draws[i].mesh = drawHeader.mesh;
+			m_draws[i].vertices.resize(drawHeader.vertexCount);
+			totalVertices += drawHeader.vertexCount;
+			remaining -= (uint64_t)drawHeader.vertexCount * sizeof(glm::vec3);
+			bRead = (drawHeader.vertexCount == 0) ||
+				(fread(&m_draws[i].vertices[0], sizeof(glm::vec3), drawHeader.vertexCount, input) == drawHeader.vertexCount);
+		}
+	}
+	fclose(input);
+
+	if (bRead == false)
+	{
+		std::cout << "Bake file is damaged or from another version:" << filename << std::endl;
+		Clear();
+		return(false);
+	}
+	if (bMatches == false)
+	{
+		std::cout << "Bake file was not baked for the draws of this scene:" << filename << std::endl;
+		Clear();
+		return(false);
+	}
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_SCENE_DATA, "baked lighting",
+		totalVertices * sizeof(glm::vec3));
+	return(true);
+}
+
+/***********************************************************
+ *  GetDrawCount()
+ *
+ *  This method is used for getting the number of draws with
+ *  baked colors.
+ ***********************************************************/
+int LightBaker::GetDrawCount() const
+{
+	return((int)m_draws.size());
+}
+
+/***********************************************************
+ *  GetSceneHash()
+ *
+ *  This method is used for getting the hash of the draws and
+ *  lights that the colors were baked for, to compare with
+ *  HashScene() of the scene that is drawn.
+ ***********************************************************/
+uint64_t LightBaker::GetSceneHash() const
+{
+	return(m_sceneHash);
+}
+
+/***********************************************************
+ *  HashScene()
+ *
+ *  This method is used for hashing everything the baked
+ *  colors depend on - the mesh, model matrix and material of
+ *  every draw in order, and every light.  Moving an object
+ *  or changing a material or a light changes the hash.
+ ***********************************************************/
+uint64_t LightBaker::HashScene(
+	const std::vector<BAKE_DRAW>& draws,
+	const SceneFile::LIGHT_RECORD* pLights,
+	int lightCount)
+{
+	uint64_t hash = HASH_OFFSET;
+	for (size_t i = 0; i < draws.size(); i++)
+	{
+		const BAKE_DRAW& draw = draws[i];
+		hash = HashBytes(hash, &draw.mesh, sizeof(draw.mesh));
+		hash = HashBytes(hash, &draw.model[0][0], sizeof(float) * 16);
+		hash = HashBytes(hash, &draw.material, sizeof(draw.material));
+	}
+	if (lightCount > 0)
+	{
+		hash = HashBytes(hash, pLights, sizeof(SceneFile::LIGHT_RECORD) * lightCount);
+	}
+	return(hash);
+}
+
+/***********************************************************
+ *  GetVertexLighting()
+ *
+ *  This method is used for getting the baked colors of one
+ *  draw, one per vertex of its mesh.  A draw past the baked
+ *  ones, or whose mesh or vertex count changed since the
+ *  bake, gets NULL and is lit per pixel.
+ ***********************************************************/
+const glm::vec3* LightBaker::GetVertexLighting(int draw, uint32_t mesh, int vertexCount) const
+{
+	if ((draw < 0) || (draw >= (int)m_draws.size()))
+	{
+		return(NULL);
+	}
+
+	const DRAW_LIGHTING& lighting = m_draws[draw];
+	if ((lighting.mesh != mesh) || ((int)lighting.vertices.size() != vertexCount) || (vertexCount == 0))
+	{
+		return(NULL);
+	}
+	return(&lighting.vertices[0]);
+}
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightbaker.h
+// ============
+// bake the static lighting of the scene into per-vertex colors
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumeHierarchy.h"
+#include "JobSystem.h"
+#include "MeshGenerator.h"
+#include "SceneFile.h"
+#include "SoftwareRasterizer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  LightBaker
+ *
+ *  This class computes the lighting of the scene that does
+ *  not depend on the camera - the ambient and diffuse terms
+ *  of the directional and the point lights - once for every
+ *  vertex of every draw.  The lights and the objects of the
+ *  scene never move, so a renderer that reads the baked
+ *  colors only has to add the specular terms per pixel.
+ *
+ *  The ambient light can be darkened by ambient occlusion.
+ *  Rays are cast over the hemisphere above every vertex, and
+ *  the fraction that leaves the scene within the occlusion
+ *  distance scales the ambient terms.  The rays find the
+ *  objects near them with the spatial index of the scene,
+ *  then the triangles with an index of every mesh.
+ *
+ *  The colors are kept per vertex of the shared meshes, so
+ *  a flat shape is only as detailed as its corners.
+ ***********************************************************/
+class LightBaker
+{
+public:
+	// one draw of the scene as it is rendered
+	struct BAKE_DRAW
+	{
+		// one of the SceneManager::SHAPE_MESH values
+		uint32_t mesh;
+		const MeshGenerator::MESH_DATA* pMesh;
+		glm::mat4 model;
+		SoftwareRasterizer::MATERIAL material;
+	};
+
+	// ambient occlusion rays of every vertex, no occlusion
+	// when the sample count is 0
+	struct OCCLUSION_SETTINGS
+	{
+		int sampleCount;
+		float distance;
+	};
+
+	// constructor
+	LightBaker();
+	// destructor
+	~LightBaker();
+
+private:
+	// the header at the start of a bake file
+	struct FILE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		// hash of the draws and lights that were baked
+		uint64_t sceneHash;
+		uint32_t drawCount;
+	};
+
+	// the header of every draw in a bake file, followed by
+	// one color per vertex
+	struct DRAW_HEADER
+	{
+		uint32_t mesh;
+		uint32_t vertexCount;
+	};
+
+	// baked colors of one draw
+	struct DRAW_LIGHTING
+	{
+		uint32_t mesh;
+		std::vector<glm::vec3> vertices;
+	};
+
+	// triangle index of one mesh used by the draws
+	struct MESH_INDEX
+	{
+		const MeshGenerator::MESH_DATA* pMesh;
+		BoundingVolumeHierarchy* pTriangles;
+	};
+
+	// the lights of the scene
+	std::vector<SceneFile::LIGHT_RECORD> m_lights;
+	// baked or loaded colors of every draw
+	std::vector<DRAW_LIGHTING> m_draws;
+	// hash of the draws and lights the colors were baked for
+	uint64_t m_sceneHash;
+
+	// check whether a ray hits the scene before the distance
+	bool IsOccluded(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float distance,
+		const std::vector<glm::mat4>& inverseModels,
+		const std::vector<int>& drawMeshes,
+		const std::vector<MESH_INDEX>& meshes,
+		const BoundingVolumeHierarchy& index) const;
+
+public:
+	// set the lights the scene is lit with
+	void SetLights(const SceneFile::LIGHT_RECORD* pLights, int count);
+	// bake the lighting of every vertex of the draws, which
+	// are the objects of the passed in spatial index
+	void Bake(
+		const std::vector<BAKE_DRAW>& draws,
+		const BoundingVolumeHierarchy& index,
+		const OCCLUSION_SETTINGS& occlusion,
+		JobSystem* pJobSystem);
+	// forget the baked colors
+	void Clear();
+
+	// write the baked colors to a bake file
+	bool WriteFile(const char* filename) const;
+	// read the colors of a bake file made for the draws
+	bool ReadFile(const char* filename, const std::vector<BAKE_DRAW>& draws);
+
+	// get the number of draws with baked colors
+	int GetDrawCount() const;
+	// get the hash of the draws and lights that were baked
+	uint64_t GetSceneHash() const;
+	// hash the models, materials and meshes of the draws and
+	// the lights, which a bake is only valid for
+	static uint64_t HashScene(
+		const std::vector<BAKE_DRAW>& draws,
+		const SceneFile::LIGHT_RECORD* pLights,
+		int lightCount);
+	// get the baked colors of a draw, or NULL when the draw
+	// does not match the one that was baked
+	const glm::vec3* GetVertexLighting(int draw, uint32_t mesh, int vertexCount) const;
+};
@@ -1,5 +1,8 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <atomic>           // scene reload flag
+#include <chrono>           // software renderer timing
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -11,8 +14,21 @@
 
 #include "SceneManager.h"
 #include "ViewManager.h"
-#include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "GLStateCache.h"
+#include "UniformCache.h"
+#include "FrameScheduler.h"
+#include "SimulationClock.h"
+#include "JobSystem.h"
+#include "RenderThread.h"
+#include "DynamicResolution.h"
+#include "SceneFile.h"
+#include "FileWatcher.h"
+#include "MemoryTracker.h"
+#include "SoftwareRasterizer.h"
+#include "BatchRenderer.h"
+#include "FrameCapture.h"
+#include "LightBaker.h"
 
 // Namespace for declaring global variables
 namespace
@@ -29,12 +45,98 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// state cache object for filtering redundant OpenGL state calls
+	GLStateCache* g_StateCache = nullptr;
+	// uniform cache object for skipping redundant uniform uploads
+	UniformCache* g_UniformCache = nullptr;
+	// frame scheduler object for pacing the main loop
+	FrameScheduler* g_FrameScheduler = nullptr;
+	// simulation clock object for the fixed update ticks
+	SimulationClock* g_SimulationClock = nullptr;
+	// job system object for preparing the scene in parallel
+	JobSystem* g_JobSystem = nullptr;
+	// render thread object that owns the OpenGL context when enabled
+	RenderThread* g_RenderThread = nullptr;
+	// dynamic resolution object for the offscreen scene target
+	DynamicResolution* g_DynamicResolution = nullptr;
+	// software rasterizer object drawing the scene without OpenGL
+	SoftwareRasterizer* g_SoftwareRasterizer = nullptr;
+	// reads the frames back for screenshots and image sequences
+	FrameCapture* g_FrameCapture = nullptr;
+
+	// main loop pacing, changed from the command line
+	FrameScheduler::FRAME_SETTINGS g_FrameSettings = { true, 0.0f, false, 10.0f };
+	// simulation ticks per second, changed from the command line
+	double g_TickRate = 120.0;
+	// worker threads for the job system, -1 for one per core
+	int g_WorkerThreads = -1;
+
+	// offscreen resolution scaling, changed from the command line
+	DynamicResolution::RESOLUTION_SETTINGS g_ResolutionSettings = { true, 14.0f, 0.5f, 0.25f };
+	// render on a dedicated thread, changed from the command line
+	bool g_bRenderThread = false;
+
+	// binary or text scene file replacing the built-in scene, or NULL
+	const char* g_SceneFilename = NULL;
+	// reload the scene file whenever it is saved
+	bool g_bWatchScene = false;
+	FileWatcher* g_SceneWatcher = NULL;
+	// set by the main loop, the reload runs where the OpenGL
+	// context is current
+	std::atomic<bool> g_bReloadScene(false);
+	// text scene to convert to a binary scene file, or NULL
+	const char* g_ConvertInput = NULL;
+	const char* g_ConvertOutput = NULL;
+	// store the meshes in the compact vertex layout
+	bool g_bCompactVertices = false;
+	// tessellation of the curved shapes, 0 keeps the default
+	int g_MeshSegments = 0;
+	int g_MeshRings = 0;
+	// video memory budget of the textures in MB, 0 for none
+	double g_TextureBudgetMB = 0.0;
+	// print the tracked memory once the scene is loaded
+	bool g_bDumpMemory = false;
+	// draw on the CPU without a window or an OpenGL context
+	bool g_bSoftware = false;
+	// frames the software renderer draws before exiting
+	int g_SoftwareFrames = 1;
+	// image file the last software frame is written to, or NULL
+	const char* g_SoftwareOutput = NULL;
+	// view file rendered offscreen in a batch, or NULL
+	const char* g_BatchViews = NULL;
+	// image size and file name prefix of the batch views
+	int g_BatchWidth = 320;
+	int g_BatchHeight = 256;
+	const char* g_BatchOutput = "view_";
+	// file name prefix of the captured image sequence, or NULL
+	const char* g_CapturePrefix = NULL;
+	// frames of the image sequence, 0 until the window closes
+	int g_CaptureFrames = 0;
+	// threads that encode and write the captured images
+	int g_CaptureWriters = 2;
+	// bake file the static lighting is baked into, or NULL
+	const char* g_BakeOutput = NULL;
+	// ambient occlusion rays of the bake, 0 for none
+	LightBaker::OCCLUSION_SETTINGS g_BakeOcclusion = { 0, 1.0f };
+	// bake file the software draws are lit with, or NULL
+	const char* g_BakedLighting = NULL;
+
+	// print the per-frame render statistics once per second
+	bool g_bPrintStats = false;
+	// time the render statistics were last printed
+	double g_LastStatsTime = 0.0;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+void ParseCommandLine(int argc, char* argv[]);
+void RenderFrame(const RenderThread::RENDER_PACKET& packet);
+int RunSoftwareRenderer();
+bool RunSoftwareFrames();
+bool RunBatchRenderer();
+void PickObject(const glm::vec3& origin, const glm::vec3& direction);
 
 
 /***********************************************************
@@ -45,6 +147,26 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// read the optional settings passed on the command line
+	ParseCommandLine(argc, argv);
+
+	// converting a scene file does not need a window
+	if (NULL != g_ConvertInput)
+	{
+		if (SceneFile::ConvertTextScene(g_ConvertInput, g_ConvertOutput) == false)
+		{
+			return(EXIT_FAILURE);
+		}
+		return(EXIT_SUCCESS);
+	}
+
+	// the software and batch renderers and the light baker do
+	// not need a window either
+	if ((g_bSoftware == true) || (NULL != g_BatchViews) || (NULL != g_BakeOutput))
+	{
+		return(RunSoftwareRenderer());
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -53,13 +175,20 @@ int main(int argc, char* argv[])
 
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
+	// create the uniform cache in front of the shader manager
+	g_UniformCache = new UniformCache();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
-		g_ShaderManager);
+		g_ShaderManager,
+		g_UniformCache);
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
 
+	// pace the main loop for the display window
+	g_FrameScheduler = new FrameScheduler(g_FrameSettings);
+	g_FrameScheduler->AttachWindow(g_Window);
+
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
 	{
@@ -71,42 +200,160 @@ int main(int argc, char* argv[])
 		"../../Utilities/shaders/vertexShader.glsl",
 		"../../Utilities/shaders/fragmentShader.glsl");
 	g_ShaderManager->use();
+	g_UniformCache->SyncProgram();
+	g_ViewManager->AttachCameraBlock();
+
+	// create the state cache after the OpenGL context is ready
+	g_StateCache = new GLStateCache();
+
+	// scale the scene resolution to hold the GPU frame time
+	g_DynamicResolution = new DynamicResolution(g_StateCache, g_ResolutionSettings);
+	g_DynamicResolution->Create();
+
+	// read the frames back without waiting on the GPU
+	g_FrameCapture = new FrameCapture(g_CaptureWriters);
+	if ((g_FrameCapture->Create() == true) && (NULL != g_CapturePrefix))
+	{
+		g_FrameCapture->StartSequence(g_CapturePrefix, g_CaptureFrames);
+	}
 
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager = new SceneManager(g_ShaderManager, g_StateCache, g_UniformCache);
+
+	// prepare the scene draws on all the available cores
+	g_JobSystem = new JobSystem(g_WorkerThreads);
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	g_SceneManager->SetCompactVertices(g_bCompactVertices);
+	g_SceneManager->SetTextureBudget((size_t)(g_TextureBudgetMB * 1024.0 * 1024.0));
+	if ((g_MeshSegments > 0) && (g_MeshRings > 0))
+	{
+		g_SceneManager->SetMeshTessellation(g_MeshSegments, g_MeshRings);
+	}
+	if ((NULL != g_SceneFilename) && (g_SceneManager->LoadSceneFile(g_SceneFilename) == false))
+	{
+		std::cout << "Using the built-in scene" << std::endl;
+	}
+	else if ((NULL != g_SceneFilename) && (g_bWatchScene == true))
+	{
+		g_SceneWatcher = new FileWatcher();
+		g_SceneWatcher->Watch(g_SceneFilename);
+	}
 	g_SceneManager->PrepareScene();
 
+	// step the camera and the scene at a fixed rate
+	g_SimulationClock = new SimulationClock(g_TickRate);
+
+	g_LastStatsTime = glfwGetTime();
+	unsigned int frameNumber = 0;
+
+	// hand the OpenGL context over to the render thread, the
+	// main thread keeps the event handling and the simulation
+	if (g_bRenderThread == true)
+	{
+		g_RenderThread = new RenderThread(g_Window, &RenderFrame);
+		g_RenderThread->Start();
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
+		// query the latest GLFW events - in on-demand mode this
+		// blocks until there is something new to render, or
+		// only briefly while a scene file is watched, and the
+		// frames go on while the captures are not written yet
+		g_FrameScheduler->WaitForEvents(
+			(g_ViewManager->IsViewMoving() == true) || (g_FrameCapture->IsBusy() == true),
+			(NULL != g_SceneWatcher));
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// run the fixed simulation ticks for the elapsed time
+		int ticks = g_SimulationClock->Advance();
+		for (int i = 0; i < ticks; i++)
+		{
+			g_ViewManager->UpdateSimulation(g_SimulationClock->GetTimeStep());
+			g_SceneManager->UpdateScene(g_SimulationClock->GetTimeStep());
+		}
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		// convert from 3D object space to 2D view, blending the
+		// last two simulation ticks
+		RenderThread::RENDER_PACKET packet;
+		packet.view = g_ViewManager->PrepareSceneView(g_SimulationClock->GetAlpha());
+		g_ViewManager->GetFramebufferSize(packet.framebufferWidth, packet.framebufferHeight);
+		packet.frameNumber = frameNumber;
+		if (g_ViewManager->ConsumeViewChanged() == true)
+		{
+			g_FrameScheduler->RequestRedraw();
+		}
+		if (g_ViewManager->ConsumeScreenshotRequest() == true)
+		{
+			g_FrameCapture->RequestScreenshot();
+			g_FrameScheduler->RequestRedraw();
+		}
+		packet.bPickObject = g_ViewManager->ConsumePickRequest();
+		if (packet.bPickObject == true)
+		{
+			g_ViewManager->GetCursorRay(packet.pickOrigin, packet.pickDirection);
+			g_FrameScheduler->RequestRedraw();
+		}
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+		// pick up the edits of a watched scene file
+		if ((NULL != g_SceneWatcher) && (g_SceneWatcher->PollChanged() == true))
+		{
+			g_bReloadScene = true;
+			g_FrameScheduler->RequestRedraw();
+		}
 
+		// skip the frame when nothing on screen has changed
+		if (g_FrameScheduler->BeginFrame() == false)
+		{
+			continue;
+		}
+		frameNumber++;
 
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		// render the frame here, or hand it to the render thread
+		// and go on with the next frame's simulation
+		if (NULL != g_RenderThread)
+		{
+			g_RenderThread->Submit(packet);
+		}
+		else
+		{
+			RenderFrame(packet);
+		}
 
-		// query the latest GLFW events
-		glfwPollEvents();
+		// wait out the rest of the frame when the rate is capped
+		g_FrameScheduler->EndFrame();
 	}
 
-	// clear the allocated manager objects from memory
+	// take the OpenGL context back before freeing the GL objects
+	if (NULL != g_RenderThread)
+	{
+		delete g_RenderThread;
+		g_RenderThread = NULL;
+	}
+
+	// clear the allocated manager objects from memory, the
+	// capture first so the images in flight are written
+	if (NULL != g_FrameCapture)
+	{
+		delete g_FrameCapture;
+		g_FrameCapture = NULL;
+	}
+	if (NULL != g_SceneWatcher)
+	{
+		delete g_SceneWatcher;
+		g_SceneWatcher = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
 		g_SceneManager = NULL;
 	}
+	if (NULL != g_DynamicResolution)
+	{
+		delete g_DynamicResolution;
+		g_DynamicResolution = NULL;
+	}
 	if (NULL != g_ViewManager)
 	{
 		delete g_ViewManager;
@@ -117,11 +364,505 @@ int main(int argc, char* argv[])
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_StateCache)
+	{
+		delete g_StateCache;
+		g_StateCache = NULL;
+	}
+	if (NULL != g_UniformCache)
+	{
+		delete g_UniformCache;
+		g_UniformCache = NULL;
+	}
+	if (NULL != g_FrameScheduler)
+	{
+		delete g_FrameScheduler;
+		g_FrameScheduler = NULL;
+	}
+	if (NULL != g_SimulationClock)
+	{
+		delete g_SimulationClock;
+		g_SimulationClock = NULL;
+	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
 
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to draw and present one frame from
+ *  a render packet.  It runs on the thread that owns the
+ *  OpenGL context.
+ ***********************************************************/
+void RenderFrame(const RenderThread::RENDER_PACKET& packet)
+{
+	// apply the edits of the watched scene file
+	if (g_bReloadScene.exchange(false) == true)
+	{
+		g_SceneManager->ReloadSceneFile();
+	}
+
+	// render into the scaled offscreen target
+	g_DynamicResolution->BeginFrame(packet.framebufferWidth, packet.framebufferHeight);
+
+	// Enable z-depth
+	g_StateCache->Enable(GL_DEPTH_TEST);
+
+	// Clear the frame and z buffers
+	g_StateCache->ClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// pass the prepared view into the shader
+	g_ViewManager->ApplySceneView(packet.view);
+
+	// sort and cull the scene draws against the current camera
+	g_SceneManager->SetViewPosition(packet.view.position);
+	g_SceneManager->SetViewProjection(packet.view.viewProjection);
+
+	// refresh the 3D scene
+	g_SceneManager->RenderScene();
+
+	// the spatial index holds the draws of this frame now
+	if (packet.bPickObject == true)
+	{
+		PickObject(packet.pickOrigin, packet.pickDirection);
+	}
+
+	// upscale the rendered scene into the window
+	g_DynamicResolution->EndFrame();
+
+	// copy the finished frame for the writers when captured
+	g_FrameCapture->CaptureFrame(packet.framebufferWidth, packet.framebufferHeight);
+
+	// Flips the the back buffer with the front buffer every frame.
+	glfwSwapBuffers(g_Window);
+
+	// close the state call and uniform upload counts of this frame
+	g_StateCache->BeginFrame();
+	g_UniformCache->BeginFrame();
+	if ((g_bPrintStats == true) && (glfwGetTime() - g_LastStatsTime >= 1.0))
+	{
+		g_StateCache->PrintFrameStats();
+		g_UniformCache->PrintFrameStats();
+		g_DynamicResolution->PrintFrameStats();
+		g_SceneManager->PrintTextureStats();
+		g_FrameCapture->PrintFrameStats();
+		g_LastStatsTime = glfwGetTime();
+	}
+
+	// the meshes load on their first draw, so the memory is
+	// only complete after the first frame
+	if (g_bDumpMemory == true)
+	{
+		MemoryTracker::Dump();
+		g_bDumpMemory = false;
+	}
+}
+
+/***********************************************************
+ *	PickObject()
+ *
+ *  This function is used to print the object along a ray
+ *  and how long it took to find it.
+ ***********************************************************/
+void PickObject(const glm::vec3& origin, const glm::vec3& direction)
+{
+	SceneManager::PICK_RESULT pick;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool bHit = g_SceneManager->PickObject(origin, direction, pick);
+	double microseconds = std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - start).count();
+
+	if (bHit == true)
+	{
+		std::cout << "Picked object " << pick.objectIndex << " (mesh " << pick.mesh << ") at distance "
+			<< pick.distance << " in " << microseconds << " us" << std::endl;
+	}
+	else
+	{
+		std::cout << "No object picked in " << microseconds << " us" << std::endl;
+	}
+}
+
+/***********************************************************
+ *	RunSoftwareRenderer()
+ *
+ *  This function is used to draw the scene with the software
+ *  rasterizer instead of OpenGL.  It creates no window, so it
+ *  runs on machines without a GPU, and either draws a fixed
+ *  number of frames, renders the views of a batch or bakes
+ *  the static lighting of the scene.
+ ***********************************************************/
+int RunSoftwareRenderer()
+{
+	// the view manager only builds the camera matrices here
+	g_ViewManager = new ViewManager(NULL, NULL);
+
+	g_JobSystem = new JobSystem(g_WorkerThreads);
+	g_SoftwareRasterizer = new SoftwareRasterizer(g_JobSystem);
+
+	// the scene manager sends the textures, lights and draws
+	// to the rasterizer instead of OpenGL
+	g_SceneManager = new SceneManager(NULL, NULL, NULL);
+	g_SceneManager->SetSoftwareRasterizer(g_SoftwareRasterizer);
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	if ((g_MeshSegments > 0) && (g_MeshRings > 0))
+	{
+		g_SceneManager->SetMeshTessellation(g_MeshSegments, g_MeshRings);
+	}
+	if ((NULL != g_SceneFilename) && (g_SceneManager->LoadSceneFile(g_SceneFilename) == false))
+	{
+		std::cout << "Using the built-in scene" << std::endl;
+	}
+	g_SceneManager->PrepareScene();
+	if ((NULL != g_BakedLighting) && (g_SceneManager->LoadBakedLighting(g_BakedLighting) == false))
+	{
+		std::cout << "Lighting every pixel instead" << std::endl;
+	}
+
+	bool bSucceeded = false;
+	if (NULL != g_BakeOutput)
+	{
+		bSucceeded = g_SceneManager->BakeStaticLighting(g_BakeOutput, g_BakeOcclusion);
+	}
+	else
+	{
+		bSucceeded = (NULL != g_BatchViews) ? RunBatchRenderer() : RunSoftwareFrames();
+	}
+
+	// the scene manager frees its textures in the rasterizer
+	delete g_SceneManager;
+	g_SceneManager = NULL;
+	delete g_SoftwareRasterizer;
+	g_SoftwareRasterizer = NULL;
+	delete g_JobSystem;
+	g_JobSystem = NULL;
+	delete g_ViewManager;
+	g_ViewManager = NULL;
+
+	return((bSucceeded == true) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	RunSoftwareFrames()
+ *
+ *  This function is used to draw a fixed number of frames
+ *  from the default camera with the software rasterizer, one
+ *  simulation tick apart, then write the last one to an
+ *  image file.
+ ***********************************************************/
+bool RunSoftwareFrames()
+{
+	float timeStep = (float)(1.0 / g_TickRate);
+	double totalMs = 0.0;
+	std::chrono::steady_clock::time_point lastStatsTime = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < g_SoftwareFrames; frame++)
+	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+		ViewManager::VIEW_STATE view = g_ViewManager->PrepareSceneView(1.0f);
+		int width = 0;
+		int height = 0;
+		g_ViewManager->GetFramebufferSize(width, height);
+
+		g_SoftwareRasterizer->BeginFrame(width, height,
+			view.viewProjection, view.position, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+		g_SceneManager->SetViewPosition(view.position);
+		g_SceneManager->SetViewProjection(view.viewProjection);
+		g_SceneManager->RenderScene();
+		g_SoftwareRasterizer->EndFrame();
+
+		std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+		totalMs += std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+
+		if ((g_bPrintStats == true) &&
+			(std::chrono::duration<double>(frameEnd - lastStatsTime).count() >= 1.0))
+		{
+			g_SoftwareRasterizer->PrintFrameStats();
+			lastStatsTime = frameEnd;
+		}
+
+		// the meshes are generated on their first draw
+		if (g_bDumpMemory == true)
+		{
+			MemoryTracker::Dump();
+			g_bDumpMemory = false;
+		}
+
+		g_SceneManager->UpdateScene(timeStep);
+	}
+
+	if (g_SoftwareFrames > 0)
+	{
+		std::cout << "Software renderer: " << g_SoftwareFrames << " frames, "
+			<< (totalMs / g_SoftwareFrames) << " ms per frame" << std::endl;
+	}
+
+	if ((NULL != g_SoftwareOutput) && (g_SoftwareFrames > 0))
+	{
+		return(g_SoftwareRasterizer->WriteImage(g_SoftwareOutput));
+	}
+	return(true);
+}
+
+/***********************************************************
+ *	RunBatchRenderer()
+ *
+ *  This function is used to render the camera poses of the
+ *  view file offscreen, one view per job thread at a time,
+ *  and write every view to an image file.
+ ***********************************************************/
+bool RunBatchRenderer()
+{
+	BatchRenderer batchRenderer(g_SceneManager, g_SoftwareRasterizer, g_JobSystem);
+	if (batchRenderer.LoadViews(g_BatchViews, g_BatchOutput) == false)
+	{
+		return(false);
+	}
+
+	bool bRendered = batchRenderer.Render(g_BatchWidth, g_BatchHeight);
+
+	// the meshes are generated by the first view
+	if (g_bDumpMemory == true)
+	{
+		MemoryTracker::Dump();
+		g_bDumpMemory = false;
+	}
+	return(bRendered);
+}
+
+/***********************************************************
+ *	ParseCommandLine()
+ *
+ *  This function is used to read the optional settings
+ *  passed on the command line.
+ *
+ *    --stats              print the per-frame render statistics
+ *    --no-vsync           do not wait for the display refresh
+ *    --fps <n>            cap the frame rate at n frames per second
+ *    --on-demand          only render when something has changed
+ *    --unfocused-fps <n>  frame rate cap while the window is
+ *                         unfocused, 0 for no throttling
+ *    --tick-rate <n>      simulation ticks per second
+ *    --threads <n>        job system worker threads, in addition
+ *                         to the main thread
+ *    --render-thread      render on a dedicated thread that owns
+ *                         the OpenGL context
+ *    --no-dynamic-res     always render at the full window size
+ *    --gpu-target <ms>    GPU time per frame that the dynamic
+ *                         resolution holds
+ *    --min-scale <s>      smallest dynamic resolution scale
+ *    --scene <file>       load a binary scene file, or a text
+ *                         scene ending in .scene, instead of the
+ *                         built-in scene
+ *    --watch              reload the scene file whenever it is
+ *                         saved, applying only what changed
+ *    --compact-vertices   store the meshes with 16-bit positions,
+ *                         8-bit normals and half float texture
+ *                         coordinates
+ *    --mesh-detail <segments> <rings>
+ *                         tessellation of the curved shapes
+ *    --texture-budget <mb>
+ *                         video memory the textures may use, the
+ *                         least recently used ones are reduced or
+ *                         evicted beyond it
+ *    --gpu-budget <mb>    GPU memory budget, the textures use what
+ *                         the other allocations leave of it
+ *    --cpu-budget <mb>    CPU memory budget, warned about when
+ *                         exceeded
+ *    --memory             print the tracked memory after the first
+ *                         frame, the M key prints it any time
+ *    --software           draw on the CPU with the software
+ *                         rasterizer, without a window
+ *    --frames <n>         frames the software renderer draws
+ *                         before exiting
+ *    --software-output <file>
+ *                         write the last software frame to a
+ *                         binary PPM image
+ *    --batch <file>       render the camera poses of a view file
+ *                         offscreen and write them as images,
+ *                         without a window
+ *    --batch-size <width> <height>
+ *                         image size of the batch views
+ *    --batch-output <prefix>
+ *                         file name prefix of the batch views
+ *                         that do not name their own image
+ *    --capture <prefix>   write every frame as a numbered TGA
+ *                         image after the prefix, F12 writes a
+ *                         single screenshot any time
+ *    --capture-frames <n> stop the image sequence after n frames
+ *    --capture-writers <n>
+ *                         threads that encode and write the
+ *                         captured images, at least one
+ *    --bake-lighting <file>
+ *                         bake the ambient and diffuse lighting
+ *                         of every vertex into a bake file and
+ *                         exit, without a window
+ *    --bake-ao <samples> <distance>
+ *                         darken the baked ambient light by the
+ *                         occlusion rays within the distance
+ *    --baked-lighting <file>
+ *                         light the software and batch renderers
+ *                         with a bake file, per pixel only the
+ *                         specular terms are added
+ *    --convert-scene <text> <binary>
+ *                         convert a text scene to a binary scene
+ *                         file and exit
+ ***********************************************************/
+void ParseCommandLine(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--stats") == 0)
+		{
+			g_bPrintStats = true;
+		}
+		else if (strcmp(argv[i], "--no-vsync") == 0)
+		{
+			g_FrameSettings.bVSync = false;
+		}
+		else if ((strcmp(argv[i], "--fps") == 0) && (i + 1 < argc))
+		{
+			g_FrameSettings.maxFPS = (float)atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			g_FrameSettings.bOnDemand = true;
+		}
+		else if ((strcmp(argv[i], "--unfocused-fps") == 0) && (i + 1 < argc))
+		{
+			g_FrameSettings.unfocusedFPS = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--tick-rate") == 0) && (i + 1 < argc))
+		{
+			g_TickRate = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc))
+		{
+			g_WorkerThreads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--render-thread") == 0)
+		{
+			g_bRenderThread = true;
+		}
+		else if (strcmp(argv[i], "--no-dynamic-res") == 0)
+		{
+			g_ResolutionSettings.bEnabled = false;
+		}
+		else if ((strcmp(argv[i], "--gpu-target") == 0) && (i + 1 < argc))
+		{
+			g_ResolutionSettings.targetFrameMs = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--min-scale") == 0) && (i + 1 < argc))
+		{
+			g_ResolutionSettings.minScale = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--scene") == 0) && (i + 1 < argc))
+		{
+			g_SceneFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "--watch") == 0)
+		{
+			g_bWatchScene = true;
+		}
+		else if (strcmp(argv[i], "--compact-vertices") == 0)
+		{
+			g_bCompactVertices = true;
+		}
+		else if ((strcmp(argv[i], "--mesh-detail") == 0) && (i + 2 < argc))
+		{
+			g_MeshSegments = atoi(argv[++i]);
+			g_MeshRings = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--texture-budget") == 0) && (i + 1 < argc))
+		{
+			g_TextureBudgetMB = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--gpu-budget") == 0) && (i + 1 < argc))
+		{
+			MemoryTracker::SetBudget(MemoryTracker::DOMAIN_GPU,
+				(size_t)(atof(argv[++i]) * 1024.0 * 1024.0));
+		}
+		else if ((strcmp(argv[i], "--cpu-budget") == 0) && (i + 1 < argc))
+		{
+			MemoryTracker::SetBudget(MemoryTracker::DOMAIN_CPU,
+				(size_t)(atof(argv[++i]) * 1024.0 * 1024.0));
+		}
+		else if (strcmp(argv[i], "--memory") == 0)
+		{
+			g_bDumpMemory = true;
+		}
+		else if (strcmp(argv[i], "--software") == 0)
+		{
+			g_bSoftware = true;
+		}
+		else if ((strcmp(argv[i], "--frames") == 0) && (i + 1 < argc))
+		{
+			g_SoftwareFrames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--software-output") == 0) && (i + 1 < argc))
+		{
+			g_SoftwareOutput = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--batch") == 0) && (i + 1 < argc))
+		{
+			g_BatchViews = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--batch-size") == 0) && (i + 2 < argc))
+		{
+			g_BatchWidth = atoi(argv[++i]);
+			g_BatchHeight = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--batch-output") == 0) && (i + 1 < argc))
+		{
+			g_BatchOutput = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--capture") == 0) && (i + 1 < argc))
+		{
+			g_CapturePrefix = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--capture-frames") == 0) && (i + 1 < argc))
+		{
+			g_CaptureFrames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--capture-writers") == 0) && (i + 1 < argc))
+		{
+			// images are only written by the writer threads
+			int writers = atoi(argv[++i]);
+			g_CaptureWriters = (writers > 0) ? writers : 1;
+		}
+		else if ((strcmp(argv[i], "--bake-lighting") == 0) && (i + 1 < argc))
+		{
+			g_BakeOutput = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--bake-ao") == 0) && (i + 2 < argc))
+		{
+			g_BakeOcclusion.sampleCount = atoi(argv[++i]);
+			g_BakeOcclusion.distance = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--baked-lighting") == 0) && (i + 1 < argc))
+		{
+			g_BakedLighting = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--convert-scene") == 0) && (i + 2 < argc))
+		{
+			g_ConvertInput = argv[++i];
+			g_ConvertOutput = argv[++i];
+		}
+		else
+		{
+			std::cout << "Ignoring unknown option: " << argv[i] << std::endl;
+		}
+	}
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
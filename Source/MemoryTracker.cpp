@@ -0,0 +1,340 @@
+///////////////////////////////////////////////////////////////////////////////
+// memorytracker.cpp
+// ============
+// account for the GPU and CPU memory of the textures, meshes and buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+// declaration of global variables
+namespace
+{
+	// category names and domains, in the order of MEMORY_CATEGORY
+	const char* g_CategoryNames[] =
+	{
+		"textures",
+		"vertex buffers",
+		"index buffers",
+		"uniform buffers",
+		"storage buffers",
+		"render targets",
+		"readback buffers",
+		"image data",
+		"mesh data",
+		"scene data"
+	};
+	const MemoryTracker::MEMORY_DOMAIN g_CategoryDomains[] =
+	{
+		MemoryTracker::DOMAIN_GPU,
+		MemoryTracker::DOMAIN_GPU,
+		MemoryTracker::DOMAIN_GPU,
+		MemoryTracker::DOMAIN_GPU,
+		MemoryTracker::DOMAIN_GPU,
+		MemoryTracker::DOMAIN_GPU,
+		MemoryTracker::DOMAIN_GPU,
+		MemoryTracker::DOMAIN_CPU,
+		MemoryTracker::DOMAIN_CPU,
+		MemoryTracker::DOMAIN_CPU
+	};
+	const char* g_DomainNames[] = { "GPU", "CPU" };
+
+	const double BYTES_PER_MB = 1024.0 * 1024.0;
+
+	// guards all of the records below
+	std::mutex g_TrackerLock;
+	std::vector<MemoryTracker::ALLOCATION> g_Allocations;
+	size_t g_CategoryTotals[MemoryTracker::MEMORY_CATEGORY_COUNT] = {};
+	size_t g_DomainTotals[MemoryTracker::DOMAIN_COUNT] = {};
+	size_t g_DomainPeaks[MemoryTracker::DOMAIN_COUNT] = {};
+	size_t g_DomainBudgets[MemoryTracker::DOMAIN_COUNT] = {};
+	// a budget warning is printed once per crossing
+	bool g_bBudgetWarned[MemoryTracker::DOMAIN_COUNT] = {};
+
+	/***********************************************************
+	 *  FindAllocation()
+	 *
+	 *  This function is used for finding the record of an
+	 *  asset, or -1.  The caller holds the lock.
+	 ***********************************************************/
+	int FindAllocation(const void* pOwner, int id)
+	{
+		for (size_t i = 0; i < g_Allocations.size(); i++)
+		{
+			if ((g_Allocations[i].pOwner == pOwner) && (g_Allocations[i].id == id))
+			{
+				return((int)i);
+			}
+		}
+		return(-1);
+	}
+
+	/***********************************************************
+	 *  AddBytes()
+	 *
+	 *  This function is used for adding or taking the bytes of
+	 *  an asset from the totals.  The caller holds the lock.
+	 ***********************************************************/
+	void AddBytes(MemoryTracker::MEMORY_CATEGORY category, size_t bytes, bool bAdd)
+	{
+		MemoryTracker::MEMORY_DOMAIN domain = g_CategoryDomains[category];
+		if (bAdd == true)
+		{
+			g_CategoryTotals[category] += bytes;
+			g_DomainTotals[domain] += bytes;
+			g_DomainPeaks[domain] = std::max(g_DomainPeaks[domain], g_DomainTotals[domain]);
+		}
+		else
+		{
+			g_CategoryTotals[category] -= bytes;
+			g_DomainTotals[domain] -= bytes;
+		}
+	}
+
+	/***********************************************************
+	 *  CheckBudget()
+	 *
+	 *  This function is used for warning once when a domain
+	 *  goes over its budget.  The caller holds the lock.
+	 ***********************************************************/
+	void CheckBudget(MemoryTracker::MEMORY_DOMAIN domain)
+	{
+		bool bOver = (g_DomainBudgets[domain] > 0) && (g_DomainTotals[domain] > g_DomainBudgets[domain]);
+		if ((bOver == true) && (g_bBudgetWarned[domain] == false))
+		{
+			std::cout << g_DomainNames[domain] << " memory " << (g_DomainTotals[domain] / BYTES_PER_MB)
+				<< " MB is over the budget of " << (g_DomainBudgets[domain] / BYTES_PER_MB)
+				<< " MB" << std::endl;
+		}
+		g_bBudgetWarned[domain] = bOver;
+	}
+}
+
+/***********************************************************
+ *  Track()
+ *
+ *  This method is used for recording the size of an asset.
+ *  An asset that was tracked before is resized, so callers
+ *  can report the new size whenever a buffer grows.
+ ***********************************************************/
+void MemoryTracker::Track(const void* pOwner, int id, MEMORY_CATEGORY category, const std::string& name, size_t bytes)
+{
+	if ((category < 0) || (category >= MEMORY_CATEGORY_COUNT))
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	int index = FindAllocation(pOwner, id);
+	if (index >= 0)
+	{
+		ALLOCATION& allocation = g_Allocations[index];
+		AddBytes(allocation.category, allocation.bytes, false);
+		allocation.category = category;
+		allocation.name = name;
+		allocation.bytes = bytes;
+	}
+	else
+	{
+		ALLOCATION allocation = { pOwner, id, category, name, bytes };
+		g_Allocations.push_back(allocation);
+	}
+	AddBytes(category, bytes, true);
+	CheckBudget(g_CategoryDomains[category]);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for forgetting an asset that was
+ *  freed.  Unknown assets are ignored, so callers may
+ *  release on every free path.
+ ***********************************************************/
+void MemoryTracker::Release(const void* pOwner, int id)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	int index = FindAllocation(pOwner, id);
+	if (index < 0)
+	{
+		return;
+	}
+
+	AddBytes(g_Allocations[index].category, g_Allocations[index].bytes, false);
+	CheckBudget(g_CategoryDomains[g_Allocations[index].category]);
+	g_Allocations[index] = g_Allocations.back();
+	g_Allocations.pop_back();
+}
+
+/***********************************************************
+ *  GetDomain()
+ *
+ *  This method is used for getting whether a category of
+ *  memory lives on the GPU or the CPU.
+ ***********************************************************/
+MemoryTracker::MEMORY_DOMAIN MemoryTracker::GetDomain(MEMORY_CATEGORY category)
+{
+	return(g_CategoryDomains[category]);
+}
+
+/***********************************************************
+ *  GetCategoryTotal()
+ *
+ *  This method is used for getting the tracked bytes of one
+ *  category.
+ ***********************************************************/
+size_t MemoryTracker::GetCategoryTotal(MEMORY_CATEGORY category)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	return(g_CategoryTotals[category]);
+}
+
+/***********************************************************
+ *  GetDomainTotal()
+ *
+ *  This method is used for getting the tracked bytes of the
+ *  GPU or the CPU.
+ ***********************************************************/
+size_t MemoryTracker::GetDomainTotal(MEMORY_DOMAIN domain)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	return(g_DomainTotals[domain]);
+}
+
+/***********************************************************
+ *  GetDomainPeak()
+ *
+ *  This method is used for getting the most bytes the GPU
+ *  or the CPU held at once, which includes short-lived data
+ *  such as decoded images.
+ ***********************************************************/
+size_t MemoryTracker::GetDomainPeak(MEMORY_DOMAIN domain)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	return(g_DomainPeaks[domain]);
+}
+
+/***********************************************************
+ *  GetAllocations()
+ *
+ *  This method is used for getting a copy of every tracked
+ *  asset.
+ ***********************************************************/
+void MemoryTracker::GetAllocations(std::vector<ALLOCATION>& allocations)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	allocations = g_Allocations;
+}
+
+/***********************************************************
+ *  SetBudget()
+ *
+ *  This method is used for setting the budget of the GPU or
+ *  the CPU.  Going over it prints a warning, and the texture
+ *  residency shrinks its own budget to what is left of the
+ *  GPU budget.
+ ***********************************************************/
+void MemoryTracker::SetBudget(MEMORY_DOMAIN domain, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	g_DomainBudgets[domain] = bytes;
+	g_bBudgetWarned[domain] = false;
+	CheckBudget(domain);
+}
+
+/***********************************************************
+ *  GetBudget()
+ *
+ *  This method is used for getting the budget of the GPU or
+ *  the CPU, which is 0 when there is none.
+ ***********************************************************/
+size_t MemoryTracker::GetBudget(MEMORY_DOMAIN domain)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	return(g_DomainBudgets[domain]);
+}
+
+/***********************************************************
+ *  IsOverBudget()
+ *
+ *  This method is used for checking whether the GPU or the
+ *  CPU uses more than its budget.
+ ***********************************************************/
+bool MemoryTracker::IsOverBudget(MEMORY_DOMAIN domain)
+{
+	std::lock_guard<std::mutex> lock(g_TrackerLock);
+	return((g_DomainBudgets[domain] > 0) && (g_DomainTotals[domain] > g_DomainBudgets[domain]));
+}
+
+/***********************************************************
+ *  Dump()
+ *
+ *  This method is used for printing the totals of each
+ *  domain and category, followed by every tracked asset
+ *  from the largest to the smallest.
+ ***********************************************************/
+void MemoryTracker::Dump()
+{
+	std::vector<ALLOCATION> allocations;
+	size_t categoryTotals[MEMORY_CATEGORY_COUNT];
+	size_t domainTotals[DOMAIN_COUNT];
+	size_t domainPeaks[DOMAIN_COUNT];
+	size_t domainBudgets[DOMAIN_COUNT];
+	{
+		std::lock_guard<std::mutex> lock(g_TrackerLock);
+		allocations = g_Allocations;
+		std::copy(g_CategoryTotals, g_CategoryTotals + MEMORY_CATEGORY_COUNT, categoryTotals);
+		std::copy(g_DomainTotals, g_DomainTotals + DOMAIN_COUNT, domainTotals);
+		std::copy(g_DomainPeaks, g_DomainPeaks + DOMAIN_COUNT, domainPeaks);
+		std::copy(g_DomainBudgets, g_DomainBudgets + DOMAIN_COUNT, domainBudgets);
+	}
+	std::sort(allocations.begin(), allocations.end(),
+		[](const ALLOCATION& a, const ALLOCATION& b) { return a.bytes > b.bytes; });
+
+	std::ios::fmtflags flags = std::cout.flags();
+	std::streamsize precision = std::cout.precision();
+	std::cout << std::fixed << std::setprecision(2);
+
+	std::cout << "Memory:";
+	for (int domain = 0; domain < DOMAIN_COUNT; domain++)
+	{
+		std::cout << " " << g_DomainNames[domain] << " " << (domainTotals[domain] / BYTES_PER_MB)
+			<< " MB (peak " << (domainPeaks[domain] / BYTES_PER_MB) << " MB";
+		if (domainBudgets[domain] > 0)
+		{
+			std::cout << ", budget " << (domainBudgets[domain] / BYTES_PER_MB) << " MB";
+		}
+		std::cout << ")";
+	}
+	std::cout << std::endl;
+
+	for (int category = 0; category < MEMORY_CATEGORY_COUNT; category++)
+	{
+		int count = 0;
+		for (size_t i = 0; i < allocations.size(); i++)
+		{
+			if (allocations[i].category == category)
+				count++;
+		}
+		if (count > 0)
+		{
+			std::cout << "  " << std::left << std::setw(18) << g_CategoryNames[category] << std::right
+				<< std::setw(10) << (categoryTotals[category] / BYTES_PER_MB) << " MB in "
+				<< count << " " << g_DomainNames[g_CategoryDomains[category]] << " allocations" << std::endl;
+		}
+	}
+
+	for (size_t i = 0; i < allocations.size(); i++)
+	{
+		std::cout << "    " << std::setw(10) << (allocations[i].bytes / 1024.0) << " KB  "
+			<< std::left << std::setw(18) << g_CategoryNames[allocations[i].category] << std::right
+			<< allocations[i].name << std::endl;
+	}
+
+	std::cout.flags(flags);
+	std::cout.precision(precision);
+}
@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+// memorytracker.h
+// ============
+// account for the GPU and CPU memory of the textures, meshes and buffers
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MemoryTracker
+ *
+ *  This class keeps a record of every OpenGL allocation and
+ *  of the larger CPU-side data, so the memory of the scene
+ *  can be broken down per asset.  The code that allocates
+ *  reports the size of each asset under an owner pointer
+ *  and an id, reports it again when it is resized, and
+ *  releases it when it is freed.  Sizes are estimates of
+ *  what the driver allocates, counting every mip level.
+ *
+ *  The records are shared by the whole program and guarded
+ *  by a lock, so any thread may report allocations.
+ ***********************************************************/
+class MemoryTracker
+{
+public:
+	// the kinds of tracked memory
+	enum MEMORY_CATEGORY
+	{
+		MEMORY_TEXTURE,
+		MEMORY_VERTEX_BUFFER,
+		MEMORY_INDEX_BUFFER,
+		MEMORY_UNIFORM_BUFFER,
+		MEMORY_STORAGE_BUFFER,
+		MEMORY_RENDER_TARGET,
+		MEMORY_READBACK_BUFFER,
+		MEMORY_IMAGE_DATA,
+		MEMORY_MESH_DATA,
+		MEMORY_SCENE_DATA,
+		MEMORY_CATEGORY_COUNT
+	};
+
+	// where the memory lives
+	enum MEMORY_DOMAIN
+	{
+		DOMAIN_GPU,
+		DOMAIN_CPU,
+		DOMAIN_COUNT
+	};
+
+	// one tracked asset
+	struct ALLOCATION
+	{
+		const void* pOwner;
+		int id;
+		MEMORY_CATEGORY category;
+		std::string name;
+		size_t bytes;
+	};
+
+	// record the size of an asset, replacing an earlier size
+	static void Track(const void* pOwner, int id, MEMORY_CATEGORY category, const std::string& name, size_t bytes);
+	// forget an asset that was freed
+	static void Release(const void* pOwner, int id);
+
+	// get the domain that a category of memory lives in
+	static MEMORY_DOMAIN GetDomain(MEMORY_CATEGORY category);
+	// get the tracked bytes of a category
+	static size_t GetCategoryTotal(MEMORY_CATEGORY category);
+	// get the tracked bytes of a domain, now and at the peak
+	static size_t GetDomainTotal(MEMORY_DOMAIN domain);
+	static size_t GetDomainPeak(MEMORY_DOMAIN domain);
+	// get a copy of every tracked asset
+	static void GetAllocations(std::vector<ALLOCATION>& allocations);
+
+	// set the budget of a domain, 0 for none
+	static void SetBudget(MEMORY_DOMAIN domain, size_t bytes);
+	static size_t GetBudget(MEMORY_DOMAIN domain);
+	// check whether a domain uses more than its budget
+	static bool IsOverBudget(MEMORY_DOMAIN domain);
+
+	// print the totals and every asset to the console
+	static void Dump();
+};
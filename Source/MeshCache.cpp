@@ -0,0 +1,228 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.cpp
+// ============
+// keep generated meshes in memory and on disk, keyed by their parameters
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshCache.h"
+#include "MemoryTracker.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	const char CACHE_MAGIC[4] = { 'M', 'S', 'H', 'C' };
+	// raise whenever the generator or the optimizer produce
+	// different meshes, so older cache files are ignored
+	const uint32_t CACHE_VERSION = 1;
+}
+
+/***********************************************************
+ *  MeshCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshCache::MeshCache(const std::string& directory)
+{
+	m_directory = directory;
+}
+
+/***********************************************************
+ *  ~MeshCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshCache::~MeshCache()
+{
+	m_meshes.clear();
+	MemoryTracker::Release(this, 0);
+}
+
+/***********************************************************
+ *  TrackMemory()
+ *
+ *  This method is used for reporting the memory of the
+ *  meshes kept in memory to the memory tracker.
+ ***********************************************************/
+void MeshCache::TrackMemory() const
+{
+	size_t bytes = 0;
+	std::unordered_map<std::string, MeshGenerator::MESH_DATA>::const_iterator it;
+	for (it = m_meshes.begin(); it != m_meshes.end(); ++it)
+	{
+		bytes += (it->second.vertices.size() * sizeof(MeshGenerator::MESH_VERTEX)) +
+			(it->second.indices.size() * sizeof(uint32_t));
+	}
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_MESH_DATA, "mesh cache", bytes);
+}
+
+/***********************************************************
+ *  GetFilename()
+ *
+ *  This method is used for getting the cache file of a key.
+ *  The keys only use characters that are valid in file
+ *  names.
+ ***********************************************************/
+std::string MeshCache::GetFilename(const std::string& key) const
+{
+	return(m_directory + "/" + key + ".mesh");
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This method is used for reading a mesh from its cache
+ *  file.  Files from another cache version, or that are cut
+ *  short, are ignored.
+ ***********************************************************/
+bool MeshCache::ReadFile(const std::string& key, MeshGenerator::MESH_DATA& mesh) const
+{
+	FILE* input = fopen(GetFilename(key).c_str(), "rb");
+	if (NULL == input)
+	{
+		return(false);
+	}
+
+	FILE_HEADER header;
+	bool bRead = (fread(&header, sizeof(header), 1, input) == 1) &&
+		(memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0) &&
+		(header.version == CACHE_VERSION) &&
+		(header.vertexCount > 0) &&
+		(header.indexCount > 0);
+	if (bRead == true)
+	{
+		mesh.vertices.resize(header.vertexCount);
+		mesh.indices.resize(header.indexCount);
+		bRead = (fread(&mesh.vertices[0], sizeof(MeshGenerator::MESH_VERTEX), header.vertexCount, input) == header.vertexCount) &&
+			(fread(&mesh.indices[0], sizeof(uint32_t), header.indexCount, input) == header.indexCount);
+	}
+	fclose(input);
+
+	// an index past the vertices means the file is damaged
+	for (size_t i = 0; (bRead == true) && (i < mesh.indices.size()); i++)
+	{
+		bRead = (mesh.indices[i] < header.vertexCount);
+	}
+	if (bRead == false)
+	{
+		mesh.vertices.clear();
+		mesh.indices.clear();
+	}
+	return(bRead);
+}
+
+/***********************************************************
+ *  WriteFile()
+ *
+ *  This method is used for writing a mesh to its cache file.
+ *  The mesh is written to a temporary file that is renamed
+ *  over the old one, so another run never reads a partly
+ *  written file.
+ ***********************************************************/
+bool MeshCache::WriteFile(const std::string& key, const MeshGenerator::MESH_DATA& mesh) const
+{
+#ifdef _WIN32
+	CreateDirectoryA(m_directory.c_str(), NULL);
+#else
+	mkdir(m_directory.c_str(), 0755);
+#endif
+
+	std::string filename = GetFilename(key);
+	std::string temporaryFilename = filename + ".tmp";
+	FILE* output = fopen(temporaryFilename.c_str(), "wb");
+	if (NULL == output)
+	{
+		std::cout << "Could not create mesh cache file:" << temporaryFilename << std::endl;
+		return(false);
+	}
+
+	FILE_HEADER header;
+	memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.vertexCount = (uint32_t)mesh.vertices.size();
+	header.indexCount = (uint32_t)mesh.indices.size();
+	fwrite(&header, sizeof(header), 1, output);
+	fwrite(&mesh.vertices[0], sizeof(MeshGenerator::MESH_VERTEX), mesh.vertices.size(), output);
+	fwrite(&mesh.indices[0], sizeof(uint32_t), mesh.indices.size(), output);
+	bool bWritten = (ferror(output) == 0);
+	fclose(output);
+#ifdef _WIN32
+	bWritten = bWritten && (MoveFileExA(temporaryFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE);
+#else
+	bWritten = bWritten && (rename(temporaryFilename.c_str(), filename.c_str()) == 0);
+#endif
+	if (bWritten == false)
+	{
+		std::cout << "Could not write mesh cache file:" << filename << std::endl;
+		remove(temporaryFilename.c_str());
+	}
+	return(bWritten);
+}
+
+/***********************************************************
+ *  Find()
+ *
+ *  This method is used for finding the mesh of a key, first
+ *  in memory and then in the cache directory.  A mesh read
+ *  from disk is kept in memory as well.
+ ***********************************************************/
+bool MeshCache::Find(const std::string& key, MeshGenerator::MESH_DATA& mesh)
+{
+	std::unordered_map<std::string, MeshGenerator::MESH_DATA>::const_iterator found = m_meshes.find(key);
+	if (found != m_meshes.end())
+	{
+		mesh = found->second;
+		return(true);
+	}
+
+	if (ReadFile(key, mesh) == false)
+	{
+		return(false);
+	}
+	m_meshes[key] = mesh;
+	TrackMemory();
+	return(true);
+}
+
+/***********************************************************
+ *  Store()
+ *
+ *  This method is used for keeping a finished mesh in
+ *  memory and in the cache directory.  A failed write only
+ *  means the mesh is generated again on the next run.
+ ***********************************************************/
+void MeshCache::Store(const std::string& key, const MeshGenerator::MESH_DATA& mesh)
+{
+	if (mesh.indices.empty())
+	{
+		return;
+	}
+
+	m_meshes[key] = mesh;
+	TrackMemory();
+	WriteFile(key, mesh);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for forgetting the meshes kept in
+ *  memory.  The cache files are kept.
+ ***********************************************************/
+void MeshCache::Clear()
+{
+	m_meshes.clear();
+	TrackMemory();
+}
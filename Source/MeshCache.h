@@ -0,0 +1,65 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshcache.h
+// ============
+// keep generated meshes in memory and on disk, keyed by their parameters
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshGenerator.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/***********************************************************
+ *  MeshCache
+ *
+ *  This class keeps the finished vertex and index data of
+ *  generated meshes, so a shape with the same parameters is
+ *  only generated and optimized once.  Each mesh is kept in
+ *  memory for the rest of the run and written to a file in
+ *  the cache directory, which later runs read back instead
+ *  of generating the mesh again.
+ ***********************************************************/
+class MeshCache
+{
+public:
+	// constructor
+	MeshCache(const std::string& directory);
+	// destructor
+	~MeshCache();
+
+private:
+	// the header at the start of a cache file
+	struct FILE_HEADER
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+	};
+
+	// the directory that holds the cache files
+	std::string m_directory;
+	// the meshes found or stored during this run
+	std::unordered_map<std::string, MeshGenerator::MESH_DATA> m_meshes;
+
+	// report the memory of the kept meshes
+	void TrackMemory() const;
+	// get the cache file of a key
+	std::string GetFilename(const std::string& key) const;
+	// read a mesh from its cache file
+	bool ReadFile(const std::string& key, MeshGenerator::MESH_DATA& mesh) const;
+	// write a mesh to its cache file
+	bool WriteFile(const std::string& key, const MeshGenerator::MESH_DATA& mesh) const;
+
+public:
+	// find a mesh in memory or on disk
+	bool Find(const std::string& key, MeshGenerator::MESH_DATA& mesh);
+	// keep a mesh in memory and on disk
+	void Store(const std::string& key, const MeshGenerator::MESH_DATA& mesh);
+	// forget the meshes kept in memory
+	void Clear();
+};
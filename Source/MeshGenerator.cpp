@@ -0,0 +1,511 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerator.cpp
+// ============
+// generate the vertex and index data of the basic shape meshes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshGenerator.h"
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	const float PI = 3.14159265358979f;
+
+	// grid rows built by one job
+	const int ROW_GRAIN_SIZE = 16;
+
+	// a face of the box, the tangent cross the bitangent gives
+	// the normal, so the corners wind counter-clockwise
+	struct BOX_FACE
+	{
+		float normal[3];
+		float tangent[3];
+		float bitangent[3];
+	};
+
+	const BOX_FACE g_BoxFaces[] =
+	{
+		{ {  0.0f,  0.0f,  1.0f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },
+		{ {  0.0f,  0.0f, -1.0f }, { -1.0f, 0.0f,  0.0f }, { 0.0f, 1.0f,  0.0f } },
+		{ {  1.0f,  0.0f,  0.0f }, {  0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f,  0.0f } },
+		{ { -1.0f,  0.0f,  0.0f }, {  0.0f, 0.0f,  1.0f }, { 0.0f, 1.0f,  0.0f } },
+		{ {  0.0f,  1.0f,  0.0f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 0.0f, -1.0f } },
+		{ {  0.0f, -1.0f,  0.0f }, {  1.0f, 0.0f,  0.0f }, { 0.0f, 0.0f,  1.0f } }
+	};
+
+	// corner signs and texture coordinates of a quad
+	const float g_QuadCorners[4][2] =
+	{
+		{ -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f }
+	};
+}
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used for appending one vertex to a mesh
+ *  and returning its index.
+ ***********************************************************/
+uint32_t MeshGenerator::AddVertex(
+	MESH_DATA& mesh,
+	float x, float y, float z,
+	float nx, float ny, float nz,
+	float u, float v)
+{
+	mesh.vertices.resize(mesh.vertices.size() + 1);
+	SetVertex(mesh.vertices.back(), x, y, z, nx, ny, nz, u, v);
+	return((uint32_t)mesh.vertices.size() - 1);
+}
+
+/***********************************************************
+ *  SetVertex()
+ *
+ *  This method is used for filling in a vertex that was
+ *  already allocated, so the rows of a grid can be written
+ *  from several threads.
+ ***********************************************************/
+void MeshGenerator::SetVertex(
+	MESH_VERTEX& vertex,
+	float x, float y, float z,
+	float nx, float ny, float nz,
+	float u, float v)
+{
+	vertex.position[0] = x;
+	vertex.position[1] = y;
+	vertex.position[2] = z;
+	vertex.normal[0] = nx;
+	vertex.normal[1] = ny;
+	vertex.normal[2] = nz;
+	vertex.textureCoordinate[0] = u;
+	vertex.textureCoordinate[1] = v;
+}
+
+/***********************************************************
+ *  AddFan()
+ *
+ *  This method is used for appending the triangles of a flat
+ *  convex polygon whose corners were just added in
+ *  counter-clockwise order.
+ ***********************************************************/
+void MeshGenerator::AddFan(MESH_DATA& mesh, uint32_t first, int count)
+{
+	for (int i = 1; i + 1 < count; i++)
+	{
+		mesh.indices.push_back(first);
+		mesh.indices.push_back(first + i);
+		mesh.indices.push_back(first + i + 1);
+	}
+}
+
+/***********************************************************
+ *  ForEachRow()
+ *
+ *  This method is used for running the body over ranges of
+ *  the rows of a grid.  Every row writes its own vertices
+ *  and indices, so the ranges can run on any thread.
+ ***********************************************************/
+void MeshGenerator::ForEachRow(int rowCount, JobSystem* pJobSystem, const JobSystem::RANGE_FUNCTION& body)
+{
+	if (NULL != pJobSystem)
+	{
+		pJobSystem->ParallelFor(rowCount, ROW_GRAIN_SIZE, body);
+	}
+	else
+	{
+		body(0, rowCount);
+	}
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This method is used for building a unit cube around the
+ *  origin, with the whole texture on each of its faces.
+ ***********************************************************/
+void MeshGenerator::BuildBox(MESH_DATA& mesh)
+{
+	for (int face = 0; face < 6; face++)
+	{
+		const BOX_FACE& f = g_BoxFaces[face];
+		uint32_t first = (uint32_t)mesh.vertices.size();
+		for (int corner = 0; corner < 4; corner++)
+		{
+			float s = g_QuadCorners[corner][0] * 0.5f;
+			float t = g_QuadCorners[corner][1] * 0.5f;
+			AddVertex(mesh,
+				(f.normal[0] * 0.5f) + (f.tangent[0] * s) + (f.bitangent[0] * t),
+				(f.normal[1] * 0.5f) + (f.tangent[1] * s) + (f.bitangent[1] * t),
+				(f.normal[2] * 0.5f) + (f.tangent[2] * s) + (f.bitangent[2] * t),
+				f.normal[0], f.normal[1], f.normal[2],
+				s + 0.5f, t + 0.5f);
+		}
+		AddFan(mesh, first, 4);
+	}
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This method is used for building a plane facing up that
+ *  spans -1 to 1 along the X and Z axes.
+ ***********************************************************/
+void MeshGenerator::BuildPlane(MESH_DATA& mesh)
+{
+	uint32_t first = (uint32_t)mesh.vertices.size();
+	for (int corner = 0; corner < 4; corner++)
+	{
+		float s = g_QuadCorners[corner][0];
+		float t = g_QuadCorners[corner][1];
+		AddVertex(mesh, s, 0.0f, -t, 0.0f, 1.0f, 0.0f, (s + 1.0f) * 0.5f, (t + 1.0f) * 0.5f);
+	}
+	AddFan(mesh, first, 4);
+}
+
+/***********************************************************
+ *  BuildPrism()
+ *
+ *  This method is used for building a triangular prism that
+ *  fills a unit cube around the origin, with its triangles
+ *  facing along the Z axis.
+ ***********************************************************/
+void MeshGenerator::BuildPrism(MESH_DATA& mesh)
+{
+	// counter-clockwise triangle, seen from the front
+	const float corners[3][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.0f, 0.5f } };
+
+	uint32_t first = (uint32_t)mesh.vertices.size();
+	for (int i = 0; i < 3; i++)
+	{
+		AddVertex(mesh, corners[i][0], corners[i][1], 0.5f, 0.0f, 0.0f, 1.0f,
+			corners[i][0] + 0.5f, corners[i][1] + 0.5f);
+	}
+	AddFan(mesh, first, 3);
+
+	first = (uint32_t)mesh.vertices.size();
+	for (int i = 2; i >= 0; i--)
+	{
+		AddVertex(mesh, corners[i][0], corners[i][1], -0.5f, 0.0f, 0.0f, -1.0f,
+			0.5f - corners[i][0], corners[i][1] + 0.5f);
+	}
+	AddFan(mesh, first, 3);
+
+	// one quad per edge, facing away from the triangle
+	for (int i = 0; i < 3; i++)
+	{
+		const float* a = corners[i];
+		const float* b = corners[(i + 1) % 3];
+		glm::vec2 normal = glm::normalize(glm::vec2(b[1] - a[1], a[0] - b[0]));
+
+		first = (uint32_t)mesh.vertices.size();
+		AddVertex(mesh, a[0], a[1], 0.5f, normal.x, normal.y, 0.0f, 0.0f, 0.0f);
+		AddVertex(mesh, a[0], a[1], -0.5f, normal.x, normal.y, 0.0f, 1.0f, 0.0f);
+		AddVertex(mesh, b[0], b[1], -0.5f, normal.x, normal.y, 0.0f, 1.0f, 1.0f);
+		AddVertex(mesh, b[0], b[1], 0.5f, normal.x, normal.y, 0.0f, 0.0f, 1.0f);
+		AddFan(mesh, first, 4);
+	}
+}
+
+/***********************************************************
+ *  BuildPyramid4()
+ *
+ *  This method is used for building a four sided pyramid
+ *  that fills a unit cube around the origin.
+ ***********************************************************/
+void MeshGenerator::BuildPyramid4(MESH_DATA& mesh)
+{
+	// base corners, counter-clockwise seen from above
+	const float corners[4][2] = { { -0.5f, 0.5f }, { 0.5f, 0.5f }, { 0.5f, -0.5f }, { -0.5f, -0.5f } };
+	const glm::vec3 apex(0.0f, 0.5f, 0.0f);
+
+	// the base faces down, so its corners are added reversed
+	uint32_t first = (uint32_t)mesh.vertices.size();
+	for (int i = 3; i >= 0; i--)
+	{
+		AddVertex(mesh, corners[i][0], -0.5f, corners[i][1], 0.0f, -1.0f, 0.0f,
+			corners[i][0] + 0.5f, corners[i][1] + 0.5f);
+	}
+	AddFan(mesh, first, 4);
+
+	for (int i = 0; i < 4; i++)
+	{
+		glm::vec3 a(corners[i][0], -0.5f, corners[i][1]);
+		glm::vec3 b(corners[(i + 1) % 4][0], -0.5f, corners[(i + 1) % 4][1]);
+		glm::vec3 normal = glm::normalize(glm::cross(b - a, apex - a));
+
+		first = (uint32_t)mesh.vertices.size();
+		AddVertex(mesh, a.x, a.y, a.z, normal.x, normal.y, normal.z, 0.0f, 0.0f);
+		AddVertex(mesh, b.x, b.y, b.z, normal.x, normal.y, normal.z, 1.0f, 0.0f);
+		AddVertex(mesh, apex.x, apex.y, apex.z, normal.x, normal.y, normal.z, 0.5f, 1.0f);
+		AddFan(mesh, first, 3);
+	}
+}
+
+/***********************************************************
+ *  BuildCurve()
+ *
+ *  This method is used for building a curved shape from its
+ *  parameters.  Tessellations too coarse to form the shape
+ *  are raised to the smallest one that does.
+ ***********************************************************/
+void MeshGenerator::BuildCurve(MESH_DATA& mesh, const CURVE_PARAMETERS& parameters, JobSystem* pJobSystem)
+{
+	int segments = std::max(parameters.segments, 3);
+	switch (parameters.type)
+	{
+	case CURVE_CYLINDER:
+		BuildCylinder(mesh, segments, std::max(parameters.rings, 1),
+			parameters.bottomRadius, parameters.topRadius, pJobSystem);
+		break;
+	case CURVE_SPHERE:
+		BuildSphere(mesh, segments, std::max(parameters.rings, 2), pJobSystem);
+		break;
+	case CURVE_TORUS:
+		BuildTorus(mesh, segments, std::max(parameters.rings, 3),
+			parameters.mainRadius, parameters.tubeRadius, pJobSystem);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  BuildCylinder()
+ *
+ *  This method is used for building a closed cylinder that
+ *  stands on the origin with a height of 1, with its side
+ *  split into rings along the height.  Different top and
+ *  bottom radii give a tapered cylinder, and a top radius
+ *  of 0 gives a cone.  The side repeats its first column so
+ *  the texture does not wrap back at the seam.
+ ***********************************************************/
+void MeshGenerator::BuildCylinder(
+	MESH_DATA& mesh,
+	int segments, int rings,
+	float bottomRadius, float topRadius,
+	JobSystem* pJobSystem)
+{
+	// the side normal leans out by the slope of the taper
+	float slope = bottomRadius - topRadius;
+	float normalScale = 1.0f / sqrtf(1.0f + (slope * slope));
+
+	std::vector<glm::vec2> directions(segments + 1);
+	for (int i = 0; i <= segments; i++)
+	{
+		float angle = (2.0f * PI * i) / segments;
+		directions[i] = glm::vec2(cosf(angle), sinf(angle));
+	}
+
+	// the upper triangles of the top row are empty for a cone
+	const uint32_t first = (uint32_t)mesh.vertices.size();
+	const size_t firstIndex = mesh.indices.size();
+	const uint32_t columns = segments + 1;
+	const bool bCone = (topRadius <= 0.0f);
+	mesh.vertices.resize(first + ((rings + 1) * columns));
+	mesh.indices.resize(firstIndex + (rings * segments * 6) - (bCone ? segments * 3 : 0));
+
+	ForEachRow(rings + 1, pJobSystem, [&](int begin, int end)
+	{
+		for (int ring = begin; ring < end; ring++)
+		{
+			float t = (float)ring / rings;
+			float radius = bottomRadius + ((topRadius - bottomRadius) * t);
+			uint32_t row = first + (ring * columns);
+			for (int i = 0; i <= segments; i++)
+			{
+				float c = directions[i].x;
+				float s = directions[i].y;
+				SetVertex(mesh.vertices[row + i], radius * c, t, radius * s,
+					c * normalScale, slope * normalScale, s * normalScale,
+					(float)i / segments, t);
+			}
+			if (ring == rings)
+			{
+				continue;
+			}
+
+			uint32_t* pIndex = &mesh.indices[firstIndex + (ring * segments * 6)];
+			bool bUpper = ((bCone == false) || (ring < rings - 1));
+			for (int i = 0; i < segments; i++)
+			{
+				uint32_t bottom = row + i;
+				uint32_t top = bottom + columns;
+				*pIndex++ = bottom;
+				*pIndex++ = top;
+				*pIndex++ = bottom + 1;
+				if (bUpper == true)
+				{
+					*pIndex++ = bottom + 1;
+					*pIndex++ = top;
+					*pIndex++ = top + 1;
+				}
+			}
+		}
+	});
+
+	// the caps, the top one wound the other way around
+	for (int cap = 0; cap < 2; cap++)
+	{
+		float radius = (cap == 0) ? bottomRadius : topRadius;
+		float y = (cap == 0) ? 0.0f : 1.0f;
+		float normal = (cap == 0) ? -1.0f : 1.0f;
+		if (radius <= 0.0f)
+		{
+			continue;
+		}
+
+		uint32_t capFirst = (uint32_t)mesh.vertices.size();
+		for (int i = 0; i < segments; i++)
+		{
+			const glm::vec2& direction = directions[(cap == 0) ? i : (segments - i)];
+			AddVertex(mesh, radius * direction.x, y, radius * direction.y, 0.0f, normal, 0.0f,
+				0.5f + (0.5f * direction.x), 0.5f + (0.5f * direction.y));
+		}
+		AddFan(mesh, capFirst, segments);
+	}
+}
+
+/***********************************************************
+ *  BuildCone()
+ *
+ *  This method is used for building a closed cone that
+ *  stands on the origin with a radius and height of 1.
+ ***********************************************************/
+void MeshGenerator::BuildCone(MESH_DATA& mesh, int segments, int rings, JobSystem* pJobSystem)
+{
+	BuildCylinder(mesh, segments, rings, 1.0f, 0.0f, pJobSystem);
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This method is used for building a sphere with a radius
+ *  of 1 around the origin from rings of latitude.  The rows
+ *  at the poles only get the triangles that have an area.
+ ***********************************************************/
+void MeshGenerator::BuildSphere(MESH_DATA& mesh, int segments, int rings, JobSystem* pJobSystem)
+{
+	std::vector<glm::vec2> directions(segments + 1);
+	for (int i = 0; i <= segments; i++)
+	{
+		float angle = (2.0f * PI * i) / segments;
+		directions[i] = glm::vec2(cosf(angle), sinf(angle));
+	}
+
+	// the two pole rows hold half the triangles of the others
+	const uint32_t first = (uint32_t)mesh.vertices.size();
+	const size_t firstIndex = mesh.indices.size();
+	const uint32_t columns = segments + 1;
+	mesh.vertices.resize(first + ((rings + 1) * columns));
+	mesh.indices.resize(firstIndex + ((rings - 1) * segments * 6));
+
+	ForEachRow(rings + 1, pJobSystem, [&](int begin, int end)
+	{
+		for (int ring = begin; ring < end; ring++)
+		{
+			float polar = (PI * ring) / rings;
+			float ringRadius = sinf(polar);
+			float y = cosf(polar);
+			uint32_t row = first + (ring * columns);
+			for (int i = 0; i <= segments; i++)
+			{
+				float x = ringRadius * directions[i].x;
+				float z = ringRadius * directions[i].y;
+				SetVertex(mesh.vertices[row + i], x, y, z, x, y, z,
+					(float)i / segments, 1.0f - ((float)ring / rings));
+			}
+			if (ring == rings)
+			{
+				continue;
+			}
+
+			size_t offset = (ring == 0) ? 0 : ((2 * ring) - 1) * segments * 3;
+			uint32_t* pIndex = &mesh.indices[firstIndex + offset];
+			for (int i = 0; i < segments; i++)
+			{
+				uint32_t top = row + i;
+				uint32_t bottom = top + columns;
+				if (ring > 0)
+				{
+					*pIndex++ = top;
+					*pIndex++ = top + 1;
+					*pIndex++ = bottom;
+				}
+				if (ring < rings - 1)
+				{
+					*pIndex++ = top + 1;
+					*pIndex++ = bottom + 1;
+					*pIndex++ = bottom;
+				}
+			}
+		}
+	});
+}
+
+/***********************************************************
+ *  BuildTorus()
+ *
+ *  This method is used for building a torus around the Y
+ *  axis.  The main radius goes to the center of the tube.
+ ***********************************************************/
+void MeshGenerator::BuildTorus(
+	MESH_DATA& mesh,
+	int segments, int sides,
+	float mainRadius, float tubeRadius,
+	JobSystem* pJobSystem)
+{
+	std::vector<glm::vec2> tubeDirections(sides + 1);
+	for (int j = 0; j <= sides; j++)
+	{
+		float tubeAngle = (2.0f * PI * j) / sides;
+		tubeDirections[j] = glm::vec2(cosf(tubeAngle), sinf(tubeAngle));
+	}
+
+	const uint32_t first = (uint32_t)mesh.vertices.size();
+	const size_t firstIndex = mesh.indices.size();
+	const uint32_t rows = sides + 1;
+	mesh.vertices.resize(first + ((segments + 1) * rows));
+	mesh.indices.resize(firstIndex + (segments * sides * 6));
+
+	ForEachRow(segments + 1, pJobSystem, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			float angle = (2.0f * PI * i) / segments;
+			float c = cosf(angle);
+			float s = sinf(angle);
+			uint32_t row = first + (i * rows);
+			for (int j = 0; j <= sides; j++)
+			{
+				float tubeC = tubeDirections[j].x;
+				float tubeS = tubeDirections[j].y;
+				float radius = mainRadius + (tubeRadius * tubeC);
+				SetVertex(mesh.vertices[row + j], radius * c, tubeRadius * tubeS, radius * s,
+					tubeC * c, tubeS, tubeC * s, (float)i / segments, (float)j / sides);
+			}
+			if (i == segments)
+			{
+				continue;
+			}
+
+			uint32_t* pIndex = &mesh.indices[firstIndex + (i * sides * 6)];
+			for (int j = 0; j < sides; j++)
+			{
+				uint32_t current = row + j;
+				uint32_t next = current + rows;
+				*pIndex++ = current;
+				*pIndex++ = current + 1;
+				*pIndex++ = next;
+				*pIndex++ = next;
+				*pIndex++ = current + 1;
+				*pIndex++ = next + 1;
+			}
+		}
+	});
+}
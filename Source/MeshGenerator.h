@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshgenerator.h
+// ============
+// generate the vertex and index data of the basic shape meshes
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MeshGenerator
+ *
+ *  This class builds the indexed triangle lists of the basic
+ *  shapes.  The shapes keep the sizes of the original shape
+ *  meshes - the box, prism and pyramid fill a unit cube
+ *  around the origin, the plane spans -1 to 1, and the
+ *  cylinders and the cone stand on the origin with a radius
+ *  and height of 1 - so existing scene transforms still fit.
+ *
+ *  The curved shapes take their tessellation as parameters.
+ *  Their vertices and indices are sized up front and filled
+ *  one row of the grid at a time, so a job system can build
+ *  the rows in parallel.
+ ***********************************************************/
+class MeshGenerator
+{
+public:
+	// one vertex, laid out like the attributes of the shaders
+	struct MESH_VERTEX
+	{
+		float position[3];
+		float normal[3];
+		float textureCoordinate[2];
+	};
+
+	// indexed triangle list of one mesh, the indices start at
+	// 0 for every mesh
+	struct MESH_DATA
+	{
+		std::vector<MESH_VERTEX> vertices;
+		std::vector<uint32_t> indices;
+	};
+
+	// the families of curved shapes
+	enum CURVE_TYPE
+	{
+		CURVE_CYLINDER,
+		CURVE_SPHERE,
+		CURVE_TORUS
+	};
+
+	// the parameters of a curved shape - a cylinder tapers from
+	// the bottom to the top radius and is a cone when the top
+	// radius is 0, a torus uses the rings as the sides of its
+	// tube
+	struct CURVE_PARAMETERS
+	{
+		CURVE_TYPE type;
+		int segments;
+		int rings;
+		float bottomRadius;
+		float topRadius;
+		float mainRadius;
+		float tubeRadius;
+	};
+
+	// build the flat shapes
+	static void BuildBox(MESH_DATA& mesh);
+	static void BuildPlane(MESH_DATA& mesh);
+	static void BuildPrism(MESH_DATA& mesh);
+	static void BuildPyramid4(MESH_DATA& mesh);
+
+	// build the curved shapes, on the job system when one is
+	// passed in
+	static void BuildCurve(MESH_DATA& mesh, const CURVE_PARAMETERS& parameters, JobSystem* pJobSystem);
+	static void BuildCylinder(
+		MESH_DATA& mesh,
+		int segments, int rings,
+		float bottomRadius, float topRadius,
+		JobSystem* pJobSystem);
+	static void BuildCone(MESH_DATA& mesh, int segments, int rings, JobSystem* pJobSystem);
+	static void BuildSphere(MESH_DATA& mesh, int segments, int rings, JobSystem* pJobSystem);
+	static void BuildTorus(
+		MESH_DATA& mesh,
+		int segments, int sides,
+		float mainRadius, float tubeRadius,
+		JobSystem* pJobSystem);
+
+private:
+	// append a vertex and return its index
+	static uint32_t AddVertex(
+		MESH_DATA& mesh,
+		float x, float y, float z,
+		float nx, float ny, float nz,
+		float u, float v);
+	// fill in a vertex that was already allocated
+	static void SetVertex(
+		MESH_VERTEX& vertex,
+		float x, float y, float z,
+		float nx, float ny, float nz,
+		float u, float v);
+	// append a flat polygon as a triangle fan
+	static void AddFan(MESH_DATA& mesh, uint32_t first, int count);
+	// run the body over ranges of grid rows, in parallel when
+	// a job system is passed in
+	static void ForEachRow(int rowCount, JobSystem* pJobSystem, const JobSystem::RANGE_FUNCTION& body);
+};
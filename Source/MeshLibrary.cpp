@@ -0,0 +1,844 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlibrary.cpp
+// ============
+// keep every basic shape mesh in one shared vertex and index buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshLibrary.h"
+#include "MemoryTracker.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// default tessellation of the curved shapes, the rings are
+	// the sides of the torus tube
+	const int CURVE_SEGMENTS = 36;
+	const int CURVE_RINGS = 18;
+	const float TORUS_MAIN_RADIUS = 1.0f;
+	const float TORUS_TUBE_RADIUS = 0.2f;
+
+	// reuse the overdraw sort may give up, as a factor of
+	// the cache miss ratio
+	const float OVERDRAW_THRESHOLD = 1.05f;
+
+	// shape names for the load report
+	const char* g_ShapeNames[] =
+	{
+		"box",
+		"plane",
+		"cylinder",
+		"cone",
+		"prism",
+		"pyramid4",
+		"sphere",
+		"tapered cylinder",
+		"torus"
+	};
+
+	// curve type names for the cache keys
+	const char* g_CurveNames[] =
+	{
+		"cylinder",
+		"sphere",
+		"torus"
+	};
+
+	// directory of the mesh cache files
+	const char* MESH_CACHE_DIRECTORY = "meshcache";
+
+	// smallest allocation of the shared buffers
+	const int MIN_VERTEX_CAPACITY = 1024;
+	const int MIN_INDEX_CAPACITY = 4096;
+
+	// largest magnitudes of the signed normalized formats
+	const float SNORM16_MAX = 32767.0f;
+	const float SNORM8_MAX = 127.0f;
+
+	/***********************************************************
+	 *  FloatToHalf()
+	 *
+	 *  This function is used for converting a float to a half
+	 *  float, rounding to the nearest value.  Values too small
+	 *  for a normal half float become zero.
+	 ***********************************************************/
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits = 0;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		if (exponent <= 0)
+		{
+			return((uint16_t)sign);
+		}
+		if (exponent >= 31)
+		{
+			return((uint16_t)(sign | 0x7c00));
+		}
+
+		// a carry out of the mantissa rounds up the exponent
+		uint32_t half = ((uint32_t)exponent << 10) | (mantissa >> 13);
+		half += (mantissa >> 12) & 1;
+		return((uint16_t)(sign | std::min(half, (uint32_t)0x7c00)));
+	}
+
+	/***********************************************************
+	 *  PackNormal()
+	 *
+	 *  This function is used for packing a unit normal into
+	 *  the signed 8-bit normalized values that the vertex
+	 *  fetch expands back to floats.
+	 ***********************************************************/
+	void PackNormal(const float normal[3], int8_t packed[4])
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			float value = std::max(-1.0f, std::min(1.0f, normal[i]));
+			packed[i] = (int8_t)std::lround(value * SNORM8_MAX);
+		}
+		packed[3] = 0;
+	}
+}
+
+/***********************************************************
+ *  MeshLibrary()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshLibrary::MeshLibrary(GLStateCache* pStateCache)
+{
+	m_pStateCache = pStateCache;
+	m_bOptimizeOverdraw = true;
+	m_vertexFormat = VERTEX_FLOAT;
+	m_curveSegments = CURVE_SEGMENTS;
+	m_curveRings = CURVE_RINGS;
+	m_pJobSystem = NULL;
+	m_pMeshCache = new MeshCache(MESH_CACHE_DIRECTORY);
+	m_vertexArray = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_vertexCount = 0;
+	m_vertexCapacity = 0;
+	m_indexCount = 0;
+	m_indexCapacity = 0;
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		m_meshes[i].bLoaded = false;
+		m_meshes[i].baseVertex = 0;
+		m_meshes[i].firstIndex = 0;
+		m_meshes[i].indexCount = 0;
+		m_meshes[i].positionScale = 1.0f;
+		m_bounds[i].bKnown = false;
+	}
+}
+
+/***********************************************************
+ *  ~MeshLibrary()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshLibrary::~MeshLibrary()
+{
+	Destroy();
+	FreeMeshData();
+	delete m_pMeshCache;
+	m_pMeshCache = NULL;
+	m_pJobSystem = NULL;
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the shared vertex array
+ *  object.  The buffers are only allocated when the first
+ *  mesh is loaded.
+ ***********************************************************/
+bool MeshLibrary::Create()
+{
+	if (m_vertexArray == 0)
+	{
+		glGenVertexArrays(1, &m_vertexArray);
+	}
+	return(m_vertexArray != 0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shared buffers.  The
+ *  shapes are generated again when they are drawn next.
+ ***********************************************************/
+void MeshLibrary::Destroy()
+{
+	if (m_vertexArray != 0)
+	{
+		glDeleteVertexArrays(1, &m_vertexArray);
+		m_pStateCache->InvalidateVertexArray();
+	}
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+	}
+	if (m_indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indexBuffer);
+	}
+	MemoryTracker::Release(this, 0);
+	MemoryTracker::Release(this, 1);
+
+	m_vertexArray = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_vertexCount = 0;
+	m_vertexCapacity = 0;
+	m_indexCount = 0;
+	m_indexCapacity = 0;
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		m_meshes[i].bLoaded = false;
+	}
+}
+
+/***********************************************************
+ *  GetCurveParameters()
+ *
+ *  This method is used for getting the parameters of a
+ *  curved shape at the current tessellation.  It returns
+ *  false for the flat shapes.
+ ***********************************************************/
+bool MeshLibrary::GetCurveParameters(MESH_SHAPE shape, MeshGenerator::CURVE_PARAMETERS& parameters) const
+{
+	parameters.type = MeshGenerator::CURVE_CYLINDER;
+	parameters.segments = m_curveSegments;
+	parameters.rings = 1;
+	parameters.bottomRadius = 1.0f;
+	parameters.topRadius = 1.0f;
+	parameters.mainRadius = TORUS_MAIN_RADIUS;
+	parameters.tubeRadius = TORUS_TUBE_RADIUS;
+
+	switch (shape)
+	{
+	case SHAPE_CYLINDER:
+		break;
+	case SHAPE_CONE:
+		parameters.topRadius = 0.0f;
+		break;
+	case SHAPE_TAPERED_CYLINDER:
+		parameters.topRadius = 0.5f;
+		break;
+	case SHAPE_SPHERE:
+		parameters.type = MeshGenerator::CURVE_SPHERE;
+		parameters.rings = m_curveRings;
+		break;
+	case SHAPE_TORUS:
+		parameters.type = MeshGenerator::CURVE_TORUS;
+		parameters.rings = m_curveRings;
+		break;
+	default:
+		return(false);
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  GetCacheKey()
+ *
+ *  This method is used for getting the key that a shape is
+ *  cached under.  It holds every parameter that changes the
+ *  finished mesh, so different tessellations never share
+ *  an entry.
+ ***********************************************************/
+std::string MeshLibrary::GetCacheKey(MESH_SHAPE shape) const
+{
+	char key[160];
+	MeshGenerator::CURVE_PARAMETERS parameters;
+	if (GetCurveParameters(shape, parameters) == true)
+	{
+		snprintf(key, sizeof(key), "%s_%d_%d_%g_%g_%g_%g_%d",
+			g_CurveNames[parameters.type], parameters.segments, parameters.rings,
+			parameters.bottomRadius, parameters.topRadius,
+			parameters.mainRadius, parameters.tubeRadius,
+			m_bOptimizeOverdraw ? 1 : 0);
+	}
+	else
+	{
+		snprintf(key, sizeof(key), "%s_%d", g_ShapeNames[shape], m_bOptimizeOverdraw ? 1 : 0);
+	}
+	return(std::string(key));
+}
+
+/***********************************************************
+ *  GenerateMesh()
+ *
+ *  This method is used for generating the vertex and index
+ *  data of one shape.
+ ***********************************************************/
+void MeshLibrary::GenerateMesh(MESH_SHAPE shape, MeshGenerator::MESH_DATA& mesh)
+{
+	MeshGenerator::CURVE_PARAMETERS parameters;
+	if (GetCurveParameters(shape, parameters) == true)
+	{
+		MeshGenerator::BuildCurve(mesh, parameters, m_pJobSystem);
+		return;
+	}
+
+	switch (shape)
+	{
+	case SHAPE_BOX:
+		MeshGenerator::BuildBox(mesh);
+		break;
+	case SHAPE_PLANE:
+		MeshGenerator::BuildPlane(mesh);
+		break;
+	case SHAPE_PRISM:
+		MeshGenerator::BuildPrism(mesh);
+		break;
+	case SHAPE_PYRAMID4:
+		MeshGenerator::BuildPyramid4(mesh);
+		break;
+	default:
+		break;
+	}
+}
+
+/***********************************************************
+ *  BuildMesh()
+ *
+ *  This method is used for generating a shape and then
+ *  reordering its triangles and vertices for the vertex
+ *  cache, reporting the time and the cache reuse.
+ ***********************************************************/
+void MeshLibrary::BuildMesh(MESH_SHAPE shape, MeshGenerator::MESH_DATA& mesh)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	GenerateMesh(shape, mesh);
+	if (mesh.indices.empty())
+	{
+		return;
+	}
+	std::chrono::duration<double, std::milli> generateTime = std::chrono::steady_clock::now() - start;
+
+	float originalACMR = MeshOptimizer::ComputeACMR(mesh.indices,
+		(int)mesh.vertices.size(), MeshOptimizer::REPORT_CACHE_SIZE);
+	MeshOptimizer::OptimizeVertexCache(mesh.indices, (int)mesh.vertices.size());
+	if (m_bOptimizeOverdraw == true)
+	{
+		MeshOptimizer::OptimizeOverdraw(mesh.indices, mesh.vertices, OVERDRAW_THRESHOLD);
+	}
+	MeshOptimizer::OptimizeVertexFetch(mesh);
+	float optimizedACMR = MeshOptimizer::ComputeACMR(mesh.indices,
+		(int)mesh.vertices.size(), MeshOptimizer::REPORT_CACHE_SIZE);
+	std::chrono::duration<double, std::milli> totalTime = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Built mesh " << g_ShapeNames[shape] << ": " << mesh.vertices.size()
+		<< " vertices, " << (mesh.indices.size() / 3) << " triangles, ACMR "
+		<< originalACMR << " -> " << optimizedACMR << ", generated in "
+		<< generateTime.count() << " ms, optimized in "
+		<< (totalTime.count() - generateTime.count()) << " ms" << std::endl;
+}
+
+/***********************************************************
+ *  SetupVertexArray()
+ *
+ *  This method is used for pointing the shared vertex array
+ *  at the current buffers, with the position, normal and
+ *  texture coordinate at the attribute locations 0, 1 and 2
+ *  that the shaders read.  The compact formats are expanded
+ *  to floats by the vertex fetch, so the shaders read both
+ *  layouts the same way.
+ ***********************************************************/
+void MeshLibrary::SetupVertexArray()
+{
+	const GLsizei stride = (GLsizei)GetVertexSize();
+
+	m_pStateCache->BindVertexArray(m_vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	if (m_vertexFormat == VERTEX_COMPACT)
+	{
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride,
+			(void*)offsetof(COMPACT_VERTEX, position));
+		glVertexAttribPointer(1, 3, GL_BYTE, GL_TRUE, stride,
+			(void*)offsetof(COMPACT_VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+			(void*)offsetof(COMPACT_VERTEX, textureCoordinate));
+	}
+	else
+	{
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride,
+			(void*)offsetof(MeshGenerator::MESH_VERTEX, position));
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+			(void*)offsetof(MeshGenerator::MESH_VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+			(void*)offsetof(MeshGenerator::MESH_VERTEX, textureCoordinate));
+	}
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+}
+
+/***********************************************************
+ *  GetVertexSize()
+ *
+ *  This method is used for getting the bytes of one vertex
+ *  in the current layout.
+ ***********************************************************/
+size_t MeshLibrary::GetVertexSize() const
+{
+	if (m_vertexFormat == VERTEX_COMPACT)
+	{
+		return(sizeof(COMPACT_VERTEX));
+	}
+	return(sizeof(MeshGenerator::MESH_VERTEX));
+}
+
+/***********************************************************
+ *  CompactVertices()
+ *
+ *  This method is used for converting generated vertices to
+ *  the compact layout.  The positions are divided by the
+ *  largest coordinate of the mesh so they use the whole
+ *  16-bit range, and that scale is returned for the model
+ *  matrix to undo.
+ ***********************************************************/
+float MeshLibrary::CompactVertices(
+	const std::vector<MeshGenerator::MESH_VERTEX>& vertices,
+	std::vector<COMPACT_VERTEX>& compact)
+{
+	float scale = 0.0f;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		for (int j = 0; j < 3; j++)
+		{
+			scale = std::max(scale, std::fabs(vertices[i].position[j]));
+		}
+	}
+	if (scale == 0.0f)
+	{
+		scale = 1.0f;
+	}
+
+	compact.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const MeshGenerator::MESH_VERTEX& vertex = vertices[i];
+		COMPACT_VERTEX& packed = compact[i];
+		for (int j = 0; j < 3; j++)
+		{
+			packed.position[j] = (int16_t)std::lround(vertex.position[j] / scale * SNORM16_MAX);
+		}
+		PackNormal(vertex.normal, packed.normal);
+		packed.textureCoordinate[0] = FloatToHalf(vertex.textureCoordinate[0]);
+		packed.textureCoordinate[1] = FloatToHalf(vertex.textureCoordinate[1]);
+	}
+
+	return(scale);
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for growing the shared buffers so
+ *  they hold the passed in counts.  The capacity at least
+ *  doubles, and the loaded meshes are copied on the GPU
+ *  into the new buffers, so their ranges stay valid.
+ ***********************************************************/
+void MeshLibrary::Reserve(int vertexCount, int indexCount)
+{
+	if ((vertexCount <= m_vertexCapacity) && (indexCount <= m_indexCapacity))
+	{
+		return;
+	}
+
+	int vertexCapacity = std::max(vertexCount, std::max(m_vertexCapacity * 2, MIN_VERTEX_CAPACITY));
+	int indexCapacity = std::max(indexCount, std::max(m_indexCapacity * 2, MIN_INDEX_CAPACITY));
+	const GLsizeiptr vertexSize = (GLsizeiptr)GetVertexSize();
+
+	GLuint buffers[2] = { 0, 0 };
+	glGenBuffers(2, buffers);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[0]);
+	glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * vertexSize, NULL, GL_STATIC_DRAW);
+	if (m_vertexCount > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, m_vertexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_vertexCount * vertexSize);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffers[1]);
+	glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(uint32_t), NULL, GL_STATIC_DRAW);
+	if (m_indexCount > 0)
+	{
+		glBindBuffer(GL_COPY_READ_BUFFER, m_indexBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_indexCount * sizeof(uint32_t));
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (m_vertexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_vertexBuffer);
+	}
+	if (m_indexBuffer != 0)
+	{
+		glDeleteBuffers(1, &m_indexBuffer);
+	}
+	m_vertexBuffer = buffers[0];
+	m_indexBuffer = buffers[1];
+	m_vertexCapacity = vertexCapacity;
+	m_indexCapacity = indexCapacity;
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_VERTEX_BUFFER,
+		"shape mesh vertices", vertexCapacity * vertexSize);
+	MemoryTracker::Track(this, 1, MemoryTracker::MEMORY_INDEX_BUFFER,
+		"shape mesh indices", indexCapacity * sizeof(uint32_t));
+
+	SetupVertexArray();
+}
+
+/***********************************************************
+ *  LoadMesh()
+ *
+ *  This method is used for generating a shape and appending
+ *  it to the shared buffers.  Its indices stay relative to
+ *  its first vertex, which is passed as the base vertex when
+ *  the shape is drawn.
+ ***********************************************************/
+bool MeshLibrary::LoadMesh(MESH_SHAPE shape)
+{
+	if ((m_vertexArray == 0) && (Create() == false))
+	{
+		return(false);
+	}
+
+	MeshGenerator::MESH_DATA mesh;
+	if (FindMesh(shape, mesh) == false)
+	{
+		return(false);
+	}
+
+	int vertexCount = (int)mesh.vertices.size();
+	int indexCount = (int)mesh.indices.size();
+	Reserve(m_vertexCount + vertexCount, m_indexCount + indexCount);
+
+	float positionScale = 1.0f;
+	std::vector<COMPACT_VERTEX> compact;
+	const void* pVertices = &mesh.vertices[0];
+	if (m_vertexFormat == VERTEX_COMPACT)
+	{
+		positionScale = CompactVertices(mesh.vertices, compact);
+		pVertices = &compact[0];
+	}
+
+	// the index buffer is part of the vertex array state
+	const size_t vertexSize = GetVertexSize();
+	m_pStateCache->BindVertexArray(m_vertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER,
+		m_vertexCount * vertexSize,
+		vertexCount * vertexSize,
+		pVertices);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,
+		m_indexCount * sizeof(uint32_t),
+		indexCount * sizeof(uint32_t),
+		&mesh.indices[0]);
+
+	m_meshes[shape].bLoaded = true;
+	m_meshes[shape].baseVertex = m_vertexCount;
+	m_meshes[shape].firstIndex = m_indexCount;
+	m_meshes[shape].indexCount = indexCount;
+	m_meshes[shape].positionScale = positionScale;
+	m_vertexCount += vertexCount;
+	m_indexCount += indexCount;
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindMesh()
+ *
+ *  This method is used for getting the finished vertex and
+ *  index data of a shape from the mesh cache, building and
+ *  caching it when it is not there yet.  A shape with the
+ *  same parameters is only built once.  The box around its
+ *  positions is recorded on the way, as both the OpenGL and
+ *  the CPU shapes come from here.
+ ***********************************************************/
+bool MeshLibrary::FindMesh(MESH_SHAPE shape, MeshGenerator::MESH_DATA& mesh)
+{
+	std::string key = GetCacheKey(shape);
+	if (m_pMeshCache->Find(key, mesh) == false)
+	{
+		BuildMesh(shape, mesh);
+		if (mesh.indices.empty())
+		{
+			return(false);
+		}
+		m_pMeshCache->Store(key, mesh);
+	}
+
+	MESH_BOUNDS& bounds = m_bounds[shape];
+	const float* pPosition = mesh.vertices[0].position;
+	bounds.min = glm::vec3(pPosition[0], pPosition[1], pPosition[2]);
+	bounds.max = bounds.min;
+	for (size_t i = 1; i < mesh.vertices.size(); i++)
+	{
+		pPosition = mesh.vertices[i].position;
+		glm::vec3 position(pPosition[0], pPosition[1], pPosition[2]);
+		bounds.min = glm::min(bounds.min, position);
+		bounds.max = glm::max(bounds.max, position);
+	}
+	bounds.bKnown = true;
+	return(true);
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing one shape from the shared
+ *  buffers.  The shared vertex array stays bound between
+ *  draws, so the state cache filters the bind.
+ ***********************************************************/
+void MeshLibrary::Draw(MESH_SHAPE shape)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		return;
+	}
+	if ((m_meshes[shape].bLoaded == false) && (LoadMesh(shape) == false))
+	{
+		return;
+	}
+
+	const MESH_RANGE& range = m_meshes[shape];
+	m_pStateCache->BindVertexArray(m_vertexArray);
+	glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+		(void*)(range.firstIndex * sizeof(uint32_t)), range.baseVertex);
+}
+
+/***********************************************************
+ *  SetOverdrawOptimization()
+ *
+ *  This method is used for choosing whether the triangle
+ *  clusters of the meshes loaded from now on are sorted to
+ *  cut overdraw.
+ ***********************************************************/
+void MeshLibrary::SetOverdrawOptimization(bool bOptimize)
+{
+	m_bOptimizeOverdraw = bOptimize;
+}
+
+/***********************************************************
+ *  SetVertexFormat()
+ *
+ *  This method is used for choosing the layout that the
+ *  vertices are stored in.  Changing it frees the loaded
+ *  shapes, which are loaded again in the new layout when
+ *  they are drawn next.
+ ***********************************************************/
+void MeshLibrary::SetVertexFormat(VERTEX_FORMAT format)
+{
+	if (format == m_vertexFormat)
+	{
+		return;
+	}
+
+	UnloadMeshes();
+	m_vertexFormat = format;
+}
+
+/***********************************************************
+ *  SetTessellation()
+ *
+ *  This method is used for setting the segments around the
+ *  curved shapes and the rings of the sphere and the torus
+ *  tube.  Changing them frees the loaded shapes, which are
+ *  loaded again at the new tessellation when they are drawn
+ *  next.
+ ***********************************************************/
+void MeshLibrary::SetTessellation(int segments, int rings)
+{
+	if ((segments == m_curveSegments) && (rings == m_curveRings))
+	{
+		return;
+	}
+
+	UnloadMeshes();
+	m_curveSegments = segments;
+	m_curveRings = rings;
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system that the
+ *  rows of the curved shapes are built on.  Without one they
+ *  are built on the calling thread.
+ ***********************************************************/
+void MeshLibrary::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+/***********************************************************
+ *  UnloadMeshes()
+ *
+ *  This method is used for freeing the loaded shapes while
+ *  keeping the vertex array, so they are loaded again when
+ *  they are drawn next.
+ ***********************************************************/
+void MeshLibrary::UnloadMeshes()
+{
+	if (m_vertexArray != 0)
+	{
+		Destroy();
+		Create();
+	}
+	FreeMeshData();
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		m_bounds[i].bKnown = false;
+	}
+}
+
+/***********************************************************
+ *  GetMeshData()
+ *
+ *  This method is used for getting the vertex and index data
+ *  of a shape for drawing it on the CPU, without any OpenGL
+ *  buffers.  The data is built on first use and kept until
+ *  the tessellation changes.  It is NULL for an unknown shape.
+ ***********************************************************/
+const MeshGenerator::MESH_DATA* MeshLibrary::GetMeshData(MESH_SHAPE shape)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		return(NULL);
+	}
+
+	MeshGenerator::MESH_DATA& mesh = m_meshData[shape];
+	if (mesh.indices.empty())
+	{
+		if (FindMesh(shape, mesh) == false)
+		{
+			return(NULL);
+		}
+		MemoryTracker::Track(this, 2 + shape, MemoryTracker::MEMORY_MESH_DATA,
+			std::string(g_ShapeNames[shape]) + " mesh data",
+			(mesh.vertices.size() * sizeof(MeshGenerator::MESH_VERTEX)) +
+			(mesh.indices.size() * sizeof(uint32_t)));
+	}
+	return(&mesh);
+}
+
+/***********************************************************
+ *  FreeMeshData()
+ *
+ *  This method is used for freeing the vertex and index data
+ *  kept for drawing the shapes on the CPU.
+ ***********************************************************/
+void MeshLibrary::FreeMeshData()
+{
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		std::vector<MeshGenerator::MESH_VERTEX>().swap(m_meshData[i].vertices);
+		std::vector<uint32_t>().swap(m_meshData[i].indices);
+		MemoryTracker::Release(this, 2 + i);
+	}
+}
+
+/***********************************************************
+ *  GetPositionScale()
+ *
+ *  This method is used for getting the scale that the model
+ *  matrix of a shape needs to undo the compact positions.
+ *  The scale comes from the vertices, so the shape is loaded
+ *  if it was not drawn yet.  It is 1 for float vertices.
+ ***********************************************************/
+float MeshLibrary::GetPositionScale(MESH_SHAPE shape)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		return(1.0f);
+	}
+	if ((m_meshes[shape].bLoaded == false) && (LoadMesh(shape) == false))
+	{
+		return(1.0f);
+	}
+	return(m_meshes[shape].positionScale);
+}
+
+/***********************************************************
+ *  GetMeshBounds()
+ *
+ *  This method is used for getting the mesh-space box around
+ *  the positions of a shape, before any compact scale.  A
+ *  shape that was not loaded yet is uploaded when the shared
+ *  buffers exist, or else built as CPU data.
+ ***********************************************************/
+bool MeshLibrary::GetMeshBounds(MESH_SHAPE shape, glm::vec3& min, glm::vec3& max)
+{
+	if ((shape < 0) || (shape >= SHAPE_COUNT))
+	{
+		return(false);
+	}
+	if (m_bounds[shape].bKnown == false)
+	{
+		if (m_vertexArray != 0)
+		{
+			LoadMesh(shape);
+		}
+		else
+		{
+			GetMeshData(shape);
+		}
+		if (m_bounds[shape].bKnown == false)
+		{
+			return(false);
+		}
+	}
+
+	min = m_bounds[shape].min;
+	max = m_bounds[shape].max;
+	return(true);
+}
+
+/***********************************************************
+ *  GetLoadedMeshCount()
+ *
+ *  This method is used for getting the number of shapes that
+ *  were loaded so far.
+ ***********************************************************/
+int MeshLibrary::GetLoadedMeshCount() const
+{
+	int count = 0;
+	for (int i = 0; i < SHAPE_COUNT; i++)
+	{
+		if (m_meshes[i].bLoaded == true)
+			count++;
+	}
+	return(count);
+}
+
+/***********************************************************
+ *  GetUsedBytes()
+ *
+ *  This method is used for getting the bytes of the shared
+ *  buffers that hold loaded shapes.
+ ***********************************************************/
+size_t MeshLibrary::GetUsedBytes() const
+{
+	return((m_vertexCount * GetVertexSize()) +
+		(m_indexCount * sizeof(uint32_t)));
+}
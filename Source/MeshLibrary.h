@@ -0,0 +1,193 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlibrary.h
+// ============
+// keep every basic shape mesh in one shared vertex and index buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "GLStateCache.h"
+#include "JobSystem.h"
+#include "MeshCache.h"
+#include "MeshGenerator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MeshLibrary
+ *
+ *  This class stores all of the basic shape meshes in one
+ *  vertex buffer and one index buffer behind a single vertex
+ *  array object.  Each mesh is a range of the buffers drawn
+ *  with a base vertex, so switching between meshes does not
+ *  rebind anything.  A mesh is only generated and uploaded
+ *  the first time it is drawn, so the buffers only hold the
+ *  meshes that the scene actually uses, and its triangles
+ *  are reordered for the vertex cache on the way.  The
+ *  finished meshes are cached by their tessellation, so a
+ *  shape is only generated once across runs.
+ *
+ *  The vertices are either stored as the full floats of the
+ *  generator or in a compact 14 byte layout, which cuts the
+ *  vertex bandwidth to under half.  The compact positions are
+ *  16-bit normalized values that are scaled back to the size
+ *  of the mesh by the model matrix of each draw.
+ ***********************************************************/
+class MeshLibrary
+{
+public:
+	// the shapes in the library, in the same order as
+	// SceneManager::SHAPE_MESH
+	enum MESH_SHAPE
+	{
+		SHAPE_BOX,
+		SHAPE_PLANE,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_PRISM,
+		SHAPE_PYRAMID4,
+		SHAPE_SPHERE,
+		SHAPE_TAPERED_CYLINDER,
+		SHAPE_TORUS,
+		SHAPE_COUNT
+	};
+
+	// the layouts the vertices can be stored in
+	enum VERTEX_FORMAT
+	{
+		VERTEX_FLOAT,
+		VERTEX_COMPACT
+	};
+
+	// constructor
+	MeshLibrary(GLStateCache* pStateCache);
+	// destructor
+	~MeshLibrary();
+
+private:
+	// location of one loaded mesh in the shared buffers
+	struct MESH_RANGE
+	{
+		bool bLoaded;
+		GLint baseVertex;
+		GLuint firstIndex;
+		GLsizei indexCount;
+		float positionScale;
+	};
+
+	// mesh-space box around the full float positions of a
+	// shape, found when the shape is first loaded
+	struct MESH_BOUNDS
+	{
+		bool bKnown;
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	// compact vertex - positions as 16-bit normalized values
+	// of the mesh scale, normals as 8-bit normalized values
+	// and texture coordinates as half floats, 14 bytes with
+	// every value on its natural alignment
+	struct COMPACT_VERTEX
+	{
+		int16_t position[3];
+		// the fourth value is unused and keeps the texture
+		// coordinates on two bytes
+		int8_t normal[4];
+		uint16_t textureCoordinate[2];
+	};
+
+	// pointer to the OpenGL state cache object
+	GLStateCache* m_pStateCache;
+	// sort the triangle clusters of new meshes for overdraw
+	bool m_bOptimizeOverdraw;
+	// the layout of the stored vertices
+	VERTEX_FORMAT m_vertexFormat;
+	// the tessellation of the curved shapes
+	int m_curveSegments;
+	int m_curveRings;
+	// builds the rows of the curved shapes in parallel, or NULL
+	JobSystem* m_pJobSystem;
+	// the finished meshes, in memory and on disk
+	MeshCache* m_pMeshCache;
+	// the shared vertex array, vertex buffer and index buffer
+	GLuint m_vertexArray;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	// used and allocated vertices and indices
+	int m_vertexCount;
+	int m_vertexCapacity;
+	int m_indexCount;
+	int m_indexCapacity;
+	// where each shape is stored, once it was loaded
+	MESH_RANGE m_meshes[SHAPE_COUNT];
+	// the box around each shape, once it was loaded
+	MESH_BOUNDS m_bounds[SHAPE_COUNT];
+	// vertex and index data of the shapes drawn on the CPU
+	MeshGenerator::MESH_DATA m_meshData[SHAPE_COUNT];
+
+	// get the parameters of a curved shape
+	bool GetCurveParameters(MESH_SHAPE shape, MeshGenerator::CURVE_PARAMETERS& parameters) const;
+	// get the key that a shape is cached under
+	std::string GetCacheKey(MESH_SHAPE shape) const;
+	// generate the vertex and index data of a shape
+	void GenerateMesh(MESH_SHAPE shape, MeshGenerator::MESH_DATA& mesh);
+	// generate a shape and optimize it for the vertex cache
+	void BuildMesh(MESH_SHAPE shape, MeshGenerator::MESH_DATA& mesh);
+	// get the finished data of a shape from the cache, or
+	// build it
+	bool FindMesh(MESH_SHAPE shape, MeshGenerator::MESH_DATA& mesh);
+	// free the loaded shapes, so they load again on next use
+	void UnloadMeshes();
+	// free the shape data kept for drawing on the CPU
+	void FreeMeshData();
+	// generate and upload a shape into the shared buffers
+	bool LoadMesh(MESH_SHAPE shape);
+	// grow the shared buffers to hold the passed in counts
+	void Reserve(int vertexCount, int indexCount);
+	// point the vertex array at the current buffers
+	void SetupVertexArray();
+	// get the bytes of one stored vertex
+	size_t GetVertexSize() const;
+	// convert generated vertices to the compact layout
+	float CompactVertices(
+		const std::vector<MeshGenerator::MESH_VERTEX>& vertices,
+		std::vector<COMPACT_VERTEX>& compact);
+
+public:
+	// create the shared buffers on the current context
+	bool Create();
+	// free the shared buffers
+	void Destroy();
+	// draw a shape, loading it on first use
+	void Draw(MESH_SHAPE shape);
+	// sort the triangle clusters of new meshes for overdraw
+	void SetOverdrawOptimization(bool bOptimize);
+	// choose the layout the vertices are stored in
+	void SetVertexFormat(VERTEX_FORMAT format);
+	// set the tessellation of the curved shapes
+	void SetTessellation(int segments, int rings);
+	// set the job system used to build the curved shapes
+	void SetJobSystem(JobSystem* pJobSystem);
+	// get the data of a shape for drawing it on the CPU,
+	// building it on first use
+	const MeshGenerator::MESH_DATA* GetMeshData(MESH_SHAPE shape);
+	// get the scale the model matrix needs for a shape,
+	// loading it on first use
+	float GetPositionScale(MESH_SHAPE shape);
+	// get the mesh-space box around a shape, loading it on
+	// first use
+	bool GetMeshBounds(MESH_SHAPE shape, glm::vec3& min, glm::vec3& max);
+
+	// get the number of loaded shapes
+	int GetLoadedMeshCount() const;
+	// get the bytes of buffer memory in use
+	size_t GetUsedBytes() const;
+};
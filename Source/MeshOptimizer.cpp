@@ -0,0 +1,396 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// ============
+// reorder mesh triangles and vertices for the GPU vertex cache
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// vertex scoring constants of Forsyth's algorithm
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	// smallest cluster that may end on a soft cache break
+	const int MIN_CLUSTER_TRIANGLES = 16;
+
+	/***********************************************************
+	 *  VertexScore()
+	 *
+	 *  Score a vertex by its position in the simulated LRU
+	 *  cache and by how many of its triangles are left, so
+	 *  that cached vertices and nearly finished ones are
+	 *  preferred.
+	 ***********************************************************/
+	float VertexScore(int cachePosition, int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return(-1.0f);
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// the last triangle's vertices score the same, so
+			// the order within it does not matter
+			if (cachePosition < 3)
+			{
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else
+			{
+				const float scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+				score = powf(1.0f - ((cachePosition - 3) * scaler), CACHE_DECAY_POWER);
+			}
+		}
+
+		// finish off vertices with few triangles left
+		score += VALENCE_BOOST_SCALE * powf((float)remainingTriangles, -VALENCE_BOOST_POWER);
+		return(score);
+	}
+
+	/***********************************************************
+	 *  CountMisses()
+	 *
+	 *  Count the vertices of a triangle that miss a FIFO cache,
+	 *  adding the missed ones to it.  A vertex is cached while
+	 *  fewer than cacheSize misses happened since it was added.
+	 ***********************************************************/
+	int CountMisses(const uint32_t* triangle, std::vector<int>& insertTimes, int& missCount, int cacheSize)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t vertex = triangle[k];
+			if ((insertTimes[vertex] < 0) || (missCount - insertTimes[vertex] >= cacheSize))
+			{
+				insertTimes[vertex] = missCount;
+				missCount++;
+				misses++;
+			}
+		}
+		return(misses);
+	}
+}
+
+/***********************************************************
+ *  ComputeACMR()
+ *
+ *  This method is used for simulating a FIFO vertex cache of
+ *  the passed in size and getting the vertices shaded per
+ *  triangle.  It is 0.5 at best for large regular meshes
+ *  and 3 when no vertex is ever reused.
+ ***********************************************************/
+float MeshOptimizer::ComputeACMR(const std::vector<uint32_t>& indices, int vertexCount, int cacheSize)
+{
+	int triangleCount = (int)indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return(0.0f);
+	}
+
+	std::vector<int> insertTimes(vertexCount, -1);
+	int missCount = 0;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		CountMisses(&indices[t * 3], insertTimes, missCount, cacheSize);
+	}
+
+	return((float)missCount / triangleCount);
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This method is used for ordering the triangles with Tom
+ *  Forsyth's algorithm.  It simulates an LRU cache, scores
+ *  every vertex by its cache position and its remaining
+ *  triangles, and greedily emits the best scoring triangle.
+ *  Only the triangles touching the cache are rescored after
+ *  each step, so the run time grows linearly with the mesh.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, int vertexCount)
+{
+	int triangleCount = (int)indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// the triangles of every vertex, in one flat array
+	std::vector<int> remaining(vertexCount, 0);
+	for (int i = 0; i < triangleCount * 3; i++)
+	{
+		remaining[indices[i]]++;
+	}
+	std::vector<int> offsets(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		offsets[v + 1] = offsets[v] + remaining[v];
+	}
+	std::vector<int> adjacency(triangleCount * 3);
+	std::vector<int> cursor(offsets.begin(), offsets.end() - 1);
+	for (int t = 0; t < triangleCount; t++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			adjacency[cursor[indices[(t * 3) + k]]++] = t;
+		}
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = VertexScore(-1, remaining[v]);
+	}
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> bEmitted(triangleCount, false);
+	int bestTriangle = 0;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] = vertexScores[indices[t * 3]] +
+			vertexScores[indices[(t * 3) + 1]] + vertexScores[indices[(t * 3) + 2]];
+		if (triangleScores[t] > triangleScores[bestTriangle])
+		{
+			bestTriangle = t;
+		}
+	}
+
+	std::vector<uint32_t> ordered;
+	ordered.reserve(indices.size());
+	std::vector<int> cache;
+	std::vector<int> newCache;
+	cache.reserve(CACHE_SIZE + 3);
+	newCache.reserve(CACHE_SIZE + 3);
+	int scanStart = 0;
+
+	for (int emitted = 0; emitted < triangleCount; emitted++)
+	{
+		// when no cached triangle is left, start over at the
+		// best scoring triangle that was not emitted yet
+		if (bestTriangle < 0)
+		{
+			while (bEmitted[scanStart] == true)
+			{
+				scanStart++;
+			}
+			bestTriangle = scanStart;
+			for (int t = scanStart + 1; t < triangleCount; t++)
+			{
+				if ((bEmitted[t] == false) && (triangleScores[t] > triangleScores[bestTriangle]))
+				{
+					bestTriangle = t;
+				}
+			}
+		}
+
+		const uint32_t* triangle = &indices[bestTriangle * 3];
+		bEmitted[bestTriangle] = true;
+		newCache.clear();
+		for (int k = 0; k < 3; k++)
+		{
+			uint32_t v = triangle[k];
+			ordered.push_back(v);
+			newCache.push_back(v);
+
+			// drop the triangle from the vertex's list
+			int begin = offsets[v];
+			int end = begin + remaining[v];
+			for (int i = begin; i < end; i++)
+			{
+				if (adjacency[i] == bestTriangle)
+				{
+					std::swap(adjacency[i], adjacency[end - 1]);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// the triangle's vertices move to the front of the cache
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			int v = cache[i];
+			if ((v != (int)triangle[0]) && (v != (int)triangle[1]) && (v != (int)triangle[2]))
+			{
+				newCache.push_back(v);
+			}
+		}
+		int newCacheSize = (int)newCache.size();
+		for (int i = 0; i < newCacheSize; i++)
+		{
+			int v = newCache[i];
+			cachePositions[v] = (i < CACHE_SIZE) ? i : -1;
+			vertexScores[v] = VertexScore(cachePositions[v], remaining[v]);
+		}
+
+		// rescore the triangles that touch the cache, including
+		// the ones whose vertices were just evicted
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (int i = 0; i < newCacheSize; i++)
+		{
+			int v = newCache[i];
+			for (int j = offsets[v]; j < offsets[v] + remaining[v]; j++)
+			{
+				int t = adjacency[j];
+				triangleScores[t] = vertexScores[indices[t * 3]] +
+					vertexScores[indices[(t * 3) + 1]] + vertexScores[indices[(t * 3) + 2]];
+				if (triangleScores[t] > bestScore)
+				{
+					bestScore = triangleScores[t];
+					bestTriangle = t;
+				}
+			}
+		}
+
+		if (newCache.size() > CACHE_SIZE)
+		{
+			newCache.resize(CACHE_SIZE);
+		}
+		cache.swap(newCache);
+	}
+
+	indices.swap(ordered);
+}
+
+/***********************************************************
+ *  OptimizeOverdraw()
+ *
+ *  This method is used for sorting the cache-ordered
+ *  triangles in clusters.  A cluster ends where the cache
+ *  starts over, or where most of a triangle misses once the
+ *  cluster has some size, so sorting whole clusters keeps
+ *  most of the reuse.  Clusters facing away from the mesh
+ *  center are drawn first, since they are the ones most
+ *  likely to cover the others.  The new order is only kept
+ *  when its reuse stays within the threshold.
+ ***********************************************************/
+void MeshOptimizer::OptimizeOverdraw(
+	std::vector<uint32_t>& indices,
+	const std::vector<MeshGenerator::MESH_VERTEX>& vertices,
+	float threshold)
+{
+	int triangleCount = (int)indices.size() / 3;
+	int vertexCount = (int)vertices.size();
+	if (triangleCount < 2 * MIN_CLUSTER_TRIANGLES)
+	{
+		return;
+	}
+
+	// split the triangles into clusters at the cache breaks
+	std::vector<int> clusterStarts;
+	std::vector<int> insertTimes(vertexCount, -1);
+	int missCount = 0;
+	for (int t = 0; t < triangleCount; t++)
+	{
+		int misses = CountMisses(&indices[t * 3], insertTimes, missCount, CACHE_SIZE);
+		bool bHardBreak = (misses == 3);
+		bool bSoftBreak = (misses >= 2) && (clusterStarts.empty() == false) &&
+			(t - clusterStarts.back() >= MIN_CLUSTER_TRIANGLES);
+		if ((t == 0) || bHardBreak || bSoftBreak)
+		{
+			clusterStarts.push_back(t);
+		}
+	}
+	int clusterCount = (int)clusterStarts.size();
+	if (clusterCount < 2)
+	{
+		return;
+	}
+	clusterStarts.push_back(triangleCount);
+
+	glm::vec3 meshCenter(0.0f, 0.0f, 0.0f);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		meshCenter = meshCenter + glm::vec3(vertices[v].position[0], vertices[v].position[1], vertices[v].position[2]);
+	}
+	meshCenter = meshCenter * (1.0f / vertexCount);
+
+	// score each cluster by how far it faces away from the center
+	std::vector<std::pair<float, int> > clusterScores(clusterCount);
+	for (int c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 center(0.0f, 0.0f, 0.0f);
+		glm::vec3 normal(0.0f, 0.0f, 0.0f);
+		float area = 0.0f;
+		for (int t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const MeshGenerator::MESH_VERTEX& a = vertices[indices[t * 3]];
+			const MeshGenerator::MESH_VERTEX& b = vertices[indices[(t * 3) + 1]];
+			const MeshGenerator::MESH_VERTEX& d = vertices[indices[(t * 3) + 2]];
+			glm::vec3 pa(a.position[0], a.position[1], a.position[2]);
+			glm::vec3 pb(b.position[0], b.position[1], b.position[2]);
+			glm::vec3 pd(d.position[0], d.position[1], d.position[2]);
+			// the cross product is the normal weighted by area
+			glm::vec3 cross = glm::cross(pb - pa, pd - pa);
+			float triangleArea = glm::length(cross);
+			normal = normal + cross;
+			center = center + ((pa + pb + pd) * (triangleArea / 3.0f));
+			area += triangleArea;
+		}
+
+		float score = 0.0f;
+		if ((area > 0.0f) && (glm::length(normal) > 0.0f))
+		{
+			center = center * (1.0f / area);
+			score = glm::dot(center - meshCenter, glm::normalize(normal));
+		}
+		clusterScores[c] = std::make_pair(-score, c);
+	}
+	std::stable_sort(clusterScores.begin(), clusterScores.end());
+
+	std::vector<uint32_t> sorted;
+	sorted.reserve(indices.size());
+	for (int i = 0; i < clusterCount; i++)
+	{
+		int c = clusterScores[i].second;
+		sorted.insert(sorted.end(), indices.begin() + (clusterStarts[c] * 3), indices.begin() + (clusterStarts[c + 1] * 3));
+	}
+
+	if (ComputeACMR(sorted, vertexCount, CACHE_SIZE) <= ComputeACMR(indices, vertexCount, CACHE_SIZE) * threshold)
+	{
+		indices.swap(sorted);
+	}
+}
+
+/***********************************************************
+ *  OptimizeVertexFetch()
+ *
+ *  This method is used for storing the vertices in the order
+ *  the triangles first use them and remapping the indices.
+ *  Vertices no triangle uses are dropped.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexFetch(MeshGenerator::MESH_DATA& mesh)
+{
+	std::vector<int> remap(mesh.vertices.size(), -1);
+	std::vector<MeshGenerator::MESH_VERTEX> vertices;
+	vertices.reserve(mesh.vertices.size());
+
+	for (size_t i = 0; i < mesh.indices.size(); i++)
+	{
+		uint32_t v = mesh.indices[i];
+		if (remap[v] < 0)
+		{
+			remap[v] = (int)vertices.size();
+			vertices.push_back(mesh.vertices[v]);
+		}
+		mesh.indices[i] = (uint32_t)remap[v];
+	}
+
+	mesh.vertices.swap(vertices);
+}
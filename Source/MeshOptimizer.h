@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ============
+// reorder mesh triangles and vertices for the GPU vertex cache
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshGenerator.h"
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  MeshOptimizer
+ *
+ *  This class reorders the indexed triangle lists of the
+ *  generated meshes.  The triangles are first ordered with
+ *  Forsyth's linear-speed vertex cache algorithm, so that
+ *  the vertices shaded for one triangle are reused by the
+ *  next ones.  Clusters of those triangles can then be
+ *  sorted to draw the outward facing ones first, which cuts
+ *  overdraw as long as it costs little vertex cache reuse.
+ *  Finally the vertices are stored in the order they are
+ *  first used, so fetching them walks memory forward.
+ ***********************************************************/
+class MeshOptimizer
+{
+public:
+	// vertex cache size that the triangle order is tuned for
+	static const int CACHE_SIZE = 32;
+	// FIFO cache size used to report the reuse, a common
+	// size for the post-transform cache of older hardware
+	static const int REPORT_CACHE_SIZE = 16;
+
+	// order the triangles for vertex cache reuse
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, int vertexCount);
+	// sort clusters of cache-ordered triangles to cut overdraw,
+	// keeping the order when the reuse would drop more than the
+	// passed in factor
+	static void OptimizeOverdraw(
+		std::vector<uint32_t>& indices,
+		const std::vector<MeshGenerator::MESH_VERTEX>& vertices,
+		float threshold);
+	// store the vertices in the order they are first used
+	static void OptimizeVertexFetch(MeshGenerator::MESH_DATA& mesh);
+
+	// get the average cache miss ratio - the vertices shaded
+	// per triangle with a FIFO cache of the passed in size
+	static float ComputeACMR(const std::vector<uint32_t>& indices, int vertexCount, int cacheSize);
+};
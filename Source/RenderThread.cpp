@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderthread.cpp
+// ============
+// own the OpenGL context on a dedicated thread fed with render packets
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderThread.h"
+
+/***********************************************************
+ *  RenderThread()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderThread::RenderThread(GLFWwindow* window, const RENDER_FUNCTION& renderFunction)
+{
+	m_pWindow = window;
+	m_renderFunction = renderFunction;
+	m_writeIndex = 0;
+	m_readyIndex = 0;
+	m_bPacketReady = false;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~RenderThread()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderThread::~RenderThread()
+{
+	Stop();
+	m_pWindow = NULL;
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the render thread.  The
+ *  OpenGL context is released from the calling thread, since
+ *  a context can only be current on one thread at a time.
+ ***********************************************************/
+void RenderThread::Start()
+{
+	if (m_thread.joinable())
+	{
+		return;
+	}
+
+	m_bStopping = false;
+	m_bPacketReady = false;
+	glfwMakeContextCurrent(NULL);
+	m_thread = std::thread(&RenderThread::ThreadMain, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the render thread after
+ *  it has drawn the last submitted packet, and taking the
+ *  OpenGL context back on the calling thread.
+ ***********************************************************/
+void RenderThread::Stop()
+{
+	if (m_thread.joinable() == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(m_lock);
+		m_bStopping = true;
+	}
+	m_condition.notify_all();
+	m_thread.join();
+
+	glfwMakeContextCurrent(m_pWindow);
+}
+
+/***********************************************************
+ *  Submit()
+ *
+ *  This method is used for handing a filled packet to the
+ *  render thread.  It only blocks while the render thread
+ *  has not yet taken the previous packet, so at most one
+ *  frame is simulated ahead of the one being rendered.
+ ***********************************************************/
+void RenderThread::Submit(const RENDER_PACKET& packet)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_condition.wait(lock, [this]() { return (m_bPacketReady == false) || m_bStopping; });
+	if (m_bStopping == true)
+	{
+		return;
+	}
+
+	// the render thread only ever reads the other packet
+	m_packets[m_writeIndex] = packet;
+	m_readyIndex = m_writeIndex;
+	m_writeIndex = 1 - m_writeIndex;
+	m_bPacketReady = true;
+
+	lock.unlock();
+	m_condition.notify_all();
+}
+
+/***********************************************************
+ *  ThreadMain()
+ *
+ *  This method is the main loop of the render thread.  It
+ *  takes the published packet, frees the main thread to
+ *  fill the other one, and renders while that happens.
+ ***********************************************************/
+void RenderThread::ThreadMain()
+{
+	glfwMakeContextCurrent(m_pWindow);
+
+	while (true)
+	{
+		int packetIndex = 0;
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_condition.wait(lock, [this]() { return m_bPacketReady || m_bStopping; });
+			if (m_bPacketReady == false)
+			{
+				break;
+			}
+			packetIndex = m_readyIndex;
+			m_bPacketReady = false;
+		}
+		m_condition.notify_all();
+
+		m_renderFunction(m_packets[packetIndex]);
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
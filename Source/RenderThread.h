@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderthread.h
+// ============
+// own the OpenGL context on a dedicated thread fed with render packets
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ViewManager.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/***********************************************************
+ *  RenderThread
+ *
+ *  This class runs the rendering on its own thread, which
+ *  owns the window's OpenGL context while it is started.
+ *  The main thread fills one of two render packets while
+ *  the render thread draws and swaps the other one, so the
+ *  simulation of the next frame overlaps the submission of
+ *  the current one.
+ ***********************************************************/
+class RenderThread
+{
+public:
+	// everything the render thread needs to draw one frame
+	struct RENDER_PACKET
+	{
+		ViewManager::VIEW_STATE view;
+		int framebufferWidth;
+		int framebufferHeight;
+		unsigned int frameNumber;
+		// pick the object along the ray once the frame is drawn
+		bool bPickObject;
+		glm::vec3 pickOrigin;
+		glm::vec3 pickDirection;
+	};
+
+	typedef std::function<void(const RENDER_PACKET& packet)> RENDER_FUNCTION;
+
+	// constructor
+	RenderThread(GLFWwindow* window, const RENDER_FUNCTION& renderFunction);
+	// destructor
+	~RenderThread();
+
+private:
+	// window whose OpenGL context is used for rendering
+	GLFWwindow* m_pWindow;
+	// draws one packet, called on the render thread
+	RENDER_FUNCTION m_renderFunction;
+	std::thread m_thread;
+
+	// the two packets handed between the threads
+	RENDER_PACKET m_packets[2];
+	// packet the main thread fills next
+	int m_writeIndex;
+	// packet published for the render thread
+	int m_readyIndex;
+	// a published packet has not been taken yet
+	bool m_bPacketReady;
+	// the render thread is asked to finish
+	bool m_bStopping;
+	std::mutex m_lock;
+	std::condition_variable m_condition;
+
+	// main loop of the render thread
+	void ThreadMain();
+
+public:
+	// release the context from the calling thread and start
+	// rendering on the render thread
+	void Start();
+	// hand a packet to the render thread, waiting while the
+	// previous packet has not been taken yet
+	void Submit(const RENDER_PACKET& packet);
+	// finish the last packet, stop the render thread and make
+	// the context current on the calling thread again
+	void Stop();
+};
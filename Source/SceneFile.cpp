@@ -0,0 +1,754 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// memory-mapped binary scene files and the text to binary converter
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "MemoryTracker.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// mesh names of the text format, in the same order as
+	// SceneManager::SHAPE_MESH
+	const char* g_MeshNames[] =
+	{
+		"box",
+		"plane",
+		"cylinder",
+		"cone",
+		"prism",
+		"pyramid4",
+		"sphere",
+		"taperedcylinder",
+		"torus"
+	};
+	const int MESH_NAME_COUNT = sizeof(g_MeshNames) / sizeof(g_MeshNames[0]);
+
+	// a node of the text file before it is sorted depth-first
+	struct TEXT_NODE
+	{
+		std::string name;
+		int parent;
+		float position[3];
+	};
+
+	/***********************************************************
+	 *  TEXT_SCENE
+	 *
+	 *  Tables collected from a text scene before they are
+	 *  written out, with the tag lookups that resolve the
+	 *  references between them.
+	 ***********************************************************/
+	struct TEXT_SCENE
+	{
+		std::vector<SceneFile::TEXTURE_RECORD> textures;
+		std::vector<SceneFile::MATERIAL_RECORD> materials;
+		std::vector<SceneFile::LIGHT_RECORD> lights;
+		std::vector<TEXT_NODE> nodes;
+		std::vector<SceneFile::OBJECT_RECORD> objects;
+		std::string strings;
+		std::unordered_map<std::string, int> textureTags;
+		std::unordered_map<std::string, int> materialTags;
+		std::unordered_map<std::string, int> nodeNames;
+		std::unordered_map<std::string, uint32_t> stringOffsets;
+
+		// add a string to the string table once
+		uint32_t AddString(const std::string& value)
+		{
+			std::unordered_map<std::string, uint32_t>::iterator found = stringOffsets.find(value);
+			if (found != stringOffsets.end())
+			{
+				return(found->second);
+			}
+
+			uint32_t offset = (uint32_t)strings.size();
+			strings.append(value);
+			strings.push_back('\0');
+			stringOffsets[value] = offset;
+			return(offset);
+		}
+	};
+
+	/***********************************************************
+	 *  ReadFloats()
+	 *
+	 *  Read a number of floats from a line of the text scene.
+	 ***********************************************************/
+	bool ReadFloats(std::istringstream& line, float* pValues, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (!(line >> pValues[i]))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	/***********************************************************
+	 *  FindTag()
+	 *
+	 *  Resolve a tag to its index, "-" resolves to -1.
+	 ***********************************************************/
+	bool FindTag(const std::unordered_map<std::string, int>& tags, const std::string& tag, int32_t& index)
+	{
+		if (tag == "-")
+		{
+			index = -1;
+			return(true);
+		}
+
+		std::unordered_map<std::string, int>::const_iterator found = tags.find(tag);
+		if (found == tags.end())
+		{
+			return(false);
+		}
+		index = found->second;
+		return(true);
+	}
+
+	/***********************************************************
+	 *  AppendNodes()
+	 *
+	 *  Append a text node and then its subtree to the sorted
+	 *  order, which makes every subtree contiguous.
+	 ***********************************************************/
+	void AppendNodes(int node, const std::vector<std::vector<int> >& children, std::vector<int>& order)
+	{
+		order.push_back(node);
+		for (size_t i = 0; i < children[node].size(); i++)
+		{
+			AppendNodes(children[node][i], children, order);
+		}
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pData = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+	m_fileDescriptor = -1;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a binary scene file into
+ *  memory.  The tables are used in place for as long as the
+ *  file stays open.
+ ***********************************************************/
+bool SceneFile::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(file, &fileSize);
+	HANDLE mapping = NULL;
+	if (fileSize.QuadPart > 0)
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	if (mapping == NULL)
+	{
+		std::cout << "Could not map scene file:" << filename << std::endl;
+		CloseHandle(file);
+		return(false);
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_pData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	int fileDescriptor = open(filename, O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	struct stat fileStatus;
+	void* pMapped = MAP_FAILED;
+	if ((fstat(fileDescriptor, &fileStatus) == 0) && (fileStatus.st_size > 0))
+	{
+		pMapped = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	}
+	if (pMapped == MAP_FAILED)
+	{
+		std::cout << "Could not map scene file:" << filename << std::endl;
+		close(fileDescriptor);
+		return(false);
+	}
+
+	m_fileDescriptor = fileDescriptor;
+	m_pData = (const uint8_t*)pMapped;
+	m_size = (size_t)fileStatus.st_size;
+#endif
+
+	if ((NULL == m_pData) || (Validate(filename) == false))
+	{
+		Close();
+		return(false);
+	}
+
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_SCENE_DATA,
+		std::string(filename) + " (mapped)", m_size);
+	return(true);
+}
+
+/***********************************************************
+ *  OpenText()
+ *
+ *  This method is used for compiling a text scene straight
+ *  into memory, so it can be used like a mapped binary file
+ *  without converting it first.  Used for live reloading.
+ ***********************************************************/
+bool SceneFile::OpenText(const char* textFilename)
+{
+	Close();
+
+	if (CompileTextScene(textFilename, m_textImage) == false)
+	{
+		m_textImage.clear();
+		return(false);
+	}
+
+	m_pData = &m_textImage[0];
+	m_size = m_textImage.size();
+	if (Validate(textFilename) == false)
+	{
+		Close();
+		return(false);
+	}
+
+	MemoryTracker::Track(this, 0, MemoryTracker::MEMORY_SCENE_DATA,
+		std::string(textFilename) + " (compiled)", m_size);
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the scene file.  Any
+ *  record pointers handed out before become invalid.
+ ***********************************************************/
+void SceneFile::Close()
+{
+	MemoryTracker::Release(this, 0);
+
+	// a compiled text scene is not mapped
+	if (m_textImage.empty() == false)
+	{
+		m_textImage.clear();
+		m_pData = NULL;
+	}
+
+#ifdef _WIN32
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if (NULL != m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+#else
+	if (NULL != m_pData)
+	{
+		munmap((void*)m_pData, m_size);
+	}
+	if (m_fileDescriptor >= 0)
+	{
+		close(m_fileDescriptor);
+	}
+#endif
+
+	m_pData = NULL;
+	m_size = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+	m_fileDescriptor = -1;
+}
+
+/***********************************************************
+ *  IsOpen()
+ *
+ *  This method is used for checking whether a scene file is
+ *  mapped.
+ ***********************************************************/
+bool SceneFile::IsOpen() const
+{
+	return(NULL != m_pData);
+}
+
+/***********************************************************
+ *  Validate()
+ *
+ *  This method is used for checking the header of the mapped
+ *  file and that every table lies inside of it.  The records
+ *  themselves are not visited, so opening a file costs the
+ *  same no matter how many objects it holds.
+ ***********************************************************/
+bool SceneFile::Validate(const char* filename)
+{
+	if (m_size < sizeof(FILE_HEADER))
+	{
+		std::cout << "Scene file is too small:" << filename << std::endl;
+		return(false);
+	}
+
+	const FILE_HEADER* pHeader = (const FILE_HEADER*)m_pData;
+	if ((pHeader->magic != FILE_MAGIC) || (pHeader->version != FILE_VERSION))
+	{
+		std::cout << "Not a version " << FILE_VERSION << " scene file:" << filename << std::endl;
+		return(false);
+	}
+	if (pHeader->fileSize != m_size)
+	{
+		std::cout << "Scene file is truncated:" << filename << std::endl;
+		return(false);
+	}
+
+	const TABLE* tables[] = { &pHeader->textures, &pHeader->materials, &pHeader->lights,
+		&pHeader->nodes, &pHeader->objects, &pHeader->strings };
+	const size_t recordSizes[] = { sizeof(TEXTURE_RECORD), sizeof(MATERIAL_RECORD),
+		sizeof(LIGHT_RECORD), sizeof(NODE_RECORD), sizeof(OBJECT_RECORD), 1 };
+	for (int i = 0; i < 6; i++)
+	{
+		uint64_t end = (uint64_t)tables[i]->offset + (uint64_t)tables[i]->count * recordSizes[i];
+		if (((tables[i]->offset % 4) != 0) || (tables[i]->offset < sizeof(FILE_HEADER)) || (end > m_size))
+		{
+			std::cout << "Scene file has a damaged table:" << filename << std::endl;
+			return(false);
+		}
+	}
+
+	// every string must be terminated inside of the table
+	if ((pHeader->strings.count > 0) &&
+		(m_pData[pHeader->strings.offset + pHeader->strings.count - 1] != '\0'))
+	{
+		std::cout << "Scene file has a damaged string table:" << filename << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetTable()
+ *
+ *  This method is used for getting the start of a table in
+ *  the mapped file.
+ ***********************************************************/
+const void* SceneFile::GetTable(const TABLE& table) const
+{
+	return(m_pData + table.offset);
+}
+
+/***********************************************************
+ *  Table accessors
+ *
+ *  These methods are used for getting the record count and
+ *  the first record of each table.  They must only be
+ *  called while a file is open.
+ ***********************************************************/
+int SceneFile::GetTextureCount() const
+{
+	return((int)((const FILE_HEADER*)m_pData)->textures.count);
+}
+
+const SceneFile::TEXTURE_RECORD* SceneFile::GetTextures() const
+{
+	return((const TEXTURE_RECORD*)GetTable(((const FILE_HEADER*)m_pData)->textures));
+}
+
+int SceneFile::GetMaterialCount() const
+{
+	return((int)((const FILE_HEADER*)m_pData)->materials.count);
+}
+
+const SceneFile::MATERIAL_RECORD* SceneFile::GetMaterials() const
+{
+	return((const MATERIAL_RECORD*)GetTable(((const FILE_HEADER*)m_pData)->materials));
+}
+
+int SceneFile::GetLightCount() const
+{
+	return((int)((const FILE_HEADER*)m_pData)->lights.count);
+}
+
+const SceneFile::LIGHT_RECORD* SceneFile::GetLights() const
+{
+	return((const LIGHT_RECORD*)GetTable(((const FILE_HEADER*)m_pData)->lights));
+}
+
+int SceneFile::GetNodeCount() const
+{
+	return((int)((const FILE_HEADER*)m_pData)->nodes.count);
+}
+
+const SceneFile::NODE_RECORD* SceneFile::GetNodes() const
+{
+	return((const NODE_RECORD*)GetTable(((const FILE_HEADER*)m_pData)->nodes));
+}
+
+int SceneFile::GetObjectCount() const
+{
+	return((int)((const FILE_HEADER*)m_pData)->objects.count);
+}
+
+const SceneFile::OBJECT_RECORD* SceneFile::GetObjects() const
+{
+	return((const OBJECT_RECORD*)GetTable(((const FILE_HEADER*)m_pData)->objects));
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a tag or path from the
+ *  string table.  Offsets outside of it give an empty string.
+ ***********************************************************/
+const char* SceneFile::GetString(uint32_t offset) const
+{
+	const TABLE& strings = ((const FILE_HEADER*)m_pData)->strings;
+	if (offset >= strings.count)
+	{
+		return("");
+	}
+	return((const char*)(m_pData + strings.offset + offset));
+}
+
+/***********************************************************
+ *  CompileTextScene()
+ *
+ *  This method is used for compiling a text scene into the
+ *  image of a binary scene file.  Every line holds one
+ *  record, see Scenes/desk.scene for the fields.  Tags are
+ *  resolved to indices here, and the nodes are sorted
+ *  depth-first, so the runtime never has to look anything up.
+ ***********************************************************/
+bool SceneFile::CompileTextScene(const char* textFilename, std::vector<uint8_t>& image)
+{
+	std::ifstream input(textFilename);
+	if (!input)
+	{
+		std::cout << "Could not open text scene:" << textFilename << std::endl;
+		return(false);
+	}
+
+	TEXT_SCENE scene;
+	int pointLights = 0;
+	int directionalLights = 0;
+	std::string text;
+	int lineNumber = 0;
+
+	while (std::getline(input, text))
+	{
+		lineNumber++;
+		std::istringstream line(text);
+		std::string kind;
+		if (!(line >> kind) || (kind[0] == '#'))
+		{
+			continue;
+		}
+
+		bool bValid = true;
+		std::string error;
+		if (kind == "texture")
+		{
+			std::string tag;
+			std::string path;
+			bValid = (line >> tag >> path) && (scene.textureTags.count(tag) == 0);
+			if (bValid)
+			{
+				TEXTURE_RECORD record;
+				record.tagOffset = scene.AddString(tag);
+				record.pathOffset = scene.AddString(path);
+				scene.textureTags[tag] = (int)scene.textures.size();
+				scene.textures.push_back(record);
+			}
+		}
+		else if (kind == "material")
+		{
+			std::string tag;
+			MATERIAL_RECORD record;
+			bValid = (line >> tag) && (scene.materialTags.count(tag) == 0) &&
+				ReadFloats(line, record.ambientColor, 3) &&
+				ReadFloats(line, &record.ambientStrength, 1) &&
+				ReadFloats(line, record.diffuseColor, 3) &&
+				ReadFloats(line, record.specularColor, 3) &&
+				ReadFloats(line, &record.shininess, 1);
+			if (bValid)
+			{
+				record.tagOffset = scene.AddString(tag);
+				scene.materialTags[tag] = (int)scene.materials.size();
+				scene.materials.push_back(record);
+			}
+		}
+		else if ((kind == "pointlight") || (kind == "dirlight"))
+		{
+			LIGHT_RECORD record;
+			bool bPoint = (kind == "pointlight");
+			record.type = bPoint ? LIGHT_POINT : LIGHT_DIRECTIONAL;
+			record.focalStrength = 0.0f;
+			record.specularIntensity = 0.0f;
+			bValid = ReadFloats(line, record.vector, 3) &&
+				ReadFloats(line, record.ambientColor, 3) &&
+				ReadFloats(line, record.diffuseColor, 3) &&
+				ReadFloats(line, record.specularColor, 3) &&
+				((bPoint == false) || (ReadFloats(line, &record.focalStrength, 1) &&
+					ReadFloats(line, &record.specularIntensity, 1)));
+			if (bPoint ? (++pointLights > MAX_POINT_LIGHTS) : (++directionalLights > 1))
+			{
+				error = "too many lights of this kind";
+				bValid = false;
+			}
+			if (bValid)
+			{
+				scene.lights.push_back(record);
+			}
+		}
+		else if (kind == "node")
+		{
+			TEXT_NODE node;
+			std::string parent;
+			int32_t parentIndex = -1;
+			bValid = (line >> node.name >> parent) && (scene.nodeNames.count(node.name) == 0) &&
+				FindTag(scene.nodeNames, parent, parentIndex) &&
+				ReadFloats(line, node.position, 3);
+			if (bValid)
+			{
+				node.parent = parentIndex;
+				scene.nodeNames[node.name] = (int)scene.nodes.size();
+				scene.nodes.push_back(node);
+			}
+		}
+		else if (kind == "object")
+		{
+			std::string mesh;
+			std::string node;
+			std::string texture;
+			std::string material;
+			OBJECT_RECORD record;
+			bValid = (line >> mesh >> node) &&
+				FindTag(scene.nodeNames, node, record.node) &&
+				ReadFloats(line, record.scale, 3) &&
+				ReadFloats(line, record.rotationDegrees, 3) &&
+				ReadFloats(line, record.position, 3) &&
+				(line >> texture) && FindTag(scene.textureTags, texture, record.texture) &&
+				ReadFloats(line, record.color, 4) &&
+				ReadFloats(line, record.UVscale, 2) &&
+				(line >> material) && FindTag(scene.materialTags, material, record.material);
+
+			record.mesh = MESH_NAME_COUNT;
+			for (int i = 0; i < MESH_NAME_COUNT; i++)
+			{
+				if (mesh == g_MeshNames[i])
+					record.mesh = i;
+			}
+			if (record.mesh == MESH_NAME_COUNT)
+			{
+				error = "unknown mesh " + mesh;
+				bValid = false;
+			}
+			if (bValid)
+			{
+				scene.objects.push_back(record);
+			}
+		}
+		else
+		{
+			error = "unknown record " + kind;
+			bValid = false;
+		}
+
+		if (bValid == false)
+		{
+			std::cout << textFilename << ":" << lineNumber << ": invalid " << kind << " line";
+			if (error.empty() == false)
+			{
+				std::cout << ", " << error;
+			}
+			std::cout << std::endl;
+			return(false);
+		}
+	}
+
+	// sort the nodes depth-first and remap the references
+	int nodeCount = (int)scene.nodes.size();
+	std::vector<std::vector<int> > children(nodeCount);
+	std::vector<int> order;
+	for (int i = 0; i < nodeCount; i++)
+	{
+		if (scene.nodes[i].parent >= 0)
+			children[scene.nodes[i].parent].push_back(i);
+	}
+	for (int i = 0; i < nodeCount; i++)
+	{
+		if (scene.nodes[i].parent < 0)
+			AppendNodes(i, children, order);
+	}
+	int sortedCount = (int)order.size();
+	std::vector<int> sortedIndex(nodeCount);
+	for (int i = 0; i < sortedCount; i++)
+	{
+		sortedIndex[order[i]] = i;
+	}
+
+	std::vector<NODE_RECORD> nodes(sortedCount);
+	for (int i = 0; i < sortedCount; i++)
+	{
+		const TEXT_NODE& node = scene.nodes[order[i]];
+		nodes[i].parent = (node.parent >= 0) ? sortedIndex[node.parent] : -1;
+		memcpy(nodes[i].position, node.position, sizeof(nodes[i].position));
+		nodes[i].nameOffset = scene.AddString(node.name);
+	}
+	for (size_t i = 0; i < scene.objects.size(); i++)
+	{
+		if (scene.objects[i].node >= 0)
+			scene.objects[i].node = sortedIndex[scene.objects[i].node];
+	}
+
+	// lay the tables out one after the other behind the header
+	FILE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	header.magic = FILE_MAGIC;
+	header.version = FILE_VERSION;
+
+	uint32_t offset = sizeof(FILE_HEADER);
+	TABLE* tables[] = { &header.textures, &header.materials, &header.lights,
+		&header.nodes, &header.objects, &header.strings };
+	const size_t counts[] = { scene.textures.size(), scene.materials.size(),
+		scene.lights.size(), nodes.size(), scene.objects.size(), scene.strings.size() };
+	const size_t recordSizes[] = { sizeof(TEXTURE_RECORD), sizeof(MATERIAL_RECORD),
+		sizeof(LIGHT_RECORD), sizeof(NODE_RECORD), sizeof(OBJECT_RECORD), 1 };
+	for (int i = 0; i < 6; i++)
+	{
+		tables[i]->offset = offset;
+		tables[i]->count = (uint32_t)counts[i];
+		offset += (uint32_t)(counts[i] * recordSizes[i]);
+		offset = (offset + 3) & ~3u;
+	}
+	header.fileSize = offset;
+
+	// copy the tables into a zeroed image, which also pads
+	// every table up to the next 4 byte boundary
+	image.assign(header.fileSize, 0);
+	memcpy(&image[0], &header, sizeof(header));
+	if (scene.textures.size() > 0)
+		memcpy(&image[header.textures.offset], &scene.textures[0], scene.textures.size() * sizeof(TEXTURE_RECORD));
+	if (scene.materials.size() > 0)
+		memcpy(&image[header.materials.offset], &scene.materials[0], scene.materials.size() * sizeof(MATERIAL_RECORD));
+	if (scene.lights.size() > 0)
+		memcpy(&image[header.lights.offset], &scene.lights[0], scene.lights.size() * sizeof(LIGHT_RECORD));
+	if (nodes.size() > 0)
+		memcpy(&image[header.nodes.offset], &nodes[0], nodes.size() * sizeof(NODE_RECORD));
+	if (scene.objects.size() > 0)
+		memcpy(&image[header.objects.offset], &scene.objects[0], scene.objects.size() * sizeof(OBJECT_RECORD));
+	if (scene.strings.size() > 0)
+		memcpy(&image[header.strings.offset], scene.strings.data(), scene.strings.size());
+
+	return(true);
+}
+
+/***********************************************************
+ *  ConvertTextScene()
+ *
+ *  This method is used for converting a text scene into a
+ *  binary scene file.
+ ***********************************************************/
+bool SceneFile::ConvertTextScene(const char* textFilename, const char* binaryFilename)
+{
+	std::vector<uint8_t> image;
+	if (CompileTextScene(textFilename, image) == false)
+	{
+		return(false);
+	}
+
+	// write a temporary file and rename it over the old one,
+	// so a running program that has the old file mapped keeps
+	// reading complete contents until it reloads
+	std::string temporaryFilename = std::string(binaryFilename) + ".tmp";
+	FILE* output = fopen(temporaryFilename.c_str(), "wb");
+	if (NULL == output)
+	{
+		std::cout << "Could not create scene file:" << temporaryFilename << std::endl;
+		return(false);
+	}
+
+	fwrite(&image[0], 1, image.size(), output);
+	bool bWritten = (ferror(output) == 0);
+	fclose(output);
+#ifdef _WIN32
+	bWritten = bWritten && (MoveFileExA(temporaryFilename.c_str(), binaryFilename, MOVEFILE_REPLACE_EXISTING) != FALSE);
+#else
+	bWritten = bWritten && (rename(temporaryFilename.c_str(), binaryFilename) == 0);
+#endif
+	if (bWritten == false)
+	{
+		std::cout << "Could not write scene file:" << binaryFilename << std::endl;
+		remove(temporaryFilename.c_str());
+		return(false);
+	}
+
+	const FILE_HEADER* pHeader = (const FILE_HEADER*)&image[0];
+	std::cout << "Converted " << textFilename << " to " << binaryFilename << ": "
+		<< pHeader->textures.count << " textures, " << pHeader->materials.count << " materials, "
+		<< pHeader->lights.count << " lights, " << pHeader->nodes.count << " nodes, "
+		<< pHeader->objects.count << " objects" << std::endl;
+	return(true);
+}
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// memory-mapped binary scene files and the text to binary converter
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class maps a binary scene file into memory and hands
+ *  out its tables in place.  Every record is made of 4 byte
+ *  fields in little-endian order, tables start on 4 byte
+ *  boundaries, and tags and paths are offsets into one
+ *  string table, so nothing has to be parsed or allocated
+ *  when the file is opened.  Texture, material and node
+ *  references are indices that were resolved from the tags
+ *  when the text scene was converted.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// "SCNB" read as a little-endian integer
+	static const uint32_t FILE_MAGIC = 0x424E4353;
+	// bumped whenever the layout of a record changes
+	static const uint32_t FILE_VERSION = 1;
+	// light sources supported by the scene shader
+	static const int MAX_POINT_LIGHTS = 4;
+
+	// kinds of light records
+	enum LIGHT_TYPE
+	{
+		LIGHT_POINT,
+		LIGHT_DIRECTIONAL
+	};
+
+	// location of one table in the file
+	struct TABLE
+	{
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	// first bytes of every scene file
+	struct FILE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t fileSize;
+		uint32_t reserved;
+		TABLE textures;
+		TABLE materials;
+		TABLE lights;
+		TABLE nodes;
+		TABLE objects;
+		// the count of the string table is in bytes
+		TABLE strings;
+	};
+
+	struct TEXTURE_RECORD
+	{
+		uint32_t tagOffset;
+		uint32_t pathOffset;
+	};
+
+	struct MATERIAL_RECORD
+	{
+		float ambientColor[3];
+		float ambientStrength;
+		float diffuseColor[3];
+		float specularColor[3];
+		float shininess;
+		uint32_t tagOffset;
+	};
+
+	struct LIGHT_RECORD
+	{
+		uint32_t type;
+		// position of a point light, direction of a directional one
+		float vector[3];
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float focalStrength;
+		float specularIntensity;
+	};
+
+	// transform node, sorted depth-first like the scene graph
+	struct NODE_RECORD
+	{
+		int32_t parent;
+		float position[3];
+		uint32_t nameOffset;
+	};
+
+	struct OBJECT_RECORD
+	{
+		// one of the SceneManager::SHAPE_MESH values
+		uint32_t mesh;
+		// node the transform is relative to, or -1
+		int32_t node;
+		float scale[3];
+		float rotationDegrees[3];
+		float position[3];
+		// texture record index, or -1 to draw with the color
+		int32_t texture;
+		float color[4];
+		float UVscale[2];
+		// material record index, or -1
+		int32_t material;
+	};
+
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+private:
+	// start and size of the mapped file
+	const uint8_t* m_pData;
+	size_t m_size;
+	// operating system handles of the mapping
+	void* m_fileHandle;
+	void* m_mappingHandle;
+	int m_fileDescriptor;
+	// image of a text scene compiled in memory, used in
+	// place of a mapping
+	std::vector<uint8_t> m_textImage;
+
+	// check the header and that every table is inside the file
+	bool Validate(const char* filename);
+	// get the start of a table
+	const void* GetTable(const TABLE& table) const;
+	// compile a text scene into the image of a binary file
+	static bool CompileTextScene(const char* textFilename, std::vector<uint8_t>& image);
+
+public:
+	// map a binary scene file, closing the previous one
+	bool Open(const char* filename);
+	// compile a text scene into memory, closing the previous
+	// scene file
+	bool OpenText(const char* textFilename);
+	// unmap the scene file
+	void Close();
+	// check whether a scene file is mapped
+	bool IsOpen() const;
+
+	// get the tables of the mapped file
+	int GetTextureCount() const;
+	const TEXTURE_RECORD* GetTextures() const;
+	int GetMaterialCount() const;
+	const MATERIAL_RECORD* GetMaterials() const;
+	int GetLightCount() const;
+	const LIGHT_RECORD* GetLights() const;
+	int GetNodeCount() const;
+	const NODE_RECORD* GetNodes() const;
+	int GetObjectCount() const;
+	const OBJECT_RECORD* GetObjects() const;
+	// get a string from the string table, empty when invalid
+	const char* GetString(uint32_t offset) const;
+
+	// convert a text scene description into a binary scene file
+	static bool ConvertTextScene(const char* textFilename, const char* binaryFilename);
+};
@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// parent/child transform hierarchy stored as a flat depth-first array
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <iostream>
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+}
+
+/***********************************************************
+ *  ~SceneGraph()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneGraph::~SceneGraph()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing all of the nodes.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	m_parents.clear();
+	m_subtreeEnds.clear();
+	m_localTransforms.clear();
+	m_worldTransforms.clear();
+	m_dirtyFlags.clear();
+	m_dirtyNodes.clear();
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for appending a node to the graph.
+ *  Appending keeps the array depth-first only while the
+ *  parent's subtree is still open, meaning it ends at the
+ *  new node, so a parent that was closed by a later sibling
+ *  subtree is rejected.  It returns the index of the new
+ *  node, or -1 on failure.
+ ***********************************************************/
+int SceneGraph::AddNode(int parent, const glm::mat4& localTransform)
+{
+	int node = (int)m_parents.size();
+
+	if ((parent >= node) || ((parent >= 0) && (m_subtreeEnds[parent] != node)))
+	{
+		std::cout << "Scene graph node " << node << " cannot be added under node "
+			<< parent << ", its children must be added depth-first" << std::endl;
+		return(-1);
+	}
+	if (parent < -1)
+	{
+		parent = -1;
+	}
+
+	m_parents.push_back(parent);
+	m_subtreeEnds.push_back(node + 1);
+	m_localTransforms.push_back(localTransform);
+	m_worldTransforms.push_back(localTransform);
+	m_dirtyFlags.push_back(0);
+
+	// the new node extends the subtree of all its ancestors
+	for (int ancestor = parent; ancestor >= 0; ancestor = m_parents[ancestor])
+	{
+		m_subtreeEnds[ancestor] = node + 1;
+	}
+
+	MarkDirty(node);
+	return(node);
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of nodes.
+ ***********************************************************/
+int SceneGraph::GetNodeCount() const
+{
+	return((int)m_parents.size());
+}
+
+/***********************************************************
+ *  GetParent()
+ *
+ *  This method is used for getting the parent of a node.
+ ***********************************************************/
+int SceneGraph::GetParent(int node) const
+{
+	return(m_parents[node]);
+}
+
+/***********************************************************
+ *  GetSubtreeEnd()
+ *
+ *  This method is used for getting one past the last node
+ *  in the subtree of a node.
+ ***********************************************************/
+int SceneGraph::GetSubtreeEnd(int node) const
+{
+	return(m_subtreeEnds[node]);
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for adding a node to the dirty list,
+ *  unless it is already waiting there.
+ ***********************************************************/
+void SceneGraph::MarkDirty(int node)
+{
+	if (m_dirtyFlags[node] == 0)
+	{
+		m_dirtyFlags[node] = 1;
+		m_dirtyNodes.push_back(node);
+	}
+}
+
+/***********************************************************
+ *  SetLocalTransform()
+ *
+ *  This method is used for setting the transform of a node
+ *  relative to its parent.  The world transforms of the
+ *  node and its subtree are recomputed on the next update.
+ ***********************************************************/
+void SceneGraph::SetLocalTransform(int node, const glm::mat4& localTransform)
+{
+	if (m_localTransforms[node] == localTransform)
+	{
+		return;
+	}
+
+	m_localTransforms[node] = localTransform;
+	MarkDirty(node);
+}
+
+/***********************************************************
+ *  GetLocalTransform()
+ *
+ *  This method is used for getting the transform of a node
+ *  relative to its parent.
+ ***********************************************************/
+const glm::mat4& SceneGraph::GetLocalTransform(int node) const
+{
+	return(m_localTransforms[node]);
+}
+
+/***********************************************************
+ *  GetWorldTransform()
+ *
+ *  This method is used for getting the world transform of a
+ *  node as of the last update.
+ ***********************************************************/
+const glm::mat4& SceneGraph::GetWorldTransform(int node) const
+{
+	return(m_worldTransforms[node]);
+}
+
+/***********************************************************
+ *  UpdateSubtree()
+ *
+ *  This method is used for recomputing the world transforms
+ *  of a subtree front to back.  Parents always come before
+ *  their children, so each parent is already up to date
+ *  when its children read it.
+ ***********************************************************/
+int SceneGraph::UpdateSubtree(int root)
+{
+	int end = m_subtreeEnds[root];
+	int parent = m_parents[root];
+
+	if (parent >= 0)
+		m_worldTransforms[root] = m_worldTransforms[parent] * m_localTransforms[root];
+	else
+		m_worldTransforms[root] = m_localTransforms[root];
+	m_dirtyFlags[root] = 0;
+
+	for (int node = root + 1; node < end; node++)
+	{
+		m_worldTransforms[node] = m_worldTransforms[m_parents[node]] * m_localTransforms[node];
+		m_dirtyFlags[node] = 0;
+	}
+
+	return(end - root);
+}
+
+/***********************************************************
+ *  UpdateWorldTransforms()
+ *
+ *  This method is used for recomputing the world transforms
+ *  of every dirty subtree.  The dirty nodes are sorted, so a
+ *  dirty node inside a subtree that was just recomputed is
+ *  skipped instead of being recomputed again.
+ ***********************************************************/
+int SceneGraph::UpdateWorldTransforms()
+{
+	if (m_dirtyNodes.empty())
+	{
+		return(0);
+	}
+
+	std::sort(m_dirtyNodes.begin(), m_dirtyNodes.end());
+
+	int updated = 0;
+	int coveredEnd = 0;
+	for (size_t i = 0; i < m_dirtyNodes.size(); i++)
+	{
+		int node = m_dirtyNodes[i];
+		if (node < coveredEnd)
+		{
+			continue;
+		}
+
+		updated += UpdateSubtree(node);
+		coveredEnd = m_subtreeEnds[node];
+	}
+
+	m_dirtyNodes.clear();
+	return(updated);
+}
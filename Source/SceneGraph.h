@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// parent/child transform hierarchy stored as a flat depth-first array
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class keeps a transform hierarchy in arrays sorted
+ *  depth-first, so every parent comes before its children
+ *  and the subtree of a node is the contiguous index range
+ *  from the node up to its subtree end.  Changing a local
+ *  transform only marks the node dirty, and the update
+ *  recomputes each dirty subtree in one linear pass, so
+ *  moving an assembly costs work proportional to its size.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	// constructor
+	SceneGraph();
+	// destructor
+	~SceneGraph();
+
+private:
+	// parent of every node, -1 for a root
+	std::vector<int> m_parents;
+	// one past the last node in the subtree of every node
+	std::vector<int> m_subtreeEnds;
+	// transform relative to the parent
+	std::vector<glm::mat4> m_localTransforms;
+	// transform relative to the world, valid after an update
+	std::vector<glm::mat4> m_worldTransforms;
+	// set while a node is waiting in the dirty list
+	std::vector<uint8_t> m_dirtyFlags;
+	// nodes whose local transform changed since the update
+	std::vector<int> m_dirtyNodes;
+
+	// mark a node for the next update
+	void MarkDirty(int node);
+	// recompute the world transforms of one subtree
+	int UpdateSubtree(int root);
+
+public:
+	// remove all of the nodes
+	void Clear();
+	// add a node under the passed in parent, or a root for
+	// -1 - the parent must be the last added node or one of
+	// its ancestors, which keeps the array depth-first
+	int AddNode(int parent, const glm::mat4& localTransform);
+
+	// get the number of nodes
+	int GetNodeCount() const;
+	// get the parent of a node, -1 for a root
+	int GetParent(int node) const;
+	// get one past the last node in the subtree of a node
+	int GetSubtreeEnd(int node) const;
+
+	// set the transform of a node relative to its parent
+	void SetLocalTransform(int node, const glm::mat4& localTransform);
+	// get the transform of a node relative to its parent
+	const glm::mat4& GetLocalTransform(int node) const;
+	// get the world transform of a node from the last update
+	const glm::mat4& GetWorldTransform(int node) const;
+
+	// recompute the world transforms of the dirty subtrees,
+	// returning the number of nodes that were recomputed
+	int UpdateWorldTransforms();
+};
@@ -9,12 +9,23 @@
 
 #include "SceneManager.h"
 
+#ifdef USE_STATIC_SCENE
+#include "StaticScene.h"
+#endif
+
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #endif
 
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 
 // declaration of global variables
 namespace
@@ -31,18 +42,62 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager* pShaderManager)
+SceneManager::SceneManager(
+	ShaderManager* pShaderManager,
+	GLStateCache* pStateCache,
+	UniformCache* pUniformCache)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_pStateCache = pStateCache;
+	m_pUniformCache = pUniformCache;
+	m_pMeshLibrary = new MeshLibrary(pStateCache);
+	m_pTextureResidency = new TextureResidency(pStateCache, 0);
+	m_pSoftwareRasterizer = NULL;
+	m_pSoftwareTarget = NULL;
 
 	// initialize the texture collection
 	for (int i = 0; i < 16; i++)
 	{
 		m_textureIDs[i].tag = "/0";
-		m_textureIDs[i].ID = -1;
+		m_textureIDs[i].bTransparent = false;
+		m_textureIDs[i].writeTime = 0;
 	}
 	m_loadedTextures = 0;
+
+	// initialize the recorded draw state
+	m_currentDraw.mesh = MESH_BOX;
+	m_currentDraw.scaleXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
+	m_currentDraw.XrotationDegrees = 0.0f;
+	m_currentDraw.YrotationDegrees = 0.0f;
+	m_currentDraw.ZrotationDegrees = 0.0f;
+	m_currentDraw.positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	m_currentDraw.bUseTexture = false;
+	m_currentDraw.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+
+	// the shape boxes are resolved once the shapes are queued
+	for (int i = 0; i < MeshLibrary::SHAPE_COUNT; i++)
+	{
+		m_meshBounds[i].min = glm::vec3(0.0f, 0.0f, 0.0f);
+		m_meshBounds[i].max = glm::vec3(0.0f, 0.0f, 0.0f);
+	}
+	m_currentDraw.textureSlot = 0;
+	m_currentDraw.UVscale = glm::vec2(1.0f, 1.0f);
+	m_currentDraw.materialIndex = -1;
+	m_currentDraw.parentNode = -1;
+	m_lampNode = -1;
+	m_pencilHolderNode = -1;
+	m_pSceneFile = NULL;
+	m_pJobSystem = NULL;
+	m_viewPosition = glm::vec3(0.0f, 0.0f, 0.0f);
+	// cull nothing until the view-projection is set
+	for (int i = 0; i < 6; i++)
+	{
+		m_frustumPlanes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+	m_bBakeLighting = false;
+	m_bGatherBakeDraws = false;
+	m_bakeOcclusion.sampleCount = 0;
+	m_bakeOcclusion.distance = 0.0f;
 }
 
 /***********************************************************
@@ -54,10 +109,19 @@ SceneManager::~SceneManager()
 {
 	// clear the allocated memory
 	m_pShaderManager = NULL;
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
+	m_pStateCache = NULL;
+	m_pUniformCache = NULL;
+	m_pJobSystem = NULL;
+	delete m_pMeshLibrary;
+	m_pMeshLibrary = NULL;
 	// destroy the created OpenGL textures
 	DestroyGLTextures();
+	delete m_pTextureResidency;
+	m_pTextureResidency = NULL;
+	m_pSoftwareRasterizer = NULL;
+	m_pSoftwareTarget = NULL;
+	delete m_pSceneFile;
+	m_pSceneFile = NULL;
 }
 
 /***********************************************************
@@ -70,68 +134,46 @@ SceneManager::~SceneManager()
  ***********************************************************/
 bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 {
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+	if (LoadGLTexture(filename, tag, m_loadedTextures) == false)
+	{
+		return(false);
+	}
 
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	m_loadedTextures++;
+	return(true);
+}
 
-		return true;
+/***********************************************************
+ *  LoadGLTexture()
+ *
+ *  This method is used for loading a texture image file into
+ *  the passed in texture slot, replacing whatever the slot
+ *  held before.  The texture residency owns the OpenGL
+ *  texture, and may evict it and decode the file again when
+ *  the textures do not fit their memory budget.
+ ***********************************************************/
+bool SceneManager::LoadGLTexture(const char* filename, std::string tag, int slot)
+{
+	bool bTransparent = false;
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		// the software rasterizer keeps its own decoded copy
+		if (m_pSoftwareRasterizer->LoadTexture(slot, filename, bTransparent) == false)
+		{
+			return(false);
+		}
+	}
+	else if (m_pTextureResidency->Load(slot, filename, bTransparent) == false)
+	{
+		return(false);
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// register the loaded texture and associate it with the special tag string
+	m_textureIDs[slot].tag = tag;
+	m_textureIDs[slot].bTransparent = bTransparent;
+	m_textureIDs[slot].writeTime = FileWatcher::GetWriteTime(filename);
 
-	// Error loading the image
-	return false;
+	return(true);
 }
 
 /***********************************************************
@@ -142,11 +184,15 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		return;
+	}
+
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
 		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		m_pStateCache->BindTexture(i, m_pTextureResidency->GetTextureID(i));
 	}
 }
 
@@ -160,7 +206,14 @@ void SceneManager::DestroyGLTextures()
 {
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		if (NULL != m_pSoftwareRasterizer)
+		{
+			m_pSoftwareRasterizer->FreeTexture(i);
+		}
+		else
+		{
+			m_pTextureResidency->Free(i);
+		}
 	}
 }
 
@@ -180,7 +233,7 @@ int SceneManager::FindTextureID(std::string tag)
 	{
 		if (m_textureIDs[index].tag.compare(tag) == 0)
 		{
-			textureID = m_textureIDs[index].ID;
+			textureID = m_pTextureResidency->GetTextureID(index);
 			bFound = true;
 		}
 		else
@@ -229,150 +282,969 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	int index = 0;
+	bool bFound = false;
+	while ((index < m_objectMaterials.size()) && (bFound == false))
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			bFound = true;
+			material.ambientColor = m_objectMaterials[index].ambientColor;
+			material.ambientStrength = m_objectMaterials[index].ambientStrength;
+			material.diffuseColor = m_objectMaterials[index].diffuseColor;
+			material.specularColor = m_objectMaterials[index].specularColor;
+			material.shininess = m_objectMaterials[index].shininess;
+		}
+		else
+		{
+			index++;
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a previously
+ *  defined material, or -1 when the tag is not defined.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(std::string tag)
+{
+	int materialIndex = -1;
+	int index = 0;
+	int materialCount = (int)m_objectMaterials.size();
+	bool bFound = false;
+
+	while ((index < materialCount) && (bFound == false))
+	{
+		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		{
+			materialIndex = index;
+			bFound = true;
+		}
+		else
+			index++;
+	}
+
+	return(materialIndex);
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for recording the passed in
+ *  transformation values for the next queued draw.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	m_currentDraw.scaleXYZ = scaleXYZ;
+	m_currentDraw.XrotationDegrees = XrotationDegrees;
+	m_currentDraw.YrotationDegrees = YrotationDegrees;
+	m_currentDraw.ZrotationDegrees = ZrotationDegrees;
+	m_currentDraw.positionXYZ = positionXYZ;
+}
+
+/***********************************************************
+ *  SetShaderColor()
+ *
+ *  This method is used for recording the passed in color
+ *  for the next queued draw
+ ***********************************************************/
+void SceneManager::SetShaderColor(
+	float redColorValue,
+	float greenColorValue,
+	float blueColorValue,
+	float alphaValue)
+{
+	m_currentDraw.bUseTexture = false;
+	m_currentDraw.color.r = redColorValue;
+	m_currentDraw.color.g = greenColorValue;
+	m_currentDraw.color.b = blueColorValue;
+	m_currentDraw.color.a = alphaValue;
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for recording the texture slot
+ *  associated with the passed in tag for the next queued draw.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	std::string textureTag)
+{
+	m_currentDraw.bUseTexture = true;
+	m_currentDraw.textureSlot = FindTextureSlot(textureTag);
+}
+
+/***********************************************************
+ *  SetTextureUVScale()
+ *
+ *  This method is used for recording the texture UV scale
+ *  values for the next queued draw.
+ ***********************************************************/
+void SceneManager::SetTextureUVScale(float u, float v)
+{
+	m_currentDraw.UVscale = glm::vec2(u, v);
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for recording the material for the
+ *  next queued draw.  Unknown tags keep the previous material.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	std::string materialTag)
+{
+	int materialIndex = FindMaterialIndex(materialTag);
+	if (materialIndex >= 0)
+	{
+		m_currentDraw.materialIndex = materialIndex;
+	}
+}
+
+/***********************************************************
+ *  SetParentNode()
+ *
+ *  This method is used for recording the scene graph node
+ *  that the transformations of the next queued draws are
+ *  relative to.  It stays recorded until it is set again.
+ ***********************************************************/
+void SceneManager::SetParentNode(int node)
+{
+	m_currentDraw.parentNode = node;
+}
+
+/***********************************************************
+ *  SetViewPosition()
+ *
+ *  This method is used for setting the camera position that
+ *  the queued draws are sorted against.
+ ***********************************************************/
+void SceneManager::SetViewPosition(glm::vec3 viewPosition)
+{
+	m_viewPosition = viewPosition;
+}
+
+/***********************************************************
+ *  SetViewProjection()
+ *
+ *  This method is used for setting the camera view and
+ *  projection, from which the frustum planes for culling the
+ *  queued draws are extracted.
+ ***********************************************************/
+void SceneManager::SetViewProjection(glm::mat4 viewProjection)
+{
+	// each plane is the fourth matrix row plus or minus one of
+	// the other rows
+	for (int i = 0; i < 3; i++)
+	{
+		glm::vec4 row(viewProjection[0][i], viewProjection[1][i],
+			viewProjection[2][i], viewProjection[3][i]);
+		glm::vec4 row3(viewProjection[0][3], viewProjection[1][3],
+			viewProjection[2][3], viewProjection[3][3]);
+		m_frustumPlanes[i * 2] = row3 + row;
+		m_frustumPlanes[(i * 2) + 1] = row3 - row;
+	}
+
+	// normalize the planes so the distances are in world units
+	for (int i = 0; i < 6; i++)
+	{
+		float length = glm::length(glm::vec3(m_frustumPlanes[i]));
+		if (length > 0.0f)
+		{
+			m_frustumPlanes[i] = m_frustumPlanes[i] * (1.0f / length);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system that the
+ *  queued draws are prepared with, and that the curved shape
+ *  meshes are built on.  Without one they are prepared on
+ *  the calling thread.
+ ***********************************************************/
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+	m_pMeshLibrary->SetJobSystem(pJobSystem);
+}
+
+/***********************************************************
+ *  SetSoftwareRasterizer()
+ *
+ *  This method is used for drawing the scene with the
+ *  software rasterizer instead of OpenGL.  The textures and
+ *  lights go to the rasterizer, and the sorted draws are
+ *  recorded with it instead of being drawn, so no OpenGL
+ *  context is needed.  It must be called before
+ *  PrepareScene().
+ ***********************************************************/
+void SceneManager::SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer)
+{
+	m_pSoftwareRasterizer = pRasterizer;
+}
+
+/***********************************************************
+ *  SetSoftwareTarget()
+ *
+ *  This method is used for recording the draws of the next
+ *  frames with another rasterizer, which shares the scene of
+ *  the software rasterizer through ShareScene().  Offscreen
+ *  views are rendered this way on several threads while the
+ *  textures stay loaded once.
+ ***********************************************************/
+void SceneManager::SetSoftwareTarget(SoftwareRasterizer* pTarget)
+{
+	m_pSoftwareTarget = pTarget;
+}
+
+/***********************************************************
+ *  SetCompactVertices()
+ *
+ *  This method is used for choosing whether the shape meshes
+ *  are stored in the compact vertex layout, which halves the
+ *  vertex bandwidth of every draw.
+ ***********************************************************/
+void SceneManager::SetCompactVertices(bool bCompact)
+{
+	m_pMeshLibrary->SetVertexFormat(bCompact ?
+		MeshLibrary::VERTEX_COMPACT : MeshLibrary::VERTEX_FLOAT);
+}
+
+/***********************************************************
+ *  SetMeshTessellation()
+ *
+ *  This method is used for setting the segments around the
+ *  curved shape meshes and the rings of the sphere and the
+ *  torus tube.
+ ***********************************************************/
+void SceneManager::SetMeshTessellation(int segments, int rings)
+{
+	m_pMeshLibrary->SetTessellation(segments, rings);
+}
+
+/***********************************************************
+ *  SetTextureBudget()
+ *
+ *  This method is used for setting the video memory that
+ *  the scene textures may use.  A budget of 0 keeps every
+ *  texture resident.
+ ***********************************************************/
+void SceneManager::SetTextureBudget(size_t budgetBytes)
+{
+	m_pTextureResidency->SetBudget(budgetBytes);
+}
+
+/***********************************************************
+ *  PrintTextureStats()
+ *
+ *  This method is used for printing the texture memory and
+ *  the residency changes of the last frame.
+ ***********************************************************/
+void SceneManager::PrintTextureStats() const
+{
+	m_pTextureResidency->PrintFrameStats();
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the closest draw of the
+ *  last frame along a ray.  The spatial index finds the
+ *  draws whose world boxes the ray passes, and the ray is
+ *  moved into the space of each of those meshes, checked
+ *  against the box of the shape and then tested against its
+ *  triangles.  The triangles come from the CPU data of the
+ *  shape, which is built the first time it is picked.
+ ***********************************************************/
+bool SceneManager::PickObject(const glm::vec3& origin, const glm::vec3& direction, PICK_RESULT& result)
+{
+	const float MAX_PICK_DISTANCE = 1000.0f;
+
+	// the direction is not normalized in the mesh space, so
+	// the distance along the ray is the same in both spaces
+	BoundingVolumeHierarchy::RAY_TEST test = [this, &origin, &direction, MAX_PICK_DISTANCE](int object, float& distance)
+	{
+		glm::mat4 inverse = glm::inverse(m_worldMatrices[object]);
+		glm::vec3 localOrigin = glm::vec3(inverse * glm::vec4(origin, 1.0f));
+		glm::vec3 localDirection = glm::vec3(inverse * glm::vec4(direction, 0.0f));
+
+		MeshLibrary::MESH_SHAPE shape = (MeshLibrary::MESH_SHAPE)m_objectMeshes[object];
+		float boxDistance = 0.0f;
+		if (BoundingVolumeHierarchy::IntersectRay(m_meshBounds[shape], localOrigin, localDirection,
+			MAX_PICK_DISTANCE, boxDistance) == false)
+		{
+			return(false);
+		}
+		const MeshGenerator::MESH_DATA* pMesh = m_pMeshLibrary->GetMeshData(shape);
+		if (NULL == pMesh)
+		{
+			return(false);
+		}
+
+		bool bHit = false;
+		distance = MAX_PICK_DISTANCE;
+		for (size_t i = 0; i + 2 < pMesh->indices.size(); i += 3)
+		{
+			const float* p0 = pMesh->vertices[pMesh->indices[i]].position;
+			const float* p1 = pMesh->vertices[pMesh->indices[i + 1]].position;
+			const float* p2 = pMesh->vertices[pMesh->indices[i + 2]].position;
+			float triangleDistance = 0.0f;
+			if ((BoundingVolumeHierarchy::IntersectTriangle(localOrigin, localDirection,
+				glm::vec3(p0[0], p0[1], p0[2]),
+				glm::vec3(p1[0], p1[1], p1[2]),
+				glm::vec3(p2[0], p2[1], p2[2]),
+				triangleDistance) == true) && (triangleDistance < distance))
+			{
+				distance = triangleDistance;
+				bHit = true;
+			}
+		}
+		return(bHit);
+	};
+
+	BoundingVolumeHierarchy::RAY_HIT hit;
+	if (m_objectIndex.Raycast(origin, direction, MAX_PICK_DISTANCE, test, hit) == false)
+	{
+		return(false);
+	}
+
+	result.objectIndex = hit.object;
+	result.mesh = m_objectMeshes[hit.object];
+	result.distance = hit.distance;
+	result.position = origin + (direction * hit.distance);
+	return(true);
+}
+
+/***********************************************************
+ *  GetObjectIndex()
+ *
+ *  This method is used for getting the spatial index over
+ *  the world bounds of the draws of the last frame, for the
+ *  box and frustum queries.
+ ***********************************************************/
+const BoundingVolumeHierarchy& SceneManager::GetObjectIndex() const
+{
+	return(m_objectIndex);
+}
+
+/***********************************************************
+ *  BakeStaticLighting()
+ *
+ *  This method is used for baking the ambient and diffuse
+ *  lighting of every vertex of the scene, optionally with
+ *  ambient occlusion, and writing it to a bake file.  The
+ *  scene is queued once as if it was rendered, and the
+ *  queued draws are baked instead of drawn.
+ ***********************************************************/
+bool SceneManager::BakeStaticLighting(const char* filename, const LightBaker::OCCLUSION_SETTINGS& occlusion)
+{
+	m_bBakeLighting = true;
+	m_bakeOcclusion = occlusion;
+	RenderScene();
+	m_bBakeLighting = false;
+
+	if (m_lightBaker.GetDrawCount() == 0)
+	{
+		std::cout << "No draws to bake the lighting of" << std::endl;
+		return(false);
+	}
+	return(m_lightBaker.WriteFile(filename));
+}
+
+/***********************************************************
+ *  LoadBakedLighting()
+ *
+ *  This method is used for loading the colors of a bake
+ *  file, which the software draws are lit with from then
+ *  on.  The colors only apply while the scene queues the
+ *  same draws it queued when it was baked, so the scene is
+ *  queued once first to get the draws the file must hold.
+ ***********************************************************/
+bool SceneManager::LoadBakedLighting(const char* filename)
+{
+	m_bGatherBakeDraws = true;
+	RenderScene();
+	m_bGatherBakeDraws = false;
+
+	return(m_lightBaker.ReadFile(filename, m_bakeDraws));
+}
+
+/***********************************************************
+ *  UpdateScene()
+ *
+ *  This method is used for advancing the scene by one fixed
+ *  simulation tick.  Animated objects are to be stepped here
+ *  and never from the render loop, so their motion does not
+ *  depend on the frame rate.
+ ***********************************************************/
+void SceneManager::UpdateScene(float timeStep)
+{
+	// the scene has no animated objects yet
+	(void)timeStep;
+}
+
+/***********************************************************
+ *  QueueDraw()
+ *
+ *  This method is used for queueing the passed in mesh with
+ *  the currently recorded state.  The queued draws are
+ *  transformed, culled and sorted in SubmitRenderQueues().
+ ***********************************************************/
+void SceneManager::QueueDraw(SHAPE_MESH mesh)
+{
+	m_drawCommands.push_back(m_currentDraw);
+	m_drawCommands.back().mesh = mesh;
+}
+
+/***********************************************************
+ *  IsTransparent()
+ *
+ *  This method is used for checking whether a queued draw
+ *  uses a partially transparent texture or color, and must
+ *  be blended.
+ ***********************************************************/
+bool SceneManager::IsTransparent(const DRAW_COMMAND& command)
+{
+	if (command.bUseTexture == true)
+	{
+		if ((command.textureSlot >= 0) && (command.textureSlot < m_loadedTextures))
+		{
+			return(m_textureIDs[command.textureSlot].bTransparent);
+		}
+		return(false);
+	}
+
+	return(command.color.a < 1.0f);
+}
+
+/***********************************************************
+ *  ComposeDrawTransforms()
+ *
+ *  This method is used for composing the model matrices of
+ *  the queued draws.  The recorded Euler angles become one
+ *  quaternion per draw, converted again only when the angles
+ *  of the draw changed, and the transform batch only
+ *  recomposes the matrices of the draws that changed since
+ *  the previous frame.
+ ***********************************************************/
+void SceneManager::ComposeDrawTransforms()
+{
+	int commandCount = (int)m_drawCommands.size();
+
+	// only the assemblies that moved are recomputed
+	m_sceneGraph.UpdateWorldTransforms();
+
+	m_transforms.Resize(commandCount);
+	m_modelMatrices.resize(commandCount);
+	// new draws start with angles that never compare equal
+	m_drawAngles.resize(commandCount, glm::vec3(std::numeric_limits<float>::quiet_NaN()));
+	m_drawRotations.resize(commandCount);
+	for (int i = 0; i < commandCount; i++)
+	{
+		const DRAW_COMMAND& command = m_drawCommands[i];
+
+		glm::vec3 angles(command.XrotationDegrees, command.YrotationDegrees, command.ZrotationDegrees);
+		glm::vec3& lastAngles = m_drawAngles[i];
+		if ((angles.x != lastAngles.x) || (angles.y != lastAngles.y) || (angles.z != lastAngles.z))
+		{
+			// same rotation order as X, then Y, then Z matrices
+			m_drawRotations[i] =
+				glm::angleAxis(glm::radians(angles.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+				glm::angleAxis(glm::radians(angles.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+				glm::angleAxis(glm::radians(angles.z), glm::vec3(0.0f, 0.0f, 1.0f));
+			lastAngles = angles;
+		}
+		m_transforms.SetTransform(i, command.positionXYZ, m_drawRotations[i], command.scaleXYZ);
+	}
+
+	if (commandCount > 0)
+	{
+		m_transforms.ComposeDirty(&m_modelMatrices[0]);
+	}
+}
+
+/***********************************************************
+ *  ResolveMeshBounds()
+ *
+ *  This method is used for getting the mesh-space boxes of
+ *  the shapes of the queued draws from the mesh library,
+ *  which loads the shapes that were not loaded yet.  It runs
+ *  before the preparation jobs, which only read the boxes.
+ ***********************************************************/
+void SceneManager::ResolveMeshBounds()
+{
+	bool bResolved[MeshLibrary::SHAPE_COUNT] = { false };
+	for (size_t i = 0; i < m_drawCommands.size(); i++)
+	{
+		MeshLibrary::MESH_SHAPE shape = (MeshLibrary::MESH_SHAPE)m_drawCommands[i].mesh;
+		if ((shape < 0) || (shape >= MeshLibrary::SHAPE_COUNT) || (bResolved[shape] == true))
+		{
+			continue;
+		}
+
+		BoundingVolumeHierarchy::AABB& bounds = m_meshBounds[shape];
+		if (m_pMeshLibrary->GetMeshBounds(shape, bounds.min, bounds.max) == false)
+		{
+			// a shape that does not load is not drawn either
+			bounds.min = glm::vec3(0.0f, 0.0f, 0.0f);
+			bounds.max = glm::vec3(0.0f, 0.0f, 0.0f);
+		}
+		bResolved[shape] = true;
+	}
+}
+
+/***********************************************************
+ *  PrepareDraws()
+ *
+ *  This method is used for preparing a range of the queued
+ *  draws.  It picks up the model matrices, drops the draws
+ *  outside of the camera frustum, builds the sort keys and
+ *  packs the visible draws into the calling thread's buffer.
+ *  It runs on the job threads and must not call OpenGL.
+ ***********************************************************/
+void SceneManager::PrepareDraws(int begin, int end)
+{
+	int threadIndex = (NULL != m_pJobSystem) ? JobSystem::GetThreadIndex() : 0;
+	std::vector<PREPARED_DRAW>& output = m_threadDraws[threadIndex];
+
+	for (int i = begin; i < end; i++)
+	{
+		const DRAW_COMMAND& command = m_drawCommands[i];
+		PREPARED_DRAW draw;
+
+		// the scale, rotation and translation composed by the
+		// batch, placed in the world by the parent node
+		if (command.parentNode >= 0)
+		{
+			draw.model = m_sceneGraph.GetWorldTransform(command.parentNode) * m_modelMatrices[i];
+		}
+		else
+		{
+			draw.model = m_modelMatrices[i];
+		}
+
+		// world box around the box of the shape, for the
+		// spatial index - the half size of the shape box grows
+		// by the absolute value of every matrix column
+		const BoundingVolumeHierarchy::AABB& meshBounds = m_meshBounds[command.mesh];
+		glm::vec3 meshCenter = (meshBounds.min + meshBounds.max) * 0.5f;
+		glm::vec3 meshExtent = (meshBounds.max - meshBounds.min) * 0.5f;
+		glm::vec3 center = glm::vec3(draw.model * glm::vec4(meshCenter, 1.0f));
+		glm::vec3 extent = (glm::abs(glm::vec3(draw.model[0])) * meshExtent.x) +
+			(glm::abs(glm::vec3(draw.model[1])) * meshExtent.y) +
+			(glm::abs(glm::vec3(draw.model[2])) * meshExtent.z);
+		BoundingVolumeHierarchy::AABB& bounds = m_objectBounds[i];
+		if ((bounds.min != center - extent) || (bounds.max != center + extent))
+		{
+			bounds.min = center - extent;
+			bounds.max = center + extent;
+			m_boundsChanged[i] = 1;
+		}
+		m_worldMatrices[i] = draw.model;
+		m_objectMeshes[i] = command.mesh;
+
+		// skip the draw when the sphere around its world box
+		// is outside of any of the frustum planes
+		float radius = glm::length(extent);
+		bool bVisible = true;
+		for (int plane = 0; (plane < 6) && (bVisible == true); plane++)
+		{
+			const glm::vec4& p = m_frustumPlanes[plane];
+			if ((p.x * center.x) + (p.y * center.y) + (p.z * center.z) + p.w < -radius)
+			{
+				bVisible = false;
+			}
+		}
+		if (bVisible == false)
+		{
+			continue;
+		}
+
+		// opaque draws sort front-to-back, transparent draws
+		// after them back-to-front, ties keep the queue order -
+		// the bits of a positive float sort like the float
+		glm::vec3 offset = center - m_viewPosition;
+		float depth = glm::dot(offset, offset);
+		uint32_t depthBits = 0;
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+		uint64_t key = (uint64_t)(i & 0xFFFFFF);
+		if (IsTransparent(command) == true)
+		{
+			key |= (1ULL << 63) | ((uint64_t)(~depthBits) << 24);
+		}
+		else
+		{
+			key |= ((uint64_t)depthBits << 24);
+		}
+
+		draw.sortKey = key;
+		draw.commandIndex = i;
+		output.push_back(draw);
+	}
+}
+
+/***********************************************************
+ *  UpdateObjectIndex()
+ *
+ *  This method is used for updating the spatial index to
+ *  the bounds the preparation jobs found.  Only the boxes
+ *  above the moved draws are refit, but the index is built
+ *  again when the number of draws changed or most of them
+ *  moved, as a refit tree loses its shape.
+ ***********************************************************/
+void SceneManager::UpdateObjectIndex()
+{
+	int objectCount = (int)m_objectBounds.size();
+	int changedCount = 0;
+	for (int i = 0; i < objectCount; i++)
+	{
+		changedCount += m_boundsChanged[i];
+	}
+	if ((changedCount == 0) && (m_objectIndex.GetObjectCount() == objectCount))
+	{
+		return;
+	}
+
+	if ((m_objectIndex.GetObjectCount() != objectCount) || (changedCount * 2 > objectCount))
+	{
+		m_objectIndex.Build((objectCount > 0) ? &m_objectBounds[0] : NULL, objectCount);
+		std::fill(m_boundsChanged.begin(), m_boundsChanged.end(), 0);
+		return;
+	}
+
+	for (int i = 0; i < objectCount; i++)
+	{
+		if (m_boundsChanged[i] != 0)
+		{
+			m_objectIndex.SetObjectBounds(i, m_objectBounds[i]);
+			m_boundsChanged[i] = 0;
+		}
+	}
+	m_objectIndex.Refit();
+}
+
+/***********************************************************
+ *  SubmitRenderQueues()
+ *
+ *  This method is used for drawing the queued draws.  The
+ *  draws are prepared in parallel jobs, gathered from the
+ *  per-thread buffers and sorted.  The opaque draws come
+ *  first, front-to-back with blending off so the depth test
+ *  rejects hidden fragments early, then the transparent
+ *  draws are blended back-to-front without writing depth.
+ ***********************************************************/
+void SceneManager::SubmitRenderQueues()
+{
+	// the draw counts below this are prepared on one thread
+	const int PREPARE_GRAIN_SIZE = 256;
+
+	int threadCount = (NULL != m_pJobSystem) ? m_pJobSystem->GetThreadCount() : 1;
+	if ((int)m_threadDraws.size() != threadCount)
+	{
+		m_threadDraws.resize(threadCount);
+	}
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_threadDraws[i].clear();
+	}
+
+	ComposeDrawTransforms();
+	ResolveMeshBounds();
+
+	// written by the preparation jobs, one entry per draw
+	int commandCount = (int)m_drawCommands.size();
+	m_worldMatrices.resize(commandCount);
+	m_objectBounds.resize(commandCount);
+	m_objectMeshes.resize(commandCount);
+	m_boundsChanged.resize(commandCount, 1);
+
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(commandCount, PREPARE_GRAIN_SIZE,
+			[this](int begin, int end) { PrepareDraws(begin, end); });
+	}
+	else
+	{
+		PrepareDraws(0, commandCount);
+	}
+
+	UpdateObjectIndex();
+
+	if (m_bBakeLighting == true)
+	{
+		BakeQueuedDraws();
+		m_drawCommands.clear();
+		return;
+	}
+	if (m_bGatherBakeDraws == true)
+	{
+		if (GatherBakeDraws(m_bakeDraws) == false)
+		{
+			m_bakeDraws.clear();
+		}
+		m_drawCommands.clear();
+		return;
+	}
+
+	// gather the visible draws of all the threads
+	m_preparedDraws.clear();
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_preparedDraws.insert(m_preparedDraws.end(),
+			m_threadDraws[i].begin(), m_threadDraws[i].end());
+	}
+	std::sort(m_preparedDraws.begin(), m_preparedDraws.end(),
+		[](const PREPARED_DRAW& a, const PREPARED_DRAW& b)
+		{ return a.sortKey < b.sortKey; });
+
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		SubmitSoftwareDraws();
+		m_drawCommands.clear();
+		return;
+	}
+
+	m_pStateCache->Disable(GL_BLEND);
+	m_pStateCache->DepthMask(GL_TRUE);
+
+	bool bBlending = false;
+	for (size_t i = 0; i < m_preparedDraws.size(); i++)
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
+		const PREPARED_DRAW& draw = m_preparedDraws[i];
+		const DRAW_COMMAND& command = m_drawCommands[draw.commandIndex];
+
+		// switch to blending at the first transparent draw
+		if ((bBlending == false) && ((draw.sortKey >> 63) != 0))
 		{
-			index++;
+			m_pStateCache->Enable(GL_BLEND);
+			m_pStateCache->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			m_pStateCache->DepthMask(GL_FALSE);
+			bBlending = true;
 		}
+
+		ApplyDrawCommand(command, draw.model);
+		DrawShapeMesh(command.mesh);
 	}
 
-	return(true);
+	if (bBlending == true)
+	{
+		m_pStateCache->DepthMask(GL_TRUE);
+		m_pStateCache->Disable(GL_BLEND);
+	}
+
+	m_drawCommands.clear();
+	// the textures of this frame are known, so the ones that
+	// are over the budget can be reduced or evicted
+	m_pTextureResidency->EndFrame();
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  ApplyDrawCommand()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for passing the prepared transform
+ *  and the recorded color, texture and material of a queued
+ *  draw into the shader.
  ***********************************************************/
-void SceneManager::SetTransformations(
-	glm::vec3 scaleXYZ,
-	float XrotationDegrees,
-	float YrotationDegrees,
-	float ZrotationDegrees,
-	glm::vec3 positionXYZ)
+void SceneManager::ApplyDrawCommand(const DRAW_COMMAND& command, const glm::mat4& model)
 {
-	// variables for this method
-	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
+	// compact meshes are stored at a normalized size that the
+	// model matrix scales back up
+	float positionScale = m_pMeshLibrary->GetPositionScale((MeshLibrary::MESH_SHAPE)command.mesh);
+	if (positionScale != 1.0f)
+	{
+		m_pUniformCache->setMat4Value(g_ModelName,
+			glm::scale(model, glm::vec3(positionScale)));
+	}
+	else
+	{
+		m_pUniformCache->setMat4Value(g_ModelName, model);
+	}
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	// the uniform cache skips any of these values that are
+	// unchanged since the previous draw
+	m_pUniformCache->setIntValue(g_UseTextureName, command.bUseTexture);
+	if (command.bUseTexture == true)
+	{
+		// marks the texture as used, reloading it if it was evicted
+		m_pTextureResidency->Bind(command.textureSlot);
+		m_pUniformCache->setSampler2DValue(g_TextureValueName, command.textureSlot);
+	}
+	else
+	{
+		m_pUniformCache->setVec4Value(g_ColorValueName, command.color);
+	}
+	m_pUniformCache->setVec2Value("UVscale", command.UVscale);
 
-	if (NULL != m_pShaderManager)
+	if (command.materialIndex >= 0)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		const OBJECT_MATERIAL& material = m_objectMaterials[command.materialIndex];
+		m_pUniformCache->setVec3Value("material.ambientColor", material.ambientColor);
+		m_pUniformCache->setFloatValue("material.ambientStrength", material.ambientStrength);
+		m_pUniformCache->setVec3Value("material.diffuseColor", material.diffuseColor);
+		m_pUniformCache->setVec3Value("material.specularColor", material.specularColor);
+		m_pUniformCache->setFloatValue("material.shininess", material.shininess);
 	}
 }
 
 /***********************************************************
- *  SetShaderColor()
+ *  SubmitSoftwareDraws()
  *
- *  This method is used for setting the passed in color
- *  into the shader for the next draw command
+ *  This method is used for recording the sorted draws with
+ *  the software rasterizer.  The draws carry the same state
+ *  that ApplyDrawCommand() sends into the shader, and the
+ *  rasterizer renders them when the frame ends.
  ***********************************************************/
-void SceneManager::SetShaderColor(
-	float redColorValue,
-	float greenColorValue,
-	float blueColorValue,
-	float alphaValue)
+void SceneManager::SubmitSoftwareDraws()
 {
-	// variables for this method
-	glm::vec4 currentColor;
-
-	currentColor.r = redColorValue;
-	currentColor.g = greenColorValue;
-	currentColor.b = blueColorValue;
-	currentColor.a = alphaValue;
+	SoftwareRasterizer* pTarget = (NULL != m_pSoftwareTarget) ?
+		m_pSoftwareTarget : m_pSoftwareRasterizer;
+	// a bake of another scene, or of this scene before an
+	// object moved or a material or light changed, is refused
+	if (m_lightBaker.GetDrawCount() > 0)
+	{
+		if ((GatherBakeDraws(m_bakeDraws) == false) ||
+			(LightBaker::HashScene(m_bakeDraws, m_lightRecords.empty() ? NULL : &m_lightRecords[0],
+				(int)m_lightRecords.size()) != m_lightBaker.GetSceneHash()))
+		{
+			std::cout << "Baked lighting does not match the scene and is no longer used" << std::endl;
+			m_lightBaker.Clear();
+		}
+	}
+	bool bBaked = (m_lightBaker.GetDrawCount() > 0);
 
-	if (NULL != m_pShaderManager)
+	for (size_t i = 0; i < m_preparedDraws.size(); i++)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		const PREPARED_DRAW& draw = m_preparedDraws[i];
+		const DRAW_COMMAND& command = m_drawCommands[draw.commandIndex];
+
+		const MeshGenerator::MESH_DATA* pMesh =
+			m_pMeshLibrary->GetMeshData((MeshLibrary::MESH_SHAPE)command.mesh);
+		if (NULL == pMesh)
+		{
+			continue;
+		}
+
+		SoftwareRasterizer::DRAW_STATE state;
+		state.bUseTexture = command.bUseTexture;
+		state.textureSlot = command.textureSlot;
+		state.color = command.color;
+		state.UVscale = command.UVscale;
+		state.bBlend = ((draw.sortKey >> 63) != 0);
+		state.bHasMaterial = (command.materialIndex >= 0);
+		if (state.bHasMaterial == true)
+		{
+			const OBJECT_MATERIAL& material = m_objectMaterials[command.materialIndex];
+			state.material.ambientColor = material.ambientColor;
+			state.material.ambientStrength = material.ambientStrength;
+			state.material.diffuseColor = material.diffuseColor;
+			state.material.specularColor = material.specularColor;
+			state.material.shininess = material.shininess;
+		}
+		state.pBakedLighting = NULL;
+		if (bBaked == true)
+		{
+			state.pBakedLighting = m_lightBaker.GetVertexLighting(draw.commandIndex,
+				command.mesh, (int)pMesh->vertices.size());
+		}
+
+		pTarget->DrawMesh(*pMesh, draw.model, state);
 	}
 }
 
 /***********************************************************
- *  SetShaderTexture()
+ *  GatherBakeDraws()
  *
- *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  This method is used for getting the mesh, world matrix
+ *  and material of all of the queued draws, visible or not,
+ *  in the order they were queued so the spatial index finds
+ *  them.  A draw without a material is baked with the one
+ *  before it in the queue, which is the material it is drawn
+ *  with unless the sort places it after another draw.
  ***********************************************************/
-void SceneManager::SetShaderTexture(
-	std::string textureTag)
+bool SceneManager::GatherBakeDraws(std::vector<LightBaker::BAKE_DRAW>& draws)
 {
-	if (NULL != m_pShaderManager)
+	// the same material the rasterizer starts with
+	SoftwareRasterizer::MATERIAL material;
+	material.ambientColor = glm::vec3(0.0f);
+	material.ambientStrength = 0.0f;
+	material.diffuseColor = glm::vec3(0.0f);
+	material.specularColor = glm::vec3(0.0f);
+	material.shininess = 1.0f;
+
+	draws.clear();
+	draws.reserve(m_drawCommands.size());
+	for (size_t i = 0; i < m_drawCommands.size(); i++)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		const DRAW_COMMAND& command = m_drawCommands[i];
+		if (command.materialIndex >= 0)
+		{
+			const OBJECT_MATERIAL& objectMaterial = m_objectMaterials[command.materialIndex];
+			material.ambientColor = objectMaterial.ambientColor;
+			material.ambientStrength = objectMaterial.ambientStrength;
+			material.diffuseColor = objectMaterial.diffuseColor;
+			material.specularColor = objectMaterial.specularColor;
+			material.shininess = objectMaterial.shininess;
+		}
 
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		LightBaker::BAKE_DRAW draw;
+		draw.mesh = (uint32_t)command.mesh;
+		draw.pMesh = m_pMeshLibrary->GetMeshData((MeshLibrary::MESH_SHAPE)command.mesh);
+		draw.model = m_worldMatrices[i];
+		draw.material = material;
+		if (NULL == draw.pMesh)
+		{
+			std::cout << "Could not get the mesh of draw " << i << " for the baked lighting" << std::endl;
+			return(false);
+		}
+		draws.push_back(draw);
 	}
+	return(true);
 }
 
 /***********************************************************
- *  SetTextureUVScale()
+ *  BakeQueuedDraws()
  *
- *  This method is used for setting the texture UV scale
- *  values into the shader.
+ *  This method is used for baking the lighting of all of the
+ *  queued draws with the lights of the scene.
  ***********************************************************/
-void SceneManager::SetTextureUVScale(float u, float v)
+void SceneManager::BakeQueuedDraws()
 {
-	if (NULL != m_pShaderManager)
+	if (GatherBakeDraws(m_bakeDraws) == false)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_lightBaker.Clear();
+		return;
 	}
+
+	m_lightBaker.SetLights(m_lightRecords.empty() ? NULL : &m_lightRecords[0], (int)m_lightRecords.size());
+	m_lightBaker.Bake(m_bakeDraws, m_objectIndex, m_bakeOcclusion, m_pJobSystem);
 }
 
 /***********************************************************
- *  SetShaderMaterial()
+ *  DrawShapeMesh()
  *
- *  This method is used for passing the material values
- *  into the shader.
+ *  This method is used for drawing the basic shape mesh of
+ *  a queued draw.
  ***********************************************************/
-void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+void SceneManager::DrawShapeMesh(SHAPE_MESH mesh)
 {
-	if (m_objectMaterials.size() > 0)
-	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
-
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
-		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-		}
-	}
+	// the library keeps the shapes in the same order
+	m_pMeshLibrary->Draw((MeshLibrary::MESH_SHAPE)mesh);
 }
 
 /**************************************************************/
@@ -571,32 +1443,34 @@ void SceneManager::DefineObjectMaterials()
  ***********************************************************/
 void SceneManager::SetupSceneLights()
 {
-	// Enable custom lighting in shaders
-	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-
-	// First light source (Point light with amber tones)
-	m_pShaderManager->setVec3Value("lightSources[0].position", -2.5f, 4.5f, 6.5f);
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.2f, 0.15f, 0.1f); // Amber ambient
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.7f, 0.5f, 0.3f); // Amber diffuse
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.25f, 0.2f, 0.1f); // Amber specular
-	m_pShaderManager->setFloatValue("lightSources[0].focalStrength", 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.5f);
-
-	// Second light source (Point light with a brighter tone)
-	m_pShaderManager->setVec3Value("lightSources[1].position", -0.21f, 3.29f, 0.6f);
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.25f, 0.2f, 0.15f); // Warm amber
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.85f, 0.7f, 0.5f); // Bright amber diffuse
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.8f, 0.7f, 0.6f); // Bright specular
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 1.0f);
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.8f);
-
-
-	// Directional light
-	m_pShaderManager->setVec3Value("dirLight.direction", 1.0f, -1.0f, 0.0f);  // Direction from top-right
-	m_pShaderManager->setVec3Value("dirLight.ambient", 0.2f, 0.2f, 0.2f);    // Soft ambient light
-	m_pShaderManager->setVec3Value("dirLight.diffuse", 0.7f, 0.7f, 0.7f);    // Bright diffuse
-	m_pShaderManager->setVec3Value("dirLight.specular", 1.0f, 1.0f, 1.0f);   // Strong specular
-
+	const SceneFile::LIGHT_RECORD lights[] =
+	{
+		// First light source (Point light with amber tones)
+		{ SceneFile::LIGHT_POINT,
+			{ -2.5f, 4.5f, 6.5f },
+			{ 0.2f, 0.15f, 0.1f },		// Amber ambient
+			{ 0.7f, 0.5f, 0.3f },		// Amber diffuse
+			{ 0.25f, 0.2f, 0.1f },		// Amber specular
+			1.0f, 0.5f },
+		// Second light source (Point light with a brighter tone)
+		{ SceneFile::LIGHT_POINT,
+			{ -0.21f, 3.29f, 0.6f },
+			{ 0.25f, 0.2f, 0.15f },		// Warm amber
+			{ 0.85f, 0.7f, 0.5f },		// Bright amber diffuse
+			{ 0.8f, 0.7f, 0.6f },		// Bright specular
+			1.0f, 0.8f },
+		// Directional light
+		{ SceneFile::LIGHT_DIRECTIONAL,
+			{ 1.0f, -1.0f, 0.0f },		// Direction from top-right
+			{ 0.2f, 0.2f, 0.2f },		// Soft ambient light
+			{ 0.7f, 0.7f, 0.7f },		// Bright diffuse
+			{ 1.0f, 1.0f, 1.0f },		// Strong specular
+			0.0f, 0.0f }
+	};
+
+	// the same records as a scene file, so the software
+	// rasterizer receives them too
+	ApplyLightRecords(lights, sizeof(lights) / sizeof(lights[0]));
 }
 
 
@@ -609,38 +1483,538 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
-	// load the texture image files for the textures applied
-	// to objects in the 3D scene
-	LoadSceneTextures();
-	// define the materials that will be used for the objects
-	// in the 3D scene
-	DefineObjectMaterials();
-	// add and defile the light sources for the 3D scene
-	SetupSceneLights();
+	if (NULL != m_pSceneFile)
+	{
+		// the scene file replaces the built-in textures,
+		// materials, lights and assemblies
+		PrepareSceneFile();
+	}
+	else
+	{
+#ifdef USE_STATIC_SCENE
+		PrepareStaticScene();
+#else
+		// load the texture image files for the textures applied
+		// to objects in the 3D scene
+		LoadSceneTextures();
+		// define the materials that will be used for the objects
+		// in the 3D scene
+		DefineObjectMaterials();
+		// add and defile the light sources for the 3D scene
+		SetupSceneLights();
+
+		// the lamp and the pencil holder are assemblies - their
+		// parts are placed relative to one node, so moving the
+		// node moves the whole assembly
+		m_lampNode = m_sceneGraph.AddNode(-1, glm::translate(glm::vec3(0.0f, 0.25f, 0.0f)));
+		m_pencilHolderNode = m_sceneGraph.AddNode(-1, glm::translate(glm::vec3(1.3f, 0.0f, 1.0f)));
+#endif
+	}
 
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->LoadPrismMesh();
-	m_basicMeshes->LoadPyramid4Mesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadTorusMesh();
+	// in the rendered 3D scene - the meshes are generated
+	// into the shared buffers the first time they are drawn,
+	// and the software rasterizer reads the generated data
+	if (NULL == m_pSoftwareRasterizer)
+	{
+		m_pMeshLibrary->Create();
+	}
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for loading a scene file that replaces
+ *  the built-in scene.  Binary files are mapped, and text
+ *  scenes ending in .scene are compiled in memory.  It must
+ *  be called before PrepareScene(), and on failure the
+ *  built-in scene is used.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const char* filename)
+{
+	SceneFile* pSceneFile = new SceneFile();
+	std::string name = filename;
+	bool bText = (name.size() > 6) && (name.compare(name.size() - 6, 6, ".scene") == 0);
+	if ((bText ? pSceneFile->OpenText(filename) : pSceneFile->Open(filename)) == false)
+	{
+		delete pSceneFile;
+		return(false);
+	}
+
+	delete m_pSceneFile;
+	m_pSceneFile = pSceneFile;
+	m_sceneFilename = name;
+	return(true);
+}
+
+/***********************************************************
+ *  ReloadSceneFile()
+ *
+ *  This method is used for loading the scene file again
+ *  after it was edited.  The new file is compared against the
+ *  loaded one and only the differences are applied, so most
+ *  edits cost a few milliseconds instead of a restart.  When
+ *  the new file cannot be read the loaded scene is kept.
+ ***********************************************************/
+bool SceneManager::ReloadSceneFile()
+{
+	if (NULL == m_pSceneFile)
+	{
+		return(false);
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	SceneFile* pOldSceneFile = m_pSceneFile;
+	m_pSceneFile = NULL;
+	if (LoadSceneFile(m_sceneFilename.c_str()) == false)
+	{
+		m_pSceneFile = pOldSceneFile;
+		std::cout << "Keeping the loaded scene" << std::endl;
+		return(false);
+	}
+
+	// the new file is swapped in only after the differences
+	// were taken against the old one
+	SceneFile* pNewSceneFile = m_pSceneFile;
+	m_pSceneFile = pOldSceneFile;
+	ApplySceneFileChanges(pNewSceneFile);
+	m_pSceneFile = pNewSceneFile;
+	delete pOldSceneFile;
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	std::cout << "Reloaded " << m_sceneFilename << " in " << elapsed.count() << " ms" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  ApplySceneFileChanges()
+ *
+ *  This method is used for updating the loaded scene to the
+ *  passed in scene file.  Textures whose path and image file
+ *  are unchanged keep their slot, so only new or edited
+ *  images are decoded.  Materials and node transforms are
+ *  patched in place, and the scene graph is only rebuilt
+ *  when the hierarchy itself changed.  Objects need nothing,
+ *  since they are queued from the file every frame and the
+ *  transform batch only recomposes the ones that moved.
+ ***********************************************************/
+void SceneManager::ApplySceneFileChanges(const SceneFile* pSceneFile)
+{
+	// keep the texture slots whose image is unchanged
+	const SceneFile::TEXTURE_RECORD* pOldTextures = m_pSceneFile->GetTextures();
+	const SceneFile::TEXTURE_RECORD* pTextures = pSceneFile->GetTextures();
+	std::vector<int> textureSlots(pSceneFile->GetTextureCount(), -1);
+	bool bSlotUsed[16] = {};
+	for (int i = 0; i < pSceneFile->GetTextureCount(); i++)
+	{
+		const char* path = pSceneFile->GetString(pTextures[i].pathOffset);
+		for (int j = 0; j < m_pSceneFile->GetTextureCount(); j++)
+		{
+			int slot = m_sceneTextureSlots[j];
+			if ((slot >= 0) && (bSlotUsed[slot] == false) &&
+				(strcmp(path, m_pSceneFile->GetString(pOldTextures[j].pathOffset)) == 0) &&
+				(FileWatcher::GetWriteTime(path) == m_textureIDs[slot].writeTime))
+			{
+				textureSlots[i] = slot;
+				bSlotUsed[slot] = true;
+				m_textureIDs[slot].tag = pSceneFile->GetString(pTextures[i].tagOffset);
+				break;
+			}
+		}
+	}
+
+	// decode the new and edited images into the free slots
+	int decodedTextures = 0;
+	for (int i = 0; i < pSceneFile->GetTextureCount(); i++)
+	{
+		if (textureSlots[i] >= 0)
+		{
+			continue;
+		}
+
+		int slot = 0;
+		while ((slot < 16) && (bSlotUsed[slot] == true))
+		{
+			slot++;
+		}
+		if ((slot < 16) && LoadGLTexture(
+			pSceneFile->GetString(pTextures[i].pathOffset),
+			pSceneFile->GetString(pTextures[i].tagOffset), slot))
+		{
+			textureSlots[i] = slot;
+			bSlotUsed[slot] = true;
+			m_loadedTextures = std::max(m_loadedTextures, slot + 1);
+			decodedTextures++;
+		}
+	}
+
+	// free the images that are no longer used
+	for (int slot = 0; slot < m_loadedTextures; slot++)
+	{
+		if ((bSlotUsed[slot] == false) && (m_textureIDs[slot].tag.compare("/0") != 0))
+		{
+			if (NULL != m_pSoftwareRasterizer)
+			{
+				m_pSoftwareRasterizer->FreeTexture(slot);
+			}
+			else
+			{
+				m_pTextureResidency->Free(slot);
+			}
+			m_textureIDs[slot].tag = "/0";
+			m_textureIDs[slot].bTransparent = false;
+			m_textureIDs[slot].writeTime = 0;
+		}
+	}
+	m_sceneTextureSlots = textureSlots;
+	BindGLTextures();
+
+	// patch the materials that changed
+	const SceneFile::MATERIAL_RECORD* pMaterials = pSceneFile->GetMaterials();
+	int changedMaterials = 0;
+	m_objectMaterials.resize(pSceneFile->GetMaterialCount());
+	for (int i = 0; i < pSceneFile->GetMaterialCount(); i++)
+	{
+		const SceneFile::MATERIAL_RECORD& record = pMaterials[i];
+		OBJECT_MATERIAL& material = m_objectMaterials[i];
+		glm::vec3 ambientColor = glm::make_vec3(record.ambientColor);
+		glm::vec3 diffuseColor = glm::make_vec3(record.diffuseColor);
+		glm::vec3 specularColor = glm::make_vec3(record.specularColor);
+		if ((material.ambientColor != ambientColor) ||
+			(material.ambientStrength != record.ambientStrength) ||
+			(material.diffuseColor != diffuseColor) ||
+			(material.specularColor != specularColor) ||
+			(material.shininess != record.shininess))
+		{
+			material.ambientColor = ambientColor;
+			material.ambientStrength = record.ambientStrength;
+			material.diffuseColor = diffuseColor;
+			material.specularColor = specularColor;
+			material.shininess = record.shininess;
+			changedMaterials++;
+		}
+		material.tag = pSceneFile->GetString(record.tagOffset);
+	}
+
+	// the uniform cache skips the light values that did not change
+	ApplyLightRecords(pSceneFile->GetLights(), pSceneFile->GetLightCount());
+
+	// move the nodes in place while the hierarchy is the same
+	const SceneFile::NODE_RECORD* pNodes = pSceneFile->GetNodes();
+	bool bSameHierarchy = (pSceneFile->GetNodeCount() == m_pSceneFile->GetNodeCount());
+	for (int i = 0; (i < pSceneFile->GetNodeCount()) && (bSameHierarchy == true); i++)
+	{
+		bSameHierarchy = (pNodes[i].parent == m_pSceneFile->GetNodes()[i].parent);
+	}
+	if (bSameHierarchy == true)
+	{
+		for (int i = 0; i < pSceneFile->GetNodeCount(); i++)
+		{
+			m_sceneGraph.SetLocalTransform(m_sceneNodes[i],
+				glm::translate(glm::make_vec3(pNodes[i].position)));
+		}
+	}
+	else
+	{
+		m_sceneGraph.Clear();
+		m_sceneNodes.assign(pSceneFile->GetNodeCount(), -1);
+		for (int i = 0; i < pSceneFile->GetNodeCount(); i++)
+		{
+			int parent = ((pNodes[i].parent >= 0) && (pNodes[i].parent < i)) ?
+				m_sceneNodes[pNodes[i].parent] : -1;
+			m_sceneNodes[i] = m_sceneGraph.AddNode(parent,
+				glm::translate(glm::make_vec3(pNodes[i].position)));
+		}
+	}
+
+	// count the moved or restyled objects for the report
+	int changedObjects = std::abs(pSceneFile->GetObjectCount() - m_pSceneFile->GetObjectCount());
+	int commonObjects = std::min(pSceneFile->GetObjectCount(), m_pSceneFile->GetObjectCount());
+	for (int i = 0; i < commonObjects; i++)
+	{
+		if (memcmp(&pSceneFile->GetObjects()[i], &m_pSceneFile->GetObjects()[i],
+			sizeof(SceneFile::OBJECT_RECORD)) != 0)
+		{
+			changedObjects++;
+		}
+	}
+
+	std::cout << "Scene changes: " << decodedTextures << " textures decoded, "
+		<< changedMaterials << " materials, " << changedObjects << " objects" << std::endl;
+}
+
+/***********************************************************
+ *  PrepareSceneFile()
+ *
+ *  This method is used for loading the textures, materials,
+ *  lights and transform nodes of the mapped scene file.  The
+ *  records keep their order, so the indices stored in the
+ *  object records map directly to the loaded resources.
+ ***********************************************************/
+void SceneManager::PrepareSceneFile()
+{
+	const SceneFile::TEXTURE_RECORD* pTextures = m_pSceneFile->GetTextures();
+	m_sceneTextureSlots.assign(m_pSceneFile->GetTextureCount(), -1);
+	for (int i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+	{
+		// there are only 16 texture slots
+		int slot = m_loadedTextures;
+		if ((slot < 16) && CreateGLTexture(
+			m_pSceneFile->GetString(pTextures[i].pathOffset),
+			m_pSceneFile->GetString(pTextures[i].tagOffset)))
+		{
+			m_sceneTextureSlots[i] = slot;
+		}
+	}
+	// after the textures are loaded into memory, bind them
+	// to the texture slots
+	BindGLTextures();
+
+	const SceneFile::MATERIAL_RECORD* pMaterials = m_pSceneFile->GetMaterials();
+	for (int i = 0; i < m_pSceneFile->GetMaterialCount(); i++)
+	{
+		const SceneFile::MATERIAL_RECORD& record = pMaterials[i];
+		OBJECT_MATERIAL material;
+		material.ambientColor = glm::make_vec3(record.ambientColor);
+		material.ambientStrength = record.ambientStrength;
+		material.diffuseColor = glm::make_vec3(record.diffuseColor);
+		material.specularColor = glm::make_vec3(record.specularColor);
+		material.shininess = record.shininess;
+		material.tag = m_pSceneFile->GetString(record.tagOffset);
+		m_objectMaterials.push_back(material);
+	}
+
+	ApplyLightRecords(m_pSceneFile->GetLights(), m_pSceneFile->GetLightCount());
+
+	// the node records are already sorted depth-first
+	const SceneFile::NODE_RECORD* pNodes = m_pSceneFile->GetNodes();
+	m_sceneNodes.assign(m_pSceneFile->GetNodeCount(), -1);
+	for (int i = 0; i < m_pSceneFile->GetNodeCount(); i++)
+	{
+		int parent = ((pNodes[i].parent >= 0) && (pNodes[i].parent < i)) ?
+			m_sceneNodes[pNodes[i].parent] : -1;
+		m_sceneNodes[i] = m_sceneGraph.AddNode(parent,
+			glm::translate(glm::make_vec3(pNodes[i].position)));
+	}
+}
+
+/***********************************************************
+ *  ApplyLightRecords()
+ *
+ *  This method is used for sending the light records of the
+ *  scene file or the static scene into the shader.  Point
+ *  lights beyond the ones the shader supports are skipped.
+ *  The records are kept for baking the lighting.
+ ***********************************************************/
+void SceneManager::ApplyLightRecords(const SceneFile::LIGHT_RECORD* pLights, int count)
+{
+	m_lightRecords.assign(pLights, pLights + count);
+
+	if (NULL != m_pSoftwareRasterizer)
+	{
+		ApplySoftwareLights(pLights, count);
+		return;
+	}
+
+	m_pUniformCache->setBoolValue(g_UseLightingName, true);
+	int pointLights = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const SceneFile::LIGHT_RECORD& record = pLights[i];
+		if (record.type == SceneFile::LIGHT_DIRECTIONAL)
+		{
+			m_pUniformCache->setVec3Value("dirLight.direction", glm::make_vec3(record.vector));
+			m_pUniformCache->setVec3Value("dirLight.ambient", glm::make_vec3(record.ambientColor));
+			m_pUniformCache->setVec3Value("dirLight.diffuse", glm::make_vec3(record.diffuseColor));
+			m_pUniformCache->setVec3Value("dirLight.specular", glm::make_vec3(record.specularColor));
+		}
+		else if (pointLights < SceneFile::MAX_POINT_LIGHTS)
+		{
+			std::string name = "lightSources[" + std::to_string(pointLights++) + "].";
+			m_pUniformCache->setVec3Value(name + "position", glm::make_vec3(record.vector));
+			m_pUniformCache->setVec3Value(name + "ambientColor", glm::make_vec3(record.ambientColor));
+			m_pUniformCache->setVec3Value(name + "diffuseColor", glm::make_vec3(record.diffuseColor));
+			m_pUniformCache->setVec3Value(name + "specularColor", glm::make_vec3(record.specularColor));
+			m_pUniformCache->setFloatValue(name + "focalStrength", record.focalStrength);
+			m_pUniformCache->setFloatValue(name + "specularIntensity", record.specularIntensity);
+		}
+	}
+
+	// switch off the point lights a reloaded scene removed
+	for (; pointLights < SceneFile::MAX_POINT_LIGHTS; pointLights++)
+	{
+		std::string name = "lightSources[" + std::to_string(pointLights) + "].";
+		m_pUniformCache->setVec3Value(name + "ambientColor", 0.0f, 0.0f, 0.0f);
+		m_pUniformCache->setVec3Value(name + "diffuseColor", 0.0f, 0.0f, 0.0f);
+		m_pUniformCache->setVec3Value(name + "specularColor", 0.0f, 0.0f, 0.0f);
+	}
+}
+
+/***********************************************************
+ *  ApplySoftwareLights()
+ *
+ *  This method is used for passing the light records to the
+ *  software rasterizer, with the same limit on point lights
+ *  as the shader.
+ ***********************************************************/
+void SceneManager::ApplySoftwareLights(const SceneFile::LIGHT_RECORD* pLights, int count)
+{
+	int pointLights = 0;
+	for (int i = 0; i < count; i++)
+	{
+		const SceneFile::LIGHT_RECORD& record = pLights[i];
+		if (record.type == SceneFile::LIGHT_DIRECTIONAL)
+		{
+			SoftwareRasterizer::DIRECTIONAL_LIGHT light;
+			light.direction = glm::make_vec3(record.vector);
+			light.ambient = glm::make_vec3(record.ambientColor);
+			light.diffuse = glm::make_vec3(record.diffuseColor);
+			light.specular = glm::make_vec3(record.specularColor);
+			m_pSoftwareRasterizer->SetDirectionalLight(light);
+		}
+		else if (pointLights < SoftwareRasterizer::MAX_POINT_LIGHTS)
+		{
+			SoftwareRasterizer::POINT_LIGHT light;
+			light.position = glm::make_vec3(record.vector);
+			light.ambientColor = glm::make_vec3(record.ambientColor);
+			light.diffuseColor = glm::make_vec3(record.diffuseColor);
+			light.specularColor = glm::make_vec3(record.specularColor);
+			light.focalStrength = record.focalStrength;
+			light.specularIntensity = record.specularIntensity;
+			m_pSoftwareRasterizer->SetPointLight(pointLights++, light);
+		}
+	}
+
+	// switch off the point lights a reloaded scene removed
+	for (; pointLights < SoftwareRasterizer::MAX_POINT_LIGHTS; pointLights++)
+	{
+		SoftwareRasterizer::POINT_LIGHT light;
+		light.position = glm::vec3(0.0f, 0.0f, 0.0f);
+		light.ambientColor = glm::vec3(0.0f, 0.0f, 0.0f);
+		light.diffuseColor = glm::vec3(0.0f, 0.0f, 0.0f);
+		light.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+		light.focalStrength = 0.0f;
+		light.specularIntensity = 0.0f;
+		m_pSoftwareRasterizer->SetPointLight(pointLights, light);
+	}
+}
+
+#ifdef USE_STATIC_SCENE
+/***********************************************************
+ *  PrepareStaticScene()
+ *
+ *  This method is used for loading the textures, materials,
+ *  lights and transform nodes of the static scene.  Their
+ *  tables and the tag indices are fixed while compiling, so
+ *  only the OpenGL resources are created here.
+ ***********************************************************/
+void SceneManager::PrepareStaticScene()
+{
+	m_sceneTextureSlots.assign(StaticScene::TEXTURE_COUNT, -1);
+	for (int i = 0; i < StaticScene::TEXTURE_COUNT; i++)
+	{
+		int slot = m_loadedTextures;
+		if (CreateGLTexture(StaticScene::TEXTURES[i].path, StaticScene::TEXTURES[i].tag))
+		{
+			m_sceneTextureSlots[i] = slot;
+		}
+	}
+	// after the textures are loaded into memory, bind them
+	// to the texture slots
+	BindGLTextures();
+
+	m_objectMaterials.reserve(StaticScene::MATERIAL_COUNT);
+	for (int i = 0; i < StaticScene::MATERIAL_COUNT; i++)
+	{
+		const StaticScene::STATIC_MATERIAL& record = StaticScene::MATERIALS[i];
+		OBJECT_MATERIAL material;
+		material.ambientColor = glm::make_vec3(record.ambientColor);
+		material.ambientStrength = record.ambientStrength;
+		material.diffuseColor = glm::make_vec3(record.diffuseColor);
+		material.specularColor = glm::make_vec3(record.specularColor);
+		material.shininess = record.shininess;
+		material.tag = record.tag;
+		m_objectMaterials.push_back(material);
+	}
+
+	ApplyLightRecords(StaticScene::LIGHTS, StaticScene::LIGHT_COUNT);
+
+	m_sceneNodes.assign(StaticScene::NODE_COUNT, -1);
+	for (int i = 0; i < StaticScene::NODE_COUNT; i++)
+	{
+		int parent = StaticScene::NODES[i].parent;
+		m_sceneNodes[i] = m_sceneGraph.AddNode((parent >= 0) ? m_sceneNodes[parent] : -1,
+			glm::translate(glm::make_vec3(StaticScene::NODES[i].position)));
+	}
+}
+#endif
+
+/***********************************************************
+ *  QueueObjectRecords()
+ *
+ *  This method is used for queueing the object records of
+ *  the scene file or the static scene.  The records already
+ *  hold resolved indices, so each one is copied into a draw
+ *  command without any tag lookups.  References outside of
+ *  the tables are dropped instead of trusted.
+ ***********************************************************/
+void SceneManager::QueueObjectRecords(const SceneFile::OBJECT_RECORD* pObjects, int objectCount)
+{
+	int textureCount = (int)m_sceneTextureSlots.size();
+	int materialCount = (int)m_objectMaterials.size();
+	int nodeCount = (int)m_sceneNodes.size();
+
+	m_drawCommands.reserve(objectCount);
+	for (int i = 0; i < objectCount; i++)
+	{
+		const SceneFile::OBJECT_RECORD& record = pObjects[i];
+		if (record.mesh > MESH_TORUS)
+		{
+			continue;
+		}
+
+		DRAW_COMMAND command;
+		command.mesh = (SHAPE_MESH)record.mesh;
+		command.scaleXYZ = glm::make_vec3(record.scale);
+		command.XrotationDegrees = record.rotationDegrees[0];
+		command.YrotationDegrees = record.rotationDegrees[1];
+		command.ZrotationDegrees = record.rotationDegrees[2];
+		command.positionXYZ = glm::make_vec3(record.position);
+		command.textureSlot = ((record.texture >= 0) && (record.texture < textureCount)) ?
+			m_sceneTextureSlots[record.texture] : -1;
+		command.bUseTexture = (command.textureSlot >= 0);
+		command.color = glm::make_vec4(record.color);
+		command.UVscale = glm::make_vec2(record.UVscale);
+		command.materialIndex = (record.material < materialCount) ? record.material : -1;
+		command.parentNode = ((record.node >= 0) && (record.node < nodeCount)) ?
+			m_sceneNodes[record.node] : -1;
+		m_drawCommands.push_back(command);
+	}
 }
 
 /***********************************************************
  *  RenderScene()
  *
  *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  transforming and queueing the basic 3D shapes, then
+ *  drawing the sorted opaque and transparent queues
  ***********************************************************/
 void SceneManager::RenderScene()
 {
+	if (NULL != m_pSceneFile)
+	{
+		QueueObjectRecords(m_pSceneFile->GetObjects(), m_pSceneFile->GetObjectCount());
+		SubmitRenderQueues();
+		return;
+	}
+#ifdef USE_STATIC_SCENE
+	// the static scene replaces the built-in one
+	QueueObjectRecords(StaticScene::OBJECTS, StaticScene::OBJECT_COUNT);
+	SubmitRenderQueues();
+	return;
+#endif
+
 	// declare the variables for the transformations
 	glm::vec3 scaleXYZ;
 	float XrotationDegrees = 0.0f;
@@ -668,7 +2042,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 
 	// Draw the table top
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 	/******************************************************************/
 
 	/******************************************************************/
@@ -685,7 +2059,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 
 	// Draw the first leg
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	// Draw Box (table leg 2)
@@ -697,7 +2071,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 	
 
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 	/******************************************************************/
 
 	/******************************************************************/
@@ -709,7 +2083,7 @@ void SceneManager::RenderScene()
 	SetShaderColor(0.4f, 0.2f, 0.1f, 1.0f); // Darker brown color for the legs
 	SetShaderMaterial("wood");
 
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 	/******************************************************************/
 
 	/******************************************************************/
@@ -721,7 +2095,7 @@ void SceneManager::RenderScene()
 	SetShaderColor(0.4f, 0.2f, 0.1f, 1.0f); // Darker brown color for the legs
 	SetShaderMaterial("wood");
 
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 	/******************************************************************/
 
 	
@@ -743,7 +2117,7 @@ void SceneManager::RenderScene()
 
 
 	// Draw the back wall
-	m_basicMeshes->DrawPlaneMesh();
+	QueueDraw(MESH_PLANE);
 
 
 	/******************************************************************/
@@ -762,7 +2136,7 @@ void SceneManager::RenderScene()
 
 
 	// Draw the floor
-	m_basicMeshes->DrawPlaneMesh();
+	QueueDraw(MESH_PLANE);
 
 	/******************************************************************/
 	// Draw notepad
@@ -779,92 +2153,101 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("backdrop");
 
 	// Draw the notepad
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	// Draw pencil holder
+	// the parts below are placed relative to the pencil holder node
+	SetParentNode(m_pencilHolderNode);
+
 	// Render the top of the pencil case with the hole texture
 	SetShaderColor(0.8f, 0.6f, 0.5f, 1.0f); // Same color as the base
 	scaleXYZ = glm::vec3(0.4f, 0.05f, 0.3f); // Thin top face for the cylinder
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(1.3f, 1.161f, 1.0f)); // Top position of the cylinder
+	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 1.161f, 0.0f)); // Top position of the cylinder
 
 	// Apply texture and draw the top face
 	SetShaderTexture("claytop");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("wood");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	// Draw Cylinder (pencil holder) base
 	SetShaderColor(0.8f, 0.6f, 0.5f, 1.0f); // Light brown/orange color
 	scaleXYZ = glm::vec3(0.41f, 1.21f, 0.31f); // Set the XYZ scale for the mesh
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(1.3f, 0.0f, 1.0f)); // Set the transformations
+	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f)); // Set the transformations
 
 	// Apply texture and draw the base mesh
 	SetShaderTexture("clay");
 	SetTextureUVScale(1.0, 1.0);
 	SetShaderMaterial("wood");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
+	// the lamp parts are placed relative to the lamp node
+	SetParentNode(m_lampNode);
+
     // Draw Cylinder (lamp base)
 	// SetShaderColor(0.95f, 0.85f, 0.8f, 1.0f); // Off white color
 	scaleXYZ = glm::vec3(1.0f, 0.4f, 0.7f);// set the XYZ scale for the mesh
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.25f, 0.0f)); // set the transformations
+	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f)); // set the transformations
 	// Texture
 	SetShaderTexture("plastic");
 	SetTextureUVScale(1.0, 1.0);
 	SetShaderMaterial("wood");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
 	// Draw Cylinder (lamp stem)
 	// SetShaderColor(0.4f, 0.4f, 0.4f, 1.0f); // Dark grey color
 	scaleXYZ = glm::vec3(0.1f, 4.0f, 0.1f);// set the XYZ scale for the mesh
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.6f, 0.35f, 0.0f)); // set the transformations
+	SetTransformations(scaleXYZ, 0.0f, 0.0f, 0.0f, glm::vec3(0.6f, 0.1f, 0.0f)); // set the transformations
 	// Texture
 	SetShaderTexture("metal");
 	SetTextureUVScale(1.0, 1.0);
 	SetShaderMaterial("metal");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
 	// Draw Cone (lamp shade)
 	SetShaderColor(0.95f, 0.85f, 0.8f, 1.0f); // Off white color
 	scaleXYZ = glm::vec3(0.6f, 1.0f, 0.6f); // Scale for the cone
-	SetTransformations(scaleXYZ, -45.0f, 0.0f, -20.0f, glm::vec3(-0.2f, 3.65f, 0.6f)); // set the transformations
+	SetTransformations(scaleXYZ, -45.0f, 0.0f, -20.0f, glm::vec3(-0.2f, 3.4f, 0.6f)); // set the transformations
 	// Texture
 	SetShaderTexture("plastic");
 	SetTextureUVScale(1.0, 1.0);
 	SetShaderMaterial("wood");
 
-	m_basicMeshes->DrawConeMesh();
+	QueueDraw(MESH_CONE);
 
 	/******************************************************************/
 	// Draw Cylinder (lamp top)
 	SetShaderColor(0.95f, 0.85f, 0.8f, 1.0f); // Off white color
 	scaleXYZ = glm::vec3(0.16f, 0.7f, 0.16f);// set the XYZ scale for the mesh
-	SetTransformations(scaleXYZ, 0.0f, 0.0f, 90.0f, glm::vec3(0.9f, 4.25f, 0.0f)); // set the transformations
+	SetTransformations(scaleXYZ, 0.0f, 0.0f, 90.0f, glm::vec3(0.9f, 4.0f, 0.0f)); // set the transformations
 	// Texture
 	SetShaderTexture("plastic");
 	SetTextureUVScale(1.0, 1.0);
 	SetShaderMaterial("wood");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
 	// Draw Cylinder (lamp top 2)
 	SetShaderColor(0.95f, 0.85f, 0.8f, 1.0f); // Off white color
 	scaleXYZ = glm::vec3(0.2f, 0.8f, 0.2f);// set the XYZ scale for the mesh
-	SetTransformations(scaleXYZ, -45.0f, 0.0f, -20.0f, glm::vec3(0.0f, 3.95f, 0.3f)); // set the transformations
+	SetTransformations(scaleXYZ, -45.0f, 0.0f, -20.0f, glm::vec3(0.0f, 3.7f, 0.3f)); // set the transformations
 	// Texture
 	SetShaderTexture("plastic");
 	SetTextureUVScale(1.0, 1.0);
 	SetShaderMaterial("wood");
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
+
+	// back to world space for the rest of the scene
+	SetParentNode(-1);
 
 
 	/******************************************************************/
@@ -883,7 +2266,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("cover");
 
 	// Draw book 1
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	// Draw Box (book 1 pages)
@@ -900,7 +2283,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 	 
 	// Draw book 1 pages
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 
 	/******************************************************************/
@@ -919,7 +2302,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("cover");
 
 	// Draw book 2
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	// Draw Box (book 2 pages)
@@ -937,7 +2320,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 
 	// Draw book 2 pages
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	// Draw Box (book 3)
@@ -955,7 +2338,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("cover");
 
 	// Draw book 3
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	// Draw Box (book 3 pages)
@@ -973,7 +2356,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 
 	// Draw book 3 pages
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	//  Bowl on top of books
@@ -986,7 +2369,7 @@ void SceneManager::RenderScene()
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	// Draw Cylinder (bowl) base
 	SetShaderColor(0.8f, 0.6f, 0.5f, 1.0f); // Light brown/orange color
@@ -998,7 +2381,7 @@ void SceneManager::RenderScene()
 	SetTextureUVScale(1.0, 1.0);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
     // Draw Box (book 4 - Top/Bottom)
@@ -1016,7 +2399,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("backdrop");
 
     // Draw book 4
-    m_basicMeshes->DrawBoxMesh();
+    QueueDraw(MESH_BOX);
 
 	/******************************************************************/
 	// Draw Box (book 4 - Spine)
@@ -1034,7 +2417,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("backdrop");
 
 	// Draw book 4 spine
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 	
 	/******************************************************************/
 	// Draw Box (book 4 - pages)
@@ -1052,7 +2435,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 
 	// Draw book 4 pages
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
     /******************************************************************/
     // Draw Box (book 5 - top)
@@ -1070,7 +2453,7 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("backdrop");
 
     // Draw book 5
-    m_basicMeshes->DrawBoxMesh();
+    QueueDraw(MESH_BOX);
 
     /******************************************************************/
 	// Draw Box (book 5 - pages)
@@ -1088,119 +2471,126 @@ void SceneManager::RenderScene()
 	SetShaderMaterial("wood");
 
 	// Draw book 5 pages
-	m_basicMeshes->DrawBoxMesh();
+	QueueDraw(MESH_BOX);
 
 	/******************************************************************/
+	// the pencils stand in the pencil holder and move with it
+	SetParentNode(m_pencilHolderNode);
+
 	// Draw Cylinder (pencil)
 	SetShaderColor(1.0f, 0.85f, 0.6f, 1.0f); // Light wood color for the pencil body
 	scaleXYZ = glm::vec3(0.03f, 1.0f, 0.03f); // Thin, long cylinder for the pencil body
-	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(1.53f, 0.9f, 1.0f)); // Position it above the pencil holder at an angle
+	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(0.23f, 0.9f, 0.0f)); // Position it above the pencil holder at an angle
 
 	SetShaderTexture("pencil");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	// Draw Pencil Top
 	scaleXYZ = glm::vec3(0.0299f, 1.0001f, 0.0299f); // Scale
-	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(1.53f, 0.9f, 1.0f)); // Position
+	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(0.23f, 0.9f, 0.0f)); // Position
 
 	SetShaderTexture("penciltop");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 
 	/******************************************************************/
 	// Draw Cylinder (pencil 2)
 	SetShaderColor(1.0f, 0.85f, 0.6f, 1.0f); // Light wood color for the pencil body
 	scaleXYZ = glm::vec3(0.0301f, 1.0f, 0.03f); // Thin, long cylinder for the pencil body
-	SetTransformations(scaleXYZ, 0.0f, -15.0f, -25.0f, glm::vec3(1.4f, 0.9f, 1.1f)); // Position e
+	SetTransformations(scaleXYZ, 0.0f, -15.0f, -25.0f, glm::vec3(0.1f, 0.9f, 0.1f)); // Position e
 
 	SetShaderTexture("pencil");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	// Draw Pencil Top
 	scaleXYZ = glm::vec3(0.0299f, 1.002f, 0.0299f); // Scale
-	SetTransformations(scaleXYZ, 0.0f, -15.0f, -25.0f, glm::vec3(1.4f, 0.9f, 1.1f)); // Position 
+	SetTransformations(scaleXYZ, 0.0f, -15.0f, -25.0f, glm::vec3(0.1f, 0.9f, 0.1f)); // Position 
 
 	SetShaderTexture("penciltop");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
 	// Draw Cylinder (pencil 3)
 	SetShaderColor(1.0f, 0.85f, 0.6f, 1.0f); // Light wood color for the pencil body
 	scaleXYZ = glm::vec3(0.03f, 1.0f, 0.03f); // Thin, long cylinder for the pencil body
-	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(1.3f, 0.9f, 1.0f)); // Position
+	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(0.0f, 0.9f, 0.0f)); // Position
 
 	SetShaderTexture("pencil");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	// Draw Pencil Top
 	scaleXYZ = glm::vec3(0.0299f, 1.001f, 0.0299f); // Scale
-	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(1.3f, 0.9f, 1.0f)); // Position
+	SetTransformations(scaleXYZ, 0.0f, -15.0f, -15.0f, glm::vec3(0.0f, 0.9f, 0.0f)); // Position
 
 	SetShaderTexture("penciltop");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
 	// Draw Cylinder (pencil 4 - black)
 	SetShaderColor(1.0f, 0.85f, 0.6f, 1.0f); // Light wood color for the pencil body
 	scaleXYZ = glm::vec3(0.03f, 1.0f, 0.03f); // Thin, long cylinder for the pencil body
-	SetTransformations(scaleXYZ, 15.0f, 0.0f, -15.0f, glm::vec3(1.35f, 0.9f, 1.11f)); // Position
+	SetTransformations(scaleXYZ, 15.0f, 0.0f, -15.0f, glm::vec3(0.05f, 0.9f, 0.11f)); // Position
 
 	SetShaderTexture("pencil2");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	// Draw Pencil Top
 	scaleXYZ = glm::vec3(0.0299f, 1.001f, 0.0299f); // Scale
-	SetTransformations(scaleXYZ, 15.0f, 0.0f, -15.0f, glm::vec3(1.35f, 0.9f, 1.11f)); // Position 
+	SetTransformations(scaleXYZ, 15.0f, 0.0f, -15.0f, glm::vec3(0.05f, 0.9f, 0.11f)); // Position 
 
 	SetShaderTexture("penciltop2");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	/******************************************************************/
 	// Draw Cylinder (pencil 5 - black)
 	SetShaderColor(1.0f, 0.85f, 0.6f, 1.0f); // Light wood color for the pencil body
 	scaleXYZ = glm::vec3(0.03f, 1.0f, 0.03f); // Thin, long cylinder for the pencil body
-	SetTransformations(scaleXYZ, 10.0f, -15.0f, -5.0f, glm::vec3(1.2f, 0.9f, 1.13f)); // Position 
+	SetTransformations(scaleXYZ, 10.0f, -15.0f, -5.0f, glm::vec3(-0.1f, 0.9f, 0.13f)); // Position 
 
 	SetShaderTexture("pencil2");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
 
 	// Draw Pencil Top
 	scaleXYZ = glm::vec3(0.0299f, 1.001f, 0.0299f); // Scale
-	SetTransformations(scaleXYZ, 10.0f, -15.0f, -5.0f, glm::vec3(1.2f, 0.9f, 1.13f)); // Position 
+	SetTransformations(scaleXYZ, 10.0f, -15.0f, -5.0f, glm::vec3(-0.1f, 0.9f, 0.13f)); // Position 
 
 	SetShaderTexture("penciltop2");
 	SetTextureUVScale(1.0f, 1.0f);
 	SetShaderMaterial("cover");
 
-	m_basicMeshes->DrawCylinderMesh();
+	QueueDraw(MESH_CYLINDER);
+
+	SetParentNode(-1);
 
+	// draw the queued shapes sorted by their distance to the camera
+	SubmitRenderQueues();
 }
 
 
@@ -10,7 +10,18 @@
 #pragma once
 
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "GLStateCache.h"
+#include "UniformCache.h"
+#include "JobSystem.h"
+#include "TransformBatch.h"
+#include "SceneGraph.h"
+#include "MeshLibrary.h"
+#include "SceneFile.h"
+#include "FileWatcher.h"
+#include "TextureResidency.h"
+#include "SoftwareRasterizer.h"
+#include "BoundingVolumeHierarchy.h"
+#include "LightBaker.h"
 
 #include <string>
 #include <vector>
@@ -25,14 +36,22 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(
+		ShaderManager *pShaderManager,
+		GLStateCache* pStateCache,
+		UniformCache* pUniformCache);
 	// destructor
 	~SceneManager();
 
+	// the OpenGL texture of a slot is owned by the texture
+	// residency, which may evict and reload it
 	struct TEXTURE_INFO
 	{
 		std::string tag;
-		uint32_t ID;
+		// true when the image carries partially transparent pixels
+		bool bTransparent;
+		// modification time of the image file when it was loaded
+		long long writeTime;
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,20 +64,147 @@ public:
 		std::string tag;
 	};
 
+	// basic shape meshes that can be queued for drawing
+	enum SHAPE_MESH
+	{
+		MESH_BOX,
+		MESH_PLANE,
+		MESH_CYLINDER,
+		MESH_CONE,
+		MESH_PRISM,
+		MESH_PYRAMID4,
+		MESH_SPHERE,
+		MESH_TAPERED_CYLINDER,
+		MESH_TORUS
+	};
+
+	// recorded shader state and transform for one queued draw
+	struct DRAW_COMMAND
+	{
+		SHAPE_MESH mesh;
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+		bool bUseTexture;
+		glm::vec4 color;
+		int textureSlot;
+		glm::vec2 UVscale;
+		int materialIndex;
+		// scene graph node the transform is relative to, or -1
+		int parentNode;
+	};
+
+	// queued draw found along a ray
+	struct PICK_RESULT
+	{
+		// index of the draw in the order RenderScene queues them
+		int objectIndex;
+		SHAPE_MESH mesh;
+		float distance;
+		glm::vec3 position;
+	};
+
+	// per-draw data packed by the scene preparation jobs
+	struct PREPARED_DRAW
+	{
+		glm::mat4 model;
+		// transparency, camera distance and draw order
+		uint64_t sortKey;
+		int commandIndex;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
+	// pointer to the OpenGL state cache object
+	GLStateCache* m_pStateCache;
+	// pointer to the uniform cache object
+	UniformCache* m_pUniformCache;
+	// basic shape meshes in one shared buffer
+	MeshLibrary* m_pMeshLibrary;
+	// OpenGL textures of the texture slots, within a budget
+	TextureResidency* m_pTextureResidency;
+	// draws the scene on the CPU instead of OpenGL, or NULL
+	SoftwareRasterizer* m_pSoftwareRasterizer;
+	// rasterizer sharing the scene that records the draws of
+	// the next frames instead, or NULL
+	SoftwareRasterizer* m_pSoftwareTarget;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// shader state recorded for the next queued draw
+	DRAW_COMMAND m_currentDraw;
+	// draws queued by RenderScene in recording order
+	std::vector<DRAW_COMMAND> m_drawCommands;
+	// transforms of the queued draws, recomposed only when
+	// a draw moved since the previous frame
+	TransformBatch m_transforms;
+	// Euler angles each draw's rotation was last converted
+	// from, so the conversion only runs when they change
+	std::vector<glm::vec3> m_drawAngles;
+	std::vector<glm::quat> m_drawRotations;
+	// composed model matrix of every queued draw
+	std::vector<glm::mat4> m_modelMatrices;
+	// mesh-space box of every shape, resolved before the
+	// preparation jobs for the shapes that are queued
+	BoundingVolumeHierarchy::AABB m_meshBounds[MeshLibrary::SHAPE_COUNT];
+	// transform hierarchy of the assembled objects
+	SceneGraph m_sceneGraph;
+	// scene graph nodes that move the parts of an assembly
+	int m_lampNode;
+	int m_pencilHolderNode;
+	// mapped binary scene file, or NULL for the built-in scene
+	SceneFile* m_pSceneFile;
+	// path the scene file was loaded from, for reloading
+	std::string m_sceneFilename;
+	// texture slot of every texture record of the scene file
+	// or the static scene, -1 when not loaded
+	std::vector<int> m_sceneTextureSlots;
+	// scene graph node of every node record
+	std::vector<int> m_sceneNodes;
+	// visible draws packed by each job thread
+	std::vector<std::vector<PREPARED_DRAW> > m_threadDraws;
+	// visible draws of all threads, in submission order
+	std::vector<PREPARED_DRAW> m_preparedDraws;
+	// world matrix, bounds and mesh of every queued draw of
+	// the last frame, kept for the spatial queries
+	std::vector<glm::mat4> m_worldMatrices;
+	std::vector<BoundingVolumeHierarchy::AABB> m_objectBounds;
+	std::vector<SHAPE_MESH> m_objectMeshes;
+	// set for the draws whose bounds changed since the index
+	// was last updated
+	std::vector<uint8_t> m_boundsChanged;
+	// spatial index over the bounds of the queued draws
+	BoundingVolumeHierarchy m_objectIndex;
+	// lights of the scene, kept for baking
+	std::vector<SceneFile::LIGHT_RECORD> m_lightRecords;
+	// baked lighting of the queued draws
+	LightBaker m_lightBaker;
+	// the queued draws as they are baked, gathered again to
+	// check that a bake still matches the scene
+	std::vector<LightBaker::BAKE_DRAW> m_bakeDraws;
+	// the next submitted frame is baked instead of drawn
+	bool m_bBakeLighting;
+	// the next submitted frame only gathers its draws, which
+	// a bake file is checked against before it is read
+	bool m_bGatherBakeDraws;
+	LightBaker::OCCLUSION_SETTINGS m_bakeOcclusion;
+	// pointer to the job system used for preparing the draws
+	JobSystem* m_pJobSystem;
+	// camera position used for sorting the queued draws
+	glm::vec3 m_viewPosition;
+	// camera frustum planes used for culling the queued draws
+	glm::vec4 m_frustumPlanes[6];
 
 	// load texture images and convert to OpenGL texture data
 	bool CreateGLTexture(const char* filename, std::string tag);
+	// load a texture image file into one texture slot
+	bool LoadGLTexture(const char* filename, std::string tag, int slot);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
@@ -68,9 +214,36 @@ private:
 	int FindTextureSlot(std::string tag);
 	// find a defined material by tag
 	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(std::string tag);
 
-	// set the transformation values 
-	// into the transform buffer
+	// queue the given mesh with the currently recorded state
+	void QueueDraw(SHAPE_MESH mesh);
+	// check whether a queued draw needs blending
+	bool IsTransparent(const DRAW_COMMAND& command);
+	// compose the model matrices of the queued draws
+	void ComposeDrawTransforms();
+	// get the mesh-space boxes of the queued shapes
+	void ResolveMeshBounds();
+	// transform, cull and pack a range of the queued draws
+	void PrepareDraws(int begin, int end);
+	// refit or rebuild the spatial index to the moved draws
+	void UpdateObjectIndex();
+	// prepare, sort and draw the queued draws
+	void SubmitRenderQueues();
+	// send the recorded state of a queued draw into the shader
+	void ApplyDrawCommand(const DRAW_COMMAND& command, const glm::mat4& model);
+	// draw the basic shape mesh for a queued draw
+	void DrawShapeMesh(SHAPE_MESH mesh);
+	// record the sorted draws with the software rasterizer
+	void SubmitSoftwareDraws();
+	// get the meshes, models and materials the queued draws
+	// are baked with
+	bool GatherBakeDraws(std::vector<LightBaker::BAKE_DRAW>& draws);
+	// bake the lighting of all of the queued draws
+	void BakeQueuedDraws();
+
+	// record the transformation values 
+	// for the next queued draw
 	void SetTransformations(
 		glm::vec3 scaleXYZ,
 		float XrotationDegrees,
@@ -78,32 +251,90 @@ private:
 		float ZrotationDegrees,
 		glm::vec3 positionXYZ);
 
-	// set the color values into the shader
+	// record the color values for the next queued draw
 	void SetShaderColor(
 		float redColorValue,
 		float greenColorValue,
 		float blueColorValue,
 		float alphaValue);
 
-	// set the texture data into the shader
+	// record the texture for the next queued draw
 	void SetShaderTexture(
 		std::string textureTag);
 
-	// set the UV scale for the texture mapping
+	// record the UV scale for the texture mapping
 	void SetTextureUVScale(
 		float u, float v);
 
-	// set the object material into the shader
+	// record the object material for the next queued draw
 	void SetShaderMaterial(
 		std::string materialTag);
 
+	// record the scene graph node that the next queued draws
+	// are placed relative to, -1 for world space
+	void SetParentNode(int node);
+
+	// load the textures, materials, lights and nodes of the
+	// mapped scene file
+	void PrepareSceneFile();
+#ifdef USE_STATIC_SCENE
+	// load the textures, materials, lights and nodes of the
+	// compiled-in static scene
+	void PrepareStaticScene();
+#endif
+	// update the loaded scene to a newly opened scene file
+	void ApplySceneFileChanges(const SceneFile* pSceneFile);
+	// send the light records into the shader
+	void ApplyLightRecords(const SceneFile::LIGHT_RECORD* pLights, int count);
+	// pass the light records to the software rasterizer
+	void ApplySoftwareLights(const SceneFile::LIGHT_RECORD* pLights, int count);
+	// queue object records with resolved indices
+	void QueueObjectRecords(const SceneFile::OBJECT_RECORD* pObjects, int count);
+
 public:
 
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
+	// use a binary scene file instead of the built-in scene,
+	// must be called before PrepareScene()
+	bool LoadSceneFile(const char* filename);
+	// load the scene file again after it was edited, only
+	// updating what changed
+	bool ReloadSceneFile();
 	// rendering objects
 	void RenderScene();
+	// set the camera position used for sorting the draws
+	void SetViewPosition(glm::vec3 viewPosition);
+	// set the camera view-projection used for culling the draws
+	void SetViewProjection(glm::mat4 viewProjection);
+	// set the job system used to prepare the draws in parallel
+	void SetJobSystem(JobSystem* pJobSystem);
+	// draw with the software rasterizer instead of OpenGL,
+	// must be called before PrepareScene()
+	void SetSoftwareRasterizer(SoftwareRasterizer* pRasterizer);
+	// record the next frames with another rasterizer sharing
+	// the scene of the software rasterizer, NULL to stop
+	void SetSoftwareTarget(SoftwareRasterizer* pTarget);
+	// store the shape meshes in the compact vertex layout
+	void SetCompactVertices(bool bCompact);
+	// set the tessellation of the curved shape meshes
+	void SetMeshTessellation(int segments, int rings);
+	// set the video memory budget of the textures, 0 for none
+	void SetTextureBudget(size_t budgetBytes);
+	// print the texture residency of the last frame
+	void PrintTextureStats() const;
+	// find the closest draw of the last frame along a ray
+	bool PickObject(const glm::vec3& origin, const glm::vec3& direction, PICK_RESULT& result);
+	// get the spatial index over the draws of the last frame
+	const BoundingVolumeHierarchy& GetObjectIndex() const;
+	// bake the static lighting of the scene and write it to a
+	// bake file, only with the software rasterizer
+	bool BakeStaticLighting(const char* filename, const LightBaker::OCCLUSION_SETTINGS& occlusion);
+	// light the software draws with the colors of a bake file
+	bool LoadBakedLighting(const char* filename);
+	// advance the scene animations by one fixed simulation tick
+	void UpdateScene(float timeStep);
 
 	// load textures before rendering
 	void LoadSceneTextures();
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+// simulationclock.cpp
+// ============
+// step the scene simulation at a fixed tick rate independent of rendering
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SimulationClock.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+// declaration of global variables
+namespace
+{
+	// most ticks run for one frame - after a long stall the
+	// remaining time is dropped instead of catching up
+	constexpr int MAX_TICKS_PER_FRAME = 8;
+}
+
+/***********************************************************
+ *  SimulationClock()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SimulationClock::SimulationClock(double ticksPerSecond)
+{
+	if (ticksPerSecond <= 0.0)
+	{
+		ticksPerSecond = 120.0;
+	}
+	m_timeStep = 1.0 / ticksPerSecond;
+	m_accumulator = 0.0;
+	m_lastTime = 0.0;
+	m_bFirstAdvance = true;
+}
+
+/***********************************************************
+ *  ~SimulationClock()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SimulationClock::~SimulationClock()
+{
+}
+
+/***********************************************************
+ *  GetTimeStep()
+ *
+ *  This method is used for getting the length of one fixed
+ *  simulation tick in seconds.
+ ***********************************************************/
+float SimulationClock::GetTimeStep() const
+{
+	return((float)m_timeStep);
+}
+
+/***********************************************************
+ *  Advance()
+ *
+ *  This method is used for adding the real time elapsed since
+ *  the last call, and returning how many fixed ticks should
+ *  be simulated to catch up with it.
+ ***********************************************************/
+int SimulationClock::Advance()
+{
+	double currentTime = glfwGetTime();
+	int ticks = 0;
+
+	if (m_bFirstAdvance == true)
+	{
+		m_lastTime = currentTime;
+		m_bFirstAdvance = false;
+	}
+
+	m_accumulator += currentTime - m_lastTime;
+	m_lastTime = currentTime;
+
+	while ((m_accumulator >= m_timeStep) && (ticks < MAX_TICKS_PER_FRAME))
+	{
+		m_accumulator -= m_timeStep;
+		ticks++;
+	}
+
+	// drop the time that could not be simulated
+	if (m_accumulator >= m_timeStep)
+	{
+		m_accumulator = 0.0;
+	}
+
+	return(ticks);
+}
+
+/***********************************************************
+ *  GetAlpha()
+ *
+ *  This method is used for getting how far the current time
+ *  is past the last simulated tick, from 0 to 1.
+ ***********************************************************/
+float SimulationClock::GetAlpha() const
+{
+	return((float)(m_accumulator / m_timeStep));
+}
@@ -0,0 +1,43 @@
+///////////////////////////////////////////////////////////////////////////////
+// simulationclock.h
+// ============
+// step the scene simulation at a fixed tick rate independent of rendering
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+/***********************************************************
+ *  SimulationClock
+ *
+ *  This class accumulates the real elapsed time and converts
+ *  it into a whole number of fixed simulation ticks.  The
+ *  time left over is returned as an interpolation factor,
+ *  so rendering can blend the last two simulated states.
+ ***********************************************************/
+class SimulationClock
+{
+public:
+	// constructor
+	SimulationClock(double ticksPerSecond);
+	// destructor
+	~SimulationClock();
+
+private:
+	// length of one simulation tick in seconds
+	double m_timeStep;
+	// real time that has not been simulated yet
+	double m_accumulator;
+	// real time of the last call to Advance()
+	double m_lastTime;
+	// true until the first call to Advance()
+	bool m_bFirstAdvance;
+
+public:
+	// get the length of one tick in seconds
+	float GetTimeStep() const;
+	// get the number of ticks to run for the elapsed time
+	int Advance();
+	// get how far the current time is between the last two ticks
+	float GetAlpha() const;
+};
@@ -0,0 +1,1275 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.cpp
+// ============
+// render the shape meshes on the CPU with a binned tile rasterizer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SoftwareRasterizer.h"
+#include "MemoryTracker.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+// the triangle setup and the edge functions work on four
+// values at once wherever SSE2 is available
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define RASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// outcode bits of a clip space vertex, one per frustum plane
+	const int OUTSIDE_LEFT = 1;
+	const int OUTSIDE_RIGHT = 2;
+	const int OUTSIDE_BOTTOM = 4;
+	const int OUTSIDE_TOP = 8;
+	const int OUTSIDE_NEAR = 16;
+	const int OUTSIDE_FAR = 32;
+
+	// triangles with less area in pixels cover nothing
+	const float MIN_TRIANGLE_AREA = 1.0e-8f;
+
+	// the draws and the tile rows are handed out one at a
+	// time, the tiles are small enough to share evenly
+	const int DRAW_GRAIN_SIZE = 1;
+	const int TILE_GRAIN_SIZE = 1;
+
+	/***********************************************************
+	 *  GetOutcode()
+	 *
+	 *  This function is used for getting the frustum planes a
+	 *  clip space vertex is outside of.
+	 ***********************************************************/
+	int GetOutcode(const glm::vec4& clip)
+	{
+		int code = 0;
+		if (clip.x < -clip.w) code |= OUTSIDE_LEFT;
+		if (clip.x > clip.w) code |= OUTSIDE_RIGHT;
+		if (clip.y < -clip.w) code |= OUTSIDE_BOTTOM;
+		if (clip.y > clip.w) code |= OUTSIDE_TOP;
+		if (clip.z < -clip.w) code |= OUTSIDE_NEAR;
+		if (clip.z > clip.w) code |= OUTSIDE_FAR;
+		return(code);
+	}
+
+	/***********************************************************
+	 *  UnpackColor()
+	 *
+	 *  This function is used for expanding an RGBA8 texel to
+	 *  floats from 0 to 1.
+	 ***********************************************************/
+	glm::vec4 UnpackColor(uint32_t texel)
+	{
+		const float scale = 1.0f / 255.0f;
+		return(glm::vec4(
+			(float)(texel & 0xff) * scale,
+			(float)((texel >> 8) & 0xff) * scale,
+			(float)((texel >> 16) & 0xff) * scale,
+			(float)(texel >> 24) * scale));
+	}
+
+	/***********************************************************
+	 *  PackColor()
+	 *
+	 *  This function is used for clamping a color and storing
+	 *  it as an opaque RGBA8 pixel.
+	 ***********************************************************/
+	uint32_t PackColor(const glm::vec4& color)
+	{
+		glm::vec3 clamped = glm::clamp(glm::vec3(color), 0.0f, 1.0f);
+		uint32_t r = (uint32_t)(clamped.r * 255.0f + 0.5f);
+		uint32_t g = (uint32_t)(clamped.g * 255.0f + 0.5f);
+		uint32_t b = (uint32_t)(clamped.b * 255.0f + 0.5f);
+		return(r | (g << 8) | (b << 16) | 0xff000000u);
+	}
+
+	/***********************************************************
+	 *  WrapCoordinate()
+	 *
+	 *  This function is used for repeating a texel coordinate
+	 *  over the size of the texture.
+	 ***********************************************************/
+	int WrapCoordinate(int coordinate, int size)
+	{
+		coordinate %= size;
+		return((coordinate < 0) ? coordinate + size : coordinate);
+	}
+}
+
+/***********************************************************
+ *  SoftwareRasterizer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SoftwareRasterizer::SoftwareRasterizer(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		m_textures[i].width = 0;
+		m_textures[i].height = 0;
+	}
+	m_pTextures = m_textures;
+
+	// no light until the scene sets them, like the uniforms
+	m_directionalLight.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	m_directionalLight.ambient = glm::vec3(0.0f);
+	m_directionalLight.diffuse = glm::vec3(0.0f);
+	m_directionalLight.specular = glm::vec3(0.0f);
+	for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+	{
+		m_pointLights[i].position = glm::vec3(0.0f);
+		m_pointLights[i].ambientColor = glm::vec3(0.0f);
+		m_pointLights[i].diffuseColor = glm::vec3(0.0f);
+		m_pointLights[i].specularColor = glm::vec3(0.0f);
+		m_pointLights[i].focalStrength = 1.0f;
+		m_pointLights[i].specularIntensity = 0.0f;
+	}
+	m_activeLightCount = 0;
+	m_currentMaterial.ambientColor = glm::vec3(0.0f);
+	m_currentMaterial.ambientStrength = 0.0f;
+	m_currentMaterial.diffuseColor = glm::vec3(0.0f);
+	m_currentMaterial.specularColor = glm::vec3(0.0f);
+	m_currentMaterial.shininess = 1.0f;
+
+	m_viewProjection = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_clearColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	m_width = 0;
+	m_height = 0;
+	m_tilesX = 0;
+	m_tilesY = 0;
+
+	int threadCount = (NULL != m_pJobSystem) ? m_pJobSystem->GetThreadCount() : 1;
+	m_tileBuffers.resize(threadCount);
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_tileBuffers[i].color.resize(TILE_SIZE * TILE_SIZE);
+		m_tileBuffers[i].depth.resize(TILE_SIZE * TILE_SIZE);
+		m_tileBuffers[i].visible.resize(TILE_SIZE * TILE_SIZE);
+	}
+	m_threadPixels.assign(threadCount, 0);
+
+	m_frameStats.draws = 0;
+	m_frameStats.triangles = 0;
+	m_frameStats.binned = 0;
+	m_frameStats.pixels = 0;
+	m_frameStats.setupMs = 0.0;
+	m_frameStats.binMs = 0.0;
+	m_frameStats.rasterMs = 0.0;
+	m_lastFrameStats = m_frameStats;
+}
+
+/***********************************************************
+ *  ~SoftwareRasterizer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		FreeTexture(i);
+	}
+	MemoryTracker::Release(this, MAX_TEXTURES);
+	m_pJobSystem = NULL;
+}
+
+/***********************************************************
+ *  LoadTexture()
+ *
+ *  This method is used for decoding an image file into a
+ *  texture slot as RGBA texels, flipped so the bottom row
+ *  comes first like the images uploaded to OpenGL.  The
+ *  texture is sampled with the same bilinear filtering and
+ *  wrapping as the OpenGL textures.
+ ***********************************************************/
+bool SoftwareRasterizer::LoadTexture(int slot, const char* filename, bool& bTransparent)
+{
+	if ((slot < 0) || (slot >= MAX_TEXTURES))
+	{
+		return(false);
+	}
+
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 0);
+	if (NULL == image)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return(false);
+	}
+	if ((colorChannels != 3) && (colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		stbi_image_free(image);
+		return(false);
+	}
+
+	TEXTURE& texture = m_textures[slot];
+	int pixelCount = width * height;
+	texture.width = width;
+	texture.height = height;
+	texture.texels.resize(pixelCount);
+
+	// an RGBA image only needs blending if some pixel is not
+	// fully opaque
+	bTransparent = false;
+	for (int i = 0; i < pixelCount; i++)
+	{
+		const unsigned char* pixel = image + (i * colorChannels);
+		uint32_t alpha = (colorChannels == 4) ? pixel[3] : 255;
+		if (alpha < 255)
+		{
+			bTransparent = true;
+		}
+		texture.texels[i] = (uint32_t)pixel[0] | ((uint32_t)pixel[1] << 8) |
+			((uint32_t)pixel[2] << 16) | (alpha << 24);
+	}
+	stbi_image_free(image);
+
+	MemoryTracker::Track(this, slot, MemoryTracker::MEMORY_IMAGE_DATA,
+		filename, texture.texels.size() * sizeof(uint32_t));
+	return(true);
+}
+
+/***********************************************************
+ *  FreeTexture()
+ *
+ *  This method is used for freeing the texels of a slot.
+ ***********************************************************/
+void SoftwareRasterizer::FreeTexture(int slot)
+{
+	if ((slot < 0) || (slot >= MAX_TEXTURES))
+	{
+		return;
+	}
+
+	TEXTURE& texture = m_textures[slot];
+	std::vector<uint32_t>().swap(texture.texels);
+	texture.width = 0;
+	texture.height = 0;
+	MemoryTracker::Release(this, slot);
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for setting the directional light.
+ ***********************************************************/
+void SoftwareRasterizer::SetDirectionalLight(const DIRECTIONAL_LIGHT& light)
+{
+	m_directionalLight = light;
+}
+
+/***********************************************************
+ *  SetPointLight()
+ *
+ *  This method is used for setting one of the point lights.
+ *  A light with black colors is switched off.
+ ***********************************************************/
+void SoftwareRasterizer::SetPointLight(int index, const POINT_LIGHT& light)
+{
+	if ((index < 0) || (index >= MAX_POINT_LIGHTS))
+	{
+		return;
+	}
+	m_pointLights[index] = light;
+
+	m_activeLightCount = 0;
+	for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+	{
+		const POINT_LIGHT& pointLight = m_pointLights[i];
+		if ((pointLight.ambientColor != glm::vec3(0.0f)) ||
+			(pointLight.diffuseColor != glm::vec3(0.0f)) ||
+			(pointLight.specularColor != glm::vec3(0.0f)))
+		{
+			m_activeLights[m_activeLightCount++] = i;
+		}
+	}
+}
+
+/***********************************************************
+ *  ShareScene()
+ *
+ *  This method is used for rendering the scene of another
+ *  rasterizer.  The decoded textures are sampled where they
+ *  are instead of being loaded again, so several rasterizers
+ *  can render views of one scene on different threads, and
+ *  the lights and the current material are copied.
+ ***********************************************************/
+void SoftwareRasterizer::ShareScene(const SoftwareRasterizer& source)
+{
+	m_pTextures = source.m_pTextures;
+	m_directionalLight = source.m_directionalLight;
+	for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+	{
+		m_pointLights[i] = source.m_pointLights[i];
+		m_activeLights[i] = source.m_activeLights[i];
+	}
+	m_activeLightCount = source.m_activeLightCount;
+	m_currentMaterial = source.m_currentMaterial;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame.  The image is
+ *  resized when the passed in size changed, and the draws
+ *  of the previous frame are forgotten.
+ ***********************************************************/
+void SoftwareRasterizer::BeginFrame(
+	int width, int height,
+	const glm::mat4& viewProjection,
+	const glm::vec3& viewPosition,
+	const glm::vec4& clearColor)
+{
+	width = std::max(1, width);
+	height = std::max(1, height);
+	if ((width != m_width) || (height != m_height))
+	{
+		m_width = width;
+		m_height = height;
+		m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+		m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+		m_colorBuffer.assign((size_t)width * height, 0);
+		m_bins.resize((size_t)m_tilesX * m_tilesY);
+		MemoryTracker::Track(this, MAX_TEXTURES, MemoryTracker::MEMORY_IMAGE_DATA,
+			"software color buffer", m_colorBuffer.size() * sizeof(uint32_t));
+	}
+
+	m_viewProjection = viewProjection;
+	m_viewPosition = viewPosition;
+	m_clearColor = clearColor;
+	m_draws.clear();
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for recording a draw of a mesh.  The
+ *  mesh is only read in EndFrame(), so it must stay alive
+ *  and unchanged until then.
+ ***********************************************************/
+void SoftwareRasterizer::DrawMesh(
+	const MeshGenerator::MESH_DATA& mesh,
+	const glm::mat4& model,
+	const DRAW_STATE& state)
+{
+	if (mesh.indices.empty())
+	{
+		return;
+	}
+
+	DRAW draw;
+	draw.pMesh = &mesh;
+	draw.model = model;
+	draw.state = state;
+
+	// the material carries over to the following draws, the
+	// same way the material uniforms do
+	if (state.bHasMaterial == true)
+	{
+		m_currentMaterial = state.material;
+	}
+	draw.state.material = m_currentMaterial;
+
+	m_draws.push_back(draw);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for rendering the recorded draws.
+ *  The draws are set up in parallel, then every row of
+ *  tiles bins the triangles that overlap it, and finally
+ *  the tiles are rasterized in parallel.  Each pass only
+ *  starts once the previous one finished on all threads.
+ ***********************************************************/
+void SoftwareRasterizer::EndFrame()
+{
+	if ((m_width == 0) || (m_height == 0))
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	int drawCount = (int)m_draws.size();
+	if ((int)m_drawOutputs.size() < drawCount)
+	{
+		m_drawOutputs.resize(drawCount);
+	}
+	RunParallel(drawCount, DRAW_GRAIN_SIZE, [this](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			ProcessDraw(i);
+		}
+	});
+	std::chrono::steady_clock::time_point setupEnd = std::chrono::steady_clock::now();
+
+	RunParallel(m_tilesY, TILE_GRAIN_SIZE, [this](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			BinTileRow(i);
+		}
+	});
+	std::chrono::steady_clock::time_point binEnd = std::chrono::steady_clock::now();
+
+	std::fill(m_threadPixels.begin(), m_threadPixels.end(), 0);
+	RunParallel(m_tilesX * m_tilesY, TILE_GRAIN_SIZE, [this](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			RasterizeTile(i);
+		}
+	});
+	std::chrono::steady_clock::time_point rasterEnd = std::chrono::steady_clock::now();
+
+	// gather the counts of the frame
+	m_frameStats.draws = drawCount;
+	m_frameStats.triangles = 0;
+	m_frameStats.binned = 0;
+	m_frameStats.pixels = 0;
+	for (int i = 0; i < drawCount; i++)
+	{
+		m_frameStats.triangles += (int)m_drawOutputs[i].triangles.size();
+	}
+	for (size_t i = 0; i < m_bins.size(); i++)
+	{
+		m_frameStats.binned += (int)m_bins[i].size();
+	}
+	for (size_t i = 0; i < m_threadPixels.size(); i++)
+	{
+		m_frameStats.pixels += m_threadPixels[i];
+	}
+	m_frameStats.setupMs = std::chrono::duration<double, std::milli>(setupEnd - start).count();
+	m_frameStats.binMs = std::chrono::duration<double, std::milli>(binEnd - setupEnd).count();
+	m_frameStats.rasterMs = std::chrono::duration<double, std::milli>(rasterEnd - binEnd).count();
+	m_lastFrameStats = m_frameStats;
+}
+
+/***********************************************************
+ *  ProcessDraw()
+ *
+ *  This method is used for transforming the vertices of a
+ *  draw to clip space and to the world space the lighting
+ *  works in, and then clipping and setting up its
+ *  triangles.  It runs on the job threads and only writes
+ *  the output of its own draw.
+ ***********************************************************/
+void SoftwareRasterizer::ProcessDraw(int drawIndex)
+{
+	const DRAW& draw = m_draws[drawIndex];
+	const MeshGenerator::MESH_DATA& mesh = *draw.pMesh;
+	DRAW_OUTPUT& output = m_drawOutputs[drawIndex];
+
+	glm::mat4 modelViewProjection = m_viewProjection * draw.model;
+	glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(draw.model)));
+
+	int vertexCount = (int)mesh.vertices.size();
+	output.vertices.resize(vertexCount);
+	for (int i = 0; i < vertexCount; i++)
+	{
+		const MeshGenerator::MESH_VERTEX& source = mesh.vertices[i];
+		glm::vec4 position(source.position[0], source.position[1], source.position[2], 1.0f);
+
+		VERTEX& vertex = output.vertices[i];
+		vertex.clip = modelViewProjection * position;
+		vertex.world = glm::vec3(draw.model * position);
+		vertex.normal = normalMatrix * glm::vec3(source.normal[0], source.normal[1], source.normal[2]);
+		vertex.uv = glm::vec2(source.textureCoordinate[0], source.textureCoordinate[1]);
+		vertex.baked = (NULL != draw.state.pBakedLighting) ? draw.state.pBakedLighting[i] : glm::vec3(0.0f);
+	}
+
+	output.clipped.clear();
+	int indexCount = (int)mesh.indices.size();
+	for (int i = 0; i + 2 < indexCount; i += 3)
+	{
+		ClipTriangle(output, (int)mesh.indices[i], (int)mesh.indices[i + 1], (int)mesh.indices[i + 2]);
+	}
+
+	SetupTriangles(output, drawIndex);
+}
+
+/***********************************************************
+ *  ClipTriangle()
+ *
+ *  This method is used for dropping a triangle that is
+ *  completely outside of one frustum plane, and for cutting
+ *  the part behind the near plane off a triangle that
+ *  crosses it, which leaves up to two triangles.  The other
+ *  planes are left to the bounds of the tiles, so only the
+ *  near plane ever creates vertices.
+ ***********************************************************/
+void SoftwareRasterizer::ClipTriangle(DRAW_OUTPUT& output, int i0, int i1, int i2)
+{
+	int code0 = GetOutcode(output.vertices[i0].clip);
+	int code1 = GetOutcode(output.vertices[i1].clip);
+	int code2 = GetOutcode(output.vertices[i2].clip);
+	if ((code0 & code1 & code2) != 0)
+	{
+		return;
+	}
+	if (((code0 | code1 | code2) & OUTSIDE_NEAR) == 0)
+	{
+		output.clipped.push_back(i0);
+		output.clipped.push_back(i1);
+		output.clipped.push_back(i2);
+		return;
+	}
+
+	// walk the edges, keeping the vertices in front of the
+	// near plane and adding one where an edge crosses it
+	int input[3] = { i0, i1, i2 };
+	int polygon[4];
+	int polygonCount = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		VERTEX a = output.vertices[input[i]];
+		VERTEX b = output.vertices[input[(i + 1) % 3]];
+		float distanceA = a.clip.z + a.clip.w;
+		float distanceB = b.clip.z + b.clip.w;
+
+		if (distanceA >= 0.0f)
+		{
+			polygon[polygonCount++] = input[i];
+		}
+		if ((distanceA >= 0.0f) != (distanceB >= 0.0f))
+		{
+			float t = distanceA / (distanceA - distanceB);
+			VERTEX vertex;
+			vertex.clip = glm::mix(a.clip, b.clip, t);
+			vertex.world = glm::mix(a.world, b.world, t);
+			vertex.normal = glm::mix(a.normal, b.normal, t);
+			vertex.uv = glm::mix(a.uv, b.uv, t);
+			vertex.baked = glm::mix(a.baked, b.baked, t);
+			polygon[polygonCount++] = (int)output.vertices.size();
+			output.vertices.push_back(vertex);
+		}
+	}
+
+	for (int i = 1; i + 1 < polygonCount; i++)
+	{
+		output.clipped.push_back(polygon[0]);
+		output.clipped.push_back(polygon[i]);
+		output.clipped.push_back(polygon[i + 1]);
+	}
+}
+
+/***********************************************************
+ *  SetupTriangles()
+ *
+ *  This method is used for setting up the clipped triangles
+ *  of a draw.  The vertices are projected to pixels, then
+ *  the edge functions, the area, the depth plane and the
+ *  bounds are computed for four triangles at a time.
+ *  Triangles without area or outside of the image are
+ *  dropped.
+ ***********************************************************/
+void SoftwareRasterizer::SetupTriangles(DRAW_OUTPUT& output, int drawIndex)
+{
+	// project the vertices, the ones behind the near plane
+	// are no longer used by any triangle
+	int vertexCount = (int)output.vertices.size();
+	output.screen.resize(vertexCount);
+	float halfWidth = 0.5f * (float)m_width;
+	float halfHeight = 0.5f * (float)m_height;
+	for (int i = 0; i < vertexCount; i++)
+	{
+		const glm::vec4& clip = output.vertices[i].clip;
+		float inverseW = (clip.w > 0.0f) ? (1.0f / clip.w) : 0.0f;
+		output.screen[i] = glm::vec4(
+			(clip.x * inverseW + 1.0f) * halfWidth,
+			(1.0f - clip.y * inverseW) * halfHeight,
+			clip.z * inverseW,
+			inverseW);
+	}
+
+	output.triangles.clear();
+	int triangleCount = (int)output.clipped.size() / 3;
+	for (int first = 0; first < triangleCount; first += 4)
+	{
+		int laneCount = std::min(4, triangleCount - first);
+
+		// gather the corners of up to four triangles, the
+		// unused lanes repeat the last triangle
+		float x[3][4];
+		float y[3][4];
+		float z[3][4];
+		for (int lane = 0; lane < 4; lane++)
+		{
+			int triangle = first + std::min(lane, laneCount - 1);
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const glm::vec4& screen = output.screen[output.clipped[(triangle * 3) + corner]];
+				x[corner][lane] = screen.x;
+				y[corner][lane] = screen.y;
+				z[corner][lane] = screen.z;
+			}
+		}
+
+		// edge i is opposite of corner i, E(x, y) = A x + B y + C
+		float edgeA[3][4];
+		float edgeB[3][4];
+		float edgeC[3][4];
+		float area[4];
+		float depthA[4];
+		float depthB[4];
+		float depthC[4];
+		float minX[4];
+		float minY[4];
+		float maxX[4];
+		float maxY[4];
+#ifdef RASTER_SSE2
+		__m128 X[3];
+		__m128 Y[3];
+		__m128 Z[3];
+		for (int corner = 0; corner < 3; corner++)
+		{
+			X[corner] = _mm_loadu_ps(x[corner]);
+			Y[corner] = _mm_loadu_ps(y[corner]);
+			Z[corner] = _mm_loadu_ps(z[corner]);
+		}
+		__m128 A[3];
+		__m128 B[3];
+		__m128 C[3];
+		for (int edge = 0; edge < 3; edge++)
+		{
+			int from = (edge + 1) % 3;
+			int to = (edge + 2) % 3;
+			A[edge] = _mm_sub_ps(Y[from], Y[to]);
+			B[edge] = _mm_sub_ps(X[to], X[from]);
+			C[edge] = _mm_sub_ps(_mm_mul_ps(X[from], Y[to]), _mm_mul_ps(X[to], Y[from]));
+		}
+
+		// twice the signed area, which flips the edges of the
+		// triangles wound the other way so inside is positive
+		__m128 signedArea = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(A[0], X[0]), _mm_mul_ps(B[0], Y[0])), C[0]);
+		__m128 negative = _mm_cmplt_ps(signedArea, _mm_setzero_ps());
+		__m128 signBit = _mm_and_ps(negative, _mm_set1_ps(-0.0f));
+		__m128 absoluteArea = _mm_xor_ps(signedArea, signBit);
+		__m128 inverseArea = _mm_div_ps(_mm_set1_ps(1.0f),
+			_mm_max_ps(absoluteArea, _mm_set1_ps(MIN_TRIANGLE_AREA)));
+
+		// the depth plane from the corner depths
+		__m128 planeA = _mm_setzero_ps();
+		__m128 planeB = _mm_setzero_ps();
+		__m128 planeC = _mm_setzero_ps();
+		for (int edge = 0; edge < 3; edge++)
+		{
+			A[edge] = _mm_xor_ps(A[edge], signBit);
+			B[edge] = _mm_xor_ps(B[edge], signBit);
+			C[edge] = _mm_xor_ps(C[edge], signBit);
+			planeA = _mm_add_ps(planeA, _mm_mul_ps(A[edge], Z[edge]));
+			planeB = _mm_add_ps(planeB, _mm_mul_ps(B[edge], Z[edge]));
+			planeC = _mm_add_ps(planeC, _mm_mul_ps(C[edge], Z[edge]));
+			_mm_storeu_ps(edgeA[edge], A[edge]);
+			_mm_storeu_ps(edgeB[edge], B[edge]);
+			_mm_storeu_ps(edgeC[edge], C[edge]);
+		}
+		_mm_storeu_ps(area, absoluteArea);
+		_mm_storeu_ps(depthA, _mm_mul_ps(planeA, inverseArea));
+		_mm_storeu_ps(depthB, _mm_mul_ps(planeB, inverseArea));
+		_mm_storeu_ps(depthC, _mm_mul_ps(planeC, inverseArea));
+		_mm_storeu_ps(minX, _mm_min_ps(X[0], _mm_min_ps(X[1], X[2])));
+		_mm_storeu_ps(minY, _mm_min_ps(Y[0], _mm_min_ps(Y[1], Y[2])));
+		_mm_storeu_ps(maxX, _mm_max_ps(X[0], _mm_max_ps(X[1], X[2])));
+		_mm_storeu_ps(maxY, _mm_max_ps(Y[0], _mm_max_ps(Y[1], Y[2])));
+#else
+		for (int lane = 0; lane < 4; lane++)
+		{
+			for (int edge = 0; edge < 3; edge++)
+			{
+				int from = (edge + 1) % 3;
+				int to = (edge + 2) % 3;
+				edgeA[edge][lane] = y[from][lane] - y[to][lane];
+				edgeB[edge][lane] = x[to][lane] - x[from][lane];
+				edgeC[edge][lane] = (x[from][lane] * y[to][lane]) - (x[to][lane] * y[from][lane]);
+			}
+			float signedArea = (edgeA[0][lane] * x[0][lane]) + (edgeB[0][lane] * y[0][lane]) + edgeC[0][lane];
+			float sign = (signedArea < 0.0f) ? -1.0f : 1.0f;
+			area[lane] = signedArea * sign;
+			float inverseArea = 1.0f / std::max(area[lane], MIN_TRIANGLE_AREA);
+			depthA[lane] = 0.0f;
+			depthB[lane] = 0.0f;
+			depthC[lane] = 0.0f;
+			for (int edge = 0; edge < 3; edge++)
+			{
+				edgeA[edge][lane] *= sign;
+				edgeB[edge][lane] *= sign;
+				edgeC[edge][lane] *= sign;
+				depthA[lane] += edgeA[edge][lane] * z[edge][lane];
+				depthB[lane] += edgeB[edge][lane] * z[edge][lane];
+				depthC[lane] += edgeC[edge][lane] * z[edge][lane];
+			}
+			depthA[lane] *= inverseArea;
+			depthB[lane] *= inverseArea;
+			depthC[lane] *= inverseArea;
+			minX[lane] = std::min(x[0][lane], std::min(x[1][lane], x[2][lane]));
+			minY[lane] = std::min(y[0][lane], std::min(y[1][lane], y[2][lane]));
+			maxX[lane] = std::max(x[0][lane], std::max(x[1][lane], x[2][lane]));
+			maxY[lane] = std::max(y[0][lane], std::max(y[1][lane], y[2][lane]));
+		}
+#endif
+
+		// keep the triangles that cover any pixel center
+		for (int lane = 0; lane < laneCount; lane++)
+		{
+			if (area[lane] <= MIN_TRIANGLE_AREA)
+			{
+				continue;
+			}
+
+			TRIANGLE triangle;
+			triangle.minX = std::max(0, (int)std::floor(minX[lane]));
+			triangle.minY = std::max(0, (int)std::floor(minY[lane]));
+			triangle.maxX = std::min(m_width - 1, (int)std::ceil(maxX[lane]));
+			triangle.maxY = std::min(m_height - 1, (int)std::ceil(maxY[lane]));
+			if ((triangle.minX > triangle.maxX) || (triangle.minY > triangle.maxY))
+			{
+				continue;
+			}
+
+			int triangleIndex = first + lane;
+			for (int edge = 0; edge < 3; edge++)
+			{
+				triangle.edgeA[edge] = edgeA[edge][lane];
+				triangle.edgeB[edge] = edgeB[edge][lane];
+				triangle.edgeC[edge] = edgeC[edge][lane];
+				// with y pointing down, a left edge has the
+				// inside to its right and a top edge is level
+				// with the inside below it
+				triangle.bTopLeft[edge] = (edgeA[edge][lane] > 0.0f) ||
+					((edgeA[edge][lane] == 0.0f) && (edgeB[edge][lane] > 0.0f));
+				triangle.vertex[edge] = output.clipped[(triangleIndex * 3) + edge];
+				triangle.inverseW[edge] = output.screen[triangle.vertex[edge]].w;
+			}
+			triangle.inverseArea = 1.0f / area[lane];
+			triangle.depthA = depthA[lane];
+			triangle.depthB = depthB[lane];
+			triangle.depthC = depthC[lane];
+			triangle.drawIndex = drawIndex;
+			output.triangles.push_back(triangle);
+		}
+	}
+}
+
+/***********************************************************
+ *  BinTileRow()
+ *
+ *  This method is used for collecting the triangles that
+ *  overlap the tiles of one row.  Every row walks all the
+ *  triangles in draw order, so the bins keep the order the
+ *  draws were sorted in without merging anything.
+ ***********************************************************/
+void SoftwareRasterizer::BinTileRow(int tileY)
+{
+	int rowTop = tileY * TILE_SIZE;
+	int rowBottom = rowTop + TILE_SIZE - 1;
+	for (int tileX = 0; tileX < m_tilesX; tileX++)
+	{
+		m_bins[(tileY * m_tilesX) + tileX].clear();
+	}
+
+	int drawCount = (int)m_draws.size();
+	for (int draw = 0; draw < drawCount; draw++)
+	{
+		const std::vector<TRIANGLE>& triangles = m_drawOutputs[draw].triangles;
+		for (size_t i = 0; i < triangles.size(); i++)
+		{
+			const TRIANGLE& triangle = triangles[i];
+			if ((triangle.maxY < rowTop) || (triangle.minY > rowBottom))
+			{
+				continue;
+			}
+			int firstTile = triangle.minX / TILE_SIZE;
+			int lastTile = triangle.maxX / TILE_SIZE;
+			for (int tileX = firstTile; tileX <= lastTile; tileX++)
+			{
+				if (OverlapsTile(triangle, tileX * TILE_SIZE, rowTop) == true)
+				{
+					m_bins[(tileY * m_tilesX) + tileX].push_back(&triangle);
+				}
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  OverlapsTile()
+ *
+ *  This method is used for checking whether a triangle may
+ *  cover a pixel of a tile.  Long thin triangles overlap the
+ *  bounds of many tiles they never touch, so each edge is
+ *  checked at the pixel center of the tile that is furthest
+ *  inside of it.
+ ***********************************************************/
+bool SoftwareRasterizer::OverlapsTile(const TRIANGLE& triangle, int tileLeft, int tileTop) const
+{
+	for (int edge = 0; edge < 3; edge++)
+	{
+		float x = (float)tileLeft + ((triangle.edgeA[edge] > 0.0f) ? (float)TILE_SIZE - 0.5f : 0.5f);
+		float y = (float)tileTop + ((triangle.edgeB[edge] > 0.0f) ? (float)TILE_SIZE - 0.5f : 0.5f);
+		if ((triangle.edgeA[edge] * x) + ((triangle.edgeB[edge] * y) + triangle.edgeC[edge]) < 0.0f)
+		{
+			return(false);
+		}
+	}
+	return(true);
+}
+
+/***********************************************************
+ *  RasterizeTile()
+ *
+ *  This method is used for drawing the binned triangles of
+ *  one tile into the tile buffer of the calling thread and
+ *  copying the result into the image.  The edge functions
+ *  and the depth test run on four pixels of a row at once.
+ *  Opaque triangles write depth and only note that they are
+ *  visible, so a pixel covered many times is shaded once.
+ *  Blended triangles only test depth, and are shaded right
+ *  away over the resolved opaque pixels.
+ ***********************************************************/
+void SoftwareRasterizer::RasterizeTile(int tileIndex)
+{
+	int threadIndex = (NULL != m_pJobSystem) ? JobSystem::GetThreadIndex() : 0;
+	TILE_BUFFER& buffer = m_tileBuffers[threadIndex];
+
+	int tileLeft = (tileIndex % m_tilesX) * TILE_SIZE;
+	int tileTop = (tileIndex / m_tilesX) * TILE_SIZE;
+	int tileRight = std::min(tileLeft + TILE_SIZE, m_width) - 1;
+	int tileBottom = std::min(tileTop + TILE_SIZE, m_height) - 1;
+
+	std::fill(buffer.color.begin(), buffer.color.end(), m_clearColor);
+	std::fill(buffer.depth.begin(), buffer.depth.end(), 1.0f);
+	std::fill(buffer.visible.begin(), buffer.visible.end(), (const TRIANGLE*)NULL);
+	int tileWidth = tileRight - tileLeft + 1;
+	int tileHeight = tileBottom - tileTop + 1;
+
+	long long pixels = 0;
+	bool bResolved = true;
+	const std::vector<const TRIANGLE*>& bin = m_bins[tileIndex];
+	for (size_t i = 0; i < bin.size(); i++)
+	{
+		const TRIANGLE& triangle = *bin[i];
+		bool bBlend = m_draws[triangle.drawIndex].state.bBlend;
+
+		int minX = std::max(triangle.minX, tileLeft);
+		int maxX = std::min(triangle.maxX, tileRight);
+		int minY = std::max(triangle.minY, tileTop);
+		int maxY = std::min(triangle.maxY, tileBottom);
+		if ((minX > maxX) || (minY > maxY))
+		{
+			continue;
+		}
+		// start the rows on a multiple of four in the tile
+		int startX = tileLeft + ((minX - tileLeft) & ~3);
+
+		// a blended triangle needs the colors under it
+		if ((bBlend == true) && (bResolved == false))
+		{
+			pixels += ResolveTile(buffer, tileLeft, tileTop, tileWidth, tileHeight);
+			bResolved = true;
+		}
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float pixelY = (float)y + 0.5f;
+			float* pDepthRow = &buffer.depth[(y - tileTop) * TILE_SIZE];
+			glm::vec4* pColorRow = &buffer.color[(y - tileTop) * TILE_SIZE];
+			const TRIANGLE** pVisibleRow = &buffer.visible[(y - tileTop) * TILE_SIZE];
+
+			for (int x = startX; x <= maxX; x += 4)
+			{
+				float weights[3][4];
+				float depth[4];
+				int mask = 0;
+#ifdef RASTER_SSE2
+				__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x + 0.5f),
+					_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+				__m128 covered = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int edge = 0; edge < 3; edge++)
+				{
+					float rowValue = (triangle.edgeB[edge] * pixelY) + triangle.edgeC[edge];
+					__m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeA[edge]), pixelX),
+						_mm_set1_ps(rowValue));
+					__m128 inside = triangle.bTopLeft[edge] ?
+						_mm_cmpge_ps(value, _mm_setzero_ps()) :
+						_mm_cmpgt_ps(value, _mm_setzero_ps());
+					covered = _mm_and_ps(covered, inside);
+					_mm_storeu_ps(weights[edge], value);
+				}
+				__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthA), pixelX),
+					_mm_set1_ps((triangle.depthB * pixelY) + triangle.depthC));
+				covered = _mm_and_ps(covered, _mm_cmplt_ps(z, _mm_loadu_ps(pDepthRow + (x - tileLeft))));
+				_mm_storeu_ps(depth, z);
+				mask = _mm_movemask_ps(covered);
+#else
+				for (int lane = 0; lane < 4; lane++)
+				{
+					float pixelX = (float)(x + lane) + 0.5f;
+					bool bCovered = true;
+					for (int edge = 0; edge < 3; edge++)
+					{
+						float value = (triangle.edgeA[edge] * pixelX) +
+							((triangle.edgeB[edge] * pixelY) + triangle.edgeC[edge]);
+						bCovered = bCovered && (triangle.bTopLeft[edge] ? (value >= 0.0f) : (value > 0.0f));
+						weights[edge][lane] = value;
+					}
+					depth[lane] = (triangle.depthA * pixelX) + ((triangle.depthB * pixelY) + triangle.depthC);
+					if (bCovered && (depth[lane] < pDepthRow[x - tileLeft + lane]))
+					{
+						mask |= (1 << lane);
+					}
+				}
+#endif
+				// drop the lanes left of the triangle bounds or
+				// right of the tile
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((x + lane < minX) || (x + lane > maxX))
+					{
+						mask &= ~(1 << lane);
+					}
+				}
+				if (mask == 0)
+				{
+					continue;
+				}
+
+				for (int lane = 0; lane < 4; lane++)
+				{
+					if ((mask & (1 << lane)) == 0)
+					{
+						continue;
+					}
+
+					int column = x - tileLeft + lane;
+					if (bBlend == true)
+					{
+						glm::vec4 color = ShadePixel(triangle,
+							weights[0][lane] * triangle.inverseArea,
+							weights[1][lane] * triangle.inverseArea,
+							weights[2][lane] * triangle.inverseArea);
+						float alpha = color.a;
+						pColorRow[column] = (color * alpha) + (pColorRow[column] * (1.0f - alpha));
+						pixels++;
+					}
+					else
+					{
+						pVisibleRow[column] = &triangle;
+						pDepthRow[column] = depth[lane];
+						bResolved = false;
+					}
+				}
+			}
+		}
+	}
+	if (bResolved == false)
+	{
+		pixels += ResolveTile(buffer, tileLeft, tileTop, tileWidth, tileHeight);
+	}
+
+	// copy the finished tile into the image
+	for (int y = tileTop; y <= tileBottom; y++)
+	{
+		const glm::vec4* pColorRow = &buffer.color[(y - tileTop) * TILE_SIZE];
+		uint32_t* pImageRow = &m_colorBuffer[((size_t)y * m_width) + tileLeft];
+		for (int x = tileLeft; x <= tileRight; x++)
+		{
+			pImageRow[x - tileLeft] = PackColor(pColorRow[x - tileLeft]);
+		}
+	}
+	m_threadPixels[threadIndex] += pixels;
+}
+
+/***********************************************************
+ *  ResolveTile()
+ *
+ *  This method is used for shading the pixels of a tile
+ *  that an opaque triangle is visible in.  The barycentric
+ *  weights are found again from the edge functions at the
+ *  pixel center, and the pixels are marked as shaded.
+ ***********************************************************/
+int SoftwareRasterizer::ResolveTile(TILE_BUFFER& buffer, int tileLeft, int tileTop, int width, int height)
+{
+	int pixels = 0;
+	for (int y = 0; y < height; y++)
+	{
+		float pixelY = (float)(tileTop + y) + 0.5f;
+		const TRIANGLE** pVisibleRow = &buffer.visible[y * TILE_SIZE];
+		glm::vec4* pColorRow = &buffer.color[y * TILE_SIZE];
+		for (int x = 0; x < width; x++)
+		{
+			const TRIANGLE* pTriangle = pVisibleRow[x];
+			if (NULL == pTriangle)
+			{
+				continue;
+			}
+
+			float pixelX = (float)(tileLeft + x) + 0.5f;
+			float weights[3];
+			for (int edge = 0; edge < 3; edge++)
+			{
+				weights[edge] = ((pTriangle->edgeA[edge] * pixelX) +
+					((pTriangle->edgeB[edge] * pixelY) + pTriangle->edgeC[edge])) * pTriangle->inverseArea;
+			}
+			pColorRow[x] = ShadePixel(*pTriangle, weights[0], weights[1], weights[2]);
+			pVisibleRow[x] = NULL;
+			pixels++;
+		}
+	}
+	return(pixels);
+}
+
+/***********************************************************
+ *  ShadePixel()
+ *
+ *  This method is used for shading one pixel from the
+ *  barycentric weights of the triangle's corners.  The
+ *  attributes are interpolated with perspective correction,
+ *  and the color is lit with the same terms as the fragment
+ *  shader:
+ *
+ *    directional - light ambient * material ambient color,
+ *                  plus N.L * light and material diffuse,
+ *                  plus (R.V)^shininess * light and material
+ *                  specular
+ *    point light - light ambient, plus N.L * light and
+ *                  material diffuse, plus (R.V)^focalStrength
+ *                  * specularIntensity * light and material
+ *                  specular
+ *
+ *  and the sum is multiplied with the texture or the color.
+ *  A draw with baked lighting takes the ambient and diffuse
+ *  terms from its vertices and only adds the specular ones.
+ ***********************************************************/
+glm::vec4 SoftwareRasterizer::ShadePixel(const TRIANGLE& triangle, float b0, float b1, float b2) const
+{
+	const DRAW& draw = m_draws[triangle.drawIndex];
+	const std::vector<VERTEX>& vertices = m_drawOutputs[triangle.drawIndex].vertices;
+	const VERTEX& v0 = vertices[triangle.vertex[0]];
+	const VERTEX& v1 = vertices[triangle.vertex[1]];
+	const VERTEX& v2 = vertices[triangle.vertex[2]];
+
+	// weigh by 1/w so the attributes follow the perspective
+	float w0 = b0 * triangle.inverseW[0];
+	float w1 = b1 * triangle.inverseW[1];
+	float w2 = b2 * triangle.inverseW[2];
+	float inverseSum = 1.0f / (w0 + w1 + w2);
+	w0 *= inverseSum;
+	w1 *= inverseSum;
+	w2 *= inverseSum;
+
+	glm::vec3 position = (v0.world * w0) + (v1.world * w1) + (v2.world * w2);
+	glm::vec3 normal = glm::normalize((v0.normal * w0) + (v1.normal * w1) + (v2.normal * w2));
+	glm::vec2 uv = (v0.uv * w0) + (v1.uv * w1) + (v2.uv * w2);
+
+	const DRAW_STATE& state = draw.state;
+	glm::vec4 objectColor = state.color;
+	if (state.bUseTexture == true)
+	{
+		// an empty slot reads as black, like an unbound texture
+		objectColor = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		if ((state.textureSlot >= 0) && (state.textureSlot < MAX_TEXTURES) &&
+			(m_pTextures[state.textureSlot].width > 0))
+		{
+			objectColor = SampleTexture(m_pTextures[state.textureSlot], uv * state.UVscale);
+		}
+	}
+
+	const MATERIAL& material = state.material;
+	glm::vec3 viewDirection = glm::normalize(m_viewPosition - position);
+	glm::vec3 phong(0.0f);
+	bool bBaked = (NULL != state.pBakedLighting);
+	if (bBaked == true)
+	{
+		phong = (v0.baked * w0) + (v1.baked * w1) + (v2.baked * w2);
+	}
+
+	glm::vec3 lightDirection = glm::normalize(-m_directionalLight.direction);
+	float impact = std::max(glm::dot(normal, lightDirection), 0.0f);
+	glm::vec3 reflectDirection = glm::reflect(-lightDirection, normal);
+	float facing = glm::dot(viewDirection, reflectDirection);
+	float specular = 0.0f;
+	if (bBaked == false)
+	{
+		phong += m_directionalLight.ambient * material.ambientColor;
+		phong += m_directionalLight.diffuse * impact * material.diffuseColor;
+	}
+	if (facing > 0.0f)
+	{
+		specular = std::pow(facing, material.shininess);
+		phong += m_directionalLight.specular * specular * material.specularColor;
+	}
+
+	// black point lights add nothing
+	for (int i = 0; i < m_activeLightCount; i++)
+	{
+		const POINT_LIGHT& light = m_pointLights[m_activeLights[i]];
+		lightDirection = glm::normalize(light.position - position);
+		if (bBaked == false)
+		{
+			impact = std::max(glm::dot(normal, lightDirection), 0.0f);
+			phong += light.ambientColor;
+			phong += impact * light.diffuseColor * material.diffuseColor;
+		}
+
+		reflectDirection = glm::reflect(-lightDirection, normal);
+		float facing = glm::dot(viewDirection, reflectDirection);
+		if (facing > 0.0f)
+		{
+			specular = std::pow(facing, light.focalStrength);
+			phong += light.specularIntensity * specular * light.specularColor * material.specularColor;
+		}
+	}
+
+	return(glm::vec4(phong * glm::vec3(objectColor), objectColor.a));
+}
+
+/***********************************************************
+ *  SampleTexture()
+ *
+ *  This method is used for reading a texture with bilinear
+ *  filtering and repeating coordinates, the same as the
+ *  sampler settings of the OpenGL textures.
+ ***********************************************************/
+glm::vec4 SoftwareRasterizer::SampleTexture(const TEXTURE& texture, glm::vec2 uv) const
+{
+	float u = (uv.x * (float)texture.width) - 0.5f;
+	float v = (uv.y * (float)texture.height) - 0.5f;
+	float left = std::floor(u);
+	float bottom = std::floor(v);
+	float fractionU = u - left;
+	float fractionV = v - bottom;
+
+	int x0 = WrapCoordinate((int)left, texture.width);
+	int y0 = WrapCoordinate((int)bottom, texture.height);
+	int x1 = (x0 + 1 < texture.width) ? x0 + 1 : 0;
+	int y1 = (y0 + 1 < texture.height) ? y0 + 1 : 0;
+
+	const uint32_t* pRow0 = &texture.texels[(size_t)y0 * texture.width];
+	const uint32_t* pRow1 = &texture.texels[(size_t)y1 * texture.width];
+	glm::vec4 bottomColor = glm::mix(UnpackColor(pRow0[x0]), UnpackColor(pRow0[x1]), fractionU);
+	glm::vec4 topColor = glm::mix(UnpackColor(pRow1[x0]), UnpackColor(pRow1[x1]), fractionU);
+	return(glm::mix(bottomColor, topColor, fractionV));
+}
+
+/***********************************************************
+ *  RunParallel()
+ *
+ *  This method is used for running the body over a range on
+ *  the job system, or on the calling thread without one.
+ ***********************************************************/
+void SoftwareRasterizer::RunParallel(int count, int grainSize, const JobSystem::RANGE_FUNCTION& body)
+{
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(count, grainSize, body);
+	}
+	else if (count > 0)
+	{
+		body(0, count);
+	}
+}
+
+/***********************************************************
+ *  GetColorBuffer()
+ *
+ *  This method is used for getting the image of the last
+ *  frame, RGBA with the top row first.
+ ***********************************************************/
+const uint32_t* SoftwareRasterizer::GetColorBuffer() const
+{
+	return(m_colorBuffer.empty() ? NULL : &m_colorBuffer[0]);
+}
+
+/***********************************************************
+ *  GetWidth()
+ *
+ *  This method is used for getting the width of the image.
+ ***********************************************************/
+int SoftwareRasterizer::GetWidth() const
+{
+	return(m_width);
+}
+
+/***********************************************************
+ *  GetHeight()
+ *
+ *  This method is used for getting the height of the image.
+ ***********************************************************/
+int SoftwareRasterizer::GetHeight() const
+{
+	return(m_height);
+}
+
+/***********************************************************
+ *  WriteImage()
+ *
+ *  This method is used for writing the image of the last
+ *  frame as a binary PPM file.
+ ***********************************************************/
+bool SoftwareRasterizer::WriteImage(const char* filename) const
+{
+	if (m_colorBuffer.empty())
+	{
+		return(false);
+	}
+
+	FILE* pFile = fopen(filename, "wb");
+	if (NULL == pFile)
+	{
+		std::cout << "Could not write image:" << filename << std::endl;
+		return(false);
+	}
+
+	fprintf(pFile, "P6\n%d %d\n255\n", m_width, m_height);
+	std::vector<unsigned char> row((size_t)m_width * 3);
+	bool bWritten = true;
+	for (int y = 0; (y < m_height) && (bWritten == true); y++)
+	{
+		for (int x = 0; x < m_width; x++)
+		{
+			uint32_t pixel = m_colorBuffer[((size_t)y * m_width) + x];
+			row[(x * 3)] = (unsigned char)(pixel & 0xff);
+			row[(x * 3) + 1] = (unsigned char)((pixel >> 8) & 0xff);
+			row[(x * 3) + 2] = (unsigned char)((pixel >> 16) & 0xff);
+		}
+		bWritten = (fwrite(&row[0], 1, row.size(), pFile) == row.size());
+	}
+	fclose(pFile);
+	return(bWritten);
+}
+
+/***********************************************************
+ *  PrintFrameStats()
+ *
+ *  This method is used for printing the counts and the
+ *  times of the passes of the last frame.
+ ***********************************************************/
+void SoftwareRasterizer::PrintFrameStats() const
+{
+	std::cout << "Software rasterizer: " << m_width << "x" << m_height << ", "
+		<< m_lastFrameStats.draws << " draws, " << m_lastFrameStats.triangles
+		<< " triangles, " << m_lastFrameStats.binned << " binned, "
+		<< m_lastFrameStats.pixels << " pixels shaded, setup "
+		<< m_lastFrameStats.setupMs << " ms, binning " << m_lastFrameStats.binMs
+		<< " ms, raster " << m_lastFrameStats.rasterMs << " ms" << std::endl;
+}
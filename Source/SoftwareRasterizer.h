@@ -0,0 +1,300 @@
+///////////////////////////////////////////////////////////////////////////////
+// softwarerasterizer.h
+// ============
+// render the shape meshes on the CPU with a binned tile rasterizer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+#include "MeshGenerator.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SoftwareRasterizer
+ *
+ *  This class draws the shape meshes without a GPU.  The
+ *  draws of a frame are only recorded until EndFrame(),
+ *  which renders them in three passes on the job system:
+ *
+ *    1. every draw transforms its vertices, clips its
+ *       triangles against the near plane and sets them up
+ *       four at a time with SIMD edge functions
+ *    2. every row of tiles collects the triangles that
+ *       overlap its tiles, in draw order
+ *    3. every tile rasterizes its triangles into a color
+ *       and depth buffer of its own, so the tiles run on all
+ *       cores without sharing any pixels.  The opaque
+ *       triangles only note which one is visible in each
+ *       pixel, and every pixel is shaded once at the end,
+ *       or before the first blended triangle over it
+ *
+ *  The shading follows the lights and materials the scene
+ *  passes to the shaders - one directional light, up to four
+ *  point lights and per-pixel Phong terms - and the draws
+ *  are blended and depth tested like the OpenGL path.  A
+ *  draw with baked lighting only adds the specular terms to
+ *  the interpolated colors of its vertices.  The image is
+ *  kept with its top row first.
+ ***********************************************************/
+class SoftwareRasterizer
+{
+public:
+	// pixels along each side of a tile
+	static const int TILE_SIZE = 64;
+	// number of texture slots, the same as the OpenGL path
+	static const int MAX_TEXTURES = 16;
+	// number of point lights the shading supports
+	static const int MAX_POINT_LIGHTS = 4;
+
+	// surface response of a draw, like the material uniforms
+	struct MATERIAL
+	{
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+	};
+
+	// one point light, like the lightSources[] uniforms
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+	};
+
+	// the directional light, like the dirLight uniforms
+	struct DIRECTIONAL_LIGHT
+	{
+		glm::vec3 direction;
+		glm::vec3 ambient;
+		glm::vec3 diffuse;
+		glm::vec3 specular;
+	};
+
+	// recorded state of one draw
+	struct DRAW_STATE
+	{
+		// sample the texture slot instead of the color
+		bool bUseTexture;
+		int textureSlot;
+		glm::vec4 color;
+		glm::vec2 UVscale;
+		// blend over the image without writing depth
+		bool bBlend;
+		// a draw without a material keeps the previous one,
+		// like the material uniforms
+		bool bHasMaterial;
+		MATERIAL material;
+		// ambient and diffuse lighting baked for every vertex
+		// of the mesh, NULL to compute it per pixel
+		const glm::vec3* pBakedLighting;
+	};
+
+	// constructor, without a job system everything runs on
+	// the calling thread
+	SoftwareRasterizer(JobSystem* pJobSystem);
+	// destructor
+	~SoftwareRasterizer();
+
+private:
+	// decoded texture with its bottom row first, like the
+	// images uploaded to OpenGL
+	struct TEXTURE
+	{
+		int width;
+		int height;
+		std::vector<uint32_t> texels;
+	};
+
+	// one recorded draw
+	struct DRAW
+	{
+		const MeshGenerator::MESH_DATA* pMesh;
+		glm::mat4 model;
+		DRAW_STATE state;
+	};
+
+	// one transformed vertex
+	struct VERTEX
+	{
+		glm::vec4 clip;
+		glm::vec3 world;
+		glm::vec3 normal;
+		glm::vec2 uv;
+		glm::vec3 baked;
+	};
+
+	// one set up triangle - the edge functions are positive
+	// inside, and times the inverse area they give the
+	// barycentric weight of the opposite vertex.  They are
+	// not normalized, so two triangles sharing an edge get
+	// exactly opposite values along it and never both or
+	// neither cover a pixel there.
+	struct TRIANGLE
+	{
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float inverseArea;
+		// edges that own the pixels exactly on them
+		bool bTopLeft[3];
+		// depth as a plane over the screen
+		float depthA;
+		float depthB;
+		float depthC;
+		// 1/w of the vertices, for perspective correction
+		float inverseW[3];
+		// covered pixels, inclusive
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+		// vertices in the vertex list of the draw
+		int vertex[3];
+		int drawIndex;
+	};
+
+	// vertices and triangles produced by one draw
+	struct DRAW_OUTPUT
+	{
+		std::vector<VERTEX> vertices;
+		// pixel position, depth and 1/w of every vertex
+		std::vector<glm::vec4> screen;
+		// triangles waiting for setup, 3 vertices each
+		std::vector<int> clipped;
+		std::vector<TRIANGLE> triangles;
+	};
+
+	// color and depth of the tile a thread is working on, and
+	// the opaque triangle visible in each pixel that was not
+	// shaded yet
+	struct TILE_BUFFER
+	{
+		std::vector<glm::vec4> color;
+		std::vector<float> depth;
+		std::vector<const TRIANGLE*> visible;
+	};
+
+	// counts of one frame
+	struct FRAME_STATS
+	{
+		int draws;
+		int triangles;
+		int binned;
+		long long pixels;
+		double setupMs;
+		double binMs;
+		double rasterMs;
+	};
+
+	// runs the passes of a frame in parallel, or NULL
+	JobSystem* m_pJobSystem;
+	// decoded textures of the slots, empty when not loaded
+	TEXTURE m_textures[MAX_TEXTURES];
+	// textures sampled while shading, these or the ones of
+	// the rasterizer the scene is shared with
+	const TEXTURE* m_pTextures;
+	// the lights of the scene
+	DIRECTIONAL_LIGHT m_directionalLight;
+	POINT_LIGHT m_pointLights[MAX_POINT_LIGHTS];
+	// the point lights that are not black, the others are
+	// skipped while shading
+	int m_activeLights[MAX_POINT_LIGHTS];
+	int m_activeLightCount;
+	// material of the last draw that had one
+	MATERIAL m_currentMaterial;
+	// camera of the current frame
+	glm::mat4 m_viewProjection;
+	glm::vec3 m_viewPosition;
+	glm::vec4 m_clearColor;
+	// size of the image and the number of tiles across it
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+	// the finished image, RGBA with the top row first
+	std::vector<uint32_t> m_colorBuffer;
+	// draws recorded for the current frame
+	std::vector<DRAW> m_draws;
+	// output of every draw, kept to reuse the memory
+	std::vector<DRAW_OUTPUT> m_drawOutputs;
+	// triangles overlapping every tile, in draw order
+	std::vector<std::vector<const TRIANGLE*> > m_bins;
+	// tile buffers of every job thread
+	std::vector<TILE_BUFFER> m_tileBuffers;
+	// counts of the current and the last finished frame
+	FRAME_STATS m_frameStats;
+	FRAME_STATS m_lastFrameStats;
+	// pixels shaded by the threads, summed at the end
+	std::vector<long long> m_threadPixels;
+
+	// transform, clip and set up the triangles of a draw
+	void ProcessDraw(int drawIndex);
+	// clip a triangle against the near plane, appending the
+	// resulting triangles for setup
+	void ClipTriangle(DRAW_OUTPUT& output, int i0, int i1, int i2);
+	// set up the clipped triangles of a draw
+	void SetupTriangles(DRAW_OUTPUT& output, int drawIndex);
+	// bin the triangles of one row of tiles
+	void BinTileRow(int tileY);
+	// check whether a triangle may cover pixels of a tile
+	bool OverlapsTile(const TRIANGLE& triangle, int tileLeft, int tileTop) const;
+	// rasterize and shade the triangles of one tile
+	void RasterizeTile(int tileIndex);
+	// shade the pixels of a tile whose visible opaque triangle
+	// is known, returning the number of shaded pixels
+	int ResolveTile(TILE_BUFFER& buffer, int tileLeft, int tileTop, int width, int height);
+	// shade one covered pixel of a triangle
+	glm::vec4 ShadePixel(const TRIANGLE& triangle, float b0, float b1, float b2) const;
+	// sample a texture with bilinear filtering and wrapping
+	glm::vec4 SampleTexture(const TEXTURE& texture, glm::vec2 uv) const;
+	// run the body over [0, count), on the job system if any
+	void RunParallel(int count, int grainSize, const JobSystem::RANGE_FUNCTION& body);
+
+public:
+	// decode an image file into a texture slot
+	bool LoadTexture(int slot, const char* filename, bool& bTransparent);
+	// free the texture of a slot
+	void FreeTexture(int slot);
+	// set the lights used for shading
+	void SetDirectionalLight(const DIRECTIONAL_LIGHT& light);
+	void SetPointLight(int index, const POINT_LIGHT& light);
+	// sample the textures of another rasterizer and copy its
+	// lights, which must outlive this one
+	void ShareScene(const SoftwareRasterizer& source);
+
+	// start a frame of the passed in size from the camera
+	void BeginFrame(
+		int width, int height,
+		const glm::mat4& viewProjection,
+		const glm::vec3& viewPosition,
+		const glm::vec4& clearColor);
+	// record a draw of a mesh, which must stay unchanged until
+	// the end of the frame
+	void DrawMesh(
+		const MeshGenerator::MESH_DATA& mesh,
+		const glm::mat4& model,
+		const DRAW_STATE& state);
+	// render the recorded draws into the image
+	void EndFrame();
+
+	// get the finished image, RGBA with the top row first
+	const uint32_t* GetColorBuffer() const;
+	int GetWidth() const;
+	int GetHeight() const;
+	// write the finished image as a binary PPM file
+	bool WriteImage(const char* filename) const;
+	// print the counts and times of the last frame
+	void PrintFrameStats() const;
+};
@@ -0,0 +1,318 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticscene.h
+// ============
+// compile-time tables of the desk scene for fixed installations
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "SceneFile.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  StaticScene
+ *
+ *  The desk scene declared as constant data.  The objects
+ *  reference their texture, material and node by tag, and
+ *  the tags are resolved to table indices while compiling,
+ *  so an unknown tag is a compile error and the program
+ *  never compares a string to build the scene.  The tables
+ *  are only used when USE_STATIC_SCENE is defined, and they
+ *  must be kept in step with Scenes/desk.scene.
+ ***********************************************************/
+namespace StaticScene
+{
+	// texture image file and the tag it is referenced by
+	struct STATIC_TEXTURE
+	{
+		const char* tag;
+		const char* path;
+	};
+
+	// object material and the tag it is referenced by
+	struct STATIC_MATERIAL
+	{
+		float ambientColor[3];
+		float ambientStrength;
+		float diffuseColor[3];
+		float specularColor[3];
+		float shininess;
+		const char* tag;
+	};
+
+	// transform node, parents come before their children
+	struct STATIC_NODE
+	{
+		const char* tag;
+		int32_t parent;
+		float position[3];
+	};
+
+	// index used when an object has no texture, material or node
+	constexpr int32_t NO_TEXTURE = -1;
+	constexpr int32_t NO_MATERIAL = -1;
+	constexpr int32_t NO_NODE = -1;
+
+	// not constexpr on purpose - a tag lookup that ends up
+	// here stops the compile at the offending tag, which the
+	// compiler shows in the failed call
+	inline int32_t UnknownSceneTag(const char* /* tag */)
+	{
+		return(-1);
+	}
+
+	/***********************************************************
+	 *  TagsEqual()
+	 *
+	 *  Compare two tags while compiling.
+	 ***********************************************************/
+	constexpr bool TagsEqual(const char* first, const char* second)
+	{
+		while ((*first != '\0') && (*first == *second))
+		{
+			first++;
+			second++;
+		}
+		return(*first == *second);
+	}
+
+	/***********************************************************
+	 *  FindTag()
+	 *
+	 *  Get the index of the entry in a table with the passed
+	 *  in tag while compiling.
+	 ***********************************************************/
+	template <typename ENTRY, size_t COUNT>
+	constexpr int32_t FindTag(const ENTRY(&table)[COUNT], const char* tag)
+	{
+		for (size_t i = 0; i < COUNT; i++)
+		{
+			if (TagsEqual(table[i].tag, tag))
+			{
+				return((int32_t)i);
+			}
+		}
+		return(UnknownSceneTag(tag));
+	}
+
+	constexpr STATIC_TEXTURE TEXTURES[] =
+	{
+		{ "floor", "textures/floor.png" },
+		{ "metal", "textures/metal.jpg" },
+		{ "wood", "textures/wood.jpg" },
+		{ "wall", "textures/wall.jpg" },
+		{ "notepad", "textures/notepad.png" },
+		{ "cover", "textures/cover.jpg" },
+		{ "cover2", "textures/cover2.jpg" },
+		{ "notebookspine", "textures/notebookspine.png" },
+		{ "pages", "textures/pages.png" },
+		{ "plastic", "textures/plastic.png" },
+		{ "pencil", "textures/pencil.png" },
+		{ "pencil2", "textures/pencil2.png" },
+		{ "penciltop", "textures/penciltop.png" },
+		{ "penciltop2", "textures/penciltop2.png" },
+		{ "clay", "textures/clay.jpg" },
+		{ "claytop", "textures/claytop.png" }
+	};
+
+	constexpr STATIC_MATERIAL MATERIALS[] =
+	{
+		{ { 0.2f, 0.2f, 0.2f }, 0.3f, { 0.2f, 0.2f, 0.2f }, { 0.5f, 0.5f, 0.5f }, 35.0f, "metal" },
+		{ { 0.1f, 0.1f, 0.1f }, 0.2f, { 0.3f, 0.3f, 0.3f }, { 0.1f, 0.1f, 0.1f }, 100.0f, "wood" },
+		{ { 0.4f, 0.4f, 0.4f }, 0.3f, { 0.3f, 0.3f, 0.3f }, { 0.6f, 0.6f, 0.6f }, 85.0f, "glass" },
+		{ { 0.1f, 0.1f, 0.1f }, 0.2f, { 0.5f, 0.5f, 0.5f }, { 0.1f, 0.1f, 0.1f }, 0.3f, "cover" },
+		{ { 0.2f, 0.2f, 0.2f }, 0.3f, { 0.5f, 0.5f, 0.5f }, { 0.3f, 0.3f, 0.3f }, 0.5f, "bread" },
+		{ { 0.2f, 0.2f, 0.2f }, 0.2f, { 0.1f, 0.1f, 0.1f }, { 0.0f, 0.0f, 0.0f }, 0.0f, "darkbread" },
+		{ { 0.1f, 0.1f, 0.1f }, 0.6f, { 0.2f, 0.2f, 0.2f }, { 0.95f, 0.85f, 0.8f }, 2.0f, "backdrop" },
+		{ { 0.1f, 0.1f, 0.1f }, 0.1f, { 0.2f, 0.2f, 0.2f }, { 0.95f, 0.85f, 0.8f }, 0.5f, "grape" },
+		{ { 0.1f, 0.1f, 0.1f }, 0.2f, { 0.95f, 0.85f, 0.8f }, { 0.95f, 0.85f, 0.8f }, 0.3f, "plastic" }
+	};
+
+	constexpr SceneFile::LIGHT_RECORD LIGHTS[] =
+	{
+		{ SceneFile::LIGHT_POINT, { -2.5f, 4.5f, 6.5f }, { 0.2f, 0.15f, 0.1f }, { 0.7f, 0.5f, 0.3f }, { 0.25f, 0.2f, 0.1f }, 1.0f, 0.5f },
+		{ SceneFile::LIGHT_POINT, { -0.21f, 3.29f, 0.6f }, { 0.25f, 0.2f, 0.15f }, { 0.85f, 0.7f, 0.5f }, { 0.8f, 0.7f, 0.6f }, 1.0f, 0.8f },
+		{ SceneFile::LIGHT_DIRECTIONAL, { 1.0f, -1.0f, 0.0f }, { 0.2f, 0.2f, 0.2f }, { 0.7f, 0.7f, 0.7f }, { 1.0f, 1.0f, 1.0f }, 0.0f, 0.0f }
+	};
+
+	constexpr int32_t TextureIndex(const char* tag) { return(FindTag(TEXTURES, tag)); }
+	constexpr int32_t MaterialIndex(const char* tag) { return(FindTag(MATERIALS, tag)); }
+
+	// the lamp and the pencil holder are assemblies whose
+	// parts are placed relative to one node
+	constexpr STATIC_NODE NODES[] =
+	{
+		{ "lamp", NO_NODE, { 0.0f, 0.25f, 0.0f } },
+		{ "pencilholder", NO_NODE, { 1.3f, 0.0f, 1.0f } }
+	};
+
+	constexpr int32_t NodeIndex(const char* tag) { return(FindTag(NODES, tag)); }
+
+	constexpr SceneFile::OBJECT_RECORD OBJECTS[] =
+	{
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 9.0f, 0.5f, 4.91f }, { 0.0f, 0.0f, 0.0f }, { -2.0f, 0.0f, -0.5f },
+			TextureIndex("wood"), { 1.0f, 1.0f, 1.0f, 1.0f }, { 3.0f, 1.5f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { -6.3f, -2.0f, -2.8f },
+			NO_TEXTURE, { 0.4f, 0.2f, 0.1f, 1.0f }, { 3.0f, 1.5f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { 2.3f, -2.0f, -2.8f },
+			NO_TEXTURE, { 0.4f, 0.2f, 0.1f, 1.0f }, { 3.0f, 1.5f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { -6.3f, -2.0f, 1.8f },
+			NO_TEXTURE, { 0.4f, 0.2f, 0.1f, 1.0f }, { 3.0f, 1.5f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 0.3f, 4.0f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { 2.3f, -2.0f, 1.8f },
+			NO_TEXTURE, { 0.4f, 0.2f, 0.1f, 1.0f }, { 3.0f, 1.5f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_PLANE, NO_NODE,
+			{ 20.0f, 1.0f, 10.0f }, { 90.0f, 0.0f, 0.0f }, { 0.0f, 2.0f, -3.0f },
+			TextureIndex("wall"), { 0.6f, 0.6f, 0.6f, 1.0f }, { 3.0f, 3.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_PLANE, NO_NODE,
+			{ 20.0f, 1.0f, 10.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, -4.0f, 4.0f },
+			TextureIndex("floor"), { 0.6f, 0.6f, 0.6f, 1.0f }, { 3.0f, 3.0f }, MaterialIndex("grape") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 3.0f, 3.5f, 0.05f }, { -7.0f, 180.0f, 0.0f }, { -1.9f, 1.9f, -2.75f },
+			TextureIndex("notepad"), { 0.6f, 0.6f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("backdrop") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.4f, 0.05f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.161f, 0.0f },
+			TextureIndex("claytop"), { 0.8f, 0.6f, 0.5f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.41f, 1.21f, 0.31f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f },
+			TextureIndex("clay"), { 0.8f, 0.6f, 0.5f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("lamp"),
+			{ 1.0f, 0.4f, 0.7f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f },
+			TextureIndex("plastic"), { 0.8f, 0.6f, 0.5f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("lamp"),
+			{ 0.1f, 4.0f, 0.1f }, { 0.0f, 0.0f, 0.0f }, { 0.6f, 0.1f, 0.0f },
+			TextureIndex("metal"), { 0.8f, 0.6f, 0.5f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("metal") },
+		{ SceneManager::MESH_CONE, NodeIndex("lamp"),
+			{ 0.6f, 1.0f, 0.6f }, { -45.0f, 0.0f, -20.0f }, { -0.2f, 3.4f, 0.6f },
+			TextureIndex("plastic"), { 0.95f, 0.85f, 0.8f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("lamp"),
+			{ 0.16f, 0.7f, 0.16f }, { 0.0f, 0.0f, 90.0f }, { 0.9f, 4.0f, 0.0f },
+			TextureIndex("plastic"), { 0.95f, 0.85f, 0.8f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("lamp"),
+			{ 0.2f, 0.8f, 0.2f }, { -45.0f, 0.0f, -20.0f }, { 0.0f, 3.7f, 0.3f },
+			TextureIndex("plastic"), { 0.95f, 0.85f, 0.8f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 2.0f, 0.15f, 1.5f }, { 0.0f, 0.0f, 0.0f }, { -4.0f, 0.329f, -1.5f },
+			TextureIndex("cover2"), { 0.95f, 0.85f, 0.8f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.98f, 0.12f, 1.501f }, { 0.0f, 0.0f, 0.0f }, { -3.985f, 0.329f, -1.5f },
+			TextureIndex("pages"), { 0.95f, 0.85f, 0.8f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 2.0f, 0.25f, 1.5f }, { 0.0f, 0.0f, 0.0f }, { -3.99f, 0.53f, -1.5f },
+			TextureIndex("cover2"), { 0.95f, 0.85f, 0.8f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.97f, 0.23f, 1.501f }, { 0.0f, 0.0f, 0.0f }, { -3.97f, 0.53f, -1.5f },
+			TextureIndex("pages"), { 0.95f, 0.85f, 0.8f, 1.0f }, { 1.0f, 0.5f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 2.0f, 0.45f, 1.5f }, { 0.0f, 0.0f, 0.0f }, { -4.01f, 0.88f, -1.5f },
+			TextureIndex("cover2"), { 0.6f, 0.2f, 0.2f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.955f, 0.4f, 1.501f }, { 0.0f, 0.0f, 0.0f }, { -3.98f, 0.88f, -1.5f },
+			TextureIndex("pages"), { 0.6f, 0.2f, 0.2f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_CYLINDER, NO_NODE,
+			{ 0.5f, 0.05f, 0.3f }, { 0.0f, 0.0f, 0.0f }, { -3.8f, 1.451f, -1.3f },
+			TextureIndex("claytop"), { 0.8f, 0.6f, 0.5f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NO_NODE,
+			{ 0.51f, 0.6f, 0.31f }, { 0.0f, 0.0f, 0.0f }, { -3.8f, 0.9f, -1.3f },
+			TextureIndex("clay"), { 0.8f, 0.6f, 0.5f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.0f, 0.04f, 1.2f }, { 0.0f, 0.0f, 0.0f }, { -2.1f, 0.2751f, 1.0f },
+			TextureIndex("cover"), { 0.8f, 0.3f, 0.1f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("backdrop") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.0f, 0.04f, 1.2f }, { 0.0f, 0.0f, 0.0f }, { -2.11f, 0.275f, 1.0f },
+			TextureIndex("notebookspine"), { 0.8f, 0.3f, 0.1f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("backdrop") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.0f, 0.039f, 1.201f }, { 0.0f, 0.0f, 0.0f }, { -2.099f, 0.2751f, 1.0f },
+			TextureIndex("pages"), { 0.8f, 0.3f, 0.1f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.1f, 0.07f, 1.3f }, { 0.0f, 0.0f, 0.0f }, { -1.8f, 0.33f, 0.5f },
+			TextureIndex("cover2"), { 0.3f, 0.7f, 0.4f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("backdrop") },
+		{ SceneManager::MESH_BOX, NO_NODE,
+			{ 1.08f, 0.05f, 1.301f }, { 0.0f, 0.0f, 0.0f }, { -1.789f, 0.33f, 0.5f },
+			TextureIndex("pages"), { 0.3f, 0.7f, 0.4f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("wood") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.03f, 1.0f, 0.03f }, { 0.0f, -15.0f, -15.0f }, { 0.23f, 0.9f, 0.0f },
+			TextureIndex("pencil"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.0299f, 1.0001f, 0.0299f }, { 0.0f, -15.0f, -15.0f }, { 0.23f, 0.9f, 0.0f },
+			TextureIndex("penciltop"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.0301f, 1.0f, 0.03f }, { 0.0f, -15.0f, -25.0f }, { 0.1f, 0.9f, 0.1f },
+			TextureIndex("pencil"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.0299f, 1.002f, 0.0299f }, { 0.0f, -15.0f, -25.0f }, { 0.1f, 0.9f, 0.1f },
+			TextureIndex("penciltop"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.03f, 1.0f, 0.03f }, { 0.0f, -15.0f, -15.0f }, { 0.0f, 0.9f, 0.0f },
+			TextureIndex("pencil"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.0299f, 1.001f, 0.0299f }, { 0.0f, -15.0f, -15.0f }, { 0.0f, 0.9f, 0.0f },
+			TextureIndex("penciltop"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.03f, 1.0f, 0.03f }, { 15.0f, 0.0f, -15.0f }, { 0.05f, 0.9f, 0.11f },
+			TextureIndex("pencil2"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.0299f, 1.001f, 0.0299f }, { 15.0f, 0.0f, -15.0f }, { 0.05f, 0.9f, 0.11f },
+			TextureIndex("penciltop2"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.03f, 1.0f, 0.03f }, { 10.0f, -15.0f, -5.0f }, { -0.1f, 0.9f, 0.13f },
+			TextureIndex("pencil2"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") },
+		{ SceneManager::MESH_CYLINDER, NodeIndex("pencilholder"),
+			{ 0.0299f, 1.001f, 0.0299f }, { 10.0f, -15.0f, -5.0f }, { -0.1f, 0.9f, 0.13f },
+			TextureIndex("penciltop2"), { 1.0f, 0.85f, 0.6f, 1.0f }, { 1.0f, 1.0f }, MaterialIndex("cover") }
+	};
+
+	constexpr int TEXTURE_COUNT = sizeof(TEXTURES) / sizeof(TEXTURES[0]);
+	constexpr int MATERIAL_COUNT = sizeof(MATERIALS) / sizeof(MATERIALS[0]);
+	constexpr int LIGHT_COUNT = sizeof(LIGHTS) / sizeof(LIGHTS[0]);
+	constexpr int NODE_COUNT = sizeof(NODES) / sizeof(NODES[0]);
+	constexpr int OBJECT_COUNT = sizeof(OBJECTS) / sizeof(OBJECTS[0]);
+
+	/***********************************************************
+	 *  CountLights()
+	 *
+	 *  Count the lights of one type while compiling.
+	 ***********************************************************/
+	constexpr int CountLights(uint32_t type)
+	{
+		int count = 0;
+		for (int i = 0; i < LIGHT_COUNT; i++)
+		{
+			if (LIGHTS[i].type == type)
+				count++;
+		}
+		return(count);
+	}
+
+	/***********************************************************
+	 *  NodesDepthFirst()
+	 *
+	 *  Check while compiling that every node comes after its
+	 *  parent, which is all a flat table of sibling assemblies
+	 *  needs to be added to the scene graph in order.
+	 ***********************************************************/
+	constexpr bool NodesDepthFirst()
+	{
+		for (int i = 0; i < NODE_COUNT; i++)
+		{
+			if (NODES[i].parent >= i)
+				return(false);
+		}
+		return(true);
+	}
+
+	static_assert(TEXTURE_COUNT <= 16, "the static scene has more textures than texture slots");
+	static_assert(CountLights(SceneFile::LIGHT_POINT) <= SceneFile::MAX_POINT_LIGHTS,
+		"the static scene has more point lights than the shader");
+	static_assert(CountLights(SceneFile::LIGHT_DIRECTIONAL) <= 1,
+		"the static scene has more than one directional light");
+	static_assert(NodesDepthFirst(), "a static scene node comes before its parent");
+}
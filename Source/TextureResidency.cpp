@@ -0,0 +1,562 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.cpp
+// ============
+// keep the scene textures within a memory budget with LRU eviction
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureResidency.h"
+#include "MemoryTracker.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// top levels a texture may lose before it is evicted
+	const int MAX_DROPPED_LEVELS = 3;
+	// textures are not reduced below this size
+	const int MIN_REDUCED_SIZE = 64;
+	// bytes per texel that drivers allocate for RGB8 and RGBA8
+	const size_t TEXEL_BYTES = 4;
+
+	const double BYTES_PER_MB = 1024.0 * 1024.0;
+
+	/***********************************************************
+	 *  SetTextureParameters()
+	 *
+	 *  This function is used for setting the wrapping and
+	 *  filtering of the bound texture.
+	 ***********************************************************/
+	void SetTextureParameters()
+	{
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+}
+
+/***********************************************************
+ *  TextureResidency()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureResidency::TextureResidency(GLStateCache* pStateCache, size_t budgetBytes)
+{
+	m_pStateCache = pStateCache;
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		m_textures[i].ID = 0;
+		m_textures[i].format = GL_RGBA;
+		m_textures[i].width = 0;
+		m_textures[i].height = 0;
+		m_textures[i].droppedLevels = 0;
+		m_textures[i].residentBytes = 0;
+		m_textures[i].lastUseFrame = 0;
+	}
+	m_budgetBytes = budgetBytes;
+	m_residentBytes = 0;
+	m_frame = 0;
+	m_frameStats.evicted = 0;
+	m_frameStats.reduced = 0;
+	m_frameStats.streamed = 0;
+	m_lastFrameStats = m_frameStats;
+	m_bBudgetWarned = false;
+}
+
+/***********************************************************
+ *  ~TextureResidency()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureResidency::~TextureResidency()
+{
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		Free(i);
+	}
+	m_pStateCache = NULL;
+}
+
+/***********************************************************
+ *  GetTextureBytes()
+ *
+ *  This method is used for estimating the video memory of a
+ *  texture with a full mip chain.
+ ***********************************************************/
+size_t TextureResidency::GetTextureBytes(int width, int height)
+{
+	size_t bytes = 0;
+	while (true)
+	{
+		bytes += (size_t)width * height * TEXEL_BYTES;
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	return(bytes);
+}
+
+/***********************************************************
+ *  Upload()
+ *
+ *  This method is used for decoding an image file into a
+ *  slot at its full resolution, replacing the texture the
+ *  slot held before.  The transparency of the image is only
+ *  checked when it is asked for.
+ ***********************************************************/
+bool TextureResidency::Upload(int slot, const std::string& filename, bool* pbTransparent)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	// indicate to always flip images vertically when loaded
+	stbi_set_flip_vertically_on_load(true);
+
+	unsigned char* image = stbi_load(filename.c_str(), &width, &height, &colorChannels, 0);
+	if (NULL == image)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return(false);
+	}
+	if ((colorChannels != 3) && (colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		stbi_image_free(image);
+		return(false);
+	}
+	// the decoded image only lives until it is uploaded, so it
+	// only shows in the peak CPU memory
+	MemoryTracker::Track(this, MAX_TEXTURES + slot, MemoryTracker::MEMORY_IMAGE_DATA,
+		filename, (size_t)width * height * colorChannels);
+
+	GLenum format = (colorChannels == 4) ? GL_RGBA : GL_RGB;
+	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	m_pStateCache->BindTexture(slot, textureID);
+	SetTextureParameters();
+	glTexImage2D(GL_TEXTURE_2D, 0, (colorChannels == 4) ? GL_RGBA8 : GL_RGB8,
+		width, height, 0, format, GL_UNSIGNED_BYTE, image);
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	// an RGBA image only needs blending if some pixel is not
+	// fully opaque - most PNG files carry an unused alpha channel
+	if (NULL != pbTransparent)
+	{
+		*pbTransparent = false;
+		int pixelCount = width * height;
+		for (int i = 0; (colorChannels == 4) && (i < pixelCount); i++)
+		{
+			if (image[(i * 4) + 3] < 255)
+			{
+				*pbTransparent = true;
+				break;
+			}
+		}
+	}
+	stbi_image_free(image);
+	MemoryTracker::Release(this, MAX_TEXTURES + slot);
+
+	// the new texture is bound to the unit already, so the old
+	// one can go without leaving a stale binding behind
+	TEXTURE_STATE& texture = m_textures[slot];
+	if (texture.ID != 0)
+	{
+		glDeleteTextures(1, &texture.ID);
+	}
+	m_residentBytes -= texture.residentBytes;
+
+	texture.filename = filename;
+	texture.ID = textureID;
+	texture.format = format;
+	texture.width = width;
+	texture.height = height;
+	texture.droppedLevels = 0;
+	texture.residentBytes = GetTextureBytes(width, height);
+	texture.lastUseFrame = m_frame;
+	m_residentBytes += texture.residentBytes;
+	MemoryTracker::Track(this, slot, MemoryTracker::MEMORY_TEXTURE, filename, texture.residentBytes);
+
+	return(true);
+}
+
+/***********************************************************
+ *  DropTopLevel()
+ *
+ *  This method is used for halving the resolution of a
+ *  texture.  The levels below the top one are read back and
+ *  uploaded into a new texture one level higher, which
+ *  frees three quarters of its memory without decoding the
+ *  image again.
+ ***********************************************************/
+bool TextureResidency::DropTopLevel(int slot)
+{
+	TEXTURE_STATE& texture = m_textures[slot];
+	int width = std::max(1, texture.width >> texture.droppedLevels);
+	int height = std::max(1, texture.height >> texture.droppedLevels);
+	if ((texture.ID == 0) || (texture.droppedLevels >= MAX_DROPPED_LEVELS) ||
+		((width <= MIN_REDUCED_SIZE) && (height <= MIN_REDUCED_SIZE)))
+	{
+		return(false);
+	}
+
+	const int channels = (texture.format == GL_RGBA) ? 4 : 3;
+	const GLint internalFormat = (texture.format == GL_RGBA) ? GL_RGBA8 : GL_RGB8;
+
+	// read every level below the top one
+	std::vector<std::vector<unsigned char> > levels;
+	m_pStateCache->BindTexture(slot, texture.ID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	int levelWidth = width;
+	int levelHeight = height;
+	while ((levelWidth > 1) || (levelHeight > 1))
+	{
+		levelWidth = std::max(1, levelWidth / 2);
+		levelHeight = std::max(1, levelHeight / 2);
+		levels.push_back(std::vector<unsigned char>((size_t)levelWidth * levelHeight * channels));
+		glGetTexImage(GL_TEXTURE_2D, (GLint)levels.size(), texture.format, GL_UNSIGNED_BYTE, &levels.back()[0]);
+	}
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	GLuint textureID = 0;
+	glGenTextures(1, &textureID);
+	m_pStateCache->BindTexture(slot, textureID);
+	SetTextureParameters();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	levelWidth = width;
+	levelHeight = height;
+	for (size_t level = 0; level < levels.size(); level++)
+	{
+		levelWidth = std::max(1, levelWidth / 2);
+		levelHeight = std::max(1, levelHeight / 2);
+		glTexImage2D(GL_TEXTURE_2D, (GLint)level, internalFormat, levelWidth, levelHeight, 0,
+			texture.format, GL_UNSIGNED_BYTE, &levels[level][0]);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels.size() - 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glDeleteTextures(1, &texture.ID);
+
+	m_residentBytes -= texture.residentBytes;
+	texture.ID = textureID;
+	texture.droppedLevels++;
+	texture.residentBytes = GetTextureBytes(std::max(1, width / 2), std::max(1, height / 2));
+	m_residentBytes += texture.residentBytes;
+	MemoryTracker::Track(this, slot, MemoryTracker::MEMORY_TEXTURE,
+		texture.filename + " at 1/" + std::to_string(1 << texture.droppedLevels), texture.residentBytes);
+	m_frameStats.reduced++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Evict()
+ *
+ *  This method is used for deleting the texture of a slot.
+ *  The slot keeps its image file, so the texture is decoded
+ *  again the next time it is bound.
+ ***********************************************************/
+void TextureResidency::Evict(int slot)
+{
+	TEXTURE_STATE& texture = m_textures[slot];
+	if (texture.ID == 0)
+	{
+		return;
+	}
+
+	// unbind first, a new texture may get the same name
+	m_pStateCache->BindTexture(slot, 0);
+	glDeleteTextures(1, &texture.ID);
+	m_residentBytes -= texture.residentBytes;
+	texture.ID = 0;
+	texture.droppedLevels = 0;
+	texture.residentBytes = 0;
+	MemoryTracker::Release(this, slot);
+	m_frameStats.evicted++;
+}
+
+/***********************************************************
+ *  FindLeastRecentlyUsed()
+ *
+ *  This method is used for finding the resident texture that
+ *  was bound longest ago.  Textures bound in the current
+ *  frame are never picked, since the frame still draws with
+ *  them.  Optionally only textures that can still lose a
+ *  level are considered.
+ ***********************************************************/
+int TextureResidency::FindLeastRecentlyUsed(bool bReducible) const
+{
+	int found = -1;
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		const TEXTURE_STATE& texture = m_textures[i];
+		if ((texture.ID == 0) || (texture.lastUseFrame >= m_frame))
+		{
+			continue;
+		}
+		if (bReducible == true)
+		{
+			int width = std::max(1, texture.width >> texture.droppedLevels);
+			int height = std::max(1, texture.height >> texture.droppedLevels);
+			if ((texture.droppedLevels >= MAX_DROPPED_LEVELS) ||
+				((width <= MIN_REDUCED_SIZE) && (height <= MIN_REDUCED_SIZE)))
+			{
+				continue;
+			}
+		}
+		if ((found < 0) || (texture.lastUseFrame < m_textures[found].lastUseFrame))
+		{
+			found = i;
+		}
+	}
+	return(found);
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for loading an image file into a
+ *  slot, replacing its texture.  On failure the slot keeps
+ *  what it held before.
+ ***********************************************************/
+bool TextureResidency::Load(int slot, const char* filename, bool& bTransparent)
+{
+	if ((slot < 0) || (slot >= MAX_TEXTURES))
+	{
+		return(false);
+	}
+	if (Upload(slot, std::string(filename), &bTransparent) == false)
+	{
+		return(false);
+	}
+
+	const TEXTURE_STATE& texture = m_textures[slot];
+	std::cout << "Successfully loaded image:" << filename << ", width:" << texture.width
+		<< ", height:" << texture.height << ", channels:" << ((texture.format == GL_RGBA) ? 4 : 3) << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  Free()
+ *
+ *  This method is used for deleting the texture of a slot
+ *  and forgetting its image file.
+ ***********************************************************/
+void TextureResidency::Free(int slot)
+{
+	if ((slot < 0) || (slot >= MAX_TEXTURES))
+	{
+		return;
+	}
+
+	TEXTURE_STATE& texture = m_textures[slot];
+	if (texture.ID != 0)
+	{
+		m_pStateCache->BindTexture(slot, 0);
+		glDeleteTextures(1, &texture.ID);
+	}
+	m_residentBytes -= texture.residentBytes;
+	texture.filename.clear();
+	texture.ID = 0;
+	texture.width = 0;
+	texture.height = 0;
+	texture.droppedLevels = 0;
+	texture.residentBytes = 0;
+	MemoryTracker::Release(this, slot);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for binding a slot to its texture
+ *  unit for the next draw.  The slot is marked as used in
+ *  this frame, and an evicted texture is decoded again
+ *  first.
+ ***********************************************************/
+void TextureResidency::Bind(int slot)
+{
+	if ((slot < 0) || (slot >= MAX_TEXTURES) || (m_textures[slot].filename.empty() == true))
+	{
+		return;
+	}
+
+	TEXTURE_STATE& texture = m_textures[slot];
+	texture.lastUseFrame = m_frame;
+	if ((texture.ID == 0) && (Upload(slot, texture.filename, NULL) == true))
+	{
+		m_frameStats.streamed++;
+	}
+	m_pStateCache->BindTexture(slot, texture.ID);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for bringing the resident textures
+ *  back within the budget once the draws of a frame are
+ *  submitted.  The least recently used textures lose their
+ *  top levels first and are evicted when that is not
+ *  enough.  When there is room, one reduced texture that
+ *  was used this frame gets its full resolution back.
+ ***********************************************************/
+void TextureResidency::EndFrame()
+{
+	size_t budgetBytes = GetEffectiveBudget();
+	if (budgetBytes > 0)
+	{
+		while (m_residentBytes > budgetBytes)
+		{
+			int slot = FindLeastRecentlyUsed(true);
+			if ((slot < 0) || (DropTopLevel(slot) == false))
+			{
+				break;
+			}
+		}
+		while (m_residentBytes > budgetBytes)
+		{
+			int slot = FindLeastRecentlyUsed(false);
+			if (slot < 0)
+			{
+				break;
+			}
+			Evict(slot);
+		}
+		if ((m_residentBytes > budgetBytes) && (m_bBudgetWarned == false))
+		{
+			std::cout << "The textures of one frame need " << (m_residentBytes / BYTES_PER_MB)
+				<< " MB, more than the texture budget of " << (budgetBytes / BYTES_PER_MB)
+				<< " MB" << std::endl;
+			m_bBudgetWarned = true;
+		}
+	}
+
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		const TEXTURE_STATE& texture = m_textures[i];
+		if ((texture.ID == 0) || (texture.droppedLevels == 0) || (texture.lastUseFrame != m_frame))
+		{
+			continue;
+		}
+		size_t restoredBytes = m_residentBytes - texture.residentBytes + GetTextureBytes(texture.width, texture.height);
+		if ((budgetBytes == 0) || (restoredBytes <= budgetBytes))
+		{
+			if (Upload(i, texture.filename, NULL) == true)
+			{
+				m_frameStats.streamed++;
+			}
+			break;
+		}
+	}
+
+	m_lastFrameStats = m_frameStats;
+	m_frameStats.evicted = 0;
+	m_frameStats.reduced = 0;
+	m_frameStats.streamed = 0;
+	m_frame++;
+}
+
+/***********************************************************
+ *  SetBudget()
+ *
+ *  This method is used for setting the memory budget of the
+ *  resident textures.  It is enforced at the end of the
+ *  next frame.
+ ***********************************************************/
+void TextureResidency::SetBudget(size_t budgetBytes)
+{
+	m_budgetBytes = budgetBytes;
+	m_bBudgetWarned = false;
+}
+
+/***********************************************************
+ *  GetEffectiveBudget()
+ *
+ *  This method is used for getting the budget the textures
+ *  are held to.  With a GPU budget set on the memory tracker
+ *  the textures may only use what the other GPU allocations
+ *  leave of it.
+ ***********************************************************/
+size_t TextureResidency::GetEffectiveBudget() const
+{
+	size_t gpuBudget = MemoryTracker::GetBudget(MemoryTracker::DOMAIN_GPU);
+	if (gpuBudget == 0)
+	{
+		return(m_budgetBytes);
+	}
+
+	size_t otherBytes = MemoryTracker::GetDomainTotal(MemoryTracker::DOMAIN_GPU) -
+		MemoryTracker::GetCategoryTotal(MemoryTracker::MEMORY_TEXTURE);
+	size_t leftBytes = (gpuBudget > otherBytes) ? (gpuBudget - otherBytes) : 1;
+	if (m_budgetBytes == 0)
+	{
+		return(leftBytes);
+	}
+	return(std::min(m_budgetBytes, leftBytes));
+}
+
+/***********************************************************
+ *  GetTextureID()
+ *
+ *  This method is used for getting the OpenGL texture of a
+ *  slot, which is 0 while the slot is free or evicted.
+ ***********************************************************/
+GLuint TextureResidency::GetTextureID(int slot) const
+{
+	if ((slot < 0) || (slot >= MAX_TEXTURES))
+	{
+		return(0);
+	}
+	return(m_textures[slot].ID);
+}
+
+/***********************************************************
+ *  GetResidentBytes()
+ *
+ *  This method is used for getting the estimated video
+ *  memory of the resident textures.
+ ***********************************************************/
+size_t TextureResidency::GetResidentBytes() const
+{
+	return(m_residentBytes);
+}
+
+/***********************************************************
+ *  PrintFrameStats()
+ *
+ *  This method is used for printing the texture memory and
+ *  what the last frame evicted, reduced and streamed in.
+ ***********************************************************/
+void TextureResidency::PrintFrameStats() const
+{
+	int residentCount = 0;
+	int reducedCount = 0;
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		if (m_textures[i].ID != 0)
+		{
+			residentCount++;
+			if (m_textures[i].droppedLevels > 0)
+				reducedCount++;
+		}
+	}
+
+	std::cout << "Textures: " << residentCount << " resident (" << reducedCount << " reduced), "
+		<< (m_residentBytes / BYTES_PER_MB) << " MB";
+	size_t budgetBytes = GetEffectiveBudget();
+	if (budgetBytes > 0)
+	{
+		std::cout << " / budget " << (budgetBytes / BYTES_PER_MB) << " MB";
+	}
+	std::cout << " | evicted " << m_lastFrameStats.evicted << ", reduced " << m_lastFrameStats.reduced
+		<< ", streamed in " << m_lastFrameStats.streamed << std::endl;
+}
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.h
+// ============
+// keep the scene textures within a memory budget with LRU eviction
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "GLStateCache.h"
+
+#include <cstddef>
+#include <string>
+
+/***********************************************************
+ *  TextureResidency
+ *
+ *  This class owns the OpenGL textures of the scene texture
+ *  slots and keeps their memory within a budget.  Every bind
+ *  records the frame the texture was last used in.  At the
+ *  end of a frame that went over the budget, the textures
+ *  used least recently first lose their top mip levels, so
+ *  they stay drawable at a lower resolution, and are then
+ *  evicted.  An evicted texture is decoded from its image
+ *  file again the next time it is bound, and a reduced one
+ *  gets its full resolution back once the budget allows.
+ ***********************************************************/
+class TextureResidency
+{
+public:
+	// number of texture slots, one per texture unit
+	static const int MAX_TEXTURES = 16;
+
+	// constructor, a budget of 0 never evicts anything
+	TextureResidency(GLStateCache* pStateCache, size_t budgetBytes);
+	// destructor
+	~TextureResidency();
+
+private:
+	// one texture slot
+	struct TEXTURE_STATE
+	{
+		// image file the texture is decoded from, empty when
+		// the slot is free
+		std::string filename;
+		// the OpenGL texture, 0 while evicted
+		GLuint ID;
+		// GL_RGB or GL_RGBA
+		GLenum format;
+		// full size of the image
+		int width;
+		int height;
+		// top mip levels dropped to save memory
+		int droppedLevels;
+		// estimated video memory of the texture
+		size_t residentBytes;
+		// frame the texture was last bound in
+		unsigned int lastUseFrame;
+	};
+
+	// counts of one frame
+	struct FRAME_STATS
+	{
+		int evicted;
+		int reduced;
+		int streamed;
+	};
+
+	// pointer to the OpenGL state cache object
+	GLStateCache* m_pStateCache;
+	// the texture slots
+	TEXTURE_STATE m_textures[MAX_TEXTURES];
+	// the memory budget, and the memory of the resident textures
+	size_t m_budgetBytes;
+	size_t m_residentBytes;
+	// frame counter for the least recently used order
+	unsigned int m_frame;
+	// counts of the current and the last finished frame
+	FRAME_STATS m_frameStats;
+	FRAME_STATS m_lastFrameStats;
+	// the budget warning is only printed once
+	bool m_bBudgetWarned;
+
+	// decode an image file into a slot at its full resolution
+	bool Upload(int slot, const std::string& filename, bool* pbTransparent);
+	// replace a texture by its mip chain without the top level
+	bool DropTopLevel(int slot);
+	// delete the texture of a slot, keeping its file to reload
+	void Evict(int slot);
+	// get the least recently used resident texture not bound
+	// this frame, or -1
+	int FindLeastRecentlyUsed(bool bReducible) const;
+	// get the budget after the GPU budget of the memory tracker
+	size_t GetEffectiveBudget() const;
+	// get the video memory of a texture with a full mip chain
+	static size_t GetTextureBytes(int width, int height);
+
+public:
+	// load an image file into a slot, replacing its texture
+	bool Load(int slot, const char* filename, bool& bTransparent);
+	// free the texture of a slot
+	void Free(int slot);
+	// bind a slot to its texture unit, reloading it if needed
+	void Bind(int slot);
+	// enforce the budget after the draws of a frame
+	void EndFrame();
+	// set the memory budget, 0 never evicts anything
+	void SetBudget(size_t budgetBytes);
+
+	// get the OpenGL texture of a slot, 0 while evicted
+	GLuint GetTextureID(int slot) const;
+	// get the video memory of the resident textures
+	size_t GetResidentBytes() const;
+	// print the residency of the last frame to the console
+	void PrintFrameStats() const;
+};
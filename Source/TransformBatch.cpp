@@ -0,0 +1,259 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.cpp
+// ============
+// compose the world matrices of many objects in SIMD batches
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+
+#include <xmmintrin.h>
+
+// declaration of global variables
+namespace
+{
+	// floats in one composed matrix
+	const int MATRIX_FLOATS = 16;
+}
+
+/***********************************************************
+ *  TransformBatch()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TransformBatch::TransformBatch()
+{
+	m_count = 0;
+	m_firstDirtyBlock = 0;
+	m_lastDirtyBlock = -1;
+}
+
+/***********************************************************
+ *  ~TransformBatch()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TransformBatch::~TransformBatch()
+{
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for changing the number of objects.
+ *  The arrays are padded with identity transforms up to a
+ *  whole block, so the last block can be loaded at once.
+ ***********************************************************/
+void TransformBatch::Resize(int count)
+{
+	if (count < 0)
+		count = 0;
+	if (count == m_count)
+	{
+		return;
+	}
+
+	int oldCount = m_count;
+	int blockCount = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	int paddedCount = blockCount * BLOCK_SIZE;
+
+	m_positionX.resize(paddedCount, 0.0f);
+	m_positionY.resize(paddedCount, 0.0f);
+	m_positionZ.resize(paddedCount, 0.0f);
+	m_rotationX.resize(paddedCount, 0.0f);
+	m_rotationY.resize(paddedCount, 0.0f);
+	m_rotationZ.resize(paddedCount, 0.0f);
+	m_rotationW.resize(paddedCount, 1.0f);
+	m_scaleX.resize(paddedCount, 1.0f);
+	m_scaleY.resize(paddedCount, 1.0f);
+	m_scaleZ.resize(paddedCount, 1.0f);
+	m_dirtyBlocks.resize(blockCount, 0);
+	m_count = count;
+
+	if (m_lastDirtyBlock >= blockCount)
+	{
+		m_lastDirtyBlock = blockCount - 1;
+	}
+	for (int i = oldCount; i < count; i++)
+	{
+		MarkDirty(i);
+	}
+}
+
+/***********************************************************
+ *  GetCount()
+ *
+ *  This method is used for getting the number of objects.
+ ***********************************************************/
+int TransformBatch::GetCount() const
+{
+	return(m_count);
+}
+
+/***********************************************************
+ *  MarkDirty()
+ *
+ *  This method is used for flagging the block holding the
+ *  passed in object for recomposition.
+ ***********************************************************/
+void TransformBatch::MarkDirty(int index)
+{
+	int block = index / BLOCK_SIZE;
+
+	m_dirtyBlocks[block] = 1;
+	if (m_firstDirtyBlock > m_lastDirtyBlock)
+	{
+		m_firstDirtyBlock = block;
+		m_lastDirtyBlock = block;
+	}
+	else if (block < m_firstDirtyBlock)
+	{
+		m_firstDirtyBlock = block;
+	}
+	else if (block > m_lastDirtyBlock)
+	{
+		m_lastDirtyBlock = block;
+	}
+}
+
+/***********************************************************
+ *  SetTransform()
+ *
+ *  This method is used for setting the position, rotation
+ *  and scale of an object.  Objects that are set to the
+ *  values they already have stay clean.
+ ***********************************************************/
+void TransformBatch::SetTransform(
+	int index,
+	const glm::vec3& position,
+	const glm::quat& rotation,
+	const glm::vec3& scale)
+{
+	if ((m_positionX[index] == position.x) && (m_positionY[index] == position.y) &&
+		(m_positionZ[index] == position.z) &&
+		(m_rotationX[index] == rotation.x) && (m_rotationY[index] == rotation.y) &&
+		(m_rotationZ[index] == rotation.z) && (m_rotationW[index] == rotation.w) &&
+		(m_scaleX[index] == scale.x) && (m_scaleY[index] == scale.y) &&
+		(m_scaleZ[index] == scale.z))
+	{
+		return;
+	}
+
+	m_positionX[index] = position.x;
+	m_positionY[index] = position.y;
+	m_positionZ[index] = position.z;
+	m_rotationX[index] = rotation.x;
+	m_rotationY[index] = rotation.y;
+	m_rotationZ[index] = rotation.z;
+	m_rotationW[index] = rotation.w;
+	m_scaleX[index] = scale.x;
+	m_scaleY[index] = scale.y;
+	m_scaleZ[index] = scale.z;
+	MarkDirty(index);
+}
+
+/***********************************************************
+ *  ComposeDirty()
+ *
+ *  This method is used for composing scale, then rotation,
+ *  then translation into the world matrices of the dirty
+ *  objects, one matrix per object in the passed in array.
+ *  Each SSE register holds one matrix element of four
+ *  objects, and four transposes turn the registers into the
+ *  columns of the four matrices.  Matrices of clean objects
+ *  are left untouched.  The stores go through the cache,
+ *  as the matrices are read right after they are composed.
+ ***********************************************************/
+int TransformBatch::ComposeDirty(glm::mat4* pMatrices)
+{
+	if ((NULL == pMatrices) || (m_firstDirtyBlock > m_lastDirtyBlock))
+	{
+		return(0);
+	}
+
+	float* pBase = &pMatrices[0][0][0];
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	int composed = 0;
+	for (int block = m_firstDirtyBlock; block <= m_lastDirtyBlock; block++)
+	{
+		if (m_dirtyBlocks[block] == 0)
+		{
+			continue;
+		}
+		m_dirtyBlocks[block] = 0;
+
+		int first = block * BLOCK_SIZE;
+		__m128 qx = _mm_loadu_ps(&m_rotationX[first]);
+		__m128 qy = _mm_loadu_ps(&m_rotationY[first]);
+		__m128 qz = _mm_loadu_ps(&m_rotationZ[first]);
+		__m128 qw = _mm_loadu_ps(&m_rotationW[first]);
+		__m128 sx = _mm_loadu_ps(&m_scaleX[first]);
+		__m128 sy = _mm_loadu_ps(&m_scaleY[first]);
+		__m128 sz = _mm_loadu_ps(&m_scaleZ[first]);
+
+		// the doubled products of the quaternion components
+		__m128 x2 = _mm_mul_ps(qx, two);
+		__m128 y2 = _mm_mul_ps(qy, two);
+		__m128 z2 = _mm_mul_ps(qz, two);
+		__m128 xx = _mm_mul_ps(qx, x2);
+		__m128 yy = _mm_mul_ps(qy, y2);
+		__m128 zz = _mm_mul_ps(qz, z2);
+		__m128 xy = _mm_mul_ps(qx, y2);
+		__m128 xz = _mm_mul_ps(qx, z2);
+		__m128 yz = _mm_mul_ps(qy, z2);
+		__m128 wx = _mm_mul_ps(qw, x2);
+		__m128 wy = _mm_mul_ps(qw, y2);
+		__m128 wz = _mm_mul_ps(qw, z2);
+
+		// rotation columns, each scaled by its axis
+		__m128 c0x = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_add_ps(yy, zz)));
+		__m128 c0y = _mm_mul_ps(sx, _mm_add_ps(xy, wz));
+		__m128 c0z = _mm_mul_ps(sx, _mm_sub_ps(xz, wy));
+		__m128 c0w = _mm_setzero_ps();
+		__m128 c1x = _mm_mul_ps(sy, _mm_sub_ps(xy, wz));
+		__m128 c1y = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_add_ps(xx, zz)));
+		__m128 c1z = _mm_mul_ps(sy, _mm_add_ps(yz, wx));
+		__m128 c1w = _mm_setzero_ps();
+		__m128 c2x = _mm_mul_ps(sz, _mm_add_ps(xz, wy));
+		__m128 c2y = _mm_mul_ps(sz, _mm_sub_ps(yz, wx));
+		__m128 c2z = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_add_ps(xx, yy)));
+		__m128 c2w = _mm_setzero_ps();
+		__m128 c3x = _mm_loadu_ps(&m_positionX[first]);
+		__m128 c3y = _mm_loadu_ps(&m_positionY[first]);
+		__m128 c3z = _mm_loadu_ps(&m_positionZ[first]);
+		__m128 c3w = one;
+
+		// after the transposes register k holds the column of
+		// object k of the block
+		_MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+		_MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+		_MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+		_MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+		__m128 columns[BLOCK_SIZE][4] =
+		{
+			{ c0x, c1x, c2x, c3x },
+			{ c0y, c1y, c2y, c3y },
+			{ c0z, c1z, c2z, c3z },
+			{ c0w, c1w, c2w, c3w }
+		};
+
+		int objectCount = m_count - first;
+		if (objectCount > BLOCK_SIZE)
+			objectCount = BLOCK_SIZE;
+		for (int k = 0; k < objectCount; k++)
+		{
+			float* pMatrix = pBase + (size_t)(first + k) * MATRIX_FLOATS;
+			_mm_storeu_ps(pMatrix, columns[k][0]);
+			_mm_storeu_ps(pMatrix + 4, columns[k][1]);
+			_mm_storeu_ps(pMatrix + 8, columns[k][2]);
+			_mm_storeu_ps(pMatrix + 12, columns[k][3]);
+		}
+		composed += objectCount;
+	}
+
+	m_firstDirtyBlock = 0;
+	m_lastDirtyBlock = -1;
+	return(composed);
+}
@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// transformbatch.h
+// ============
+// compose the world matrices of many objects in SIMD batches
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  TransformBatch
+ *
+ *  This class stores the position, rotation quaternion and
+ *  scale of every object in separate arrays, so that four
+ *  objects at a time fill one SSE register per component.
+ *  Objects whose transform changed are marked dirty in
+ *  blocks of four, and only the dirty blocks are composed
+ *  into column-major world matrices in memory owned by the
+ *  caller.
+ ***********************************************************/
+class TransformBatch
+{
+public:
+	// objects composed together in one SIMD block
+	static const int BLOCK_SIZE = 4;
+
+	// constructor
+	TransformBatch();
+	// destructor
+	~TransformBatch();
+
+private:
+	// number of objects in the batch
+	int m_count;
+	// component arrays, padded to a whole number of blocks
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_rotationW;
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+	// one flag per block of objects that must be recomposed
+	std::vector<uint8_t> m_dirtyBlocks;
+	// range of blocks that may be dirty, empty when first > last
+	int m_firstDirtyBlock;
+	int m_lastDirtyBlock;
+
+	// flag the block of an object for recomposition
+	void MarkDirty(int index);
+
+public:
+	// grow or shrink the batch, new objects start as identity
+	void Resize(int count);
+	// get the number of objects in the batch
+	int GetCount() const;
+
+	// set the transform of an object, marking it dirty only
+	// when one of the values actually changed
+	void SetTransform(
+		int index,
+		const glm::vec3& position,
+		const glm::quat& rotation,
+		const glm::vec3& scale);
+
+	// compose the dirty objects into an array of matrices,
+	// returning the number of objects that were composed
+	int ComposeDirty(glm::mat4* pMatrices);
+};
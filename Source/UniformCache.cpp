@@ -0,0 +1,338 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.cpp
+// ============
+// shadow the uniform values of the shader programs and skip redundant uploads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <cstring>
+
+/***********************************************************
+ *  UniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformCache::UniformCache()
+{
+	m_currentProgram = -1;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+	memset(&m_lastFrameStats, 0, sizeof(m_lastFrameStats));
+}
+
+/***********************************************************
+ *  ~UniformCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformCache::~UniformCache()
+{
+	m_programs.clear();
+}
+
+/***********************************************************
+ *  SetProgram()
+ *
+ *  This method is used for selecting the shadow table of the
+ *  passed in program, which must be the current program in
+ *  OpenGL for the following setter calls.
+ ***********************************************************/
+void UniformCache::SetProgram(GLuint program)
+{
+	int index = 0;
+	int programCount = (int)m_programs.size();
+	bool bFound = false;
+
+	while ((index < programCount) && (bFound == false))
+	{
+		if (m_programs[index].program == program)
+			bFound = true;
+		else
+			index++;
+	}
+
+	if (bFound == false)
+	{
+		PROGRAM_SHADOW shadow;
+		shadow.program = program;
+		m_programs.push_back(shadow);
+		index = (int)m_programs.size() - 1;
+	}
+
+	m_currentProgram = index;
+}
+
+/***********************************************************
+ *  SyncProgram()
+ *
+ *  This method is used for selecting the shadow table of the
+ *  program that is currently in use in OpenGL, for example
+ *  after ShaderManager::use() was called.
+ ***********************************************************/
+void UniformCache::SyncProgram()
+{
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	SetProgram((GLuint)program);
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting every shadowed value,
+ *  for example after the shaders were reloaded.
+ ***********************************************************/
+void UniformCache::Invalidate()
+{
+	m_programs.clear();
+	m_currentProgram = -1;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for closing the counters of the last
+ *  frame and starting to count a new one.
+ ***********************************************************/
+void UniformCache::BeginFrame()
+{
+	m_lastFrameStats = m_frameStats;
+	memset(&m_frameStats, 0, sizeof(m_frameStats));
+}
+
+/***********************************************************
+ *  GetLastFrameStats()
+ *
+ *  This method is used for getting the counters of the last
+ *  completed frame.
+ ***********************************************************/
+const UniformCache::FRAME_STATS& UniformCache::GetLastFrameStats() const
+{
+	return(m_lastFrameStats);
+}
+
+/***********************************************************
+ *  PrintFrameStats()
+ *
+ *  This method is used for printing the uploaded and avoided
+ *  uniform counters of the last completed frame, and the
+ *  sets of uniforms the program does not have.
+ ***********************************************************/
+void UniformCache::PrintFrameStats() const
+{
+	std::cout << "Uniform uploads (uploaded/avoided/inactive): "
+		<< m_lastFrameStats.uploaded << "/" << m_lastFrameStats.avoided
+		<< "/" << m_lastFrameStats.inactive << std::endl;
+}
+
+/***********************************************************
+ *  FindUniform()
+ *
+ *  This method is used for finding the shadow of the named
+ *  uniform in the current program.  The uniform location is
+ *  looked up once, the first time the name is used.
+ ***********************************************************/
+UniformCache::UNIFORM_SHADOW* UniformCache::FindUniform(const std::string& name)
+{
+	if (m_currentProgram < 0)
+	{
+		SyncProgram();
+	}
+
+	PROGRAM_SHADOW& program = m_programs[m_currentProgram];
+	std::unordered_map<std::string, UNIFORM_SHADOW>::iterator it = program.uniforms.find(name);
+	if (it != program.uniforms.end())
+	{
+		return(&it->second);
+	}
+
+	UNIFORM_SHADOW shadow;
+	shadow.location = glGetUniformLocation(program.program, name.c_str());
+	shadow.bValid = false;
+	shadow.count = 0;
+	shadow.intValue = 0;
+	memset(shadow.values, 0, sizeof(shadow.values));
+
+	return(&program.uniforms.insert(std::make_pair(name, shadow)).first->second);
+}
+
+/***********************************************************
+ *  UpdateInt()
+ *
+ *  This method is used for comparing an integer value with
+ *  the shadowed one.  Returns true when it must be uploaded.
+ ***********************************************************/
+bool UniformCache::UpdateInt(UNIFORM_SHADOW* pUniform, GLint value)
+{
+	// uniforms that are not active in the program are never sent
+	if (pUniform->location < 0)
+	{
+		m_frameStats.inactive++;
+		return(false);
+	}
+	if ((pUniform->bValid == true) && (pUniform->count == 0) && (pUniform->intValue == value))
+	{
+		m_frameStats.avoided++;
+		return(false);
+	}
+
+	pUniform->bValid = true;
+	pUniform->count = 0;
+	pUniform->intValue = value;
+	m_frameStats.uploaded++;
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateFloats()
+ *
+ *  This method is used for comparing float values with the
+ *  shadowed ones.  Returns true when they must be uploaded.
+ ***********************************************************/
+bool UniformCache::UpdateFloats(UNIFORM_SHADOW* pUniform, const GLfloat* values, int count)
+{
+	if (pUniform->location < 0)
+	{
+		m_frameStats.inactive++;
+		return(false);
+	}
+	if ((pUniform->bValid == true) && (pUniform->count == count) &&
+		(memcmp(pUniform->values, values, count * sizeof(GLfloat)) == 0))
+	{
+		m_frameStats.avoided++;
+		return(false);
+	}
+
+	pUniform->bValid = true;
+	pUniform->count = count;
+	memcpy(pUniform->values, values, count * sizeof(GLfloat));
+	m_frameStats.uploaded++;
+	return(true);
+}
+
+/***********************************************************
+ *  setBoolValue()
+ *
+ *  This method is used for setting a bool uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setBoolValue(const std::string& name, bool value)
+{
+	setIntValue(name, (int)value);
+}
+
+/***********************************************************
+ *  setIntValue()
+ *
+ *  This method is used for setting an int uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setIntValue(const std::string& name, int value)
+{
+	UNIFORM_SHADOW* pUniform = FindUniform(name);
+	if (UpdateInt(pUniform, value) == true)
+	{
+		glUniform1i(pUniform->location, value);
+	}
+}
+
+/***********************************************************
+ *  setSampler2DValue()
+ *
+ *  This method is used for setting a sampler uniform to a
+ *  texture unit when it differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setSampler2DValue(const std::string& name, int value)
+{
+	setIntValue(name, value);
+}
+
+/***********************************************************
+ *  setFloatValue()
+ *
+ *  This method is used for setting a float uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setFloatValue(const std::string& name, float value)
+{
+	UNIFORM_SHADOW* pUniform = FindUniform(name);
+	if (UpdateFloats(pUniform, &value, 1) == true)
+	{
+		glUniform1f(pUniform->location, value);
+	}
+}
+
+/***********************************************************
+ *  setVec2Value()
+ *
+ *  This method is used for setting a vec2 uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setVec2Value(const std::string& name, const glm::vec2& value)
+{
+	UNIFORM_SHADOW* pUniform = FindUniform(name);
+	if (UpdateFloats(pUniform, glm::value_ptr(value), 2) == true)
+	{
+		glUniform2fv(pUniform->location, 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setVec3Value()
+ *
+ *  This method is used for setting a vec3 uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setVec3Value(const std::string& name, const glm::vec3& value)
+{
+	UNIFORM_SHADOW* pUniform = FindUniform(name);
+	if (UpdateFloats(pUniform, glm::value_ptr(value), 3) == true)
+	{
+		glUniform3fv(pUniform->location, 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setVec3Value()
+ *
+ *  This method is used for setting a vec3 uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setVec3Value(const std::string& name, float x, float y, float z)
+{
+	setVec3Value(name, glm::vec3(x, y, z));
+}
+
+/***********************************************************
+ *  setVec4Value()
+ *
+ *  This method is used for setting a vec4 uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setVec4Value(const std::string& name, const glm::vec4& value)
+{
+	UNIFORM_SHADOW* pUniform = FindUniform(name);
+	if (UpdateFloats(pUniform, glm::value_ptr(value), 4) == true)
+	{
+		glUniform4fv(pUniform->location, 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  setMat4Value()
+ *
+ *  This method is used for setting a mat4 uniform when its
+ *  value differs from the last uploaded one.
+ ***********************************************************/
+void UniformCache::setMat4Value(const std::string& name, const glm::mat4& value)
+{
+	UNIFORM_SHADOW* pUniform = FindUniform(name);
+	if (UpdateFloats(pUniform, glm::value_ptr(value), 16) == true)
+	{
+		glUniformMatrix4fv(pUniform->location, 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
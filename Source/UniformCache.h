@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.h
+// ============
+// shadow the uniform values of the shader programs and skip redundant uploads
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  This class fronts the shader manager with the same set of
+ *  uniform setters.  It keeps a copy of the last value sent
+ *  to every uniform of every program, and only calls
+ *  glUniform when the value actually changes.
+ ***********************************************************/
+class UniformCache
+{
+public:
+	// constructor
+	UniformCache();
+	// destructor
+	~UniformCache();
+
+	// upload counters for one frame
+	struct FRAME_STATS
+	{
+		int uploaded;
+		int avoided;
+		// sets of uniforms the program does not have
+		int inactive;
+	};
+
+private:
+	// last uploaded value of one uniform
+	struct UNIFORM_SHADOW
+	{
+		GLint location;
+		bool bValid;
+		int count;
+		GLint intValue;
+		GLfloat values[16];
+	};
+
+	// shadowed uniforms of one shader program
+	struct PROGRAM_SHADOW
+	{
+		GLuint program;
+		std::unordered_map<std::string, UNIFORM_SHADOW> uniforms;
+	};
+
+	// shadow tables of all the programs seen so far
+	std::vector<PROGRAM_SHADOW> m_programs;
+	// index of the shadow table for the current program
+	int m_currentProgram;
+
+	// counters for the current and the last completed frame
+	FRAME_STATS m_frameStats;
+	FRAME_STATS m_lastFrameStats;
+
+	// find the shadow of a uniform in the current program
+	UNIFORM_SHADOW* FindUniform(const std::string& name);
+	// compare and store an integer value, true if it changed
+	bool UpdateInt(UNIFORM_SHADOW* pUniform, GLint value);
+	// compare and store float values, true if they changed
+	bool UpdateFloats(UNIFORM_SHADOW* pUniform, const GLfloat* values, int count);
+
+public:
+	// select the program that is current in OpenGL
+	void SetProgram(GLuint program);
+	// read the current program back from OpenGL and select it
+	void SyncProgram();
+	// forget the shadowed values of all the programs
+	void Invalidate();
+
+	// start counting a new frame
+	void BeginFrame();
+	// get the counters of the last completed frame
+	const FRAME_STATS& GetLastFrameStats() const;
+	// print the counters of the last completed frame
+	void PrintFrameStats() const;
+
+	// uniform setters matching the shader manager
+	void setBoolValue(const std::string& name, bool value);
+	void setIntValue(const std::string& name, int value);
+	void setSampler2DValue(const std::string& name, int value);
+	void setFloatValue(const std::string& name, float value);
+	void setVec2Value(const std::string& name, const glm::vec2& value);
+	void setVec3Value(const std::string& name, const glm::vec3& value);
+	void setVec3Value(const std::string& name, float x, float y, float z);
+	void setVec4Value(const std::string& name, const glm::vec4& value);
+	void setMat4Value(const std::string& name, const glm::mat4& value);
+};
@@ -8,12 +8,16 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ViewManager.h"
+#include "MemoryTracker.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>    
 
+#include <algorithm>
+#include <cstring>
+
 // Global constants
 namespace {
     constexpr int WINDOW_WIDTH = 1000;
@@ -23,15 +27,172 @@ namespace {
 
     // Camera and projection settings
     Camera* g_pCamera = nullptr;
+    // current framebuffer size, updated when the window is resized
+    int gFramebufferWidth = WINDOW_WIDTH;
+    int gFramebufferHeight = WINDOW_HEIGHT;
     float gLastX = WINDOW_WIDTH / 2.0f;
     float gLastY = WINDOW_HEIGHT / 2.0f;
     bool gFirstMouse = true;
 
+    // fixed time step of the current simulation tick
     float gDeltaTime = 0.0f;
-    float gLastFrame = 0.0f;
+
+    // camera values that are interpolated between two ticks
+    struct CAMERA_STATE
+    {
+        glm::vec3 position;
+        glm::vec3 front;
+        glm::vec3 up;
+        float zoom;
+    };
+    // camera state at the start of the last simulation tick
+    CAMERA_STATE gPreviousState;
+    // the camera jumped, so it must not be interpolated
+    bool gSnapView = true;
+    // interpolated camera position of the last prepared view
+    glm::vec3 gRenderPosition;
+    // view-projection matrix of the last prepared view
+    glm::mat4 gRenderViewProjection(1.0f);
+
+    // the camera or projection changed since the last check
+    bool gViewChanged = true;
+
+    // the memory dump key was down at the last check
+    bool gMemoryKeyDown = false;
+    // the screenshot key was down at the last check
+    bool gScreenshotKeyDown = false;
+    // a screenshot was asked for since the last check
+    bool gScreenshotRequested = false;
+    // the pick button was down at the last check
+    bool gPickButtonDown = false;
+    // an object pick was asked for since the last check
+    bool gPickRequested = false;
+    // the cursor release key was down at the last check
+    bool gCursorKeyDown = false;
+    // the cursor is free for picking instead of looking around
+    bool gCursorReleased = false;
+
+    /***********************************************************
+     *  CaptureCameraState()
+     *
+     *  Copy the interpolated values out of the camera.
+     ***********************************************************/
+    CAMERA_STATE CaptureCameraState()
+    {
+        CAMERA_STATE state;
+        state.position = g_pCamera->Position;
+        state.front = g_pCamera->Front;
+        state.up = g_pCamera->Up;
+        state.zoom = g_pCamera->Zoom;
+        return(state);
+    }
+
+    /***********************************************************
+     *  CameraStatesDiffer()
+     *
+     *  Check whether two camera states are not identical.
+     ***********************************************************/
+    bool CameraStatesDiffer(const CAMERA_STATE& a, const CAMERA_STATE& b)
+    {
+        return((a.position != b.position) || (a.front != b.front) ||
+            (a.up != b.up) || (a.zoom != b.zoom));
+    }
 
     // Projection toggle
     bool bOrthographicProjection = false;
+
+    // projection matrix and the inputs it was computed from, it
+    // is only recomputed when one of them changes
+    glm::mat4 gCachedProjection(1.0f);
+    float gCachedZoom = 0.0f;
+    bool gCachedOrthographic = false;
+    int gCachedWidth = 0;
+    int gCachedHeight = 0;
+    bool gProjectionValid = false;
+
+    // std140 layout of the shared camera uniform block:
+    //   layout(std140) uniform Camera
+    //   {
+    //       mat4 view;
+    //       mat4 projection;
+    //       mat4 viewProjection;
+    //       vec4 viewPosition;
+    //   };
+    struct CAMERA_BLOCK
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec4 position;
+    };
+    const char* CAMERA_BLOCK_NAME = "Camera";
+    // uniform buffer binding point shared by every program
+    const GLuint CAMERA_BLOCK_BINDING = 0;
+    // uniform buffer object holding the camera block
+    GLuint gCameraBuffer = 0;
+    // last uploaded contents of the camera block
+    CAMERA_BLOCK gUploadedBlock;
+    bool gBlockUploaded = false;
+    // attached programs with and without the camera block, the
+    // separate uniforms are only uploaded for the latter
+    int gBlockPrograms = 0;
+    int gUniformPrograms = 0;
+
+    /***********************************************************
+     *  ComputeProjection()
+     *
+     *  Compute the perspective or orthographic projection for
+     *  the zoom and the size of the target.
+     ***********************************************************/
+    glm::mat4 ComputeProjection(float zoom, bool bOrthographic, int width, int height)
+    {
+        float aspect = (float)width / (float)height;
+        if (bOrthographic == false)
+        {
+            // perspective projection
+            return(glm::perspective(glm::radians(zoom), aspect, 0.1f, 100.0f));
+        }
+        else if (aspect >= 1.0f)
+        {
+            // front-view orthographic projection with correct aspect ratio
+            return(glm::ortho(-5.0f, 5.0f, -5.0f / aspect, 5.0f / aspect, 0.1f, 100.0f));
+        }
+        return(glm::ortho(-5.0f * aspect, 5.0f * aspect, -5.0f, 5.0f, 0.1f, 100.0f));
+    }
+
+    /***********************************************************
+     *  GetProjection()
+     *
+     *  Get the projection for the zoom, projection mode and
+     *  framebuffer size, recomputing it only when one changed.
+     ***********************************************************/
+    const glm::mat4& GetProjection(float zoom)
+    {
+        // keep the last projection while the window is minimized
+        if ((gFramebufferWidth <= 0) || (gFramebufferHeight <= 0))
+        {
+            return(gCachedProjection);
+        }
+
+        if ((gProjectionValid == true) &&
+            (gCachedZoom == zoom) &&
+            (gCachedOrthographic == bOrthographicProjection) &&
+            (gCachedWidth == gFramebufferWidth) &&
+            (gCachedHeight == gFramebufferHeight))
+        {
+            return(gCachedProjection);
+        }
+
+        gCachedProjection = ComputeProjection(zoom, bOrthographicProjection,
+            gFramebufferWidth, gFramebufferHeight);
+
+        gCachedZoom = zoom;
+        gCachedOrthographic = bOrthographicProjection;
+        gCachedWidth = gFramebufferWidth;
+        gCachedHeight = gFramebufferHeight;
+        gProjectionValid = true;
+        return(gCachedProjection);
+    }
 }
 
 /***********************************************************
@@ -40,10 +201,12 @@ namespace {
  *  The constructor for the class
  ***********************************************************/
 ViewManager::ViewManager(
-    ShaderManager* pShaderManager)
+    ShaderManager* pShaderManager,
+    UniformCache* pUniformCache)
 {
     // initialize the member variables
     m_pShaderManager = pShaderManager;
+    m_pUniformCache = pUniformCache;
     m_pWindow = NULL;
     g_pCamera = new Camera();
     // default camera view parameters
@@ -51,6 +214,8 @@ ViewManager::ViewManager(
     g_pCamera->Front = glm::vec3(0.0f, -0.15f, -4.0f);
     g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
     g_pCamera->Zoom = 50;
+    gPreviousState = CaptureCameraState();
+    gRenderPosition = g_pCamera->Position;
 }
 
 /***********************************************************
@@ -62,12 +227,19 @@ ViewManager::~ViewManager()
 {
     // free up allocated memory
     m_pShaderManager = NULL;
+    m_pUniformCache = NULL;
     m_pWindow = NULL;
     if (NULL != g_pCamera)
     {
         delete g_pCamera;
         g_pCamera = NULL;
     }
+    if (0 != gCameraBuffer)
+    {
+        glDeleteBuffers(1, &gCameraBuffer);
+        gCameraBuffer = 0;
+        MemoryTracker::Release(&gCameraBuffer, 0);
+    }
 }
 
 /***********************************************************
@@ -99,11 +271,17 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
     // Set the scroll callback for zoom functionality
     glfwSetScrollCallback(window, &ViewManager::Scroll_Callback);
 
+    // this callback is used to keep the projection aspect
+    // matching the resized framebuffer
+    glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+    glfwGetFramebufferSize(window, &gFramebufferWidth, &gFramebufferHeight);
+
     // tell GLFW to capture all mouse events
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    // enable blending for supporting transparent rendering
-    glEnable(GL_BLEND);
+    // configure blending for transparent rendering - it is only
+    // enabled by the scene manager while drawing transparent objects
+    glDisable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     m_pWindow = window;
@@ -121,6 +299,8 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos) {
     // Disable mouse movement when in orthographic projection
     if (bOrthographicProjection) return;
+    // a released cursor moves over the scene without turning it
+    if (gCursorReleased) return;
     
     if (gFirstMouse) {
         gLastX = xMousePos;
@@ -134,7 +314,11 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
     gLastX = xMousePos;
     gLastY = yMousePos;
 
-    g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+    if ((xOffset != 0.0f) || (yOffset != 0.0f))
+    {
+        g_pCamera->ProcessMouseMovement(xOffset, yOffset);
+        gViewChanged = true;
+    }
 }
 
 /***********************************************************
@@ -143,10 +327,45 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
  *  This method captures and processes different inputs.
  ***********************************************************/
 void ViewManager::ProcessKeyboardEvents() {
+    // the software renderer runs without a window
+    if (NULL == m_pWindow) return;
+
     if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(m_pWindow, true);
     }
 
+    // M dumps the tracked memory once per key press
+    bool bMemoryKey = (glfwGetKey(m_pWindow, GLFW_KEY_M) == GLFW_PRESS);
+    if (bMemoryKey && !gMemoryKeyDown) {
+        MemoryTracker::Dump();
+    }
+    gMemoryKeyDown = bMemoryKey;
+
+    // F12 asks for one screenshot per key press
+    bool bScreenshotKey = (glfwGetKey(m_pWindow, GLFW_KEY_F12) == GLFW_PRESS);
+    if (bScreenshotKey && !gScreenshotKeyDown) {
+        gScreenshotRequested = true;
+    }
+    gScreenshotKeyDown = bScreenshotKey;
+
+    // Tab releases the cursor for picking and captures it again
+    bool bCursorKey = (glfwGetKey(m_pWindow, GLFW_KEY_TAB) == GLFW_PRESS);
+    if (bCursorKey && !gCursorKeyDown) {
+        gCursorReleased = !gCursorReleased;
+        glfwSetInputMode(m_pWindow, GLFW_CURSOR,
+            gCursorReleased ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+        // looking around starts again from the captured position
+        gFirstMouse = true;
+    }
+    gCursorKeyDown = bCursorKey;
+
+    // the left mouse button picks the object under the cursor
+    bool bPickButton = (glfwGetMouseButton(m_pWindow, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+    if (bPickButton && !gPickButtonDown) {
+        gPickRequested = true;
+    }
+    gPickButtonDown = bPickButton;
+
     if (!g_pCamera) return;
 
     // Process camera movement
@@ -161,6 +380,8 @@ void ViewManager::ProcessKeyboardEvents() {
     if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS) {
         // Switch to orthographic projection
         bOrthographicProjection = true;
+        gViewChanged = true;
+        gSnapView = true;
 
         // Set the camera to face the front in orthographic view
         g_pCamera->Position = glm::vec3(-2.0f, 2.0f, 10.0f);
@@ -172,6 +393,8 @@ void ViewManager::ProcessKeyboardEvents() {
     if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS) {
         // Switch to perspective projection
         bOrthographicProjection = false;
+        gViewChanged = true;
+        gSnapView = true;
 
         // Set the camera to face the front in perspective view
         g_pCamera->Position = glm::vec3(-1.5f, 3.5f, 8.0f);
@@ -190,66 +413,324 @@ void ViewManager::ProcessKeyboardEvents() {
 
 void ViewManager::Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset) {
     g_pCamera->ProcessMouseScroll((float)yOffset);
+    gViewChanged = true;
 }
 
 /***********************************************************
- *  PrepareSceneView()
+ *  Framebuffer_Size_Callback()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene
- *  rendering
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the display window is resized.
  ***********************************************************/
-void ViewManager::PrepareSceneView()
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
 {
-    glm::mat4 view;
-    glm::mat4 projection;
+    if ((width != gFramebufferWidth) || (height != gFramebufferHeight))
+    {
+        gFramebufferWidth = width;
+        gFramebufferHeight = height;
+        gViewChanged = true;
+    }
+}
 
-    // per-frame timing
-    float currentFrame = glfwGetTime();
-    gDeltaTime = currentFrame - gLastFrame;
-    gLastFrame = currentFrame;
+/***********************************************************
+ *  UpdateSimulation()
+ *
+ *  This method is used for advancing the camera by one fixed
+ *  simulation tick.  The state before the tick is kept, so
+ *  the rendered view can be interpolated between the two.
+ ***********************************************************/
+void ViewManager::UpdateSimulation(float timeStep)
+{
+    CAMERA_STATE lastState = gPreviousState;
+
+    // remember the state of the last tick for interpolation
+    gPreviousState = CaptureCameraState();
+    if (CameraStatesDiffer(lastState, gPreviousState))
+    {
+        gViewChanged = true;
+    }
 
     // process any keyboard events that may be waiting in the 
     // event queue
+    gDeltaTime = timeStep;
     ProcessKeyboardEvents();
 
-    // get the current view matrix from the camera
-    view = g_pCamera->GetViewMatrix();
-
-    // define the current projection matrix
-    if (bOrthographicProjection == false)
+    // switching the projection moves the camera in one jump
+    if (gSnapView)
     {
-        // perspective projection
-        projection = glm::perspective(glm::radians(g_pCamera->Zoom), (GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+        gPreviousState = CaptureCameraState();
+        gSnapView = false;
     }
-    else
+}
+
+/***********************************************************
+ *  PrepareSceneView()
+ *
+ *  This method is used for preparing the 3D scene view from
+ *  the camera state interpolated between the last two
+ *  simulation ticks, by the passed in factor from 0 to 1.
+ *  It does not call OpenGL, so the returned view can be
+ *  handed to the render thread.
+ ***********************************************************/
+ViewManager::VIEW_STATE ViewManager::PrepareSceneView(float alpha)
+{
+    VIEW_STATE viewState;
+    glm::mat4 view;
+
+    // blend the camera between the last two simulation ticks
+    CAMERA_STATE currentState = CaptureCameraState();
+    glm::vec3 position = glm::mix(gPreviousState.position, currentState.position, alpha);
+    glm::vec3 front = glm::mix(gPreviousState.front, currentState.front, alpha);
+    glm::vec3 up = glm::mix(gPreviousState.up, currentState.up, alpha);
+    float zoom = glm::mix(gPreviousState.zoom, currentState.zoom, alpha);
+    gRenderPosition = position;
+
+    // get the current view matrix from the interpolated camera
+    view = glm::lookAt(position, position + front, up);
+
+    // get the projection matrix, cached until the zoom, the
+    // projection mode or the framebuffer size changes
+    const glm::mat4& projection = GetProjection(zoom);
+
+    gRenderViewProjection = projection * view;
+
+    viewState.view = view;
+    viewState.projection = projection;
+    viewState.viewProjection = gRenderViewProjection;
+    viewState.position = position;
+    return(viewState);
+}
+
+/***********************************************************
+ *  BuildView()
+ *
+ *  This method is used for building the view of a fixed
+ *  camera pose for a target of the passed in size, with the
+ *  same projections as the interactive camera.  It does not
+ *  touch the camera or call OpenGL, so any thread may build
+ *  views for offscreen rendering.
+ ***********************************************************/
+ViewManager::VIEW_STATE ViewManager::BuildView(const CAMERA_POSE& pose, int width, int height)
+{
+    VIEW_STATE viewState;
+    viewState.view = glm::lookAt(pose.position, pose.position + pose.front, pose.up);
+    viewState.projection = ComputeProjection(pose.zoom, pose.bOrthographic,
+        std::max(1, width), std::max(1, height));
+    viewState.viewProjection = viewState.projection * viewState.view;
+    viewState.position = pose.position;
+    return(viewState);
+}
+
+/***********************************************************
+ *  ApplySceneView()
+ *
+ *  This method is used for passing a prepared view into the
+ *  shader.  It must run on the thread that owns the OpenGL
+ *  context.
+ ***********************************************************/
+void ViewManager::ApplySceneView(const VIEW_STATE& viewState)
+{
+    // update the shared camera block once for all programs
+    if (0 != gCameraBuffer)
     {
-        // front-view orthographic projection with correct aspect ratio
-        double scale = 0.0;
-        if (WINDOW_WIDTH > WINDOW_HEIGHT)
-        {
-            scale = (double)WINDOW_HEIGHT / (double)WINDOW_WIDTH;
-            projection = glm::ortho(-5.0f, 5.0f, -5.0f * (float)scale, 5.0f * (float)scale, 0.1f, 100.0f);
-        }
-        else if (WINDOW_WIDTH < WINDOW_HEIGHT)
-        {
-            scale = (double)WINDOW_WIDTH / (double)WINDOW_HEIGHT;
-            projection = glm::ortho(-5.0f * (float)scale, 5.0f * (float)scale, -5.0f, 5.0f, 0.1f, 100.0f);
-        }
-        else
+        CAMERA_BLOCK block;
+        block.view = viewState.view;
+        block.projection = viewState.projection;
+        block.viewProjection = viewState.viewProjection;
+        block.position = glm::vec4(viewState.position, 1.0f);
+
+        if ((gBlockUploaded == false) ||
+            (memcmp(&block, &gUploadedBlock, sizeof(CAMERA_BLOCK)) != 0))
         {
-            projection = glm::ortho(-5.0f, 5.0f, -5.0f, 5.0f, 0.1f, 100.0f);
+            glBindBuffer(GL_UNIFORM_BUFFER, gCameraBuffer);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CAMERA_BLOCK), &block);
+            gUploadedBlock = block;
+            gBlockUploaded = true;
         }
     }
 
-    // if the shader manager object is valid
-    if (NULL != m_pShaderManager)
+    // programs without the camera block still need the
+    // separate uniforms
+    if ((NULL != m_pUniformCache) && ((gUniformPrograms > 0) || (gBlockPrograms == 0)))
     {
         // set the view matrix into the shader for proper rendering
-        m_pShaderManager->setMat4Value(VIEW_NAME, view);
+        m_pUniformCache->setMat4Value(VIEW_NAME, viewState.view);
         // set the view matrix into the shader for proper rendering
-        m_pShaderManager->setMat4Value(PROJECTION_NAME, projection);
+        m_pUniformCache->setMat4Value(PROJECTION_NAME, viewState.projection);
         // set the view position of the camera into the shader for proper rendering
-        m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+        m_pUniformCache->setVec3Value("viewPosition", viewState.position);
+    }
+}
+
+/***********************************************************
+ *  AttachCameraBlock()
+ *
+ *  This method is used for sharing the camera uniform block
+ *  with the current shader program.  The uniform buffer is
+ *  created on the first call.  It returns false when the
+ *  program does not declare the block, in which case the
+ *  camera is passed as separate uniforms.
+ ***********************************************************/
+bool ViewManager::AttachCameraBlock()
+{
+    GLint program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+    if (program == 0)
+    {
+        return(false);
+    }
+
+    GLuint blockIndex = glGetUniformBlockIndex((GLuint)program, CAMERA_BLOCK_NAME);
+    if (blockIndex == GL_INVALID_INDEX)
+    {
+        gUniformPrograms++;
+        return(false);
+    }
+
+    if (0 == gCameraBuffer)
+    {
+        glGenBuffers(1, &gCameraBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, gCameraBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CAMERA_BLOCK), NULL, GL_DYNAMIC_DRAW);
+        MemoryTracker::Track(&gCameraBuffer, 0, MemoryTracker::MEMORY_UNIFORM_BUFFER,
+            "camera uniform block", sizeof(CAMERA_BLOCK));
+        glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, gCameraBuffer);
+        gBlockUploaded = false;
+    }
+
+    glUniformBlockBinding((GLuint)program, blockIndex, CAMERA_BLOCK_BINDING);
+    gBlockPrograms++;
+    return(true);
+}
+
+/***********************************************************
+ *  GetFramebufferSize()
+ *
+ *  This method is used for getting the current size of the
+ *  window framebuffer in pixels, as last reported by GLFW.
+ ***********************************************************/
+void ViewManager::GetFramebufferSize(int& width, int& height)
+{
+    width = gFramebufferWidth;
+    height = gFramebufferHeight;
+}
+
+/***********************************************************
+ *  GetViewPosition()
+ *
+ *  This method is used for getting the camera position of
+ *  the last prepared view in the 3D scene.
+ ***********************************************************/
+glm::vec3 ViewManager::GetViewPosition()
+{
+    return(gRenderPosition);
+}
+
+/***********************************************************
+ *  GetViewProjection()
+ *
+ *  This method is used for getting the combined view and
+ *  projection matrix of the last prepared view.
+ ***********************************************************/
+glm::mat4 ViewManager::GetViewProjection()
+{
+    return(gRenderViewProjection);
+}
+
+/***********************************************************
+ *  GetCursorRay()
+ *
+ *  This method is used for getting the world ray under the
+ *  mouse cursor in the last prepared view.  While the cursor
+ *  is captured for looking around, the ray goes through the
+ *  center of the view; Tab releases the cursor to pick any
+ *  point of the view.
+ ***********************************************************/
+void ViewManager::GetCursorRay(glm::vec3& origin, glm::vec3& direction)
+{
+    // cursor position in normalized device coordinates
+    float x = 0.0f;
+    float y = 0.0f;
+    if ((NULL != m_pWindow) && (glfwGetInputMode(m_pWindow, GLFW_CURSOR) == GLFW_CURSOR_NORMAL))
+    {
+        double cursorX = 0.0;
+        double cursorY = 0.0;
+        int width = 0;
+        int height = 0;
+        glfwGetCursorPos(m_pWindow, &cursorX, &cursorY);
+        glfwGetWindowSize(m_pWindow, &width, &height);
+        if ((width > 0) && (height > 0))
+        {
+            x = (float)((2.0 * cursorX / width) - 1.0);
+            y = (float)(1.0 - (2.0 * cursorY / height));
+        }
     }
+
+    // the cursor point on the near and the far plane
+    glm::mat4 inverse = glm::inverse(gRenderViewProjection);
+    glm::vec4 nearPoint = inverse * glm::vec4(x, y, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverse * glm::vec4(x, y, 1.0f, 1.0f);
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::normalize((glm::vec3(farPoint) / farPoint.w) - origin);
+}
+
+/***********************************************************
+ *  IsViewMoving()
+ *
+ *  This method is used for checking whether a camera
+ *  movement key is held down, or the interpolated view has
+ *  not caught up with the camera yet.  Either keeps the view
+ *  changing every frame without any new window events.
+ ***********************************************************/
+bool ViewManager::IsViewMoving()
+{
+    if (NULL == m_pWindow) return(false);
+
+    if (CameraStatesDiffer(gPreviousState, CaptureCameraState())) return(true);
+
+    return((glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS) ||
+        (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS) ||
+        (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS) ||
+        (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS) ||
+        (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS) ||
+        (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS));
+}
+
+/***********************************************************
+ *  ConsumeViewChanged()
+ *
+ *  This method is used for checking whether the camera or
+ *  the projection changed since the last call.
+ ***********************************************************/
+bool ViewManager::ConsumeViewChanged()
+{
+    bool bChanged = gViewChanged;
+    gViewChanged = false;
+    return(bChanged);
+}
+
+/***********************************************************
+ *  ConsumePickRequest()
+ *
+ *  This method is used for checking whether the pick button
+ *  was pressed since the last call.
+ ***********************************************************/
+bool ViewManager::ConsumePickRequest()
+{
+    bool bRequested = gPickRequested;
+    gPickRequested = false;
+    return(bRequested);
+}
+
+/***********************************************************
+ *  ConsumeScreenshotRequest()
+ *
+ *  This method is used for checking whether the screenshot
+ *  key was pressed since the last call.
+ ***********************************************************/
+bool ViewManager::ConsumeScreenshotRequest()
+{
+    bool bRequested = gScreenshotRequested;
+    gScreenshotRequested = false;
+    return(bRequested);
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "UniformCache.h"
 #include "camera.h"
 
 // GLFW library
@@ -18,9 +19,30 @@
 class ViewManager
 {
 public:
+	// camera matrices of one prepared view
+	struct VIEW_STATE
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 viewProjection;
+		glm::vec3 position;
+	};
+
+	// fixed camera placement, like the interactive camera
+	struct CAMERA_POSE
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		// vertical field of view in degrees
+		float zoom;
+		bool bOrthographic;
+	};
+
 	// constructor
 	ViewManager(
-		ShaderManager* pShaderManager);
+		ShaderManager* pShaderManager,
+		UniformCache* pUniformCache);
 	// destructor
 	~ViewManager();
 
@@ -30,9 +52,14 @@ public:
 	// scroll callback for interaction with the 3D scene
 	static void Scroll_Callback(GLFWwindow* window, double xOffset, double yOffset);
 
+	// framebuffer size callback for keeping the projection aspect
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to the uniform cache object
+	UniformCache* m_pUniformCache;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
 
@@ -43,6 +70,33 @@ public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
 	
+	// advance the camera by one fixed simulation tick
+	void UpdateSimulation(float timeStep);
 	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
+	VIEW_STATE PrepareSceneView(float alpha);
+	// build the view of a fixed camera pose for a target size
+	static VIEW_STATE BuildView(const CAMERA_POSE& pose, int width, int height);
+	// pass a prepared view into the shader
+	void ApplySceneView(const VIEW_STATE& viewState);
+	// share the camera uniform block with the current shader program
+	bool AttachCameraBlock();
+
+	// get the current size of the window framebuffer in pixels
+	void GetFramebufferSize(int& width, int& height);
+
+	// get the current position of the camera
+	glm::vec3 GetViewPosition();
+	// get the combined view and projection of the last prepared view
+	glm::mat4 GetViewProjection();
+	// get the world ray under the cursor in the last prepared view
+	void GetCursorRay(glm::vec3& origin, glm::vec3& direction);
+
+	// check whether a camera movement key is held down
+	bool IsViewMoving();
+	// check and clear whether the view changed since the last call
+	bool ConsumeViewChanged();
+	// check and clear whether a screenshot was asked for
+	bool ConsumeScreenshotRequest();
+	// check and clear whether an object pick was asked for
+	bool ConsumePickRequest();
 };
\ No newline at end of file